@@ -169,6 +169,7 @@ void init_home()
     gps_base_alt    = max(g_gps->altitude_cm, 0);
     home.alt        = g_gps->altitude_cm;
 	home_is_set = true;
+	location_frame.set_origin(home);
 
 	// Save Home to EEPROM - Command 0
 	// -------------------
@@ -365,6 +365,7 @@ static void do_set_home()
 		home.lat 	= next_nonnav_command.lat;				// Lat * 10**7
 		home.alt 	= max(next_nonnav_command.alt, 0);
 		home_is_set = true;
+		location_frame.set_origin(home);
 	}
 }
 
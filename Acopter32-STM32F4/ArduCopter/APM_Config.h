@@ -22,6 +22,16 @@
 
 //#define ENHANCED
 
+/* main loop rate in Hz: 100, 200 or 400. 400 needs ENHANCED on the
+ * MPU6000 boards, and is the default when it is defined
+ */
+//#define MAIN_LOOP_RATE 200
+
+/* run the rate controllers and motors on each gyro sample, rather
+ * than once per main loop
+ */
+//#define RATE_LOOP ENABLED
+
 /*--------------------------------------*/
 
 //#define FRAME_CONFIG HEXA_FRAME
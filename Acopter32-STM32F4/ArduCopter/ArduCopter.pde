@@ -97,7 +97,9 @@
 #include <AP_InertialSensor.h>  // ArduPilot Mega Inertial Sensor (accel & gyro) Library
 #include <AP_AHRS.h>
 #include <APM_PI.h>             // PI library
+#include <AP_PIDCore.h>         // PID state shared by the PID libraries
 #include <AC_PID.h>             // PID library
+#include <AC_RateLoop.h>        // rate controllers run on each gyro sample
 #include <RC_Channel.h>         // RC Channel Library
 #include <AP_Motors.h>          // AP Motors library
 #include <AP_RangeFinder.h>     // Range finder library
@@ -119,6 +121,7 @@
 #include <AP_RCMapper.h>        // RC input mapping library
 #include <AP_Notify.h>          // Notify library
 #include <AP_BattMonitor.h>     // Battery monitor library
+#include <AP_MissionStore.h>    // Mission item storage
 #if SPRAYER == ENABLED
 #include <AC_Sprayer.h>         // crop sprayer library
 #endif
@@ -194,12 +197,28 @@ static DataFlash_File DataFlash("logs");
 static DataFlash_Empty DataFlash;
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+// Mission storage
+////////////////////////////////////////////////////////////////////////////////
+// boards with a filesystem keep the mission in a file, which allows
+// much larger missions than the EEPROM
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+static AP_MissionStore_File mission_backend("mission.dat", MISSION_FILE_MAX_ITEMS);
+#elif CONFIG_HAL_BOARD == HAL_BOARD_PX4
+static AP_MissionStore_File mission_backend("/fs/microsd/APM/mission.dat", MISSION_FILE_MAX_ITEMS);
+#else
+static AP_MissionStore_EEPROM mission_backend(WP_START_BYTE, FENCE_START_BYTE - WP_START_BYTE);
+#endif
+static AP_MissionStore mission_store(mission_backend);
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // the rate we run the main loop at
 ////////////////////////////////////////////////////////////////////////////////
-#ifdef ENHANCED
-static const AP_InertialSensor::Sample_rate ins_sample_rate = AP_InertialSensor::RATE_1000HZ;
+#if MAIN_LOOP_RATE == 400
+static const AP_InertialSensor::Sample_rate ins_sample_rate = AP_InertialSensor::RATE_400HZ;
+#elif MAIN_LOOP_RATE == 200
+static const AP_InertialSensor::Sample_rate ins_sample_rate = AP_InertialSensor::RATE_200HZ;
 #else
 static const AP_InertialSensor::Sample_rate ins_sample_rate = AP_InertialSensor::RATE_100HZ;
 #endif
@@ -300,7 +319,11 @@ AP_GPS_None     g_gps_driver;
   #error Unrecognised GPS_PROTOCOL setting.
  #endif // GPS PROTOCOL
 
+#if AHRS_EKF_ENABLED == ENABLED
+static AP_AHRS_EKF ahrs(&ins, barometer, g_gps);
+#else
 static AP_AHRS_DCM ahrs(&ins, g_gps);
+#endif
 // ahrs2 object is the secondary ahrs to allow running DMP in parallel with DCM
   #if SECONDARY_DMP_ENABLED == ENABLED && CONFIG_HAL_BOARD == HAL_BOARD_APM2
 static AP_AHRS_MPU6000  ahrs2(&ins, g_gps);               // only works with APM2
@@ -475,6 +498,16 @@ static MOTOR_CLASS motors(&g.rc_1, &g.rc_2, &g.rc_3, &g.rc_4, &g.rc_7);
 static MOTOR_CLASS motors(&g.rc_1, &g.rc_2, &g.rc_3, &g.rc_4);
 #endif
 
+#if FRAME_CONFIG != HELI_FRAME
+// the roll, pitch and yaw rate controllers, updated together
+static AC_PIDBank rate_pids(g.pid_rate_roll, g.pid_rate_pitch, g.pid_rate_yaw);
+#endif
+
+#if RATE_LOOP == ENABLED
+static AC_RateLoop rate_loop(g.pid_rate_roll, g.pid_rate_pitch, g.pid_rate_yaw,
+                             g.rc_1, g.rc_2, g.rc_4, motors);
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // PIDs
 ////////////////////////////////////////////////////////////////////////////////
@@ -503,12 +536,6 @@ static int8_t copter_leds_nav_blink;
 // 10^7 times Decimal GPS means 1 == 1cm
 // This approximation makes calculations integer and it's easy to read
 static const float t7 = 10000000.0;
-// We use atan2 and other trig techniques to calaculate angles
-// We need to scale the longitude up to make these calcs work
-// to account for decreasing distance between lines of longitude away from the equator
-static float scaleLongUp = 1;
-// Sometimes we need to remove the scaling for distance calcs
-static float scaleLongDown = 1;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Location & Navigation
@@ -529,9 +556,9 @@ static uint8_t nav_mode;
 static int16_t command_nav_index;
 // Register containing the index of the previous navigation command in the mission script
 // Used to manage the execution of conditional commands
-static uint8_t prev_nav_index;
+static int16_t prev_nav_index;
 // Register containing the index of the current conditional command in the mission script
-static uint8_t command_cond_index;
+static int16_t command_cond_index;
 // Used to track the required WP navigation information
 // options include
 // NAV_ALTITUDE - have we reached the desired altitude?
@@ -635,7 +662,7 @@ static uint32_t loiter_time;
 ////////////////////////////////////////////////////////////////////////////////
 // This register tracks the current Mission Command index when writing
 // a mission using Ch7 or Ch8 aux switches in flight
-static int8_t aux_switch_wp_index;
+static int16_t aux_switch_wp_index;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -730,7 +757,7 @@ static uint32_t throttle_integrator;
 ////////////////////////////////////////////////////////////////////////////////
 // The Commanded Yaw from the autopilot.
 static int32_t nav_yaw;
-static uint8_t yaw_timer;
+static uint16_t yaw_timer;
 // Yaw will point at this location if yaw_mode is set to YAW_LOOK_AT_LOCATION
 static Vector3f yaw_look_at_WP;
 // bearing from current location to the yaw_look_at_WP
@@ -869,51 +896,53 @@ AP_Param param_loader(var_info, WP_START_BYTE);
 /*
   scheduler table - all regular tasks apart from the fast_loop()
   should be listed here, along with how often they should be called
-  (in 10ms units) and the maximum time they are expected to take (in
-  microseconds)
+  (in milliseconds) and the maximum time they are expected to take (in
+  microseconds). The periods are converted to main loop ticks, so the
+  tasks run at the same rates whatever MAIN_LOOP_RATE is
  */
 static const AP_Scheduler::Task scheduler_tasks[] PROGMEM = {
-    { throttle_loop,         2,     450 },
-    { update_GPS,            2,     900 },
-    { update_nav_mode,       1,     400 },
-    { update_batt_compass,  10,     720 },
-    { read_aux_switches,    10,      50 },
-    { arm_motors_check,     10,      10 },
-    { auto_trim,            10,     140 },
-    { update_toy_throttle,  10,      50 },
-    { update_altitude,      10,    1000 },
-    { run_nav_updates,      10,     800 },
-    { three_hz_loop,        33,      90 },
-    { compass_accumulate,    2,     420 },
-    { barometer_accumulate,  2,     250 },
-    { update_notify,         2,     100 },
-    { one_hz_loop,         100,     420 },
-    { gcs_check_input,	     2,     550 },
-    { gcs_send_heartbeat,  100,     150 },
-    { gcs_send_deferred,     2,     720 },
-    { gcs_data_stream_send,  2,     950 },
+    { throttle_loop,          MAIN_LOOP_TICKS(20),     450 },
+    { update_GPS,             MAIN_LOOP_TICKS(20),     900 },
+    { update_nav_mode,        MAIN_LOOP_TICKS(10),     400 },
+    { update_batt_compass,    MAIN_LOOP_TICKS(100),    720 },
+    { read_aux_switches,      MAIN_LOOP_TICKS(100),     50 },
+    { arm_motors_check,       MAIN_LOOP_TICKS(100),     10 },
+    { auto_trim,              MAIN_LOOP_TICKS(100),    140 },
+    { update_toy_throttle,    MAIN_LOOP_TICKS(100),     50 },
+    { update_altitude,        MAIN_LOOP_TICKS(100),   1000 },
+    { run_nav_updates,        MAIN_LOOP_TICKS(100),    800 },
+    { three_hz_loop,          MAIN_LOOP_TICKS(330),     90 },
+    { update_mission_store,   MAIN_LOOP_TICKS(100),    200 },
+    { compass_accumulate,     MAIN_LOOP_TICKS(20),     420 },
+    { barometer_accumulate,   MAIN_LOOP_TICKS(20),     250 },
+    { update_notify,          MAIN_LOOP_TICKS(20),     100 },
+    { one_hz_loop,            MAIN_LOOP_TICKS(1000),   420 },
+    { gcs_check_input,        MAIN_LOOP_TICKS(20),     550 },
+    { gcs_send_heartbeat,     MAIN_LOOP_TICKS(1000),   150 },
+    { gcs_send_deferred,      MAIN_LOOP_TICKS(20),     720 },
+    { gcs_data_stream_send,   MAIN_LOOP_TICKS(20),     950 },
 #if COPTER_LEDS == ENABLED
-    { update_copter_leds,   10,      55 },
+    { update_copter_leds,     MAIN_LOOP_TICKS(100),     55 },
 #endif
-    { update_mount,          2,     450 },
-    { ten_hz_logging_loop,  10,     260 },
-    { fifty_hz_logging_loop, 2,     220 },
-    { perf_update,        1000,     200 },
-    { read_receiver_rssi,   10,      50 },
+    { update_mount,           MAIN_LOOP_TICKS(20),     450 },
+    { ten_hz_logging_loop,    MAIN_LOOP_TICKS(100),    260 },
+    { fifty_hz_logging_loop,  MAIN_LOOP_TICKS(20),     220 },
+    { perf_update,            MAIN_LOOP_TICKS(10000),  200 },
+    { read_receiver_rssi,     MAIN_LOOP_TICKS(100),     50 },
 #ifdef USERHOOK_FASTLOOP
-    { userhook_FastLoop,     1,    100  },
+    { userhook_FastLoop,      MAIN_LOOP_TICKS(10),     100 },
 #endif
 #ifdef USERHOOK_50HZLOOP
-    { userhook_50Hz,         2,    100  },
+    { userhook_50Hz,          MAIN_LOOP_TICKS(20),     100 },
 #endif
 #ifdef USERHOOK_MEDIUMLOOP
-    { userhook_MediumLoop,   10,    100 },
+    { userhook_MediumLoop,    MAIN_LOOP_TICKS(100),    100 },
 #endif
 #ifdef USERHOOK_SLOWLOOP
-    { userhook_SlowLoop,     30,    100 },
+    { userhook_SlowLoop,      MAIN_LOOP_TICKS(300),    100 },
 #endif
 #ifdef USERHOOK_SUPERSLOWLOOP
-    { userhook_SuperSlowLoop,100,   100 },
+    { userhook_SuperSlowLoop, MAIN_LOOP_TICKS(1000),   100 },
 #endif
 };
 
@@ -981,10 +1010,12 @@ static void perf_update(void)
     if (g.log_bitmask & MASK_LOG_PM)
         Log_Write_Performance();
     if (scheduler.debug()) {
-        cliSerial->printf_P(PSTR("PERF: %u/%u %lu\n"), 
+        cliSerial->printf_P(PSTR("PERF: %u/%u %lu latency %u/%u\n"), 
                             (unsigned)perf_info_get_num_long_running(),
                             (unsigned)perf_info_get_num_loops(),
-                            (unsigned long)perf_info_get_max_time());
+                            (unsigned long)perf_info_get_max_time(),
+                            (unsigned)perf_info_get_avg_latency(),
+                            (unsigned)perf_info_get_max_latency());
     }
     perf_info_reset();
     gps_fix_count = 0;
@@ -1021,13 +1052,19 @@ void loop()
     // have to call this once per loop, as the tasks are scheduled
     // in multiples of the main loop tick. So if they don't run on
     // the first call to the scheduler they won't run on a later
-    // call until scheduler.tick() is called again
-    uint32_t time_available = (timer + 10000) - micros();
-    scheduler.run(time_available - 300);
+    // call until scheduler.tick() is called again. At the higher
+    // loop rates the fast loop may leave no time at all, in which
+    // case the tasks wait for a later tick
+    uint32_t time_used = micros() - timer;
+    if (time_used + 300 < MAIN_LOOP_MICROS) {
+        scheduler.run(MAIN_LOOP_MICROS - time_used - 300);
+    } else {
+        scheduler.run(0);
+    }
 }
 
 
-// Main loop - 100hz
+// Main loop - runs at MAIN_LOOP_RATE
 static void fast_loop()
 {
     // IMU DCM Algorithm
@@ -2008,7 +2045,9 @@ void update_throttle_mode(void)
             // special handling if we are just taking off
             if (ap.land_complete) {
                 // tell motors to do a slow start.
+                rate_loop_suspend();
                 motors.slow_start(true);
+                rate_loop_resume();
             }
             get_throttle_althold_with_slew(wp_nav.get_desired_alt(), -wp_nav.get_descent_velocity(), wp_nav.get_climb_velocity());
             set_target_alt_for_reporting(wp_nav.get_desired_alt()); // To-Do: return get_destination_alt if we are flying to a waypoint
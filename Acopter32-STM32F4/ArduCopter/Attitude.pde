@@ -88,7 +88,7 @@ get_stabilize_yaw(int32_t target_angle)
     // log output if PID logging is on and we are tuning the yaw
     if( g.log_bitmask & MASK_LOG_PID && g.radio_tuning == CH6_STABILIZE_YAW_KP ) {
         pid_log_counter++;
-        if( pid_log_counter >= 10 ) {               // (update rate / desired output rate) = (100hz / 10hz) = 10
+        if( pid_log_counter >= MAIN_LOOP_TICKS(100) ) {    // 10hz output rate
             pid_log_counter = 0;
             Log_Write_PID(CH6_STABILIZE_YAW_KP, angle_error, target_rate, 0, 0, output, tuning_value);
         }
@@ -442,6 +442,15 @@ update_rate_contoller_targets()
     }
 }
 
+#if RATE_LOOP == ENABLED
+// the gyro sample hook of the inertial sensor, called from the timer
+// process with each gyro sample
+static void rate_loop_gyro_sample(const Vector3f &gyro, float dt)
+{
+    rate_loop.gyro_sample(gyro, dt);
+}
+#endif
+
 // run roll, pitch and yaw rate controllers and send output to motors
 // targets for these controllers comes from stabilize controllers
 void
@@ -452,11 +461,21 @@ run_rate_controllers()
         heli_integrated_swash_controller(roll_rate_target_bf, pitch_rate_target_bf);
         g.rc_4.servo_out = get_heli_rate_yaw(yaw_rate_target_bf);
     }
+#elif RATE_LOOP == ENABLED
+    // the rate loop runs the controllers and motors on each gyro
+    // sample, with the same gains as the controllers below
+    rate_loop.set_targets(roll_rate_target_bf, pitch_rate_target_bf, yaw_rate_target_bf);
 #else
-    // call rate controllers
-    g.rc_1.servo_out = get_rate_roll(roll_rate_target_bf);
-    g.rc_2.servo_out = get_rate_pitch(pitch_rate_target_bf);
-    g.rc_4.servo_out = get_rate_yaw(yaw_rate_target_bf);
+    // call rate controllers, updating the three together
+    int32_t rate_error[3];
+    rate_error[0] = roll_rate_target_bf - (int32_t)(omega.x * DEGX100);
+    rate_error[1] = pitch_rate_target_bf - (int32_t)(omega.y * DEGX100);
+    rate_error[2] = yaw_rate_target_bf - (omega.z * DEGX100);
+    rate_pids.update(rate_error, G_Dt, motors.limit.roll_pitch, motors.limit.yaw);
+
+    g.rc_1.servo_out = get_rate_roll(rate_error[0]);
+    g.rc_2.servo_out = get_rate_pitch(rate_error[1]);
+    g.rc_4.servo_out = get_rate_yaw(rate_error[2]);
 #endif
 
     // run throttle controller if accel based throttle controller is enabled and active (active means it has been given a target)
@@ -589,7 +608,7 @@ int16_t get_heli_rate_yaw(int32_t target_rate)
     // log output if PID loggins is on and we are tuning the yaw
     if( g.log_bitmask & MASK_LOG_PID && (g.radio_tuning == CH6_YAW_RATE_KP || g.radio_tuning == CH6_YAW_RATE_KD) ) {
         pid_log_counter++;
-        if( pid_log_counter >= 10 ) {               // (update rate / desired output rate) = (100hz / 10hz) = 10
+        if( pid_log_counter >= MAIN_LOOP_TICKS(100) ) {    // 10hz output rate
             pid_log_counter = 0;
             Log_Write_PID(CH6_YAW_RATE_KP, rate_error, p, i, d, output, tuning_value);
         }
@@ -602,30 +621,17 @@ int16_t get_heli_rate_yaw(int32_t target_rate)
 #endif // HELI_FRAME
 
 #if FRAME_CONFIG != HELI_FRAME
+// output of the roll rate controller, from the terms of the last
+// rate_pids update
 static int16_t
-get_rate_roll(int32_t target_rate)
+get_rate_roll(int32_t rate_error)
 {
     int32_t p,i,d;                  // used to capture pid values for logging
-    int32_t current_rate;           // this iteration's rate
-    int32_t rate_error;             // simply target_rate - current_rate
     int32_t output;                 // output from pid controller
 
-    // get current rate
-    current_rate    = (omega.x * DEGX100);
-
-    // call pid controller
-    rate_error  = target_rate - current_rate;
-    p           = g.pid_rate_roll.get_p(rate_error);
-
-    // get i term
-    i = g.pid_rate_roll.get_integrator();
-
-    // update i term as long as we haven't breached the limits or the I term will certainly reduce
-    if (!motors.limit.roll_pitch || ((i>0&&rate_error<0)||(i<0&&rate_error>0))) {
-        i = g.pid_rate_roll.get_i(rate_error, G_Dt);
-    }
-
-    d = g.pid_rate_roll.get_d(rate_error, G_Dt);
+    p = rate_pids.get_terms(0).p;
+    i = rate_pids.get_terms(0).i;
+    d = rate_pids.get_terms(0).d;
     output = p + i + d;
 
     // constrain output
@@ -635,7 +641,7 @@ get_rate_roll(int32_t target_rate)
     // log output if PID logging is on and we are tuning the rate P, I or D gains
     if( g.log_bitmask & MASK_LOG_PID && (g.radio_tuning == CH6_RATE_ROLL_PITCH_KP || g.radio_tuning == CH6_RATE_ROLL_PITCH_KI || g.radio_tuning == CH6_RATE_ROLL_PITCH_KD) ) {
         pid_log_counter++;                          // Note: get_rate_pitch pid logging relies on this function to update pid_log_counter so if you change the line above you must change the equivalent line in get_rate_pitch
-        if( pid_log_counter >= 10 ) {               // (update rate / desired output rate) = (100hz / 10hz) = 10
+        if( pid_log_counter >= MAIN_LOOP_TICKS(100) ) {    // 10hz output rate
             pid_log_counter = 0;
             Log_Write_PID(CH6_RATE_ROLL_PITCH_KP, rate_error, p, i, d, output, tuning_value);
         }
@@ -647,29 +653,14 @@ get_rate_roll(int32_t target_rate)
 }
 
 static int16_t
-get_rate_pitch(int32_t target_rate)
+get_rate_pitch(int32_t rate_error)
 {
     int32_t p,i,d;                                                                      // used to capture pid values for logging
-    int32_t current_rate;                                                       // this iteration's rate
-    int32_t rate_error;                                                                 // simply target_rate - current_rate
     int32_t output;                                                                     // output from pid controller
 
-    // get current rate
-    current_rate    = (omega.y * DEGX100);
-
-    // call pid controller
-    rate_error      = target_rate - current_rate;
-    p               = g.pid_rate_pitch.get_p(rate_error);
-
-    // get i term
-    i = g.pid_rate_pitch.get_integrator();
-
-    // update i term as long as we haven't breached the limits or the I term will certainly reduce
-    if (!motors.limit.roll_pitch || ((i>0&&rate_error<0)||(i<0&&rate_error>0))) {
-        i = g.pid_rate_pitch.get_i(rate_error, G_Dt);
-    }
-
-    d = g.pid_rate_pitch.get_d(rate_error, G_Dt);
+    p = rate_pids.get_terms(1).p;
+    i = rate_pids.get_terms(1).i;
+    d = rate_pids.get_terms(1).d;
     output = p + i + d;
 
     // constrain output
@@ -689,28 +680,14 @@ get_rate_pitch(int32_t target_rate)
 }
 
 static int16_t
-get_rate_yaw(int32_t target_rate)
+get_rate_yaw(int32_t rate_error)
 {
     int32_t p,i,d;                                                                      // used to capture pid values for logging
-    int32_t rate_error;
     int32_t output;
 
-    // rate control
-    rate_error              = target_rate - (omega.z * DEGX100);
-
-    // separately calculate p, i, d values for logging
-    p = g.pid_rate_yaw.get_p(rate_error);
-
-    // get i term
-    i = g.pid_rate_yaw.get_integrator();
-
-    // update i term as long as we haven't breached the limits or the I term will certainly reduce
-    if (!motors.limit.yaw || ((i>0&&rate_error<0)||(i<0&&rate_error>0))) {
-        i = g.pid_rate_yaw.get_i(rate_error, G_Dt);
-    }
-
-    // get d value
-    d = g.pid_rate_yaw.get_d(rate_error, G_Dt);
+    p = rate_pids.get_terms(2).p;
+    i = rate_pids.get_terms(2).i;
+    d = rate_pids.get_terms(2).d;
 
     output  = p+i+d;
     output = constrain_int32(output, -4500, 4500);
@@ -719,7 +696,7 @@ get_rate_yaw(int32_t target_rate)
     // log output if PID loggins is on and we are tuning the yaw
     if( g.log_bitmask & MASK_LOG_PID && g.radio_tuning == CH6_YAW_RATE_KP ) {
         pid_log_counter++;
-        if( pid_log_counter >= 10 ) {               // (update rate / desired output rate) = (100hz / 10hz) = 10
+        if( pid_log_counter >= MAIN_LOOP_TICKS(100) ) {    // 10hz output rate
             pid_log_counter = 0;
             Log_Write_PID(CH6_YAW_RATE_KP, rate_error, p, i, d, output, tuning_value);
         }
@@ -768,7 +745,7 @@ get_of_roll(int32_t input_roll)
         // log output if PID logging is on and we are tuning the rate P, I or D gains
         if( g.log_bitmask & MASK_LOG_PID && (g.radio_tuning == CH6_OPTFLOW_KP || g.radio_tuning == CH6_OPTFLOW_KI || g.radio_tuning == CH6_OPTFLOW_KD) ) {
             pid_log_counter++;              // Note: get_of_pitch pid logging relies on this function updating pid_log_counter so if you change the line above you must change the equivalent line in get_of_pitch
-            if( pid_log_counter >= 5 ) {    // (update rate / desired output rate) = (100hz / 10hz) = 10
+            if( pid_log_counter >= MAIN_LOOP_TICKS(50) ) {    // 10hz output rate, as get_of_pitch also counts
                 pid_log_counter = 0;
                 Log_Write_PID(CH6_OPTFLOW_KP, tot_x_cm, p, i, d, of_roll, tuning_value);
             }
@@ -842,7 +819,7 @@ get_of_pitch(int32_t input_pitch)
  *************************************************************/
 
  // get_look_at_yaw - updates bearing to look at center of circle or do a panorama
-// should be called at 100hz
+// should be called from the fast loop
 static void get_circle_yaw()
 {
     static uint8_t look_at_yaw_counter = 0;     // used to reduce update rate to 10hz
@@ -853,7 +830,7 @@ static void get_circle_yaw()
         nav_yaw = get_yaw_slew(nav_yaw, ToDeg(circle_angle)*100, AUTO_YAW_SLEW_RATE);
     }else{
         look_at_yaw_counter++;
-        if( look_at_yaw_counter >= 10 ) {
+        if( look_at_yaw_counter >= MAIN_LOOP_TICKS(100) ) {
             look_at_yaw_counter = 0;
             yaw_look_at_WP_bearing = pv_get_bearing_cd(inertial_nav.get_position(), yaw_look_at_WP);
         }
@@ -866,13 +843,13 @@ static void get_circle_yaw()
 }
 
 // get_look_at_yaw - updates bearing to location held in look_at_yaw_WP and calls stabilize yaw controller
-// should be called at 100hz
+// should be called from the fast loop
 static void get_look_at_yaw()
 {
     static uint8_t look_at_yaw_counter = 0;     // used to reduce update rate to 10hz
 
     look_at_yaw_counter++;
-    if( look_at_yaw_counter >= 10 ) {
+    if( look_at_yaw_counter >= MAIN_LOOP_TICKS(100) ) {
         look_at_yaw_counter = 0;
         yaw_look_at_WP_bearing = pv_get_bearing_cd(inertial_nav.get_position(), yaw_look_at_WP);
     }
@@ -995,7 +972,9 @@ set_throttle_takeoff()
         g.pid_throttle_accel.reset_I();
     }
     // tell motors to do a slow start
+    rate_loop_suspend();
     motors.slow_start(true);
+    rate_loop_resume();
 }
 
 // get_throttle_accel - accelerometer based throttle controller
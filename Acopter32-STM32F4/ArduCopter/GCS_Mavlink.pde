@@ -202,7 +202,7 @@ static NOINLINE void send_extended_status1(mavlink_channel_t chan, uint16_t pack
         control_sensors_present,
         control_sensors_enabled,
         control_sensors_health,
-        (uint16_t)(scheduler.load_average(10000) * 1000),
+        (uint16_t)(scheduler.load_average(MAIN_LOOP_MICROS) * 1000),
         battery.voltage() * 1000, // mV
         battery_current,        // in 10mA units
         battery_remaining,      // in %
@@ -476,9 +476,9 @@ static void NOINLINE send_raw_imu3(mavlink_channel_t chan)
 
 static void NOINLINE send_current_waypoint(mavlink_channel_t chan)
 {
-    mavlink_msg_mission_current_send(
-        chan,
-        (uint16_t)g.command_index);
+    // after the mission, report the index past its last item
+    uint16_t index = g.command_index == NO_COMMAND_INDEX ? g.command_total : g.command_index;
+    mavlink_msg_mission_current_send(chan, index);
 }
 
 static void NOINLINE send_statustext(mavlink_channel_t chan)
@@ -1333,7 +1333,7 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
         // time that the mav should loiter in milliseconds
         uint8_t current = 0;                 // 1 (true), 0 (false)
 
-        if (packet.seq == (uint16_t)g.command_index)
+        if (g.command_index != NO_COMMAND_INDEX && packet.seq == (uint16_t)g.command_index)
             current = 1;
 
         uint8_t autocontinue = 1;                 // 1 (true), 0 (false)
@@ -1534,7 +1534,7 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
         // set current command
         change_command(packet.seq);
 
-        mavlink_msg_mission_current_send(chan, g.command_index);
+        send_current_waypoint(chan);
         break;
     }
 
@@ -1760,7 +1760,10 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
                 goto mission_failed;
             }
 
-                set_cmd_with_index(tell_command, packet.seq);
+            if (!set_cmd_with_index(tell_command, packet.seq)) {
+                result = MAV_MISSION_ERROR;
+                goto mission_failed;
+            }
 
             // update waypoint receiving state machine
             waypoint_timelast_receive = millis();
@@ -1776,6 +1779,7 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
 
                 send_text_P(SEVERITY_LOW,PSTR("flight plan received"));
                 waypoint_receiving = false;
+                mission_store.flush();
                 // XXX ignores waypoint radius for individual waypoints, can
                 // only set WP_RADIUS parameter
             }
@@ -2015,40 +2019,37 @@ mission_failed:
         break;
     }
 
-/* To-Do: add back support for polygon type fence
 #if AC_FENCE == ENABLED
-    // receive an AP_Limits fence point from GCS and store in EEPROM
-    // receive a fence point from GCS and store in EEPROM
+    // receive a polygon fence point from GCS and store in EEPROM
     case MAVLINK_MSG_ID_FENCE_POINT: {
         mavlink_fence_point_t packet;
         mavlink_msg_fence_point_decode(msg, &packet);
-        if (packet.count != geofence_limit.fence_total()) {
+        if (mavlink_check_target(packet.target_system, packet.target_component))
+            break;
+        Vector2l point;
+        point.x = packet.lat*1.0e7f;
+        point.y = packet.lng*1.0e7f;
+        if (packet.count != fence.get_polygon_total() || !fence_save_point(packet.idx, point)) {
             send_text_P(SEVERITY_LOW,PSTR("bad fence point"));
-        } else {
-            Vector2l point;
-            point.x = packet.lat*1.0e7f;
-            point.y = packet.lng*1.0e7f;
-            geofence_limit.set_fence_point_with_index(point, packet.idx);
         }
         break;
     }
-    // send a fence point to GCS
+    // send a polygon fence point to GCS
     case MAVLINK_MSG_ID_FENCE_FETCH_POINT: {
         mavlink_fence_fetch_point_t packet;
         mavlink_msg_fence_fetch_point_decode(msg, &packet);
         if (mavlink_check_target(packet.target_system, packet.target_component))
             break;
-        if (packet.idx >= geofence_limit.fence_total()) {
+        if (packet.idx >= fence.get_polygon_total()) {
             send_text_P(SEVERITY_LOW,PSTR("bad fence point"));
         } else {
-            Vector2l point = geofence_limit.get_fence_point_with_index(packet.idx);
-            mavlink_msg_fence_point_send(chan, 0, 0, packet.idx, geofence_limit.fence_total(),
+            Vector2l point = fence.get_polygon_point(packet.idx);
+            mavlink_msg_fence_point_send(chan, 0, 0, packet.idx, fence.get_polygon_total(),
                                          point.x*1.0e-7f, point.y*1.0e-7f);
         }
         break;
     }
 #endif // AC_FENCE ENABLED
-*/
 
     }     // end switch
 } // end handle mavlink
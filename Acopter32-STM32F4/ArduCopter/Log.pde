@@ -423,6 +423,48 @@ static void Log_Write_Compass()
     DataFlash.WriteBlock(&pkt, sizeof(pkt));
 }
 
+struct PACKED log_Compass_Cal {
+    LOG_PACKET_HEADER;
+    uint8_t status;
+    uint8_t num_samples;
+    float   fitness;
+    float   radius;
+    float   offset_x;
+    float   offset_y;
+    float   offset_z;
+    float   diag_x;
+    float   diag_y;
+    float   diag_z;
+    float   offdiag_x;
+    float   offdiag_y;
+    float   offdiag_z;
+};
+
+// Write the result of a compass calibration
+static void Log_Write_Compass_Cal(const CompassCalibrator &calibrator)
+{
+    const Vector3f &offsets = calibrator.get_offsets();
+    const Vector3f &diagonals = calibrator.get_diagonals();
+    const Vector3f &offdiagonals = calibrator.get_offdiagonals();
+    struct log_Compass_Cal pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_COMPASS_CAL_MSG),
+        status          : (uint8_t)calibrator.status(),
+        num_samples     : calibrator.get_num_samples(),
+        fitness         : calibrator.get_fitness(),
+        radius          : calibrator.get_radius(),
+        offset_x        : offsets.x,
+        offset_y        : offsets.y,
+        offset_z        : offsets.z,
+        diag_x          : diagonals.x,
+        diag_y          : diagonals.y,
+        diag_z          : diagonals.z,
+        offdiag_x       : offdiagonals.x,
+        offdiag_y       : offdiagonals.y,
+        offdiag_z       : offdiagonals.z
+    };
+    DataFlash.WriteBlock(&pkt, sizeof(pkt));
+}
+
 struct PACKED log_Performance {
     LOG_PACKET_HEADER;
     uint8_t renorm_count;
@@ -454,8 +496,8 @@ static void Log_Write_Performance()
 
 struct PACKED log_Cmd {
     LOG_PACKET_HEADER;
-    uint8_t command_total;
-    uint8_t command_number;
+    uint16_t command_total;
+    uint16_t command_number;
     uint8_t waypoint_id;
     uint8_t waypoint_options;
     uint8_t waypoint_param1;
@@ -465,11 +507,11 @@ struct PACKED log_Cmd {
 };
 
 // Write a command processing packet
-static void Log_Write_Cmd(uint8_t num, const struct Location *wp)
+static void Log_Write_Cmd(uint16_t num, const struct Location *wp)
 {
     struct log_Cmd pkt = {
         LOG_PACKET_HEADER_INIT(LOG_CMD_MSG),
-        command_total       : g.command_total,
+        command_total       : (uint16_t)g.command_total.get(),
         command_number      : num,
         waypoint_id         : wp->id,
         waypoint_options    : wp->options,
@@ -863,10 +905,12 @@ static const struct LogStructure log_structure[] PROGMEM = {
       "CTUN", "heefhhhhh",   "ThrIn,SonAlt,BarAlt,WPAlt,DesSonAlt,AngBst,CRate,ThrOut,DCRate" },
     { LOG_COMPASS_MSG, sizeof(log_Compass),             
       "MAG", "hhhhhhhhh",    "MagX,MagY,MagZ,OfsX,OfsY,OfsZ,MOfsX,MOfsY,MOfsZ" },
+    { LOG_COMPASS_CAL_MSG, sizeof(log_Compass_Cal),
+      "MCAL", "BBfffffffffff", "Stat,NSmp,Fit,Rad,OfsX,OfsY,OfsZ,DiaX,DiaY,DiaZ,ODiX,ODiY,ODiZ" },
     { LOG_PERFORMANCE_MSG, sizeof(log_Performance), 
       "PM",  "BBBHHIhB",       "RenCnt,RenBlw,FixCnt,NLon,NLoop,MaxT,PMT,I2CErr" },
     { LOG_CMD_MSG, sizeof(log_Cmd),                 
-      "CMD", "BBBBBeLL",     "CTot,CNum,CId,COpt,Prm1,Alt,Lat,Lng" },
+      "CMD", "HHBBBeLL",     "CTot,CNum,CId,COpt,Prm1,Alt,Lat,Lng" },
     { LOG_ATTITUDE_MSG, sizeof(log_Attitude),       
       "ATT", "cccccCC",      "RollIn,Roll,PitchIn,Pitch,YawIn,Yaw,NavYaw" },
     { LOG_INAV_MSG, sizeof(log_INAV),       
@@ -936,7 +980,7 @@ static void start_logging()
 #else // LOGGING_ENABLED
 
 static void Log_Write_Startup() {}
-static void Log_Write_Cmd(uint8_t num, const struct Location *wp) {}
+static void Log_Write_Cmd(uint16_t num, const struct Location *wp) {}
 static void Log_Write_Mode(uint8_t mode) {}
 void Log_Write_IMU() {}
 void Log_Write_GPS() {}
@@ -946,6 +990,7 @@ static void Log_Write_AutoTuneDetails(int16_t angle_cd, float rate_cds) {}
 #endif
 static void Log_Write_Current() {}
 static void Log_Write_Compass() {}
+static void Log_Write_Compass_Cal(const CompassCalibrator &calibrator) {}
 static void Log_Write_Attitude() {}
 static void Log_Write_INAV() {}
 #if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
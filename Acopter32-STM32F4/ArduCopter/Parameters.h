@@ -305,8 +305,8 @@ public:
 
     // Waypoints
     //
-    AP_Int8         command_total;
-    AP_Int8         command_index;
+    AP_Int16        command_total;
+    AP_Int16        command_index;
     AP_Int16        circle_radius;
     AP_Float        circle_rate;                // Circle mode's turn rate in deg/s.  positive to rotate clockwise, negative for counter clockwise
     AP_Int32        rtl_loiter_time;
@@ -1050,6 +1050,13 @@ const AP_Param::ConversionInfo conversion_table[] PROGMEM = {
     { Parameters::k_param_volt_div_ratio,     0,      AP_PARAM_FLOAT, "BATT_VOLT_MULT" },
     { Parameters::k_param_curr_amp_per_volt,  0,      AP_PARAM_FLOAT, "BATT_AMP_PERVOLT" },
     { Parameters::k_param_pack_capacity,      0,      AP_PARAM_INT32, "BATT_CAPACITY" },
+#if CONFIG_HAL_BOARD != HAL_BOARD_AVR_SITL && CONFIG_HAL_BOARD != HAL_BOARD_LINUX && CONFIG_HAL_BOARD != HAL_BOARD_PX4
+    // WP_TOTAL and WP_INDEX were 8 bit. The mission stays where it was
+    // in the EEPROM, so its count is kept. Boards with a mission file
+    // start with an empty mission, as the old one is not in the file
+    { Parameters::k_param_command_total,      0,      AP_PARAM_INT8,  "WP_TOTAL" },
+    { Parameters::k_param_command_index,      0,      AP_PARAM_INT8,  "WP_INDEX" },
+#endif
 };
 
 static void load_parameters(void)
@@ -1100,7 +1107,7 @@ static void load_parameters(void)
         uint32_t before = micros();
         // Load all auto-loaded EEPROM variables
         AP_Param::load_all();
-
+        AP_Param::convert_old_parameters(&conversion_table[0], sizeof(conversion_table)/sizeof(conversion_table[0]));
         cliSerial->printf_P(PSTR("load_all took %luus\n"), micros() - before);
     }
 }
@@ -16,37 +16,15 @@ static struct Location get_cmd_with_index(int i)
 {
     struct Location temp;
 
-    // Find out proper location in memory by using the start_byte position + the index
+    // alt is stored in CM relative to home, lat and lon in decimal * 10,000,000
     // --------------------------------------------------------------------------------
-    if (i >= g.command_total) {
+    if (i < 0 || i >= g.command_total || !mission_store.read(i, temp)) {
         // we do not have a valid command to load
         // return a WP with a "Blank" id
         temp.id = CMD_BLANK;
 
         // no reason to carry on
         return temp;
-
-    }else{
-        // we can load a command, we don't process it yet
-        // read WP position
-        uint16_t mem = (WP_START_BYTE) + (i * WP_SIZE);
-
-        temp.id = hal.storage->read_byte(mem);
-
-        mem++;
-        temp.options = hal.storage->read_byte(mem);
-
-        mem++;
-        temp.p1 = hal.storage->read_byte(mem);
-
-        mem++;
-        temp.alt = hal.storage->read_dword(mem);           // alt is stored in CM! Alt is stored relative!
-
-        mem += 4;
-        temp.lat = hal.storage->read_dword(mem);         // lat is stored in decimal * 10,000,000
-
-        mem += 4;
-        temp.lng = hal.storage->read_dword(mem);         // lon is stored in decimal * 10,000,000
     }
 
     // Add on home altitude if we are a nav command (or other command with altitude) and stored alt is relative
@@ -65,7 +43,9 @@ static struct Location get_cmd_with_index(int i)
 
 // Setters
 // -------
-static void set_cmd_with_index(struct Location temp, int i)
+// store a mission item. Returns false, and tells the GCS, if the
+// mission store could not take it
+static bool set_cmd_with_index(struct Location temp, int i)
 {
 
     i = constrain_int16(i, 0, g.command_total.get());
@@ -77,28 +57,25 @@ static void set_cmd_with_index(struct Location temp, int i)
         temp.id = MAV_CMD_NAV_WAYPOINT;
     }
 
-    uint16_t mem = WP_START_BYTE + (i * WP_SIZE);
-
-    hal.storage->write_byte(mem, temp.id);
-
-    mem++;
-    hal.storage->write_byte(mem, temp.options);
-
-    mem++;
-    hal.storage->write_byte(mem, temp.p1);
-
-    mem++;
-    hal.storage->write_dword(mem, temp.alt);     // Alt is stored in CM!
-
-    mem += 4;
-    hal.storage->write_dword(mem, temp.lat);     // Lat is stored in decimal degrees * 10^7
-
-    mem += 4;
-    hal.storage->write_dword(mem, temp.lng);     // Long is stored in decimal degrees * 10^7
+    // Alt is stored in CM, Lat and Long in decimal degrees * 10^7. The
+    // store holds the write until its page is written back
+    if (!mission_store.write(i, temp)) {
+        gcs_send_text_P(SEVERITY_HIGH, PSTR("Mission store write failed"));
+        return false;
+    }
 
     // Make sure our WP_total
     if(g.command_total < (i+1))
         g.command_total.set_and_save(i+1);
+    return true;
+}
+
+// load prefetched mission items and write back modified ones. This
+// runs as a scheduler task, so the storage is accessed in spare time
+// rather than when the navigation code needs an item
+static void update_mission_store()
+{
+    mission_store.update();
 }
 
 static int32_t get_RTL_alt()
@@ -133,9 +110,8 @@ static void init_home()
     if (g.log_bitmask & MASK_LOG_CMD)
         Log_Write_Cmd(0, &home);
 
-    // update navigation scalers.  used to offset the shrinking longitude as we go towards the poles
-    scaleLongDown = longitude_scale(home);
-    scaleLongUp   = 1.0f/scaleLongDown;
+    // set the origin of the navigation frame, which holds the scaler used to offset the shrinking longitude as we go towards the poles
+    location_frame.set_origin(home);
 }
 
 
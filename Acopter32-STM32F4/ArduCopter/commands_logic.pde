@@ -270,7 +270,15 @@ static void do_nav_wp()
     set_nav_mode(NAV_WP);
 
     // Set wp navigation target
-    wp_nav.set_destination(pv_location_to_vector(command_nav_queue));
+    Vector3f next_destination;
+    if (!wp_nav.spline_enabled()) {
+        wp_nav.set_destination(pv_location_to_vector(command_nav_queue));
+    }else if (command_nav_queue.p1 == 0 && get_next_wp_destination(next_destination)) {
+        // curve towards the following waypoint without stopping
+        wp_nav.set_spline_destination(pv_location_to_vector(command_nav_queue), &next_destination);
+    }else{
+        wp_nav.set_spline_destination(pv_location_to_vector(command_nav_queue), NULL);
+    }
 
     // initialise original_wp_bearing which is used to check if we have missed the waypoint
     wp_bearing = wp_nav.get_bearing_to_destination();
@@ -289,6 +297,22 @@ static void do_nav_wp()
     set_yaw_mode(get_wp_yaw_mode(false));
 }
 
+// get_next_wp_destination - get the position of the navigation command after the current one
+//  returns false if there is none, or if it is not a waypoint
+static bool get_next_wp_destination(Vector3f& destination)
+{
+    int16_t index = find_next_nav_index(command_nav_index + 1);
+    if (index == -1) {
+        return false;
+    }
+    struct Location cmd = get_cmd_with_index(index);
+    if (cmd.id != MAV_CMD_NAV_WAYPOINT) {
+        return false;
+    }
+    destination = pv_location_to_vector(cmd);
+    return true;
+}
+
 // do_land - initiate landing procedure
 // caller should set roll_pitch_mode to ROLL_PITCH_AUTO (for no pilot input) or ROLL_PITCH_LOITER (for pilot input)
 static void do_land(const struct Location *cmd)
@@ -895,6 +919,7 @@ static void do_set_home()
         home.lng        = command_cond_queue.lng;                                       // Lon * 10**7
         home.lat        = command_cond_queue.lat;                                       // Lat * 10**7
         home.alt        = 0;
+        location_frame.set_origin(home);
         //home_is_set 	= true;
         set_home_is_set(true);
     }
@@ -2,7 +2,7 @@
 
 // For changing active command mid-mission
 //----------------------------------------
-static void change_command(uint8_t cmd_index)
+static void change_command(uint16_t cmd_index)
 {
     // limit range
     cmd_index = min(g.command_total - 1, cmd_index);
@@ -21,6 +21,7 @@ static void change_command(uint8_t cmd_index)
         command_nav_queue               = temp;
         command_nav_index               = cmd_index;
         execute_nav_command();
+        mission_store.prefetch(command_nav_index + 1, MISSION_PREFETCH_ITEMS);
     }
 }
 
@@ -51,6 +52,9 @@ static void update_commands()
                 command_nav_index = tmp_index;
                 command_nav_queue = get_cmd_with_index(command_nav_index);
                 execute_nav_command();
+
+                // load the following commands before they are needed
+                mission_store.prefetch(command_nav_index + 1, MISSION_PREFETCH_ITEMS);
             }
         }else{
             // we are out of commands
@@ -153,7 +157,7 @@ static void verify_commands(void)
     }
 }
 
-// Finds the next navgation command in EEPROM
+// Finds the next navgation command in the mission
 static int16_t find_next_nav_index(int16_t search_index)
 {
     Location tmp;
@@ -171,7 +175,7 @@ static int16_t find_next_nav_index(int16_t search_index)
 static void exit_mission()
 {
     // we are out of commands
-    g.command_index = 255;
+    g.command_index = NO_COMMAND_INDEX;
 
     // if we are not on the ground switch to loiter or land
     if(!ap.land_complete) {
@@ -174,6 +174,55 @@
  # define MPU6K_FILTER MPU6K_DEFAULT_FILTER
 #endif
 
+//////////////////////////////////////////////////////////////////////////////
+// Main loop rate
+//
+// the rate in Hz at which the IMU is read and the attitude and rate
+// controllers and the motor outputs are run: 100, 200 or 400. The
+// scheduler tasks run at the same real time rates whatever this is
+#ifndef MAIN_LOOP_RATE
+ # ifdef ENHANCED
+  #  define MAIN_LOOP_RATE 400
+ # else
+  #  define MAIN_LOOP_RATE 100
+ # endif
+#endif
+#if MAIN_LOOP_RATE != 100 && MAIN_LOOP_RATE != 200 && MAIN_LOOP_RATE != 400
+ # error MAIN_LOOP_RATE must be 100, 200 or 400
+#endif
+#if MAIN_LOOP_RATE > 100 && (CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2)
+ # error MAIN_LOOP_RATE above 100 needs a 32 bit board
+#endif
+#if MAIN_LOOP_RATE > 200 && (CONFIG_IMU_TYPE == CONFIG_IMU_MPU6000 || CONFIG_IMU_TYPE == CONFIG_IMU_MPU6000_EXT) && !defined(ENHANCED)
+ # error MAIN_LOOP_RATE 400 needs the MPU6000 at 1kHz, define ENHANCED
+#endif
+
+// length of a main loop tick
+#define MAIN_LOOP_MICROS (1000000UL / MAIN_LOOP_RATE)
+
+// number of main loop ticks in a period of ms milliseconds
+#define MAIN_LOOP_TICKS(ms) ((uint32_t)(ms) * MAIN_LOOP_RATE / 1000)
+
+//////////////////////////////////////////////////////////////////////////////
+// Rate loop
+//
+// run the rate controllers and the motor outputs on each gyro sample
+// from the timer process, rather than once per main loop
+#ifndef RATE_LOOP
+ # define RATE_LOOP DISABLED
+#endif
+#if RATE_LOOP == ENABLED
+ # if FRAME_CONFIG == HELI_FRAME
+  #  error RATE_LOOP is not supported on helicopters
+ # endif
+ # if CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2
+  #  error RATE_LOOP needs a 32 bit board
+ # endif
+ # if CONFIG_IMU_TYPE != CONFIG_IMU_MPU6000 && CONFIG_IMU_TYPE != CONFIG_IMU_MPU6000_EXT && CONFIG_IMU_TYPE != CONFIG_IMU_SITL
+  #  error RATE_LOOP needs the MPU6000 or SITL
+ # endif
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 // ADC Enable - used to eliminate for systems which don't have ADC.
 //
@@ -1139,6 +1188,27 @@
 #endif
 
 
+// EKF attitude and position estimator, selected at runtime with
+// AHRS_EKF_USE. Too large for the APM1 and APM2
+#ifndef AHRS_EKF_ENABLED
+ #if CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2
+  # define AHRS_EKF_ENABLED DISABLED
+ #else
+  # define AHRS_EKF_ENABLED ENABLED
+ #endif
+#endif
+
+// size of the mission on boards which keep it in a file, in items
+// including home
+#ifndef MISSION_FILE_MAX_ITEMS
+ # define MISSION_FILE_MAX_ITEMS 10000
+#endif
+
+// number of mission items after the current one to load ahead of use
+#ifndef MISSION_PREFETCH_ITEMS
+ # define MISSION_PREFETCH_ITEMS AP_MISSIONSTORE_PAGE_ITEMS
+#endif
+
 // experimental mpu6000 DMP code
 #ifndef SECONDARY_DMP_ENABLED
  # define SECONDARY_DMP_ENABLED DISABLED
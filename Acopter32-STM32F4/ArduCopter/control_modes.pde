@@ -1,6 +1,6 @@
 /// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
 
-#define CONTROL_SWITCH_COUNTER  20  // 20 iterations at 100hz (i.e. 2/10th of a second) at a new switch position will cause flight mode change
+#define CONTROL_SWITCH_COUNTER  MAIN_LOOP_TICKS(200)  // 2/10th of a second at a new switch position will cause flight mode change
 static void read_control_switch()
 {
     static uint8_t switch_counter = 0;
@@ -210,8 +210,8 @@ static void do_aux_switch_function(int8_t ch_function, uint8_t ch_flag)
                 aux_switch_wp_index++;
 
                 // set the next_WP (home is stored at 0)
-                // max out at 100 since I think we need to stay under the EEPROM limit
-                aux_switch_wp_index = constrain_int16(aux_switch_wp_index, 1, 100);
+                // max out at the size of the mission store
+                aux_switch_wp_index = constrain_int16(aux_switch_wp_index, 1, MAX_WAYPOINTS);
 
                 if(g.rc_3.control_in > 0) {
                     // set our location ID to 16, MAV_CMD_NAV_WAYPOINT
@@ -221,11 +221,10 @@ static void do_aux_switch_function(int8_t ch_function, uint8_t ch_flag)
                     current_loc.id = MAV_CMD_NAV_LAND;
                 }
 
-                // save command
-                set_cmd_with_index(current_loc, aux_switch_wp_index);
-
-                // Cause the CopterLEDs to blink twice to indicate saved waypoint
-                copter_leds_nav_blink = 10;
+                // save command, blinking the CopterLEDs twice to indicate saved waypoint
+                if (set_cmd_with_index(current_loc, aux_switch_wp_index)) {
+                    copter_leds_nav_blink = 10;
+                }
             }
             break;
 
@@ -194,6 +194,10 @@
                     // requested
 #define NO_COMMAND 0
 
+// g.command_index when the mission has finished. Every value from 0
+// up is a valid mission index
+#define NO_COMMAND_INDEX -1
+
 
 // Navigation modes held in nav_mode variable
 #define NAV_NONE        0
@@ -301,6 +305,7 @@ enum ap_message {
 #elif CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
  #define LOG_DATA_INT8_MSG              0x1B
 #endif
+#define LOG_COMPASS_CAL_MSG             0x1C
 #define LOG_INDEX_MSG                   0xF0
 #define MAX_NUM_LOGS                    50
 
@@ -410,16 +415,20 @@ enum ap_message {
                             // WP
 #define WP_SIZE 15
 
-// fence points are stored at the end of the EEPROM
-#define MAX_FENCEPOINTS 6
+// fence points are stored at the end of the EEPROM. Boards which keep
+// the mission in a file give the polygon fence the space after the
+// parameters, others share it with the mission. The polygon fence
+// library is sized for the same number of points
+#if CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2
+ # define MAX_FENCEPOINTS 6
+#else
+ # define MAX_FENCEPOINTS AC_FENCE_POLYGON_POINTS_MAX
+#endif
 #define FENCE_WP_SIZE sizeof(Vector2l)
 #define FENCE_START_BYTE (EEPROM_MAX_ADDR - (MAX_FENCEPOINTS * FENCE_WP_SIZE))
 
-#define MAX_WAYPOINTS  ((FENCE_START_BYTE - WP_START_BYTE) / WP_SIZE) - 1 // -
-                                                                          // 1
-                                                                          // to
-                                                                          // be
-                                                                          // safe
+// the number of waypoints excluding home depends on the mission store
+#define MAX_WAYPOINTS  (mission_store.max_items() - 1)
 
 // mark a function as not to be inlined
 #define NOINLINE __attribute__((noinline))
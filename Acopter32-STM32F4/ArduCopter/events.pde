@@ -170,9 +170,9 @@ static void failsafe_gps_check()
     if(mode_requires_GPS(control_mode))
         set_mode(LAND);
 
-    // land if circular fence is enabled
+    // land if circular or polygon fence is enabled
 #if AC_FENCE == ENABLED
-    if((fence.get_enabled_fences() & AC_FENCE_TYPE_CIRCLE) != 0) {
+    if((fence.get_enabled_fences() & (AC_FENCE_TYPE_CIRCLE | AC_FENCE_TYPE_POLYGON)) != 0) {
         set_mode(LAND);
     }
 #endif
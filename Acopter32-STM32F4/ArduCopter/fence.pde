@@ -67,6 +67,27 @@ void fence_check()
     }
 }
 
+// fence_load_points - load the polygon fence points from EEPROM into the fence library
+static void fence_load_points()
+{
+    uint16_t total = min(fence.get_polygon_total(), MAX_FENCEPOINTS);
+    for (uint16_t i=0; i<total; i++) {
+        Vector2l point;
+        hal.storage->read_block(&point, FENCE_START_BYTE + i*FENCE_WP_SIZE, FENCE_WP_SIZE);
+        fence.set_polygon_point(i, point);
+    }
+}
+
+// fence_save_point - save a polygon fence point to EEPROM and pass it to the fence library
+static bool fence_save_point(uint16_t i, const Vector2l &point)
+{
+    if (i >= MAX_FENCEPOINTS || !fence.set_polygon_point(i, point)) {
+        return false;
+    }
+    hal.storage->write_block(FENCE_START_BYTE + i*FENCE_WP_SIZE, &point, FENCE_WP_SIZE);
+    return true;
+}
+
 // fence_send_mavlink_status - send fence status to ground station
 static void fence_send_mavlink_status(mavlink_channel_t chan)
 {   
@@ -77,7 +98,7 @@ static void fence_send_mavlink_status(mavlink_channel_t chan)
         if ((breaches & AC_FENCE_TYPE_ALT_MAX) != 0) {
             mavlink_breach_type = FENCE_BREACH_MAXALT;
         }
-        if ((breaches & AC_FENCE_TYPE_CIRCLE) != 0) {
+        if ((breaches & (AC_FENCE_TYPE_CIRCLE | AC_FENCE_TYPE_POLYGON)) != 0) {
             mavlink_breach_type = FENCE_BREACH_BOUNDARY;
         }
 
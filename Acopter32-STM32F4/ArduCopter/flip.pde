@@ -6,7 +6,7 @@
 //    Some states are fixed commands (for a fixed time)
 //    Some states are fixed commands (until some IMU condition)
 //    Some states include controls inside
-uint8_t flip_timer;
+uint16_t flip_timer;
 uint8_t flip_state;
 
 #define AAP_THR_INC 170
@@ -62,8 +62,8 @@ void roll_flip()
         break;
 
     case 2:
-        // 100 = 1 second with 100hz
-        if (flip_timer < 100) {
+        // 1 second
+        if (flip_timer < MAIN_LOOP_TICKS(1000)) {
             // we no longer need to adjust the roll_rate. 
             // It will be handled by normal flight control loops
 
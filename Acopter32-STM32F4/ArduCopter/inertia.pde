@@ -10,7 +10,7 @@ static void read_inertia()
 
     if( motors.armed() && (g.log_bitmask & MASK_LOG_INAV) ) {
         log_counter_inav++;
-        if( log_counter_inav >= 10 ) {
+        if( log_counter_inav >= MAIN_LOOP_TICKS(100) ) {
             log_counter_inav = 0;
             Log_Write_INAV();
         }
@@ -201,10 +201,12 @@ static void init_arm_motors()
 #endif
 
     // enable output to motors
+    rate_loop_suspend();
     output_min();
 
     // finally actually arm the motors
     motors.armed(true);
+    rate_loop_resume();
 
     // log arming to dataflash
     Log_Write_Event(DATA_ARMED);
@@ -296,7 +298,7 @@ static void pre_arm_checks(bool display_failure)
 
 #if AC_FENCE == ENABLED
     // check fence is initialised
-    if(!fence.pre_arm_check() || (((fence.get_enabled_fences() & AC_FENCE_TYPE_CIRCLE) != 0) && g_gps->hdop > g.gps_hdop_good)) {
+    if(!fence.pre_arm_check() || (((fence.get_enabled_fences() & (AC_FENCE_TYPE_CIRCLE | AC_FENCE_TYPE_POLYGON)) != 0) && g_gps->hdop > g.gps_hdop_good)) {
         if (display_failure) {
             gcs_send_text_P(SEVERITY_HIGH,PSTR("PreArm: Bad GPS Pos"));
         }
@@ -407,7 +409,9 @@ static void init_disarm_motors()
     gcs_send_text_P(SEVERITY_HIGH, PSTR("DISARMING MOTORS"));
 #endif
 
+    rate_loop_suspend();
     motors.armed(false);
+    rate_loop_resume();
 
     compass.save_offsets();
 
@@ -448,6 +452,30 @@ set_servos_4()
     // To-Do: implement improved stability patch for tri so that we do not need to limit throttle input to motors
     g.rc_3.servo_out = min(g.rc_3.servo_out, 800);
 #endif
+#if RATE_LOOP == DISABLED
     motors.output();
+    perf_info_check_output_latency(micros() - fast_loopTimer);
+#else
+    // the rate loop outputs while armed
+    if (!motors.armed()) {
+        motors.output();
+    }
+#endif
+}
+
+// the rate loop drives the motors from the timer process while they are
+// armed, so it is held off while the main loop changes their state
+static void rate_loop_suspend()
+{
+#if RATE_LOOP == ENABLED
+    hal.scheduler->suspend_timer_procs();
+#endif
+}
+
+static void rate_loop_resume()
+{
+#if RATE_LOOP == ENABLED
+    hal.scheduler->resume_timer_procs();
+#endif
 }
 
@@ -193,10 +193,19 @@ static void reset_nav_params(void)
 }
 
 // get_yaw_slew - reduces rate of change of yaw to a maximum
-// assumes it is called at 100hz so centi-degrees and update rate cancel each other out
+// called once per fast loop, so deg_per_sec is turned into centi-degrees per
+// call at MAIN_LOOP_RATE.  The remainder is carried to the next call, so the
+// slew averages deg_per_sec even when that is not a whole number of
+// centi-degrees per call
 static int32_t get_yaw_slew(int32_t current_yaw, int32_t desired_yaw, int16_t deg_per_sec)
 {
-    return wrap_360_cd(current_yaw + constrain_int16(wrap_180_cd(desired_yaw - current_yaw), -deg_per_sec, deg_per_sec));
+    static int16_t slew_remainder;
+
+    // centi-degrees per call from the fast loop
+    int32_t slew_sum = (int32_t)deg_per_sec * 100 + slew_remainder;
+    int16_t slew = slew_sum / MAIN_LOOP_RATE;
+    slew_remainder = slew_sum % MAIN_LOOP_RATE;
+    return wrap_360_cd(current_yaw + constrain_int16(wrap_180_cd(desired_yaw - current_yaw), -slew, slew));
 }
 
 
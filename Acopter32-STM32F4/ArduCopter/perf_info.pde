@@ -2,14 +2,19 @@
 //
 //  high level performance monitoring
 //
-//  we measure the main loop time
+//  we measure the main loop time, and the latency from an IMU sample
+//  to the motor outputs
 //
 
-#define PERF_INFO_OVERTIME_THRESHOLD_MICROS 10500
+// loops more than 5% over their length are counted as long running
+#define PERF_INFO_OVERTIME_THRESHOLD_MICROS (MAIN_LOOP_MICROS + MAIN_LOOP_MICROS/20)
 
 uint16_t perf_info_loop_count;
 uint32_t perf_info_max_time;
 uint16_t perf_info_long_running;
+uint32_t perf_info_latency_sum;
+uint16_t perf_info_latency_count;
+uint16_t perf_info_latency_max;
 
 // perf_info_reset - reset all records of loop time to zero
 void perf_info_reset()
@@ -17,6 +22,12 @@ void perf_info_reset()
     perf_info_loop_count = 0;
     perf_info_max_time = 0;
     perf_info_long_running = 0;
+    perf_info_latency_sum = 0;
+    perf_info_latency_count = 0;
+    perf_info_latency_max = 0;
+#if RATE_LOOP == ENABLED
+    rate_loop.latency_reset();
+#endif
 }
 
 // perf_info_check_loop_time - check latest loop time vs min, max and overtime threshold
@@ -47,4 +58,41 @@ uint32_t perf_info_get_max_time()
 uint16_t perf_info_get_num_long_running()
 {
     return perf_info_long_running;
-}
\ No newline at end of file
+}
+
+// perf_info_check_output_latency - record the time from the IMU sample
+// to the motor outputs of the main loop
+void perf_info_check_output_latency(uint32_t time_in_micros)
+{
+    perf_info_latency_sum += time_in_micros;
+    perf_info_latency_count++;
+    if( time_in_micros > perf_info_latency_max ) {
+        perf_info_latency_max = time_in_micros;
+    }
+}
+
+// perf_info_get_avg_latency - average latency from an IMU sample to the
+// motor outputs (in microseconds). With the rate loop this is the time
+// taken by the rate loop from a gyro sample
+uint16_t perf_info_get_avg_latency()
+{
+#if RATE_LOOP == ENABLED
+    return rate_loop.latency_avg_usec();
+#else
+    if( perf_info_latency_count == 0 ) {
+        return 0;
+    }
+    return perf_info_latency_sum / perf_info_latency_count;
+#endif
+}
+
+// perf_info_get_max_latency - maximum latency from an IMU sample to the
+// motor outputs (in microseconds)
+uint16_t perf_info_get_max_latency()
+{
+#if RATE_LOOP == ENABLED
+    return rate_loop.latency_max_usec();
+#else
+    return perf_info_latency_max;
+#endif
+}
@@ -6,31 +6,34 @@
 //    .x = latitude from home in cm
 //    .y = longitude from home in cm
 //    .z = altitude above home in cm
+// conversions use location_frame, which has its origin at home
 
 // pv_latlon_to_vector - convert lat/lon coordinates to a position vector
 const Vector3f pv_latlon_to_vector(int32_t lat, int32_t lon, int32_t alt)
 {
-    Vector3f tmp((lat-home.lat) * LATLON_TO_CM, (lon-home.lng) * LATLON_TO_CM * scaleLongDown, alt);
-    return tmp;
+    struct Location loc;
+    loc.lat = lat;
+    loc.lng = lon;
+    loc.alt = alt;
+    return location_frame.position_cm(loc);
 }
 
 // pv_latlon_to_vector - convert lat/lon coordinates to a position vector
 const Vector3f pv_location_to_vector(Location loc)
 {
-    Vector3f tmp((loc.lat-home.lat) * LATLON_TO_CM, (loc.lng-home.lng) * LATLON_TO_CM * scaleLongDown, loc.alt);
-    return tmp;
+    return location_frame.position_cm(loc);
 }
 
 // pv_get_lon - extract latitude from position vector
 const int32_t pv_get_lat(const Vector3f pos_vec)
 {
-    return home.lat + (int32_t)(pos_vec.x / LATLON_TO_CM);
+    return location_frame.position_cm_lat(pos_vec);
 }
 
 // pv_get_lon - extract longitude from position vector
 const int32_t pv_get_lon(const Vector3f &pos_vec)
 {
-    return home.lng + (int32_t)(pos_vec.y / LATLON_TO_CM * scaleLongUp);
+    return location_frame.position_cm_lng(pos_vec);
 }
 
 // pv_get_horizontal_distance_cm - return distance between two positions in cm
@@ -118,18 +118,16 @@ static void read_radio()
     if (hal.rcin->valid_channels() > 0) {
         last_update = millis();
         ap.new_radio_frame = true;
-        uint16_t periods[8];
-        hal.rcin->read(periods,8);
+        // one read of all the inputs, which sets rc_5 to rc_8. The
+        // first four are set here as RCMAP maps them
+        uint16_t periods[RC_INPUT_CHANNELS];
+        RC_Channel::set_pwm_all(periods, CH_5);
         g.rc_1.set_pwm(periods[rcmap.roll()-1]);
         g.rc_2.set_pwm(periods[rcmap.pitch()-1]);
 
         set_throttle_and_failsafe(periods[rcmap.throttle()-1]);
 
         g.rc_4.set_pwm(periods[rcmap.yaw()-1]);
-        g.rc_5.set_pwm(periods[4]);
-        g.rc_6.set_pwm(periods[5]);
-        g.rc_7.set_pwm(periods[6]);
-        g.rc_8.set_pwm(periods[7]);
     }else{
         uint32_t elapsed = millis() - last_update;
         // turn on throttle failsafe if no update from ppm encoder for 2 seconds
@@ -6,6 +6,7 @@
 static int8_t   setup_accel_scale       (uint8_t argc, const Menu::arg *argv);
 static int8_t   setup_compass           (uint8_t argc, const Menu::arg *argv);
 static int8_t   setup_compassmot        (uint8_t argc, const Menu::arg *argv);
+static int8_t   setup_compasscal        (uint8_t argc, const Menu::arg *argv);
 static int8_t   setup_erase             (uint8_t argc, const Menu::arg *argv);
 static int8_t   setup_frame             (uint8_t argc, const Menu::arg *argv);
  #if FRAME_CONFIG == HELI_FRAME
@@ -29,6 +30,7 @@ const struct Menu::command setup_menu_commands[] PROGMEM = {
     {"accel",                       setup_accel_scale},
     {"compass",                     setup_compass},
     {"compassmot",                  setup_compassmot},
+    {"compasscal",                  setup_compasscal},
     {"erase",                       setup_erase},
     {"frame",                       setup_frame},
  #if FRAME_CONFIG == HELI_FRAME
@@ -330,6 +332,96 @@ setup_compassmot(uint8_t argc, const Menu::arg *argv)
     return 0;
 }
 
+// setup_compasscal - fits the compass offsets and soft iron matrix
+// while the vehicle is turned through all orientations
+static int8_t
+setup_compasscal(uint8_t argc, const Menu::arg *argv)
+{
+    CompassCalibrator calibrator;
+    uint32_t last_run_time;
+    uint8_t  print_counter = 0;
+
+    // check compass is enabled
+    if( !g.compass_enabled ) {
+        cliSerial->print_P(PSTR("compass disabled\n"));
+        return 0;
+    }
+
+    // initialise compass
+    init_compass();
+
+    cliSerial->print_P(PSTR("Turn the vehicle slowly through all orientations until the calibration finishes.\nPress any key to exit.\n\n"));
+
+    // clear out user input
+    while( cliSerial->available() ) {
+        cliSerial->read();
+    }
+
+    // the compass passes each reading to the calibrator
+    compass.set_calibrator(&calibrator);
+    calibrator.start();
+
+    // initialise run time
+    last_run_time = millis();
+
+    // main run while there is no user input and the calibration is running
+    while(!cliSerial->available() && calibrator.running()) {
+
+        // 50hz loop
+        if( millis() - last_run_time > 20 ) {
+            last_run_time = millis();
+
+            // read the compass and take a step of the fit
+            compass.read();
+            calibrator.update();
+
+            // display progress at 1hz
+            print_counter++;
+            if(print_counter >= 50) {
+                print_counter = 0;
+                cliSerial->printf_P(PSTR("coverage:%d%% fitness:%4.2f\n"),
+                                (int)(calibrator.get_coverage() * 100.0f),
+                                calibrator.get_fitness());
+            }
+        }else{
+            // grab some compass values
+            compass.accumulate();
+        }
+    }
+    compass.set_calibrator(NULL);
+
+    // clear out any user input
+    while( cliSerial->available() ) {
+        cliSerial->read();
+    }
+
+    // log the fit when it finished, whether or not it is used
+    if( !calibrator.running() && calibrator.status() != CompassCalibrator::CAL_NOT_STARTED ) {
+#if LOGGING_ENABLED == ENABLED
+        start_logging();
+#endif
+        Log_Write_Compass_Cal(calibrator);
+    }
+
+    // set and save the calibration only if it is good
+    if( calibrator.status() == CompassCalibrator::CAL_SUCCESS ) {
+        compass.set_calibration(calibrator.get_offsets(),
+                                calibrator.get_diagonals(),
+                                calibrator.get_offdiagonals());
+        compass.save_calibration();
+        cliSerial->printf_P(PSTR("\nSuccess! fitness:%4.2f\n\n"), calibrator.get_fitness());
+    }else if( calibrator.status() == CompassCalibrator::CAL_FAILED ) {
+        cliSerial->printf_P(PSTR("\nFailed! fitness:%4.2f, calibration not changed\n\n"), calibrator.get_fitness());
+    }else{
+        calibrator.stop();
+        cliSerial->print_P(PSTR("\nStopped, calibration not changed\n\n"));
+    }
+
+    report_compass();
+
+    return 0;
+}
+
 // display_compassmot_info - displays a status line for compassmot process
 static void display_compassmot_info(Vector3f& motor_impact, Vector3f& motor_compensation)
 {
@@ -1051,6 +1143,19 @@ static void report_compass()
                     offsets.y,
                     offsets.z);
 
+    // soft iron matrix
+    if (compass.soft_iron_calibrated()) {
+        Vector3f diagonals = compass.get_diagonals();
+        Vector3f offdiagonals = compass.get_offdiagonals();
+        cliSerial->printf_P(PSTR("Mag dia: %4.4f, %4.4f, %4.4f\nMag odi: %4.4f, %4.4f, %4.4f\n"),
+                        diagonals.x,
+                        diagonals.y,
+                        diagonals.z,
+                        offdiagonals.x,
+                        offdiagonals.y,
+                        offdiagonals.z);
+    }
+
     // motor compensation
     cliSerial->print_P(PSTR("Motor Comp: "));
     if( compass.motor_compensation_type() == AP_COMPASS_MOT_COMP_DISABLED ) {
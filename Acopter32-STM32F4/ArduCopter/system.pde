@@ -60,8 +60,10 @@ static void run_cli(AP_HAL::UARTDriver *port)
 
     // cut the engines
     if(motors.armed()) {
+        rate_loop_suspend();
         motors.armed(false);
         motors.output();
+        rate_loop_resume();
     }
     
     while (1) {
@@ -258,8 +260,17 @@ static void init_ardupilot()
 
     // initialize commands
     // -------------------
+    mission_store.init();
+    if (!mission_store.healthy()) {
+        gcs_send_text_P(SEVERITY_HIGH, PSTR("Mission storage failed"));
+    }
     init_commands();
 
+#if AC_FENCE == ENABLED
+    // load the polygon fence
+    fence_load_points();
+#endif
+
     // initialise the flight mode and aux switch
     // ---------------------------
     reset_control_switch();
@@ -293,6 +304,11 @@ static void startup_ground(void)
     report_ins();
  #endif
 
+#if RATE_LOOP == ENABLED
+    // run the rate controllers on each gyro sample
+    ins.set_gyro_sample_hook(rate_loop_gyro_sample);
+#endif
+
     // setup fast AHRS gains to get right attitude
     ahrs.set_fast_gains(true);
 
@@ -13,6 +13,7 @@ static int8_t   test_ins(uint8_t argc,                  const Menu::arg *argv);
 static int8_t   test_logging(uint8_t argc,              const Menu::arg *argv);
 static int8_t   test_motors(uint8_t argc,               const Menu::arg *argv);
 static int8_t   test_optflow(uint8_t argc,              const Menu::arg *argv);
+static int8_t   test_param(uint8_t argc,                const Menu::arg *argv);
 static int8_t   test_radio_pwm(uint8_t argc,            const Menu::arg *argv);
 static int8_t   test_radio(uint8_t argc,                const Menu::arg *argv);
 static int8_t   test_relay(uint8_t argc,                const Menu::arg *argv);
@@ -37,6 +38,7 @@ const struct Menu::command test_menu_commands[] PROGMEM = {
     {"logging",             test_logging},
     {"motors",              test_motors},
     {"optflow",             test_optflow},
+    {"param",               test_param},
     {"pwm",                 test_radio_pwm},
     {"radio",               test_radio},
     {"relay",               test_relay},
@@ -368,6 +370,52 @@ test_radio(uint8_t argc, const Menu::arg *argv)
     }
 }
 
+/*
+ *  benchmark parameter lookup by name. Every name in var_info[] is
+ *  resolved with AP_Param::find() and with a linear scan, and the
+ *  results are checked against each other
+ */
+static int8_t
+test_param(uint8_t argc, const Menu::arg *argv)
+{
+    AP_Param::ParamToken token;
+    AP_Param *ap;
+    enum ap_var_type type;
+    char name[AP_MAX_NAME_SIZE+1];
+    uint16_t count = 0, errors = 0;
+    uint32_t find_us = 0, linear_us = 0;
+
+    for (ap=AP_Param::first(&token, &type); ap; ap=AP_Param::next(&token, &type)) {
+        ap->copy_name_token(token, name, sizeof(name), token.idx != 0);
+        name[AP_MAX_NAME_SIZE] = 0;
+
+        enum ap_var_type t1, t2;
+        uint32_t t0 = micros();
+        AP_Param *p1 = AP_Param::find(name, &t1);
+        uint32_t t1_us = micros();
+        AP_Param *p2 = AP_Param::find_linear(name, &t2);
+        linear_us += micros() - t1_us;
+        find_us += t1_us - t0;
+
+        // names that appear twice resolve to the first, so only
+        // check find() against the linear scan
+        if (p1 == NULL || p1 != p2 || t1 != t2) {
+            cliSerial->printf_P(PSTR("%s: mismatch\n"), name);
+            errors++;
+        }
+        count++;
+    }
+
+    cliSerial->printf_P(PSTR("%u names, %u errors\n"), (unsigned)count, (unsigned)errors);
+    if (count != 0) {
+        cliSerial->printf_P(PSTR("find: %luus total, %luus/name\n"),
+                            (unsigned long)find_us, (unsigned long)(find_us/count));
+        cliSerial->printf_P(PSTR("linear: %luus total, %luus/name\n"),
+                            (unsigned long)linear_us, (unsigned long)(linear_us/count));
+    }
+    return (0);
+}
+
 static int8_t test_relay(uint8_t argc, const Menu::arg *argv)
 {
     print_hit_enter();
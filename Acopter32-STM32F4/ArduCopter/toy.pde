@@ -104,7 +104,7 @@ void roll_pitch_toy()
     if(g.rc_1.control_in != 0) {    // roll
         get_acro_yaw(yaw_rate/2);
         ap.yaw_stopped = false;
-        yaw_timer = 150;
+        yaw_timer = MAIN_LOOP_TICKS(1500);
 
     }else if (!ap.yaw_stopped) {
         get_acro_yaw(0);
@@ -224,6 +224,7 @@ void init_home()
     home.lat        = g_gps->latitude;                                  // Lat * 10**7
     home.alt        = max(g_gps->altitude_cm, 0);
     home_is_set = true;
+    location_frame.set_origin(home);
 
     gcs_send_text_fmt(PSTR("gps alt: %lu"), (unsigned long)home.alt);
 
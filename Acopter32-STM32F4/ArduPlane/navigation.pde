@@ -60,7 +60,7 @@ static void navigate()
 
     // waypoint distance from plane
     // ----------------------------
-    wp_distance = get_distance(current_loc, next_WP);
+    wp_distance = location_frame.distance(current_loc, next_WP);
 
     if (wp_distance < 0) {
         gcs_send_text_P(SEVERITY_HIGH,PSTR("WP error - distance < 0"));
@@ -233,7 +233,7 @@ static void setup_glide_slope(void)
 {
     // establish the distance we are travelling to the next waypoint,
     // for calculating out rate of change of altitude
-    wp_totalDistance        = get_distance(current_loc, next_WP);
+    wp_totalDistance        = location_frame.distance(current_loc, next_WP);
     wp_distance             = wp_totalDistance;
 
     /*
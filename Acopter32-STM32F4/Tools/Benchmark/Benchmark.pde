@@ -0,0 +1,1122 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Fly a fixed set of missions with the copter, plane and rover
+// controllers and score how well they fly and how much CPU time the
+// controllers use, for comparing builds.
+//
+// This is a benchmark of the controller libraries, not of the
+// vehicles. It does not run the vehicle sketches: not their
+// Attitude.pde, nor their sensor reads, logging, ground station or
+// the rest of their task tables. It calls the same libraries with the
+// default gains of the vehicles, from a main loop of its own and a
+// small AP_Scheduler task table of the GPS update and the navigation:
+//
+//   copter: the stabilize and rate controllers and the AP_MotorsQuad
+//           mixer at 400Hz, the MAIN_LOOP_RATE of ArduCopter with
+//           ENHANCED, with AC_WPNav for loiter and waypoints at 100Hz
+//   plane:  the roll and pitch controllers at 50Hz with L1 navigation
+//   rover:  the heading controller at 50Hz with its bearing and
+//           crosstrack navigation
+//
+// The timings are of that code alone, not the CPU load of a vehicle.
+//
+// The controllers fly the simple vehicle models in VehicleModels.h,
+// and the models feed the AHRS, GPS and inertial nav with the true
+// state. The missions are:
+//
+//   copter: hover, step, survey, loiter_wind
+//   plane:  step, survey, loiter_wind
+//   rover:  step, survey
+//
+// hover and loiter_wind hold position in light and strong gusty wind,
+// step flies a sequence of attitude (or rover heading) steps, and
+// survey flies a lawnmower pattern of waypoints to the end.
+//
+// The tool runs on the SITL HAL with its clock stopped. The clock is
+// advanced by the main loop period, and within a loop by the thread
+// CPU time of the vehicle code, scaled by BENCH_CPU_SCALE, so the
+// scheduler sees the time each task really takes. A scale of 1 gives
+// the load on the host. To estimate the load of the controllers on a
+// board set it to how much slower the board runs the same code. A
+// loop which overruns its period starts the next one late, as the
+// vehicles wait for the next IMU sample, and this shows as loop
+// jitter. The vehicle models and the scoring are not timed.
+//
+// The results are written as JSON to BENCH_JSON (default
+// benchmark.json, "-" for stdout):
+//
+//   attitude_rms_deg, attitude_max_deg
+//       the error between the attitude the controllers demand and the
+//       attitude flown, or the heading error of the rover
+//   position_rms_m, position_max_m
+//       distance from the hold point, the mission path or the loiter
+//       circle. null for the step missions
+//   time_s, completed
+//       the mission time, and whether the mission finished in time
+//       without flying away
+//   controller_load
+//       the CPU time of the main loops, their tasks and the scheduler,
+//       over the time of the mission. The time the scheduler keeps
+//       back at the end of each loop is not counted
+//   loop_avg_us, loop_max_us, jitter_rms_us, jitter_max_us
+//       the time of a main loop of the controllers with their tasks,
+//       and how far the loops start from the loop period
+//   tasks
+//       the runs, mean and maximum time of each task of the controller
+//       task table, and the number of overruns of its time
+//
+// The gusts are random, from the seed BENCH_SEED (default 1), so a
+// build flies the same missions on every run. BENCH_VEHICLE and
+// BENCH_MISSION select one vehicle or mission by name. Usage:
+//
+//   make sitl && /tmp/Benchmark.build/Benchmark.elf -C
+//
+// The exit status is non-zero when a mission does not complete.
+//
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_GPS.h>
+#include <AP_GPS_Glitch.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Baro.h>
+#include <GCS_MAVLink.h>
+#include <Filter.h>
+#include <SITL.h>
+#include <AP_Buffer.h>
+#include <AP_Notify.h>
+#include <AP_Vehicle.h>
+#include <AP_Scheduler.h>
+#include <AP_PIDCore.h>
+#include <AC_PID.h>
+#include <APM_PI.h>
+#include <PID.h>
+#include <AP_InertialNav.h>
+#include <AC_WPNav.h>
+#include <APM_Control.h>
+#include <AP_Navigation.h>
+#include <AP_L1_Control.h>
+#include <RC_Channel.h>
+#include <AP_Curve.h>
+#include <AP_Motors.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include <time.h>
+#include <sys/time.h>
+
+#include "VehicleModels.h"
+
+#define BENCH_MAX_TASKS     4           // most tasks in a vehicle task table
+#define BENCH_MAX_WAYPOINTS 20
+#define BENCH_GPS_PERIOD    100000      // GPS update period in microseconds
+#define BENCH_FLY_AWAY      100         // a mission fails this far from its path in m
+
+AP_InertialSensor_HIL ins;
+AP_Baro_HIL barometer;
+AP_GPS_HIL g_gps_driver;
+GPS *g_gps = &g_gps_driver;
+GPS_Glitch gps_glitch(g_gps);
+
+AP_AHRS_HIL ahrs(&ins, g_gps);
+AP_InertialNav inertial_nav(&ahrs, &ins, &barometer, g_gps, gps_glitch);
+
+// the copter controllers, with the default gains of ArduCopter
+APM_PI pi_stabilize_roll(4.5f);
+APM_PI pi_stabilize_pitch(4.5f);
+APM_PI pi_stabilize_yaw(4.5f);
+AC_PID pid_rate_roll(0.15f, 0.1f, 0.004f, 500);
+AC_PID pid_rate_pitch(0.15f, 0.1f, 0.004f, 500);
+AC_PID pid_rate_yaw(0.2f, 0.02f, 0, 800);
+AC_PIDBank rate_pids(pid_rate_roll, pid_rate_pitch, pid_rate_yaw);
+APM_PI pi_loiter_lat(1.0f);
+APM_PI pi_loiter_lon(1.0f);
+AC_PID pid_loiter_rate_lat(1.0f, 0.5f, 0, 400);
+AC_PID pid_loiter_rate_lon(1.0f, 0.5f, 0, 400);
+AC_WPNav wp_nav(&inertial_nav, &ahrs, &pi_loiter_lat, &pi_loiter_lon, &pid_loiter_rate_lat, &pid_loiter_rate_lon);
+RC_Channel rc_1(CH_1), rc_2(CH_2), rc_3(CH_3), rc_4(CH_4);
+AP_MotorsQuad motors(&rc_1, &rc_2, &rc_3, &rc_4);
+#define COPTER_LOOP_HZ         400
+#define COPTER_TICKS(ms)       ((ms) * COPTER_LOOP_HZ / 1000)
+#define COPTER_THROTTLE_CRUISE 450      // the default TRIM_THROTTLE of ArduCopter
+
+// the plane controllers
+AP_Vehicle::FixedWing aparm;
+AP_RollController rollController(ahrs, aparm);
+AP_PitchController pitchController(ahrs, aparm);
+AP_L1_Control L1_controller(ahrs);
+
+// the rover heading controller, with the default gains of APMrover2
+PID pidNavSteer(0.7f, 0.1f, 0.2f, 2000);
+
+AP_Scheduler copter_scheduler;
+AP_Scheduler plane_scheduler;
+AP_Scheduler rover_scheduler;
+
+static CopterModel copter;
+static PlaneModel plane;
+static RoverModel rover;
+static BenchWind wind;
+
+/*
+  a vehicle: its main loop, the scheduler tasks run after it, and the
+  model it flies
+ */
+struct vehicle {
+    const char *name;
+    uint16_t loop_hz;
+    // time kept back from the scheduler at the end of each loop
+    uint16_t reserve_usec;
+    AP_Scheduler *scheduler;
+    const AP_Scheduler::Task *tasks;
+    const char * const *task_names;
+    uint8_t num_tasks;
+    // advance the model and give the sensors the new state
+    void (*update_model)(float dt);
+    // the work of the main loop before the scheduler runs
+    void (*fast_loop)(void);
+};
+
+struct mission {
+    const struct vehicle *vehicle;
+    const char *name;
+    void (*start)(void);
+    // called after each main loop to score it and move the mission
+    // on, returning true when the mission is over
+    bool (*update)(void);
+    float time_max;
+};
+
+// accumulated samples of one score
+struct stats {
+    float sum;
+    float sum_sq;
+    float max;
+    uint32_t count;
+};
+
+struct task_stats {
+    uint32_t runs;
+    uint32_t overruns;
+    uint64_t total_usec;
+    uint32_t max_usec;
+};
+
+static struct {
+    struct stats attitude;
+    struct stats position;
+    struct stats loop_time;
+    struct stats jitter;
+    uint32_t loops;
+    struct task_stats tasks[BENCH_MAX_TASKS];
+} results;
+
+// the SITL clock, the start of the current main loop, and the thread
+// CPU time at that start
+static uint64_t clock_usec = 1;
+static uint64_t loop_start_usec;
+static uint64_t loop_start_cpu_nsec;
+static const AP_Scheduler::Task *current_tasks;
+static float cpu_scale;
+static uint32_t bench_seed;
+
+// the state of the current mission
+static float G_Dt;
+static float mission_time;
+static bool mission_failed;
+static uint8_t mission_step;
+static uint64_t last_gps_usec;
+
+enum nav_mode {
+    NAV_NONE = 0,
+    NAV_LOITER,
+    NAV_WP
+};
+static enum nav_mode nav_mode;
+
+// the mission path, north and east of home in m
+static Vector2f route[BENCH_MAX_WAYPOINTS];
+static uint8_t num_waypoints;
+static uint8_t waypoint;
+
+static struct Location home;
+static struct Location current_loc;
+static struct Location prev_WP;
+static struct Location next_WP;
+
+// copter
+static int32_t target_roll, target_pitch, target_yaw;
+static int32_t motor_out[3];
+
+// plane
+static int32_t nav_roll_cd, nav_pitch_cd;
+static int32_t aileron, elevator;
+#define PLANE_AIRSPEED      20          // m/s
+#define PLANE_WP_RADIUS     60          // m
+#define PLANE_LOITER_RADIUS 80          // m
+
+// rover
+static int32_t nav_bearing, target_bearing, crosstrack_bearing;
+static int32_t nav_steer_cd;
+static float wp_distance;
+static butter10hz1_6 bearing_filter;
+#define ROVER_SPEED         3           // m/s, the default cruise speed of APMrover2
+#define ROVER_WP_RADIUS     2           // m
+#define ROVER_XTRACK_GAIN   100         // centi-degrees per m
+#define ROVER_XTRACK_ANGLE  5000        // centi-degrees
+
+static uint64_t cpu_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static float env_float(const char *name, float default_value)
+{
+    const char *s = getenv(name);
+    return s ? atof(s) : default_value;
+}
+
+static void add_sample(struct stats &s, float v)
+{
+    v = fabsf(v);
+    s.sum += v;
+    s.sum_sq += sq(v);
+    s.max = max(s.max, v);
+    s.count++;
+}
+
+/*
+  move the SITL clock on by the scaled CPU time used since the start
+  of the main loop, returning how far it moved
+ */
+static uint32_t sync_clock(void)
+{
+    uint64_t used_nsec = cpu_nsec() - loop_start_cpu_nsec;
+    uint64_t now = loop_start_usec + (uint64_t)(used_nsec * cpu_scale * 0.001f);
+    uint32_t elapsed = now - clock_usec;
+    clock_usec = now;
+    AVR_SITL::SITLScheduler::stop_clock(clock_usec);
+    return elapsed;
+}
+
+/*
+  called at the end of each task, with its place in the task
+  table. The time since the end of the last task, including the
+  scheduler itself, is charged to the task, as AP_Scheduler does
+ */
+static void task_done(uint8_t i)
+{
+    uint32_t elapsed = sync_clock();
+    struct task_stats &t = results.tasks[i];
+    t.runs++;
+    t.total_usec += elapsed;
+    t.max_usec = max(t.max_usec, elapsed);
+    if (elapsed > pgm_read_word(&current_tasks[i].max_time_micros)) {
+        t.overruns++;
+    }
+}
+
+/*
+  the location of a point north and east of home
+ */
+static struct Location local_location(const Vector2f &pos)
+{
+    struct Location loc = home;
+    location_offset(loc, pos.x, pos.y);
+    return loc;
+}
+
+/*
+  give the GPS driver the true position at the GPS rate
+ */
+static void update_gps_truth(const Vector2f &pos, float alt, const Vector2f &velocity)
+{
+    if (clock_usec - last_gps_usec < BENCH_GPS_PERIOD) {
+        return;
+    }
+    last_gps_usec = clock_usec;
+    struct Location loc = local_location(pos);
+    float course = ToDeg(atan2f(velocity.y, velocity.x));
+    if (course < 0) {
+        course += 360;
+    }
+    g_gps_driver.setHIL(clock_usec / 1000, loc.lat * 1.0e-7f, loc.lng * 1.0e-7f, alt,
+                        velocity.length(), course, velocity.length(), 10);
+    // setHIL() takes degrees in a float, with a resolution of about a
+    // meter, so set the position exactly
+    g_gps_driver.latitude = loc.lat;
+    g_gps_driver.longitude = loc.lng;
+}
+
+/*
+  the lawnmower pattern of a survey, starting at home
+ */
+static void build_survey(uint8_t passes, float length, float spacing)
+{
+    num_waypoints = 0;
+    for (uint8_t i=0; i<passes && num_waypoints+2 <= BENCH_MAX_WAYPOINTS; i++) {
+        float x0 = (i & 1) ? length : 0;
+        float x1 = (i & 1) ? 0 : length;
+        route[num_waypoints++] = Vector2f(x0, i * spacing);
+        route[num_waypoints++] = Vector2f(x1, i * spacing);
+    }
+}
+
+// distance from the mission path in m
+static float path_distance(const Vector2f &p)
+{
+    float dist = 1.0e9f;
+    for (uint8_t i=1; i<num_waypoints; i++) {
+        Vector2f a = route[i-1];
+        Vector2f ab = route[i] - a;
+        float t = constrain_float(((p - a) * ab) / (ab * ab), 0, 1);
+        dist = min(dist, (a + ab * t - p).length());
+    }
+    return dist;
+}
+
+// the step of a step mission, from the time of each step
+static uint8_t step_number(float step_time, uint8_t num_steps)
+{
+    return min((uint8_t)(mission_time / step_time), num_steps - 1);
+}
+
+// a mission which holds for a time, failing if it flies away
+static bool hold_until(float time, float position_error)
+{
+    if (position_error > BENCH_FLY_AWAY) {
+        mission_failed = true;
+        return true;
+    }
+    return mission_time >= time;
+}
+
+/*
+  start a mission: restart the controllers, and move the clock on so
+  that they see a gap and reset their integrators
+ */
+static void start_mission(void)
+{
+    clock_usec += 10000000UL;
+    AVR_SITL::SITLScheduler::stop_clock(clock_usec);
+    last_gps_usec = 0;
+    mission_time = 0;
+    mission_failed = false;
+    mission_step = 0;
+    nav_mode = NAV_NONE;
+    wind.set(0, 0, 0, bench_seed);
+}
+
+/*
+  copter
+ */
+
+static void copter_update_model(float dt)
+{
+    copter.update(dt, motor_out, wp_nav.get_desired_alt(), wind.update(dt));
+    ahrs.setHil(copter.attitude.x, copter.attitude.y, copter.attitude.z,
+                copter.rates.x, copter.rates.y, copter.rates.z);
+    inertial_nav.set_position_xy(copter.position.x, copter.position.y);
+    inertial_nav.set_velocity_xy(copter.velocity.x, copter.velocity.y);
+    inertial_nav.set_altitude(copter.position.z);
+    inertial_nav.set_velocity_z(copter.velocity.z);
+    update_gps_truth(Vector2f(copter.position.x, copter.position.y) * 0.01f,
+                     copter.position.z * 0.01f,
+                     Vector2f(copter.velocity.x, copter.velocity.y) * 0.01f);
+}
+
+/*
+  the stabilize and rate controllers, as get_stabilize_roll() and
+  run_rate_controllers() run them
+ */
+static void copter_fast_loop(void)
+{
+    ahrs.update();
+
+    if (nav_mode != NAV_NONE) {
+        target_roll = wp_nav.get_desired_roll();
+        target_pitch = wp_nav.get_desired_pitch();
+    }
+
+    int32_t rate_target[3];
+    rate_target[0] = pi_stabilize_roll.kP() * wrap_180_cd(target_roll - ahrs.roll_sensor);
+    rate_target[1] = pi_stabilize_pitch.kP() * wrap_180_cd(target_pitch - ahrs.pitch_sensor);
+    rate_target[2] = pi_stabilize_yaw.kP() * wrap_180_cd(target_yaw - ahrs.yaw_sensor);
+
+    for (uint8_t i=0; i<3; i++) {
+        rate_target[i] = constrain_int32(rate_target[i], -18000, 18000);
+    }
+
+    Vector3f omega = ahrs.get_gyro();
+    int32_t rate_error[3];
+    rate_error[0] = rate_target[0] - (int32_t)(ToDeg(omega.x) * 100);
+    rate_error[1] = rate_target[1] - (int32_t)(ToDeg(omega.y) * 100);
+    rate_error[2] = rate_target[2] - (int32_t)(ToDeg(omega.z) * 100);
+    rate_pids.update(rate_error, G_Dt, false, false);
+    for (uint8_t i=0; i<3; i++) {
+        motor_out[i] = constrain_int32(rate_pids.output(i), -5000, 5000);
+    }
+
+    // the mixer, as set_servos_4() runs it. The model flies the
+    // outputs of the rate controllers, not the motors
+    rc_1.servo_out = motor_out[0];
+    rc_2.servo_out = motor_out[1];
+    rc_4.servo_out = motor_out[2];
+    rc_3.servo_out = COPTER_THROTTLE_CRUISE;
+    motors.output();
+}
+
+static void update_GPS(void)
+{
+    g_gps->update();
+    if (g_gps->new_data) {
+        g_gps->new_data = false;
+        gps_glitch.check_position();
+    }
+    // the GPS task is first in every task table
+    task_done(0);
+}
+
+static void copter_run_nav(void)
+{
+    wp_nav.set_cos_sin_yaw(cosf(ahrs.yaw), sinf(ahrs.yaw), cosf(ahrs.pitch));
+    if (nav_mode == NAV_LOITER) {
+        wp_nav.update_loiter();
+    } else if (nav_mode == NAV_WP) {
+        wp_nav.update_wpnav();
+    }
+    task_done(1);
+}
+
+static const AP_Scheduler::Task copter_tasks[] PROGMEM = {
+    { update_GPS,             COPTER_TICKS(20),    900 },
+    { copter_run_nav,         COPTER_TICKS(10),    400 },
+};
+
+static const char * const copter_task_names[] = {
+    "update_GPS",
+    "run_nav"
+};
+
+static const struct vehicle copter_vehicle = {
+    "copter", COPTER_LOOP_HZ, 300, &copter_scheduler,
+    copter_tasks, copter_task_names, sizeof(copter_tasks)/sizeof(copter_tasks[0]),
+    copter_update_model, copter_fast_loop
+};
+
+static void copter_start(float alt_cm)
+{
+    start_mission();
+    copter.reset(Vector3f(0, 0, alt_cm));
+    target_roll = target_pitch = target_yaw = 0;
+    memset(motor_out, 0, sizeof(motor_out));
+    pid_rate_roll.reset_I();
+    pid_rate_pitch.reset_I();
+    pid_rate_yaw.reset_I();
+    wp_nav.set_desired_alt(alt_cm);
+    copter_update_model(0);
+}
+
+static void copter_hold_start(void)
+{
+    copter_start(1000);
+    wp_nav.init_loiter_target(copter.position, copter.velocity);
+    nav_mode = NAV_LOITER;
+}
+
+static void copter_hover_start(void)
+{
+    copter_hold_start();
+    wind.set(3, 0, 1, bench_seed);
+}
+
+static void copter_loiter_wind_start(void)
+{
+    copter_hold_start();
+    wind.set(8, 45, 3, bench_seed);
+}
+
+static void copter_score_attitude(void)
+{
+    float roll_error = (target_roll - ahrs.roll_sensor) * 0.01f;
+    float pitch_error = (target_pitch - ahrs.pitch_sensor) * 0.01f;
+    add_sample(results.attitude, pythagorous2(roll_error, pitch_error));
+}
+
+static bool copter_hold_update(void)
+{
+    copter_score_attitude();
+    float error = Vector2f(copter.position.x, copter.position.y).length() * 0.01f;
+    add_sample(results.position, error);
+    return hold_until(60, error);
+}
+
+// lean angle steps in centi-degrees, 2 seconds each
+static const int16_t copter_steps[][2] = {
+    { 2000, 0 }, { 0, 0 }, { -2000, 0 }, { 0, 0 },
+    { 0, 2000 }, { 0, 0 }, { 0, -2000 }, { 0, 0 }
+};
+#define COPTER_NUM_STEPS (sizeof(copter_steps)/sizeof(copter_steps[0]))
+
+static void copter_step_start(void)
+{
+    copter_start(1000);
+}
+
+static bool copter_step_update(void)
+{
+    copter_score_attitude();
+    mission_step = step_number(2, COPTER_NUM_STEPS);
+    target_roll = copter_steps[mission_step][0];
+    target_pitch = copter_steps[mission_step][1];
+    return mission_time >= 2 * COPTER_NUM_STEPS;
+}
+
+static Vector3f copter_waypoint(uint8_t i)
+{
+    return Vector3f(route[i].x * 100, route[i].y * 100, 1000);
+}
+
+static void copter_survey_start(void)
+{
+    copter_start(1000);
+    build_survey(10, 60, 15);
+    wp_nav.set_horizontal_velocity(500);
+    waypoint = 1;
+    wp_nav.set_destination(copter_waypoint(waypoint));
+    wp_nav.set_fast_waypoint(true);
+    nav_mode = NAV_WP;
+}
+
+static bool copter_survey_update(void)
+{
+    copter_score_attitude();
+    float error = path_distance(Vector2f(copter.position.x, copter.position.y) * 0.01f);
+    add_sample(results.position, error);
+    if (error > BENCH_FLY_AWAY) {
+        mission_failed = true;
+        return true;
+    }
+    if (wp_nav.reached_destination()) {
+        if (waypoint == num_waypoints-1) {
+            return true;
+        }
+        waypoint++;
+        wp_nav.set_destination(copter_waypoint(waypoint));
+        wp_nav.set_fast_waypoint(waypoint != num_waypoints-1);
+    }
+    return false;
+}
+
+/*
+  plane
+ */
+
+static void plane_update_model(float dt)
+{
+    plane.update(dt, aileron, elevator, wind.update(dt));
+    ahrs.setHil(plane.attitude.x, plane.attitude.y, plane.attitude.z,
+                plane.rates.x, plane.rates.y, plane.rates.z);
+    update_gps_truth(plane.position, plane.altitude, plane.ground_velocity);
+}
+
+/*
+  the roll and pitch controllers, as stabilize_roll() and
+  stabilize_pitch() run them
+ */
+static void plane_fast_loop(void)
+{
+    ahrs.update();
+    aileron = rollController.get_servo_out(nav_roll_cd - ahrs.roll_sensor, 1.0f, false);
+    elevator = pitchController.get_servo_out(nav_pitch_cd - ahrs.pitch_sensor, 1.0f, false);
+}
+
+static void plane_navigate(void)
+{
+    if (ahrs.get_position(current_loc)) {
+        if (nav_mode == NAV_WP) {
+            L1_controller.update_waypoint(prev_WP, next_WP);
+        } else if (nav_mode == NAV_LOITER) {
+            L1_controller.update_loiter(next_WP, PLANE_LOITER_RADIUS, 1);
+        }
+    }
+    if (nav_mode != NAV_NONE) {
+        nav_roll_cd = constrain_int32(L1_controller.nav_roll_cd(), -4500, 4500);
+    }
+    task_done(1);
+}
+
+static const AP_Scheduler::Task plane_tasks[] PROGMEM = {
+    { update_GPS,             5,   4000 },
+    { plane_navigate,         5,   4800 },
+};
+
+static const char * const plane_task_names[] = {
+    "update_GPS",
+    "navigate"
+};
+
+static const struct vehicle plane_vehicle = {
+    "plane", 50, 1000, &plane_scheduler,
+    plane_tasks, plane_task_names, sizeof(plane_tasks)/sizeof(plane_tasks[0]),
+    plane_update_model, plane_fast_loop
+};
+
+static void plane_start(void)
+{
+    start_mission();
+    plane.reset(0, 0, 0, PLANE_AIRSPEED);
+    nav_roll_cd = nav_pitch_cd = 0;
+    aileron = elevator = 0;
+    rollController.reset_I();
+    pitchController.reset_I();
+    plane_update_model(0);
+    g_gps->update();
+}
+
+static void plane_score_attitude(void)
+{
+    float roll_error = (nav_roll_cd - ahrs.roll_sensor) * 0.01f;
+    float pitch_error = (nav_pitch_cd - ahrs.pitch_sensor) * 0.01f;
+    add_sample(results.attitude, pythagorous2(roll_error, pitch_error));
+}
+
+// bank and pitch steps in centi-degrees, 3 seconds each
+static const int16_t plane_steps[][2] = {
+    { 3000, 0 }, { 0, 0 }, { -3000, 0 }, { 0, 0 },
+    { 0, 1000 }, { 0, 0 }, { 0, -1000 }, { 0, 0 }
+};
+#define PLANE_NUM_STEPS (sizeof(plane_steps)/sizeof(plane_steps[0]))
+
+static bool plane_step_update(void)
+{
+    plane_score_attitude();
+    mission_step = step_number(3, PLANE_NUM_STEPS);
+    nav_roll_cd = plane_steps[mission_step][0];
+    nav_pitch_cd = plane_steps[mission_step][1];
+    return mission_time >= 3 * PLANE_NUM_STEPS;
+}
+
+static void plane_survey_start(void)
+{
+    plane_start();
+    wind.set(4, 90, 1, bench_seed);
+    build_survey(6, 500, 150);
+    waypoint = 1;
+    prev_WP = local_location(route[0]);
+    next_WP = local_location(route[1]);
+    nav_mode = NAV_WP;
+}
+
+static bool plane_survey_update(void)
+{
+    plane_score_attitude();
+    float error = path_distance(plane.position);
+    add_sample(results.position, error);
+    if (error > BENCH_FLY_AWAY * 3) {
+        mission_failed = true;
+        return true;
+    }
+    // as verify_nav_wp() in ArduPlane
+    struct Location loc = local_location(plane.position);
+    if (get_distance(loc, next_WP) <= L1_controller.turn_distance(PLANE_WP_RADIUS) ||
+        location_passed_point(loc, prev_WP, next_WP)) {
+        if (waypoint == num_waypoints-1) {
+            return true;
+        }
+        waypoint++;
+        prev_WP = next_WP;
+        next_WP = local_location(route[waypoint]);
+    }
+    return false;
+}
+
+static void plane_loiter_wind_start(void)
+{
+    plane_start();
+    wind.set(8, 45, 2, bench_seed);
+    next_WP = local_location(Vector2f(PLANE_LOITER_RADIUS, 0));
+    nav_mode = NAV_LOITER;
+}
+
+static bool plane_loiter_wind_update(void)
+{
+    plane_score_attitude();
+    float error = fabsf((plane.position - Vector2f(PLANE_LOITER_RADIUS, 0)).length() - PLANE_LOITER_RADIUS);
+    // score the circle once the plane has settled on it
+    if (mission_time >= 30) {
+        add_sample(results.position, error);
+    }
+    return hold_until(150, error);
+}
+
+/*
+  rover
+ */
+
+static void rover_update_model(float dt)
+{
+    rover.update(dt, nav_steer_cd);
+    ahrs.setHil(0, 0, rover.yaw, 0, 0, rover.yaw_rate);
+    update_gps_truth(rover.position, 0, rover.ground_velocity);
+}
+
+static void rover_fast_loop(void)
+{
+    ahrs.update();
+}
+
+/*
+  the bearing to the next waypoint with the crosstrack correction, as
+  navigate() and update_crosstrack() in APMrover2
+ */
+static void rover_navigate(void)
+{
+    if (nav_mode == NAV_WP && ahrs.get_position(current_loc)) {
+        wp_distance = get_distance(current_loc, next_WP);
+        target_bearing = get_bearing_cd(current_loc, next_WP);
+        nav_bearing = target_bearing;
+        if (abs(wrap_180_cd(target_bearing - crosstrack_bearing)) < 4500 && wp_distance >= 3.0f) {
+            float crosstrack_error = sinf(radians((target_bearing - crosstrack_bearing) * 0.01f)) * wp_distance;
+            nav_bearing += constrain_float(crosstrack_error * ROVER_XTRACK_GAIN, -ROVER_XTRACK_ANGLE, ROVER_XTRACK_ANGLE);
+            nav_bearing = wrap_360_cd(nav_bearing);
+        }
+    }
+    task_done(1);
+}
+
+/*
+  the heading controller, as calc_bearing_error() and calc_nav_steer()
+ */
+static void rover_steer(void)
+{
+    int32_t bearing_error_cd = wrap_180_cd(nav_bearing - ahrs.yaw_sensor);
+    bearing_error_cd = bearing_filter.filter(bearing_error_cd);
+
+    float ground_speed = g_gps->ground_speed_cm * 0.01f;
+    float nav_gain_scaler = ground_speed < 0.01f ? 1.4f : ROVER_SPEED / ground_speed;
+    nav_gain_scaler = constrain_float(nav_gain_scaler, 0.2f, 1.4f);
+    nav_steer_cd = pidNavSteer.get_pid_4500(bearing_error_cd, nav_gain_scaler);
+    task_done(2);
+}
+
+static const AP_Scheduler::Task rover_tasks[] PROGMEM = {
+    { update_GPS,             5,   2500 },
+    { rover_navigate,         5,   1600 },
+    { rover_steer,            1,   1000 },
+};
+
+static const char * const rover_task_names[] = {
+    "update_GPS",
+    "navigate",
+    "steer"
+};
+
+static const struct vehicle rover_vehicle = {
+    "rover", 50, 1000, &rover_scheduler,
+    rover_tasks, rover_task_names, sizeof(rover_tasks)/sizeof(rover_tasks[0]),
+    rover_update_model, rover_fast_loop
+};
+
+static void rover_start(void)
+{
+    start_mission();
+    rover.reset(0, 0, 0, ROVER_SPEED);
+    nav_bearing = 0;
+    nav_steer_cd = 0;
+    pidNavSteer.reset_I();
+    rover_update_model(0);
+    g_gps->update();
+}
+
+static void rover_score_heading(void)
+{
+    add_sample(results.attitude, wrap_180_cd(nav_bearing - ahrs.yaw_sensor) * 0.01f);
+}
+
+// heading steps in centi-degrees, 8 seconds each
+static const int16_t rover_steps[] = { 9000, 0, -9000, 0, 4500, 0, -4500, 0 };
+#define ROVER_NUM_STEPS (sizeof(rover_steps)/sizeof(rover_steps[0]))
+
+static bool rover_step_update(void)
+{
+    rover_score_heading();
+    mission_step = step_number(8, ROVER_NUM_STEPS);
+    nav_bearing = wrap_360_cd(rover_steps[mission_step]);
+    return mission_time >= 8 * ROVER_NUM_STEPS;
+}
+
+static void rover_survey_start(void)
+{
+    rover_start();
+    build_survey(8, 40, 8);
+    waypoint = 1;
+    prev_WP = local_location(route[0]);
+    next_WP = local_location(route[1]);
+    crosstrack_bearing = get_bearing_cd(prev_WP, next_WP);
+    nav_mode = NAV_WP;
+}
+
+static bool rover_survey_update(void)
+{
+    rover_score_heading();
+    float error = path_distance(rover.position);
+    add_sample(results.position, error);
+    if (error > BENCH_FLY_AWAY) {
+        mission_failed = true;
+        return true;
+    }
+    // as verify_nav_wp() in APMrover2
+    struct Location loc = local_location(rover.position);
+    if (get_distance(loc, next_WP) <= ROVER_WP_RADIUS ||
+        location_passed_point(loc, prev_WP, next_WP)) {
+        if (waypoint == num_waypoints-1) {
+            return true;
+        }
+        waypoint++;
+        prev_WP = next_WP;
+        next_WP = local_location(route[waypoint]);
+        crosstrack_bearing = get_bearing_cd(prev_WP, next_WP);
+    }
+    return false;
+}
+
+static const struct mission missions[] = {
+    { &copter_vehicle, "hover",       copter_hover_start,       copter_hold_update,       90 },
+    { &copter_vehicle, "step",        copter_step_start,        copter_step_update,       30 },
+    { &copter_vehicle, "survey",      copter_survey_start,      copter_survey_update,    600 },
+    { &copter_vehicle, "loiter_wind", copter_loiter_wind_start, copter_hold_update,       90 },
+    { &plane_vehicle,  "step",        plane_start,              plane_step_update,        40 },
+    { &plane_vehicle,  "survey",      plane_survey_start,       plane_survey_update,     600 },
+    { &plane_vehicle,  "loiter_wind", plane_loiter_wind_start,  plane_loiter_wind_update, 200 },
+    { &rover_vehicle,  "step",        rover_start,              rover_step_update,        80 },
+    { &rover_vehicle,  "survey",      rover_survey_start,       rover_survey_update,     600 },
+};
+#define NUM_MISSIONS (sizeof(missions)/sizeof(missions[0]))
+
+/*
+  run one main loop of a vehicle, with the clock and the model at
+  loop_start
+ */
+static void run_loop(const struct vehicle &v, uint32_t period_usec)
+{
+    loop_start_usec = clock_usec;
+    loop_start_cpu_nsec = cpu_nsec();
+    current_tasks = v.tasks;
+
+    v.fast_loop();
+    sync_clock();
+
+    // as the fast loop of the vehicles, with some time kept back
+    v.scheduler->tick();
+    uint32_t used = clock_usec - loop_start_usec;
+    if (used + v.reserve_usec < period_usec) {
+        v.scheduler->run(period_usec - used - v.reserve_usec);
+    } else {
+        v.scheduler->run(0);
+    }
+    sync_clock();
+
+    add_sample(results.loop_time, clock_usec - loop_start_usec);
+    results.loops++;
+}
+
+// the CPU time of the main loops over the time of the mission
+static float controller_load(void)
+{
+    return mission_time > 0 ? results.loop_time.sum / (mission_time * 1.0e6f) : 0;
+}
+
+static bool fly_mission(const struct mission &m)
+{
+    const struct vehicle &v = *m.vehicle;
+    uint32_t period_usec = 1000000UL / v.loop_hz;
+
+    memset(&results, 0, sizeof(results));
+    m.start();
+
+    uint64_t next_loop = clock_usec + period_usec;
+    uint64_t last_loop = clock_usec;
+    bool done = false;
+    while (!done && mission_time < m.time_max) {
+        // a loop which ran past the period starts the next one late
+        uint64_t start = max(next_loop, clock_usec);
+        next_loop += period_usec;
+        if (results.loops != 0) {
+            add_sample(results.jitter, (float)(start - last_loop) - period_usec);
+        }
+        G_Dt = (start - last_loop) * 1.0e-6f;
+        last_loop = start;
+        clock_usec = start;
+        AVR_SITL::SITLScheduler::stop_clock(clock_usec);
+
+        v.update_model(G_Dt);
+        run_loop(v, period_usec);
+
+        mission_time += G_Dt;
+        done = m.update();
+    }
+    return done && !mission_failed;
+}
+
+// the RMS and maximum of a score, or null without samples
+static void print_rms_max(FILE *f, const char *name, const char *units, const struct stats &s)
+{
+    if (s.count == 0) {
+        fprintf(f, "\"%s_rms_%s\": null, \"%s_max_%s\": null", name, units, name, units);
+    } else {
+        fprintf(f, "\"%s_rms_%s\": %.4f, \"%s_max_%s\": %.4f",
+                name, units, sqrtf(s.sum_sq / s.count), name, units, s.max);
+    }
+}
+
+static void print_result(FILE *f, const struct mission &m, bool completed, bool first)
+{
+    const struct vehicle &v = *m.vehicle;
+    uint32_t loops = max(results.loops, 1UL);
+
+    fprintf(f, "%s\n    {\"vehicle\": \"%s\", \"mission\": \"%s\", \"completed\": %s, \"time_s\": %.2f,\n     ",
+            first ? "" : ",", v.name, m.name, completed ? "true" : "false", mission_time);
+    print_rms_max(f, "attitude", "deg", results.attitude);
+    fprintf(f, ",\n     ");
+    print_rms_max(f, "position", "m", results.position);
+    fprintf(f, ",\n     \"controller_load\": %.6f, \"loop_avg_us\": %.1f, \"loop_max_us\": %.1f,\n     ",
+            controller_load(),
+            results.loop_time.sum / loops,
+            results.loop_time.max);
+    print_rms_max(f, "jitter", "us", results.jitter);
+    fprintf(f, ",\n     \"tasks\": [");
+    for (uint8_t i=0; i<v.num_tasks; i++) {
+        const struct task_stats &t = results.tasks[i];
+        fprintf(f, "%s\n       {\"name\": \"%s\", \"runs\": %lu, \"avg_us\": %.1f, \"max_us\": %lu, \"overruns\": %lu}",
+                i == 0 ? "" : ",", v.task_names[i], (unsigned long)t.runs,
+                t.runs ? t.total_usec / (float)t.runs : 0.0f,
+                (unsigned long)t.max_usec, (unsigned long)t.overruns);
+    }
+    fprintf(f, "]}");
+}
+
+void setup(void)
+{
+    // the SITL timer would run in the middle of the timed code
+    struct itimerval it;
+    memset(&it, 0, sizeof(it));
+    setitimer(ITIMER_REAL, &it, NULL);
+
+    cpu_scale = env_float("BENCH_CPU_SCALE", 1);
+    const char *seed = getenv("BENCH_SEED");
+    bench_seed = seed ? strtoul(seed, NULL, 0) : 1;
+
+    AVR_SITL::SITLScheduler::stop_clock(clock_usec);
+
+    ins.init(AP_InertialSensor::COLD_START,
+             AP_InertialSensor::RATE_100HZ);
+    ahrs.init();
+    g_gps->init(NULL);
+    inertial_nav.init();
+
+    // CMAC, the usual SITL home
+    home.lat = -353632620;
+    home.lng = 1491652370;
+
+    aparm.airspeed_min.set(12);
+    aparm.airspeed_max.set(25);
+
+    copter_scheduler.init(copter_tasks, sizeof(copter_tasks)/sizeof(copter_tasks[0]));
+    plane_scheduler.init(plane_tasks, sizeof(plane_tasks)/sizeof(plane_tasks[0]));
+    rover_scheduler.init(rover_tasks, sizeof(rover_tasks)/sizeof(rover_tasks[0]));
+
+    // a quad X, armed, with the channel setup of ArduCopter
+    rc_1.set_angle(4500);
+    rc_2.set_angle(4500);
+    rc_3.set_range(130, 1000);
+    rc_4.set_angle(4500);
+    motors.set_update_rate(490);
+    motors.set_frame_orientation(AP_MOTORS_X_FRAME);
+    motors.set_min_throttle(130);
+    motors.Init();
+    motors.enable();
+    motors.armed(true);
+}
+
+void loop(void)
+{
+    const char *vehicle = getenv("BENCH_VEHICLE");
+    const char *mission = getenv("BENCH_MISSION");
+    const char *fname = getenv("BENCH_JSON");
+    if (fname == NULL) {
+        fname = "benchmark.json";
+    }
+    FILE *f = strcmp(fname, "-") == 0 ? stdout : fopen(fname, "w");
+    if (f == NULL) {
+        hal.console->printf("Unable to open %s\n", fname);
+        exit(1);
+    }
+
+    fprintf(f, "{\"seed\": %lu, \"cpu_scale\": %.3f, \"missions\": [",
+            (unsigned long)bench_seed, cpu_scale);
+
+    bool first = true;
+    bool failed = false;
+    for (uint8_t i=0; i<NUM_MISSIONS; i++) {
+        const struct mission &m = missions[i];
+        if ((vehicle && strcmp(vehicle, m.vehicle->name) != 0) ||
+            (mission && strcmp(mission, m.name) != 0)) {
+            continue;
+        }
+        bool completed = fly_mission(m);
+        print_result(f, m, completed, first);
+        first = false;
+        failed |= !completed;
+
+        hal.console->printf("%-6s %-11s time %6.1f s  attitude %.2f deg  position %.2f m  controller load %.5f%s\n",
+                            m.vehicle->name, m.name, mission_time,
+                            results.attitude.count ? sqrtf(results.attitude.sum_sq / results.attitude.count) : 0,
+                            results.position.count ? sqrtf(results.position.sum_sq / results.position.count) : 0,
+                            controller_load(),
+                            completed ? "" : "  (did not complete)");
+    }
+    fprintf(f, "\n]}\n");
+    if (f != stdout) {
+        fclose(f);
+    }
+    exit(failed ? 1 : 0);
+}
+
+#else
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("Benchmark is only supported on SITL"));
+}
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif
+
+AP_HAL_MAIN();
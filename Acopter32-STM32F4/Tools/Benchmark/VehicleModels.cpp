@@ -0,0 +1,133 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <AP_Common.h>
+#include <AP_Math.h>
+
+#include "VehicleModels.h"
+
+#define GUST_TC             2.0f        // time constant of the gusts in seconds
+
+#define COPTER_MOTOR_TC     0.03f       // time constant of the motors in seconds
+#define COPTER_ROLL_ACCEL   0.02f       // roll and pitch acceleration in rad/s/s per unit of motor output
+#define COPTER_YAW_ACCEL    0.005f      // yaw acceleration in rad/s/s per unit of motor output
+#define COPTER_RATE_DAMP    0.5f        // damping of the body rates, per second
+#define COPTER_DRAG         0.1f        // drag, as a fraction of the airspeed per second
+#define COPTER_ALT_TC       1.0f        // time constant of the altitude controller in seconds
+
+#define PLANE_SURFACE_ACCEL 0.006f      // roll and pitch acceleration in rad/s/s per centi-degree of surface
+#define PLANE_RATE_DAMP     6.0f        // damping of the roll and pitch rates, per second
+
+#define ROVER_SERVO_TC      0.1f        // time constant of the steering servo in seconds
+#define ROVER_MAX_STEER     25.0f       // wheel angle at full lock in degrees
+#define ROVER_WHEELBASE     1.0f        // in m
+
+BenchWind::BenchWind() :
+    _gust(0)
+{
+}
+
+void BenchWind::set(float speed, float direction_deg, float gust, uint32_t seed)
+{
+    // the wind blows from direction_deg
+    float direction = ToRad(direction_deg);
+    _mean = Vector2f(-cosf(direction), -sinf(direction)) * speed;
+    _gust = gust;
+    _gust_vel = Vector2f(0, 0);
+    _wind = _mean;
+    _random.set_seed(seed, 1);
+}
+
+const Vector2f &BenchWind::update(float dt)
+{
+    if (_gust > 0) {
+        // rand_float() is uniform in -1 to 1, with a variance of 1/3
+        float k = _gust * safe_sqrt(6.0f * dt / GUST_TC);
+        _gust_vel.x += -_gust_vel.x * dt / GUST_TC + k * _random.rand_float();
+        _gust_vel.y += -_gust_vel.y * dt / GUST_TC + k * _random.rand_float();
+    }
+    _wind = _mean + _gust_vel;
+    return _wind;
+}
+
+void CopterModel::reset(const Vector3f &_position)
+{
+    position = _position;
+    velocity = Vector3f(0, 0, 0);
+    attitude = Vector3f(0, 0, 0);
+    rates = Vector3f(0, 0, 0);
+    _motor = Vector3f(0, 0, 0);
+}
+
+void CopterModel::update(float dt, const int32_t motor_out[3], float target_alt, const Vector2f &wind)
+{
+    Vector3f out(motor_out[0], motor_out[1], motor_out[2]);
+    _motor += (out - _motor) * (dt / COPTER_MOTOR_TC);
+
+    Vector3f accel(_motor.x * COPTER_ROLL_ACCEL,
+                   _motor.y * COPTER_ROLL_ACCEL,
+                   _motor.z * COPTER_YAW_ACCEL);
+    rates += (accel - rates * COPTER_RATE_DAMP) * dt;
+    attitude += rates * dt;
+    attitude.z = wrap_PI(attitude.z);
+
+    // lean forward to accelerate forward, and right to go right
+    float forward = -GRAVITY_MSS * 100 * tanf(attitude.y);
+    float right = GRAVITY_MSS * 100 * tanf(attitude.x);
+    float cos_yaw = cosf(attitude.z);
+    float sin_yaw = sinf(attitude.z);
+    Vector2f airspeed(velocity.x - wind.x * 100, velocity.y - wind.y * 100);
+    velocity.x += (forward * cos_yaw - right * sin_yaw - airspeed.x * COPTER_DRAG) * dt;
+    velocity.y += (forward * sin_yaw + right * cos_yaw - airspeed.y * COPTER_DRAG) * dt;
+    velocity.z = (target_alt - position.z) / COPTER_ALT_TC;
+    position += velocity * dt;
+}
+
+void PlaneModel::reset(float north, float east, float heading_deg, float _airspeed)
+{
+    position = Vector2f(north, east);
+    altitude = 100;
+    attitude = Vector3f(0, 0, wrap_PI(ToRad(heading_deg)));
+    rates = Vector3f(0, 0, 0);
+    airspeed = _airspeed;
+    ground_velocity = Vector2f(cosf(attitude.z), sinf(attitude.z)) * airspeed;
+}
+
+void PlaneModel::update(float dt, int32_t aileron, int32_t elevator, const Vector2f &wind)
+{
+    rates.x += (aileron * PLANE_SURFACE_ACCEL - rates.x * PLANE_RATE_DAMP) * dt;
+    rates.y += (elevator * PLANE_SURFACE_ACCEL - rates.y * PLANE_RATE_DAMP) * dt;
+
+    // a coordinated turn at the bank angle, with the body rates of
+    // the turn added to the roll and pitch rates
+    float roll = attitude.x, pitch = attitude.y;
+    float turn_rate = GRAVITY_MSS * tanf(constrain_float(roll, -1.4f, 1.4f)) / airspeed;
+    rates.z = turn_rate * cosf(pitch) * cosf(roll);
+    attitude.x = wrap_PI(roll + rates.x * dt);
+    attitude.y = constrain_float(pitch + (rates.y * cosf(roll) - rates.z * sinf(roll)) * dt, -1.4f, 1.4f);
+    attitude.z = wrap_PI(attitude.z + turn_rate * dt);
+
+    Vector2f air_velocity = Vector2f(cosf(attitude.z), sinf(attitude.z)) * airspeed * cosf(pitch);
+    ground_velocity = air_velocity + wind;
+    position += ground_velocity * dt;
+    altitude += airspeed * sinf(pitch) * dt;
+}
+
+void RoverModel::reset(float north, float east, float heading_deg, float _speed)
+{
+    position = Vector2f(north, east);
+    yaw = wrap_PI(ToRad(heading_deg));
+    yaw_rate = 0;
+    speed = _speed;
+    ground_velocity = Vector2f(cosf(yaw), sinf(yaw)) * speed;
+    _wheel_angle = 0;
+}
+
+void RoverModel::update(float dt, int32_t steering)
+{
+    float demand = ToRad(constrain_float(steering / 4500.0f, -1, 1) * ROVER_MAX_STEER);
+    _wheel_angle += (demand - _wheel_angle) * dt / ROVER_SERVO_TC;
+    yaw_rate = speed * tanf(_wheel_angle) / ROVER_WHEELBASE;
+    yaw = wrap_PI(yaw + yaw_rate * dt);
+    ground_velocity = Vector2f(cosf(yaw), sinf(yaw)) * speed;
+    position += ground_velocity * dt;
+}
@@ -0,0 +1,124 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __VEHICLEMODELS_H__
+#define __VEHICLEMODELS_H__
+
+/*
+  simple models of a copter, a plane and a rover for the benchmark
+
+  The models are just detailed enough to close the loop around the
+  real controllers: each one turns the controller outputs into motion
+  with the lags and damping of a typical small vehicle. They are not
+  a flight simulator, and the scores are only comparable between
+  builds flying the same models.
+
+  Positions are north and east of home, velocities are north and
+  east, and angles are in radians unless the name says otherwise.
+ */
+
+#include <AP_Common.h>
+#include <AP_Math.h>
+#include <SITL_Random.h>
+
+/*
+  a steady wind with gusts. The gusts are random, with the spectrum
+  of a first order filter, and repeat for the same seed
+ */
+class BenchWind
+{
+public:
+    BenchWind();
+
+    // the mean wind speed in m/s, the direction it blows from in
+    // degrees and the RMS of the gusts in m/s
+    void set(float speed, float direction_deg, float gust, uint32_t seed);
+
+    // advance by dt seconds, returning the wind velocity in m/s
+    const Vector2f &update(float dt);
+
+    const Vector2f &get(void) const { return _wind; }
+
+private:
+    Vector2f _mean;
+    Vector2f _gust_vel;
+    Vector2f _wind;
+    float _gust;
+    SITL_Random _random;
+};
+
+/*
+  a multicopter. The motor outputs of the roll, pitch and yaw rate
+  controllers give an angular acceleration after a motor lag, the
+  lean angles give a horizontal acceleration against the drag of the
+  air, and the altitude follows the target of the altitude controller
+  with a first order lag
+ */
+class CopterModel
+{
+public:
+    // start hovering at position, in cm
+    void reset(const Vector3f &position);
+
+    // advance by dt seconds, with the outputs of the rate
+    // controllers, the target altitude in cm and the wind in m/s
+    void update(float dt, const int32_t motor_out[3], float target_alt, const Vector2f &wind);
+
+    Vector3f position;      // cm
+    Vector3f velocity;      // cm/s
+    Vector3f attitude;      // roll, pitch and yaw
+    Vector3f rates;         // body rates in rad/s
+
+private:
+    Vector3f _motor;        // lagged motor outputs
+};
+
+/*
+  a plane at a constant airspeed. The aileron and elevator give roll
+  and pitch accelerations against the damping of the wings, and the
+  bank angle gives a coordinated turn
+ */
+class PlaneModel
+{
+public:
+    // start in level flight at north and east in m, on heading in
+    // degrees at airspeed in m/s
+    void reset(float north, float east, float heading_deg, float airspeed);
+
+    // advance by dt seconds with the aileron and elevator in
+    // centi-degrees and the wind in m/s
+    void update(float dt, int32_t aileron, int32_t elevator, const Vector2f &wind);
+
+    Vector2f position;      // north and east in m
+    float altitude;         // m
+    Vector2f ground_velocity; // m/s
+    Vector3f attitude;      // roll, pitch and yaw
+    Vector3f rates;         // body rates in rad/s
+    float airspeed;         // m/s
+};
+
+/*
+  a rover at a constant speed, steering with the front wheels. The
+  wheels follow the steering output with a servo lag
+ */
+class RoverModel
+{
+public:
+    // start at north and east in m, on heading in degrees at speed
+    // in m/s
+    void reset(float north, float east, float heading_deg, float speed);
+
+    // advance by dt seconds with the steering in centi-degrees, where
+    // 4500 is full right lock
+    void update(float dt, int32_t steering);
+
+    Vector2f position;      // north and east in m
+    Vector2f ground_velocity; // m/s
+    float yaw;
+    float yaw_rate;         // rad/s
+    float speed;            // m/s
+
+private:
+    float _wheel_angle;
+};
+
+#endif // __VEHICLEMODELS_H__
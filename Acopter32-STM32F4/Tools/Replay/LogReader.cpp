@@ -0,0 +1,360 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <DataFlash.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LogReader.h"
+
+extern const AP_HAL::HAL& hal;
+
+LogReader::LogReader(AP_InertialSensor_HIL &ins, AP_Baro_HIL &baro, AP_Compass_HIL &compass, GPS *&gps) :
+    num_params(0),
+    _ins(ins),
+    _baro(baro),
+    _compass(compass),
+    _gps(gps),
+    _fd(NULL),
+    _have_baro(false),
+    _have_ctun(false),
+    _have_gps_fix(false)
+{
+    memset(&att, 0, sizeof(att));
+    memset(&inav, 0, sizeof(inav));
+    memset(_have_format, 0, sizeof(_have_format));
+}
+
+bool LogReader::open_log(const char *logfile)
+{
+    _fd = fopen(logfile, "rb");
+    return _fd != NULL;
+}
+
+/*
+  return a pointer to the field with the given label in a message, and
+  its format character
+ */
+const uint8_t *LogReader::_field_ptr(const struct log_Format &f, const uint8_t *msg,
+                                     const char *label, char &type) const
+{
+    char labels[sizeof(f.labels)+1];
+    memcpy(labels, f.labels, sizeof(f.labels));
+    labels[sizeof(f.labels)] = 0;
+
+    uint8_t ofs = 0;
+    uint8_t len = strlen(label);
+    const char *p = labels;
+    for (uint8_t i=0; i<sizeof(f.format) && f.format[i] != 0; i++) {
+        const char *end = strchr(p, ',');
+        uint8_t label_len = end ? end - p : strlen(p);
+        if (label_len == len && strncmp(p, label, len) == 0) {
+            type = f.format[i];
+            return msg + ofs;
+        }
+        switch (f.format[i]) {
+        case 'b':
+        case 'B':
+        case 'M':
+            ofs += 1;
+            break;
+        case 'h':
+        case 'H':
+        case 'c':
+        case 'C':
+            ofs += 2;
+            break;
+        case 'i':
+        case 'I':
+        case 'e':
+        case 'E':
+        case 'L':
+        case 'f':
+        case 'n':
+            ofs += 4;
+            break;
+        case 'N':
+            ofs += 16;
+            break;
+        case 'Z':
+            ofs += 64;
+            break;
+        default:
+            // unknown format character, so later offsets are unknown
+            return NULL;
+        }
+        if (end == NULL) {
+            break;
+        }
+        p = end + 1;
+    }
+    return NULL;
+}
+
+/*
+  get a numeric field as a float
+ */
+bool LogReader::_field(const struct log_Format &f, const uint8_t *msg,
+                       const char *label, float &value) const
+{
+    char type;
+    const uint8_t *p = _field_ptr(f, msg, label, type);
+    if (p == NULL) {
+        return false;
+    }
+    if (type == 'f') {
+        memcpy(&value, p, sizeof(value));
+        return true;
+    }
+    int32_t v;
+    if (!_field(f, msg, label, v)) {
+        return false;
+    }
+    value = v;
+    return true;
+}
+
+/*
+  get an integer field as an int32_t. Unsigned 32 bit fields above
+  INT32_MAX wrap
+ */
+bool LogReader::_field(const struct log_Format &f, const uint8_t *msg,
+                       const char *label, int32_t &value) const
+{
+    char type;
+    const uint8_t *p = _field_ptr(f, msg, label, type);
+    if (p == NULL) {
+        return false;
+    }
+    switch (type) {
+    case 'b': {
+        int8_t v;
+        memcpy(&v, p, sizeof(v));
+        value = v;
+        return true;
+    }
+    case 'B':
+    case 'M':
+        value = *p;
+        return true;
+    case 'h':
+    case 'c': {
+        int16_t v;
+        memcpy(&v, p, sizeof(v));
+        value = v;
+        return true;
+    }
+    case 'H':
+    case 'C': {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        value = v;
+        return true;
+    }
+    case 'i':
+    case 'I':
+    case 'e':
+    case 'E':
+    case 'L':
+        memcpy(&value, p, sizeof(value));
+        return true;
+    case 'f': {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        value = v;
+        return true;
+    }
+    }
+    return false;
+}
+
+/*
+  set a parameter from the log, so the replayed estimators use the
+  same gains as the vehicle did
+ */
+void LogReader::_process_parm(const struct log_Format &f, const uint8_t *msg)
+{
+    char type;
+    const uint8_t *p = _field_ptr(f, msg, "Name", type);
+    float value;
+    if (p == NULL || type != 'N' || !_field(f, msg, "Value", value)) {
+        return;
+    }
+    char name[17];
+    memcpy(name, p, 16);
+    name[16] = 0;
+
+    enum ap_var_type var_type;
+    AP_Param *vp = AP_Param::find(name, &var_type);
+    if (vp == NULL) {
+        return;
+    }
+    AP_Param::set_value(var_type, (void *)vp, value);
+    num_params++;
+}
+
+void LogReader::_process_imu(const struct log_Format &f, const uint8_t *msg)
+{
+    Vector3f gyro, accel;
+    if (!_field(f, msg, "GyrX", gyro.x) ||
+        !_field(f, msg, "GyrY", gyro.y) ||
+        !_field(f, msg, "GyrZ", gyro.z) ||
+        !_field(f, msg, "AccX", accel.x) ||
+        !_field(f, msg, "AccY", accel.y) ||
+        !_field(f, msg, "AccZ", accel.z)) {
+        return;
+    }
+    _ins.set_gyro(gyro);
+    _ins.set_accel(accel);
+}
+
+void LogReader::_process_gps(const struct log_Format &f, const uint8_t *msg)
+{
+    int32_t status, time, nsats, lat, lng, alt, speed, course;
+    if (!_field(f, msg, "Status", status) ||
+        !_field(f, msg, "Time", time) ||
+        !_field(f, msg, "NSats", nsats) ||
+        !_field(f, msg, "Lat", lat) ||
+        !_field(f, msg, "Lng", lng) ||
+        !_field(f, msg, "Alt", alt) ||
+        !_field(f, msg, "Spd", speed) ||
+        !_field(f, msg, "GCrs", course)) {
+        return;
+    }
+    if (status < GPS::GPS_OK_FIX_3D) {
+        return;
+    }
+    _gps->setHIL(time, lat*1.0e-7f, lng*1.0e-7f, alt*0.01f,
+                 speed*0.01f, course*0.01f, 0, nsats);
+    // setHIL() goes through a float, which loses precision, so
+    // use the logged position directly
+    _gps->latitude = lat;
+    _gps->longitude = lng;
+    _gps->update();
+    _have_gps_fix = true;
+}
+
+void LogReader::_process_mag(const struct log_Format &f, const uint8_t *msg)
+{
+    Vector3f mag, ofs;
+    if (!_field(f, msg, "MagX", mag.x) ||
+        !_field(f, msg, "MagY", mag.y) ||
+        !_field(f, msg, "MagZ", mag.z) ||
+        !_field(f, msg, "OfsX", ofs.x) ||
+        !_field(f, msg, "OfsY", ofs.y) ||
+        !_field(f, msg, "OfsZ", ofs.z)) {
+        return;
+    }
+    // the logged field includes the offsets, which read() adds back
+    _compass.set_offsets(ofs);
+    _compass.setHIL(mag - ofs);
+    _compass.read();
+}
+
+void LogReader::_process_baro_alt(float alt_cm)
+{
+    if (!_have_baro) {
+        // the logged altitude is already relative to the ground, so
+        // calibrate the ground level at zero
+        _baro.setHIL(0);
+        _baro.read();
+        _baro.update_calibration();
+        _have_baro = true;
+    }
+    _baro.setHIL(alt_cm * 0.01f);
+    _baro.read();
+}
+
+void LogReader::_process_att(const struct log_Format &f, const uint8_t *msg)
+{
+    _field(f, msg, "Roll", att.roll);
+    _field(f, msg, "Pitch", att.pitch);
+    _field(f, msg, "Yaw", att.yaw);
+}
+
+void LogReader::_process_inav(const struct log_Format &f, const uint8_t *msg)
+{
+    _field(f, msg, "IAlt", inav.alt);
+    _field(f, msg, "IClb", inav.climb_rate);
+    _field(f, msg, "GLat", inav.gps_lat);
+    _field(f, msg, "GLng", inav.gps_lng);
+    _field(f, msg, "ILat", inav.lat);
+    _field(f, msg, "ILng", inav.lng);
+
+    float balt;
+    if (!_have_ctun && _field(f, msg, "BAlt", balt)) {
+        // no CTUN messages, so use the slower INAV baro altitude
+        _process_baro_alt(balt);
+    }
+}
+
+bool LogReader::update(char type[5])
+{
+    uint8_t hdr[3];
+    if (fread(hdr, 3, 1, _fd) != 1) {
+        return false;
+    }
+    if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
+        // resynchronise on the next header byte
+        fseek(_fd, -2, SEEK_CUR);
+        type[0] = 0;
+        return true;
+    }
+
+    if (hdr[2] == LOG_FORMAT_MSG) {
+        struct log_Format f;
+        memcpy(&f, hdr, 3);
+        if (fread(&f.type, sizeof(f)-3, 1, _fd) != 1) {
+            return false;
+        }
+        memcpy(&_formats[f.type], &f, sizeof(f));
+        _have_format[f.type] = true;
+        strcpy(type, "FMT");
+        return true;
+    }
+
+    if (!_have_format[hdr[2]]) {
+        // can't know the length of an unknown message, so skip
+        // forward to the next header
+        type[0] = 0;
+        return true;
+    }
+
+    const struct log_Format &f = _formats[hdr[2]];
+    uint8_t msg[256];
+    if (f.length < 3 || fread(msg, f.length-3, 1, _fd) != 1) {
+        return false;
+    }
+
+    strncpy(type, f.name, 4);
+    type[4] = 0;
+
+    if (strcmp(type, "PARM") == 0) {
+        _process_parm(f, msg);
+    } else if (strcmp(type, "IMU") == 0) {
+        _process_imu(f, msg);
+    } else if (strcmp(type, "GPS") == 0) {
+        _process_gps(f, msg);
+    } else if (strcmp(type, "MAG") == 0) {
+        _process_mag(f, msg);
+    } else if (strcmp(type, "CTUN") == 0) {
+        float alt;
+        if (_field(f, msg, "BarAlt", alt)) {
+            _have_ctun = true;
+            _process_baro_alt(alt);
+        }
+    } else if (strcmp(type, "ATT") == 0) {
+        _process_att(f, msg);
+    } else if (strcmp(type, "INAV") == 0) {
+        _process_inav(f, msg);
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __LOGREADER_H__
+#define __LOGREADER_H__
+
+/*
+  read a binary DataFlash log and feed the sensor messages into the
+  HIL sensor drivers
+
+  The log is self describing: each message type is announced by a FMT
+  message, and fields are looked up by their label, so logs from
+  different firmware versions can be replayed as long as the labels
+  are unchanged. Field values are returned in the units they were
+  logged in, for example centi-degrees for the ATT angles.
+ */
+
+#include <stdio.h>
+
+// maximum number of message types in one log
+#define LOGREADER_MAX_FORMATS 256
+
+class LogReader
+{
+public:
+    LogReader(AP_InertialSensor_HIL &ins, AP_Baro_HIL &baro, AP_Compass_HIL &compass, GPS *&gps);
+
+    // open a log file, returning false on failure
+    bool open_log(const char *logfile);
+
+    // read the next message and inject any sensor data it holds.
+    // The name of the message, such as "IMU" or "ATT", is copied to
+    // type. Returns false at the end of the log
+    bool update(char type[5]);
+
+    // true once a GPS fix has been read from the log
+    bool have_gps_fix(void) const { return _have_gps_fix; }
+
+    // the last logged attitude, in centi-degrees
+    struct {
+        int32_t roll;
+        int32_t pitch;
+        int32_t yaw;
+    } att;
+
+    // the last logged inertial nav outputs. Altitude is in cm,
+    // climb rate in cm/s, and positions are relative to home in
+    // 1e-7 degrees
+    struct {
+        float alt;
+        float climb_rate;
+        int32_t gps_lat;
+        int32_t gps_lng;
+        float lat;
+        float lng;
+    } inav;
+
+    // number of parameters set from PARM messages
+    uint16_t num_params;
+
+private:
+    AP_InertialSensor_HIL &_ins;
+    AP_Baro_HIL &_baro;
+    AP_Compass_HIL &_compass;
+    GPS *&_gps;
+
+    FILE *_fd;
+
+    // known formats, indexed by message type
+    struct log_Format _formats[LOGREADER_MAX_FORMATS];
+    bool _have_format[LOGREADER_MAX_FORMATS];
+
+    bool _have_baro;
+    bool _have_ctun;
+    bool _have_gps_fix;
+
+    bool _field(const struct log_Format &f, const uint8_t *msg,
+                const char *label, float &value) const;
+    bool _field(const struct log_Format &f, const uint8_t *msg,
+                const char *label, int32_t &value) const;
+    const uint8_t *_field_ptr(const struct log_Format &f, const uint8_t *msg,
+                              const char *label, char &type) const;
+
+    void _process_parm(const struct log_Format &f, const uint8_t *msg);
+    void _process_imu(const struct log_Format &f, const uint8_t *msg);
+    void _process_gps(const struct log_Format &f, const uint8_t *msg);
+    void _process_mag(const struct log_Format &f, const uint8_t *msg);
+    void _process_baro_alt(float alt_cm);
+    void _process_att(const struct log_Format &f, const uint8_t *msg);
+    void _process_inav(const struct log_Format &f, const uint8_t *msg);
+};
+
+#endif // __LOGREADER_H__
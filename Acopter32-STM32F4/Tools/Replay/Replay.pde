@@ -0,0 +1,312 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Replay a binary DataFlash log from ArduCopter through the AHRS and
+// inertial nav code, and compare the recomputed attitude (ATT) and
+// position (INAV) with the values logged by the vehicle.
+//
+// The replay runs on the SITL HAL with its clock stopped, so the
+// sensors are fed with the timing of the log and the replay runs as
+// fast as the CPU allows. Results are deterministic, so the tool can
+// be used as a regression test of estimator changes against a
+// collection of logs. Usage:
+//
+//   REPLAY_LOG=flight.bin ./Replay.elf -C
+//
+// The log needs the IMU, GPS and ATT messages, along with MAG and
+// CTUN or INAV to replay the compass and barometer. The IMU message
+// has no timestamp, so time is advanced by a fixed step for each IMU
+// message. This is set by REPLAY_IMU_HZ (default 50, the IMU logging
+// rate of ArduCopter) and REPLAY_LOOP_HZ (default 100, the main loop
+// rate), with the estimators updated LOOP_HZ/IMU_HZ times per
+// sample.
+//
+// At the end a summary of the RMS and maximum errors is printed. If
+// REPLAY_MAX_ATT_ERR (degrees) or REPLAY_MAX_POS_ERR (meters) are set
+// the exit status is non-zero when the RMS error of any field
+// exceeds them.
+//
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_GPS.h>
+#include <AP_GPS_Glitch.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Baro.h>
+#include <GCS_MAVLink.h>
+#include <Filter.h>
+#include <SITL.h>
+#include <AP_Buffer.h>
+#include <AP_Notify.h>
+#include <AP_Vehicle.h>
+#include <DataFlash.h>
+#include <AP_InertialNav.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LogReader.h"
+
+// the HIL driver has no temperature sensor
+class ReplayINS : public AP_InertialSensor_HIL
+{
+public:
+    float get_temperature(void) const { return 0; }
+};
+
+ReplayINS ins;
+AP_Baro_HIL barometer;
+AP_Compass_HIL compass;
+AP_GPS_HIL g_gps_driver;
+GPS *g_gps = &g_gps_driver;
+GPS_Glitch gps_glitch(g_gps);
+
+AP_AHRS_EKF ahrs(&ins, barometer, g_gps);
+AP_InertialNav inertial_nav(&ahrs, &ins, &barometer, g_gps, gps_glitch);
+
+LogReader log_reader(ins, barometer, compass, g_gps);
+
+// parameters which may be set from the PARM messages in the log
+enum {
+    k_param_ins = 0,
+    k_param_compass,
+    k_param_barometer,
+    k_param_ahrs,
+    k_param_inertial_nav,
+    k_param_gps_glitch
+};
+
+#define GOBJECT(v, name, class) { AP_PARAM_GROUP, name, k_param_ ## v, &v, {group_info : class::var_info} }
+
+const AP_Param::Info var_info[] PROGMEM = {
+    GOBJECT(ins,            "INS_",     AP_InertialSensor),
+    GOBJECT(compass,        "COMPASS_", Compass),
+    GOBJECT(barometer,      "GND_",     AP_Baro),
+    GOBJECT(ahrs,           "AHRS_",    AP_AHRS),
+    GOBJECT(inertial_nav,   "INAV_",    AP_InertialNav),
+    GOBJECT(gps_glitch,     "GPSGLITCH_", GPS_Glitch),
+    AP_VAREND
+};
+
+AP_Param param_loader(var_info, 0);
+
+// accumulated error of one logged field
+struct error_stats {
+    const char *name;
+    float sum_sq;
+    float max;
+    uint32_t count;
+};
+
+enum {
+    ERR_ROLL = 0,
+    ERR_PITCH,
+    ERR_YAW,
+    ERR_ALT,
+    ERR_CLIMB,
+    ERR_NORTH,
+    ERR_EAST,
+    ERR_NUM
+};
+
+static struct error_stats errors[ERR_NUM] = {
+    { "ATT.Roll (deg)", 0, 0, 0 },
+    { "ATT.Pitch (deg)", 0, 0, 0 },
+    { "ATT.Yaw (deg)", 0, 0, 0 },
+    { "INAV.IAlt (m)", 0, 0, 0 },
+    { "INAV.IClb (m/s)", 0, 0, 0 },
+    { "INAV.ILat (m)", 0, 0, 0 },
+    { "INAV.ILng (m)", 0, 0, 0 },
+};
+
+static uint64_t clock_usec = 1;
+static uint32_t loop_period_usec;
+static uint8_t loops_per_imu;
+static bool pending_att;
+static bool pending_inav;
+static bool home_set;
+static float home_lng_scale;
+static uint32_t imu_count;
+
+static void add_error(uint8_t i, float err)
+{
+    err = fabsf(err);
+    errors[i].sum_sq += sq(err);
+    errors[i].max = max(errors[i].max, err);
+    errors[i].count++;
+}
+
+static float env_float(const char *name, float default_value)
+{
+    const char *s = getenv(name);
+    return s ? atof(s) : default_value;
+}
+
+/*
+  compare the recomputed attitude with the one logged for this IMU
+  sample
+ */
+static void check_att(void)
+{
+    add_error(ERR_ROLL,  (ahrs.roll_sensor - log_reader.att.roll) * 0.01f);
+    add_error(ERR_PITCH, (ahrs.pitch_sensor - log_reader.att.pitch) * 0.01f);
+    add_error(ERR_YAW,   wrap_180_cd(ahrs.yaw_sensor - log_reader.att.yaw) * 0.01f);
+}
+
+/*
+  compare the recomputed inertial nav outputs with the logged ones
+ */
+static void check_inav(void)
+{
+    add_error(ERR_ALT,   (inertial_nav.get_altitude() - log_reader.inav.alt) * 0.01f);
+    add_error(ERR_CLIMB, (inertial_nav.get_velocity_z() - log_reader.inav.climb_rate) * 0.01f);
+    if (home_set) {
+        add_error(ERR_NORTH, (inertial_nav.get_latitude_diff() - log_reader.inav.lat) * LATLON_TO_CM * 0.01f);
+        add_error(ERR_EAST,  (inertial_nav.get_longitude_diff() - log_reader.inav.lng) * LATLON_TO_CM * 0.01f * home_lng_scale);
+    }
+}
+
+/*
+  run the estimators for one IMU sample, with the clock advanced by
+  the main loop period for each update
+ */
+static void replay_imu(void)
+{
+    for (uint8_t i=0; i<loops_per_imu; i++) {
+        clock_usec += loop_period_usec;
+        AVR_SITL::SITLScheduler::stop_clock(clock_usec);
+        ahrs.update();
+        inertial_nav.update(ins.get_delta_time());
+    }
+    imu_count++;
+
+    // the ATT and INAV messages for a loop are logged just before
+    // the IMU message of the same loop
+    if (pending_att) {
+        check_att();
+        pending_att = false;
+    }
+    if (pending_inav) {
+        check_inav();
+        pending_inav = false;
+    }
+}
+
+/*
+  set home from the first INAV message with a GPS fix. The logged GPS
+  position relative to home gives the home position used by the
+  vehicle
+ */
+static void set_home(void)
+{
+    if (home_set || !log_reader.have_gps_fix()) {
+        return;
+    }
+    int32_t home_lat = g_gps->latitude - log_reader.inav.gps_lat;
+    int32_t home_lng = g_gps->longitude - log_reader.inav.gps_lng;
+    inertial_nav.set_home_position(home_lng, home_lat);
+    home_lng_scale = cosf(ToRad(home_lat * 1.0e-7f));
+    home_set = true;
+}
+
+static void print_summary(void)
+{
+    float max_att_err = env_float("REPLAY_MAX_ATT_ERR", 0);
+    float max_pos_err = env_float("REPLAY_MAX_POS_ERR", 0);
+    bool failed = false;
+
+    hal.console->printf_P(PSTR("Replayed %lu IMU samples, %u parameters\n"),
+                          (unsigned long)imu_count, (unsigned)log_reader.num_params);
+    for (uint8_t i=0; i<ERR_NUM; i++) {
+        const struct error_stats &e = errors[i];
+        float rms = e.count ? sqrtf(e.sum_sq / e.count) : 0;
+        float limit = i <= ERR_YAW ? max_att_err : max_pos_err;
+        bool bad = limit > 0 && rms > limit;
+        hal.console->printf_P(PSTR("%-16s rms=%.3f max=%.3f n=%lu%s\n"),
+                              e.name, rms, e.max, (unsigned long)e.count,
+                              bad ? " FAIL" : "");
+        failed |= bad;
+    }
+    exit(failed ? 1 : 0);
+}
+
+void setup(void)
+{
+    const char *fname = getenv("REPLAY_LOG");
+    if (fname == NULL) {
+        fname = "replay.bin";
+    }
+    if (!log_reader.open_log(fname)) {
+        hal.console->printf("Unable to open %s\n", fname);
+        exit(1);
+    }
+
+    float imu_hz = env_float("REPLAY_IMU_HZ", 50);
+    float loop_hz = env_float("REPLAY_LOOP_HZ", 100);
+    loops_per_imu = max(1, (int)(loop_hz / imu_hz + 0.5f));
+    loop_period_usec = 1.0e6f / (imu_hz * loops_per_imu);
+
+    AVR_SITL::SITLScheduler::stop_clock(clock_usec);
+
+    ins.init(AP_InertialSensor::COLD_START,
+             AP_InertialSensor::RATE_100HZ);
+    compass.init();
+    ahrs.init();
+    ahrs.set_compass(&compass);
+    barometer.init();
+    g_gps->init(NULL);
+    inertial_nav.init();
+}
+
+void loop(void)
+{
+    char type[5];
+    if (!log_reader.update(type)) {
+        print_summary();
+    }
+
+    if (strcmp(type, "IMU") == 0) {
+        replay_imu();
+    } else if (strcmp(type, "GPS") == 0) {
+        gps_glitch.check_position();
+    } else if (strcmp(type, "ATT") == 0) {
+        pending_att = true;
+    } else if (strcmp(type, "INAV") == 0) {
+        set_home();
+        pending_inav = true;
+    }
+}
+
+#else
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("Replay is only supported on SITL"));
+}
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif
+
+AP_HAL_MAIN();
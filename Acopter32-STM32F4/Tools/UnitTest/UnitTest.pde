@@ -0,0 +1,466 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Unit tests and microbenchmarks of the libraries, built natively
+// against the empty HAL so they run on the build machine without a
+// board or a simulator. Usage:
+//
+//   make host && /tmp/UnitTest.build/UnitTest.elf
+//
+// The tests are in the test_*.pde files, one per library: AP_Math,
+// Filter, AP_AHRS, AP_InertialNav, AC_WPNav, AP_Param, DataFlash and
+// AP_Compass.
+// They check results with CHECK() and CHECK_FLOAT(), and run with the
+// HAL clock stopped, so code which measures time sees exactly the
+// time the test gives it. New tests and benchmarks are added to the
+// tables below.
+//
+// The benchmarks, next to the tests of each library, each run a
+// fixed number of iterations of one piece of library code. Each is
+// run once to warm up and then UNITTEST_REPEAT times (default 5), and
+// the fastest run is reported as nanoseconds of thread CPU time per iteration. The
+// fastest run is the one least disturbed by the rest of the system,
+// which makes it repeatable to a few percent.
+//
+// A baseline is a text file with a benchmark name and a time in
+// nanoseconds on each line. UNITTEST_SAVE names a file to write the
+// results to as a new baseline. When UNITTEST_BASELINE names a
+// baseline, each result is compared with it and is a regression when
+// it is more than UNITTEST_TOLERANCE percent (default 10) slower. To
+// check a change, save a baseline from a build without it and
+// compare a build with it on the same machine.
+//
+// UNITTEST_FILTER runs only the tests and benchmarks whose names
+// contain it, and UNITTEST_BENCH=0 skips the benchmarks. The exit
+// status is non-zero when a test fails or a benchmark regresses.
+//
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_GPS.h>
+#include <AP_GPS_Glitch.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Baro.h>
+#include <GCS_MAVLink.h>
+#include <Filter.h>
+#include <LowPassFilter2p.h>
+#include <AP_Buffer.h>
+#include <AP_Notify.h>
+#include <AP_Vehicle.h>
+#include <DataFlash.h>
+#include <AP_InertialNav.h>
+#include <AP_PIDCore.h>
+#include <APM_PI.h>
+#include <AC_PID.h>
+#include <AC_WPNav.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// check a condition, recording a failure of the current test
+#define CHECK(cond) check_true((cond), __FILE__, __LINE__, #cond)
+
+// check that a is within tol of b
+#define CHECK_FLOAT(a, b, tol) check_float((a), (b), (tol), __FILE__, __LINE__, #a)
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#ifdef HAL_EMPTY_HOST
+
+#include <time.h>
+
+#define UNITTEST_MAX_BENCHMARKS 40
+
+struct unit_test {
+    const char *name;
+    void (*run)(void);
+};
+
+struct microbenchmark {
+    const char *name;
+    // iterations of each timed run. Fixed, so that a result is
+    // always the time of the same work
+    uint32_t iterations;
+    // set up before the runs, which are not timed
+    void (*setup)(void);
+    // run n iterations
+    void (*run)(uint32_t n);
+};
+
+static const struct unit_test tests[] = {
+    { "math_wrap",              test_math_wrap },
+    { "math_matrix_euler",      test_math_matrix_euler },
+    { "math_quaternion",        test_math_quaternion },
+    { "math_rotations",         test_math_rotations },
+    { "math_rotate_vectors",    test_math_rotate_vectors },
+    { "math_location",          test_math_location },
+    { "math_location_frame",    test_math_location_frame },
+    { "filter_lowpass",         test_filter_lowpass },
+    { "filter_lowpass2p",       test_filter_lowpass2p },
+    { "filter_average",         test_filter_average },
+    { "filter_mode",            test_filter_mode },
+    { "filter_derivative",      test_filter_derivative },
+    { "ahrs_level",             test_ahrs_level },
+    { "ahrs_tilt",              test_ahrs_tilt },
+    { "ahrs_yaw_rate",          test_ahrs_yaw_rate },
+    { "ins_hil_accumulate",     test_ins_hil_accumulate },
+    { "inav_stationary",        test_inav_stationary },
+    { "inav_gps_offset",        test_inav_gps_offset },
+    { "wpnav_bearing",          test_wpnav_bearing },
+    { "wpnav_stopping_point",   test_wpnav_stopping_point },
+    { "wpnav_segment",          test_wpnav_segment },
+    { "wpnav_loiter",           test_wpnav_loiter },
+    { "param_names",            test_param_names },
+    { "param_defaults",         test_param_defaults },
+    { "param_save_load",        test_param_save_load },
+    { "dataflash_logs",         test_dataflash_logs },
+    { "dataflash_pages",        test_dataflash_pages },
+    { "compass_cal_hard_iron",  test_compass_cal_hard_iron },
+    { "compass_cal_soft_iron",  test_compass_cal_soft_iron },
+    { "compass_cal_coverage",   test_compass_cal_coverage },
+    { "compass_cal_bad_fit",    test_compass_cal_bad_fit },
+    { "compass_correct",        test_compass_correct },
+};
+
+static const struct microbenchmark benchmarks[] = {
+    { "math_matrix_rotate",     100000,  NULL,                     bench_math_matrix_rotate },
+    { "math_quaternion_rotate", 100000,  NULL,                     bench_math_quaternion_rotate },
+    { "math_rotate_vectors",    10000,   NULL,                     bench_math_rotate_vectors },
+    { "math_location",          100000,  NULL,                     bench_math_location },
+    { "math_location_frame",    100000,  NULL,                     bench_math_location_frame },
+    { "filter_lowpass2p",       1000000, NULL,                     bench_filter_lowpass2p },
+    { "filter_mode",            100000,  NULL,                     bench_filter_mode },
+    { "ahrs_dcm_update",        20000,   bench_ahrs_setup,         bench_ahrs_dcm_update },
+    { "inav_update",            20000,   bench_inav_setup,         bench_inav_update },
+    { "wpnav_update",           20000,   bench_wpnav_setup,        bench_wpnav_update },
+    { "param_find",             1000,    NULL,                     bench_param_find },
+    { "dataflash_write",        100000,  bench_dataflash_setup,    bench_dataflash_write },
+    { "compass_cal_update",     10000,   bench_compass_cal_setup,  bench_compass_cal_update },
+};
+
+#define NUM_TESTS (sizeof(tests)/sizeof(tests[0]))
+#define NUM_BENCHMARKS (sizeof(benchmarks)/sizeof(benchmarks[0]))
+
+// checks of the current test
+static uint16_t checks_run;
+static uint16_t checks_failed;
+
+// the HAL clock, stopped while the tests run
+static uint64_t clock_usec;
+
+// stops the compiler removing the work of a benchmark
+volatile float bench_sink;
+
+// the sensors and estimators of the AHRS, inertial nav and waypoint
+// navigation tests
+AP_InertialSensor_HIL ins;
+AP_Baro_HIL barometer;
+AP_GPS_HIL g_gps_driver;
+GPS *g_gps = &g_gps_driver;
+GPS_Glitch gps_glitch(g_gps);
+
+AP_AHRS_DCM ahrs(&ins, g_gps);
+AP_InertialNav inertial_nav(&ahrs, &ins, &barometer, g_gps, gps_glitch);
+
+// the loiter controllers with the default gains of ArduCopter
+APM_PI pi_loiter_lat(1.0f);
+APM_PI pi_loiter_lon(1.0f);
+AC_PID pid_loiter_rate_lat(1.0f, 0.5f, 0, 400);
+AC_PID pid_loiter_rate_lon(1.0f, 0.5f, 0, 400);
+AC_WPNav wp_nav(&inertial_nav, &ahrs, &pi_loiter_lat, &pi_loiter_lon, &pid_loiter_rate_lat, &pid_loiter_rate_lon);
+
+// CMAC, the usual SITL home
+static const int32_t home_lat = -353632620;
+static const int32_t home_lng = 1491652370;
+
+static void check_failed(const char *file, int line, const char *what)
+{
+    const char *base = strrchr(file, '/');
+    hal.console->printf("    %s:%d: %s\n", base ? base+1 : file, line, what);
+    checks_failed++;
+}
+
+static void check_true(bool ok, const char *file, int line, const char *expr)
+{
+    checks_run++;
+    if (!ok) {
+        check_failed(file, line, expr);
+    }
+}
+
+static void check_float(float a, float b, float tol, const char *file, int line, const char *expr)
+{
+    checks_run++;
+    if (isnan(a) || fabsf(a - b) > tol) {
+        char msg[200];
+        snprintf(msg, sizeof(msg), "%s is %g, expected %g within %g", expr, a, b, tol);
+        check_failed(file, line, msg);
+    }
+}
+
+/*
+  set the HAL clock, in microseconds from the start. It starts at one
+  second, as a stopped clock of zero is a running clock
+ */
+static void set_clock(uint64_t usec)
+{
+    clock_usec = usec;
+    Empty::EmptyScheduler::stop_clock(clock_usec);
+}
+
+static void advance_clock(uint32_t usec)
+{
+    set_clock(clock_usec + usec);
+}
+
+// thread CPU time in nanoseconds
+static uint64_t cpu_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+  run the sensors for one main loop of dt_usec with the given body
+  rates and specific force, and update the AHRS
+ */
+static void sensor_step(const Vector3f &gyro, const Vector3f &accel, uint32_t dt_usec)
+{
+    advance_clock(dt_usec);
+    ins.set_gyro(gyro);
+    ins.set_accel(accel);
+    // ahrs.update() updates the sensors
+    ahrs.update();
+}
+
+/*
+  give the GPS a fix at pos meters north and east of home
+ */
+static void gps_fix(float north, float east)
+{
+    struct Location loc;
+    loc.lat = home_lat;
+    loc.lng = home_lng;
+    location_offset(loc, north, east);
+    g_gps_driver.setHIL(clock_usec / 1000, loc.lat * 1.0e-7f, loc.lng * 1.0e-7f, 0,
+                        0, 0, 0, 10);
+    // setHIL() takes degrees in a float, with a resolution of about a
+    // meter, so set the position exactly
+    g_gps_driver.latitude = loc.lat;
+    g_gps_driver.longitude = loc.lng;
+}
+
+/*
+  start a test of the estimators: level and still at home, with the
+  GPS fix and AHRS reset
+ */
+static void reset_estimators(void)
+{
+    ins.set_gyro(Vector3f(0, 0, 0));
+    ins.set_accel(Vector3f(0, 0, -GRAVITY_MSS));
+    ins.update();
+    ahrs.reset();
+    gps_fix(0, 0);
+    inertial_nav.set_home_position(home_lng, home_lat);
+    inertial_nav.set_position_xy(0, 0);
+    inertial_nav.set_velocity_xy(0, 0);
+    inertial_nav.set_altitude(0);
+    inertial_nav.set_velocity_z(0);
+}
+
+static bool selected(const char *name, const char *filter)
+{
+    return filter == NULL || strstr(name, filter) != NULL;
+}
+
+static uint16_t run_tests(const char *filter)
+{
+    uint16_t failed = 0, run = 0;
+    for (uint8_t i=0; i<NUM_TESTS; i++) {
+        if (!selected(tests[i].name, filter)) {
+            continue;
+        }
+        checks_run = checks_failed = 0;
+        set_clock(1000000);
+        tests[i].run();
+        run++;
+        if (checks_failed != 0 || checks_run == 0) {
+            hal.console->printf("test  %-24s FAILED %u of %u checks\n",
+                                tests[i].name, (unsigned)checks_failed, (unsigned)checks_run);
+            failed++;
+        } else {
+            hal.console->printf("test  %-24s ok (%u checks)\n",
+                                tests[i].name, (unsigned)checks_run);
+        }
+    }
+    hal.console->printf("%u tests, %u failed\n\n", (unsigned)run, (unsigned)failed);
+    return failed;
+}
+
+/*
+  the time in nanoseconds per iteration of a benchmark: the fastest of
+  repeat runs after a warm up run
+ */
+static float time_benchmark(const struct microbenchmark &b, uint8_t repeat)
+{
+    set_clock(1000000);
+    if (b.setup != NULL) {
+        b.setup();
+    }
+    b.run(b.iterations);
+    uint64_t best = 0;
+    for (uint8_t r=0; r<repeat; r++) {
+        uint64_t start = cpu_nsec();
+        b.run(b.iterations);
+        uint64_t t = cpu_nsec() - start;
+        if (r == 0 || t < best) {
+            best = t;
+        }
+    }
+    return best / (float)b.iterations;
+}
+
+/*
+  look up a benchmark in a baseline file, returning a negative time if
+  it is not there
+ */
+static float baseline_time(FILE *f, const char *name)
+{
+    char line[100], bname[64];
+    float nsec;
+    rewind(f);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%63s %f", bname, &nsec) == 2 && strcmp(bname, name) == 0) {
+            return nsec;
+        }
+    }
+    return -1;
+}
+
+static uint16_t run_benchmarks(const char *filter)
+{
+    const char *s = getenv("UNITTEST_REPEAT");
+    uint8_t repeat = s ? constrain_int16(atoi(s), 1, 100) : 5;
+    s = getenv("UNITTEST_TOLERANCE");
+    float tolerance = s ? atof(s) : 10;
+
+    FILE *baseline = NULL;
+    const char *baseline_name = getenv("UNITTEST_BASELINE");
+    if (baseline_name != NULL) {
+        baseline = fopen(baseline_name, "r");
+        if (baseline == NULL) {
+            hal.console->printf("Unable to open baseline %s\n", baseline_name);
+            exit(1);
+        }
+    }
+
+    const char *save_name = getenv("UNITTEST_SAVE");
+    float results[UNITTEST_MAX_BENCHMARKS];
+    bool ran[UNITTEST_MAX_BENCHMARKS];
+
+    uint16_t regressions = 0, run = 0;
+    hal.console->printf("%-30s %10s %10s %10s %8s\n", "benchmark", "iterations", "ns/iter", "baseline", "change");
+    for (uint8_t i=0; i<NUM_BENCHMARKS; i++) {
+        ran[i] = selected(benchmarks[i].name, filter);
+        if (!ran[i]) {
+            continue;
+        }
+        results[i] = time_benchmark(benchmarks[i], repeat);
+        run++;
+        hal.console->printf("bench %-24s %10lu %10.1f", benchmarks[i].name,
+                            (unsigned long)benchmarks[i].iterations, results[i]);
+        float base = baseline ? baseline_time(baseline, benchmarks[i].name) : -1;
+        if (base > 0) {
+            float change = 100 * (results[i] - base) / base;
+            hal.console->printf(" %10.1f %+7.1f%%", base, change);
+            if (change > tolerance) {
+                hal.console->printf("  REGRESSION");
+                regressions++;
+            }
+        }
+        hal.console->printf("\n");
+    }
+    hal.console->printf("%u benchmarks", (unsigned)run);
+    if (baseline != NULL) {
+        hal.console->printf(", %u slower than %s by more than %.0f%%",
+                            (unsigned)regressions, baseline_name, tolerance);
+        fclose(baseline);
+    }
+    hal.console->printf("\n");
+
+    if (save_name != NULL) {
+        FILE *f = fopen(save_name, "w");
+        if (f == NULL) {
+            hal.console->printf("Unable to create %s\n", save_name);
+            exit(1);
+        }
+        fprintf(f, "# UnitTest benchmark baseline, ns per iteration\n");
+        for (uint8_t i=0; i<NUM_BENCHMARKS; i++) {
+            if (ran[i]) {
+                fprintf(f, "%s %.2f\n", benchmarks[i].name, results[i]);
+            }
+        }
+        fclose(f);
+        hal.console->printf("baseline saved to %s\n", save_name);
+    }
+    return regressions;
+}
+
+void setup(void)
+{
+    set_clock(1000000);
+    ins.init(AP_InertialSensor::COLD_START,
+             AP_InertialSensor::RATE_100HZ);
+    ahrs.init();
+    g_gps->init(NULL);
+    inertial_nav.init();
+
+    const char *filter = getenv("UNITTEST_FILTER");
+    uint16_t failed = run_tests(filter);
+
+    uint16_t regressions = 0;
+    const char *bench = getenv("UNITTEST_BENCH");
+    if (bench == NULL || atoi(bench) != 0) {
+        regressions = run_benchmarks(filter);
+    }
+    fflush(stdout);
+    exit(failed != 0 || regressions != 0 ? 1 : 0);
+}
+
+void loop(void)
+{
+}
+
+#else // HAL_EMPTY_HOST
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("UnitTest runs on the host build: make host"));
+}
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif // HAL_EMPTY_HOST
+
+AP_HAL_MAIN();
@@ -0,0 +1,98 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// AP_AHRS tests and benchmarks, with the DCM estimator on a 100Hz
+// main loop
+//
+
+#ifdef HAL_EMPTY_HOST
+
+// the specific force on a vehicle at rest at the given attitude
+static Vector3f rest_accel(float roll, float pitch)
+{
+    Matrix3f m;
+    m.from_euler(roll, pitch, 0);
+    return m.mul_transpose(Vector3f(0, 0, -GRAVITY_MSS));
+}
+
+static void test_ahrs_level(void)
+{
+    reset_estimators();
+    for (uint16_t i=0; i<1000; i++) {
+        sensor_step(Vector3f(0, 0, 0), rest_accel(0, 0), 10000);
+        if (i % 10 == 0) {
+            gps_fix(0, 0);
+        }
+    }
+    CHECK_FLOAT(ToDeg(ahrs.roll), 0, 0.1f);
+    CHECK_FLOAT(ToDeg(ahrs.pitch), 0, 0.1f);
+    CHECK_FLOAT(ToDeg(ahrs.yaw), 0, 0.1f);
+    CHECK(ahrs.get_gyro().length() < 1.0e-3f);
+}
+
+static void test_ahrs_tilt(void)
+{
+    // the accelerometers pull the attitude to the tilt they measure
+    reset_estimators();
+    for (uint16_t i=0; i<6000; i++) {
+        sensor_step(Vector3f(0, 0, 0), rest_accel(ToRad(20), ToRad(-10)), 10000);
+        if (i % 10 == 0) {
+            gps_fix(0, 0);
+        }
+    }
+    CHECK_FLOAT(ToDeg(ahrs.roll), 20, 1);
+    CHECK_FLOAT(ToDeg(ahrs.pitch), -10, 1);
+    CHECK(abs(ahrs.roll_sensor - 2000) < 100);
+}
+
+static void test_ahrs_yaw_rate(void)
+{
+    // without a compass or GPS course the yaw follows the gyro
+    reset_estimators();
+    for (uint16_t i=0; i<200; i++) {
+        sensor_step(Vector3f(0, 0, 0.5f), rest_accel(0, 0), 10000);
+    }
+    CHECK_FLOAT(ahrs.yaw, 1.0f, 0.02f);
+    CHECK_FLOAT(ToDeg(ahrs.roll), 0, 0.5f);
+    CHECK_FLOAT(ahrs.get_gyro().z, 0.5f, 0.01f);
+
+    // the earth frame acceleration at rest is gravity
+    Vector3f accel_ef = ahrs.get_accel_ef();
+    CHECK_FLOAT(accel_ef.z, -GRAVITY_MSS, 0.05f);
+}
+
+static void test_ins_hil_accumulate(void)
+{
+    // update() averages the samples accumulated since the last
+    // update, which alternate between the two sets of sums. Not the
+    // shared ins, which would then use the delta angles of the samples
+    AP_InertialSensor_HIL hil_ins;
+    for (uint8_t loop=0; loop<4; loop++) {
+        for (uint8_t i=0; i<=loop; i++) {
+            hil_ins.accumulate(Vector3f(0, 0, loop + i), Vector3f(0, 0, -GRAVITY_MSS), 0.001f);
+        }
+        hil_ins.update();
+        CHECK_FLOAT(hil_ins.get_gyro().z, loop * 1.5f, 1.0e-5f);
+    }
+    // without new samples the last values are kept
+    hil_ins.update();
+    CHECK_FLOAT(hil_ins.get_gyro().z, 4.5f, 1.0e-5f);
+    CHECK_FLOAT(hil_ins.get_accel().z, -GRAVITY_MSS, 1.0e-5f);
+}
+
+static void bench_ahrs_setup(void)
+{
+    reset_estimators();
+}
+
+static void bench_ahrs_dcm_update(uint32_t n)
+{
+    for (uint32_t i=0; i<n; i++) {
+        float t = i * 0.01f;
+        sensor_step(Vector3f(0.1f * sinf(t), 0.1f * cosf(t), 0.05f),
+                    rest_accel(0.1f * sinf(t), 0), 10000);
+    }
+    bench_sink = ahrs.roll;
+}
+
+#endif // HAL_EMPTY_HOST
@@ -0,0 +1,234 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// AP_Compass tests and benchmarks, of CompassCalibrator on the field
+// of a compass with hard and soft iron, and of the correction the
+// drivers apply
+//
+
+#ifdef HAL_EMPTY_HOST
+
+// the earth field, of length 474, and a hard iron offset
+static const Vector3f compass_earth_field(250, 50, 400);
+static const Vector3f compass_hard_iron(120, -80, 200);
+
+// a symmetric soft iron distortion
+static const Matrix3f compass_soft_iron(1.10f,  0.05f, -0.03f,
+                                        0.05f,  0.95f,  0.02f,
+                                       -0.03f,  0.02f,  1.02f);
+
+static CompassCalibrator compass_cal;
+static uint32_t compass_noise_seed;
+
+// uniform noise from -1 to 1, repeatable from the seed
+static float compass_noise(void)
+{
+    compass_noise_seed = compass_noise_seed * 1664525UL + 1013904223UL;
+    return (compass_noise_seed >> 8) * (2.0f / 16777216.0f) - 1;
+}
+
+// the attitude t seconds into a manoeuvre, tumbling about all axes
+// or only turning in yaw
+static void compass_attitude(float t, bool tumble, Matrix3f &dcm)
+{
+    if (tumble) {
+        dcm.from_euler(1.3f * t, 1.2f * sinf(0.37f * t), 0.9f * t);
+    } else {
+        dcm.from_euler(0, 0, 0.9f * t);
+    }
+}
+
+// the field the compass measures at an attitude
+static Vector3f compass_field(const Matrix3f &dcm, const Matrix3f &soft_iron, float noise)
+{
+    Vector3f field = soft_iron * dcm.mul_transpose(compass_earth_field) + compass_hard_iron;
+    return field + Vector3f(compass_noise(), compass_noise(), compass_noise()) * noise;
+}
+
+/*
+  run a manoeuvre for up to the given time, with the compass at 75Hz
+  and update() at 50Hz. Returns the time the calibration finished,
+  or zero if it did not
+ */
+static float compass_cal_run(const Matrix3f &soft_iron, float noise, bool tumble, float seconds)
+{
+    compass_noise_seed = 1;
+    for (uint16_t i=1; i<seconds*75; i++) {
+        float t = i / 75.0f;
+        Matrix3f dcm;
+        compass_attitude(t, tumble, dcm);
+        compass_cal.new_sample(compass_field(dcm, soft_iron, noise));
+        if (i % 3 != 0 && compass_cal.update()) {
+            return t;
+        }
+    }
+    return 0;
+}
+
+/*
+  the largest error of the calibrated field from the earth field, in
+  the scale of the fit, over attitudes of the manoeuvre
+ */
+static float compass_cal_error(const Matrix3f &soft_iron)
+{
+    float scale = compass_cal.get_radius() / compass_earth_field.length();
+    float max_error = 0;
+    for (uint8_t i=0; i<100; i++) {
+        Matrix3f dcm;
+        compass_attitude(i * 0.6f, true, dcm);
+        Vector3f expected = dcm.mul_transpose(compass_earth_field) * scale;
+        Vector3f error = compass_cal.correct(compass_field(dcm, soft_iron, 0)) - expected;
+        max_error = max(max_error, error.length());
+    }
+    return max_error;
+}
+
+static void test_compass_cal_hard_iron(void)
+{
+    Matrix3f identity(1, 0, 0, 0, 1, 0, 0, 0, 1);
+    compass_cal.start();
+    float t = compass_cal_run(identity, 0, true, 60);
+    CHECK(t > 0);
+    CHECK(compass_cal.status() == CompassCalibrator::CAL_SUCCESS);
+    CHECK(compass_cal.get_coverage() >= COMPASS_CAL_MIN_COVERAGE);
+    CHECK_FLOAT((compass_cal.get_offsets() + compass_hard_iron).length(), 0, 1);
+    CHECK_FLOAT(compass_cal.get_radius(), compass_earth_field.length(), 1);
+    CHECK_FLOAT((compass_cal.get_diagonals() - Vector3f(1, 1, 1)).length(), 0, 0.01f);
+    CHECK_FLOAT(compass_cal.get_offdiagonals().length(), 0, 0.01f);
+    CHECK_FLOAT(compass_cal.get_fitness(), 0, 1);
+}
+
+static void test_compass_cal_soft_iron(void)
+{
+    // with noise of up to 3 on each axis
+    compass_cal.start();
+    float t = compass_cal_run(compass_soft_iron, 3, true, 60);
+    CHECK(t > 0);
+    CHECK(compass_cal.status() == CompassCalibrator::CAL_SUCCESS);
+    CHECK_FLOAT((compass_cal.get_offsets() + compass_hard_iron).length(), 0, 3);
+    CHECK_FLOAT(compass_cal_error(compass_soft_iron), 0, 5);
+    // the noise is 1.7 RMS on each axis
+    CHECK_FLOAT(compass_cal.get_fitness(), 0, 3);
+
+    // the same manoeuvre gives the same calibration
+    Vector3f ofs = compass_cal.get_offsets();
+    compass_cal.start();
+    compass_cal_run(compass_soft_iron, 3, true, 60);
+    CHECK(compass_cal_error(compass_soft_iron) < 5);
+    CHECK((compass_cal.get_offsets() - ofs).length() < 0.1f);
+}
+
+static void test_compass_cal_coverage(void)
+{
+    // turning in yaw alone only covers a band of directions, and the
+    // calibration does not finish
+    compass_cal.start();
+    CHECK(compass_cal_run(compass_soft_iron, 3, false, 60) == 0);
+    CHECK(compass_cal.running());
+    CHECK(compass_cal.get_coverage() < COMPASS_CAL_MIN_COVERAGE);
+
+    // samples beyond the size of the queue drop the oldest
+    compass_cal.start();
+    for (uint8_t i=0; i<COMPASS_CAL_FIFO_SIZE+10; i++) {
+        Matrix3f dcm;
+        compass_attitude(i * 0.5f, true, dcm);
+        compass_cal.new_sample(compass_field(dcm, compass_soft_iron, 0));
+    }
+    compass_cal.update();
+    CHECK(compass_cal.get_num_samples() <= COMPASS_CAL_FIFO_SIZE);
+    CHECK(compass_cal.get_num_samples() > 0);
+
+    compass_cal.stop();
+    CHECK(compass_cal.status() == CompassCalibrator::CAL_NOT_STARTED);
+    CHECK(!compass_cal.update());
+}
+
+static void test_compass_cal_bad_fit(void)
+{
+    // noise far above the tolerance fails the calibration
+    compass_cal.start(5);
+    float t = compass_cal_run(compass_soft_iron, 60, true, 60);
+    CHECK(t > 0);
+    CHECK(compass_cal.status() == CompassCalibrator::CAL_FAILED);
+    CHECK(compass_cal.get_fitness() > 5);
+}
+
+// turn a compass through the manoeuvre, learning its offsets
+static void compass_learn_offsets(AP_Compass_HIL &compass)
+{
+    for (uint16_t i=0; i<200; i++) {
+        Matrix3f dcm;
+        compass_attitude(i * 0.1f, true, dcm);
+        compass.setHIL(dcm.mul_transpose(compass_earth_field));
+        compass.read();
+        compass.null_offsets();
+    }
+}
+
+static void test_compass_correct(void)
+{
+    AP_Compass_HIL compass;
+    Vector3f field(200, -100, 300);
+
+    // with no soft iron calibration the offsets are added
+    compass.set_offsets(Vector3f(10, 20, -30));
+    compass.setHIL(field);
+    CHECK(compass.read());
+    CHECK_FLOAT(compass.mag_x, 210, 1);
+    CHECK_FLOAT(compass.mag_y, -80, 1);
+    CHECK_FLOAT(compass.mag_z, 270, 1);
+
+    // and then multiplied by the soft iron matrix
+    compass.set_calibration(Vector3f(10, 20, -30), Vector3f(0.9f, 1.1f, 1.0f), Vector3f(0.1f, 0, -0.05f));
+    CHECK(compass.read());
+    CHECK_FLOAT(compass.mag_x, 0.9f*210 + 0.1f*-80, 1);
+    CHECK_FLOAT(compass.mag_y, 0.1f*210 + 1.1f*-80 - 0.05f*270, 1);
+    CHECK_FLOAT(compass.mag_z, -0.05f*-80 + 1.0f*270, 1);
+
+    // offset learning, which assumes there is no soft iron matrix, is
+    // off while one is set
+    compass._learn.set(1);
+    compass_learn_offsets(compass);
+    CHECK_FLOAT((compass.get_offsets() - Vector3f(10, 20, -30)).length(), 0, 0);
+    compass.set_calibration(Vector3f(10, 20, -30), Vector3f(0, 0, 0), Vector3f(0, 0, 0));
+    compass_learn_offsets(compass);
+    CHECK((compass.get_offsets() - Vector3f(10, 20, -30)).length() > 1);
+
+    // a calibrator is given each field until it is cleared
+    CompassCalibrator cal;
+    compass.set_calibrator(&cal);
+    cal.start();
+    compass.setHIL(field);
+    compass.set_calibrator(NULL);
+    compass.setHIL(-field);
+    cal.update();
+    CHECK(cal.get_num_samples() == 1);
+}
+
+static void bench_compass_cal_setup(void)
+{
+    // enough samples for the fit, but too few to finish, so the fit
+    // steps on
+    compass_cal.start();
+    compass_noise_seed = 1;
+    for (uint16_t i=1; compass_cal.get_num_samples() < 50; i++) {
+        Matrix3f dcm;
+        compass_attitude(i / 75.0f, true, dcm);
+        compass_cal.new_sample(compass_field(dcm, compass_soft_iron, 3));
+        compass_cal.update();
+    }
+    for (uint8_t i=0; i<COMPASS_CAL_SPHERE_STEPS; i++) {
+        compass_cal.update();
+    }
+}
+
+// one step of the ellipsoid fit, over 50 samples
+static void bench_compass_cal_update(uint32_t n)
+{
+    for (uint32_t i=0; i<n; i++) {
+        compass_cal.update();
+    }
+    bench_sink = compass_cal.get_fitness();
+}
+
+#endif // HAL_EMPTY_HOST
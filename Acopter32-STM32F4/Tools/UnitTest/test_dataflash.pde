@@ -0,0 +1,176 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// DataFlash tests and benchmarks, of the generic page buffered code
+// of DataFlash_Block on a small flash chip in RAM
+//
+
+#ifdef HAL_EMPTY_HOST
+
+#define DF_RAM_PAGE_SIZE 512
+#define DF_RAM_NUM_PAGES 64
+
+/*
+  a DataFlash_Block backend in RAM, as DataFlash_SITL is in a file
+ */
+class DataFlash_RAM : public DataFlash_Block
+{
+public:
+    void Init(void) {
+        // a new chip is erased
+        memset(_flash, 0xFF, sizeof(_flash));
+        df_PageSize = DF_RAM_PAGE_SIZE;
+        // the logs are in pages 1 to df_NumPages, and the page after
+        // them holds the logging format
+        df_NumPages = DF_RAM_NUM_PAGES;
+    }
+    bool CardInserted(void) { return true; }
+    const uint8_t *page(uint16_t PageAdr) const { return _flash[PageAdr]; }
+
+private:
+    void ReadManufacturerID(void) {
+        df_manufacturer = 1;
+        df_device = 0x0203;
+    }
+    void WaitReady(void) {}
+    void BufferToPage(uint8_t BufferNum, uint16_t PageAdr, uint8_t wait) {
+        if (PageAdr < DF_RAM_NUM_PAGES+2) {
+            memcpy(_flash[PageAdr], _buffer[BufferNum], DF_RAM_PAGE_SIZE);
+        }
+    }
+    void PageToBuffer(uint8_t BufferNum, uint16_t PageAdr) {
+        if (PageAdr < DF_RAM_NUM_PAGES+2) {
+            memcpy(_buffer[BufferNum], _flash[PageAdr], DF_RAM_PAGE_SIZE);
+        } else {
+            memset(_buffer[BufferNum], 0xFF, DF_RAM_PAGE_SIZE);
+        }
+    }
+    void PageErase(uint16_t PageAdr) {
+        if (PageAdr < DF_RAM_NUM_PAGES+2) {
+            memset(_flash[PageAdr], 0xFF, DF_RAM_PAGE_SIZE);
+        }
+    }
+    void BlockErase(uint16_t BlockAdr) {
+        for (uint16_t p=BlockAdr*8; p<BlockAdr*8+8; p++) {
+            PageErase(p);
+        }
+    }
+    void BlockWrite(uint8_t BufferNum, uint16_t IntPageAdr,
+                    const void *pHeader, uint8_t hdr_size,
+                    const void *pBuffer, uint16_t size) {
+        if (hdr_size) {
+            memcpy(&_buffer[BufferNum][IntPageAdr], pHeader, hdr_size);
+        }
+        memcpy(&_buffer[BufferNum][IntPageAdr+hdr_size], pBuffer, size);
+    }
+    bool BlockRead(uint8_t BufferNum, uint16_t IntPageAdr, void *pBuffer, uint16_t size) {
+        memcpy(pBuffer, &_buffer[BufferNum][IntPageAdr], size);
+        return true;
+    }
+
+    uint8_t _flash[DF_RAM_NUM_PAGES+2][DF_RAM_PAGE_SIZE];
+    uint8_t _buffer[2][DF_RAM_PAGE_SIZE];
+};
+
+static DataFlash_RAM dataflash;
+
+// write size bytes of a counting pattern, starting from value
+static void dataflash_write_pattern(uint16_t size, uint8_t value)
+{
+    uint8_t buf[100];
+    while (size > 0) {
+        uint16_t n = min(size, sizeof(buf));
+        for (uint16_t i=0; i<n; i++) {
+            buf[i] = value++;
+        }
+        dataflash.WriteBlock(buf, n);
+        size -= n;
+    }
+}
+
+static void test_dataflash_logs(void)
+{
+    dataflash.Init();
+    CHECK(dataflash.NeedErase());
+    dataflash.EraseAll();
+    CHECK(!dataflash.NeedErase());
+    CHECK(dataflash.get_num_logs() == 0);
+
+    // two logs of several pages each
+    CHECK(dataflash.start_new_log() == 1);
+    dataflash_write_pattern(3000, 0);
+    CHECK(dataflash.start_new_log() == 2);
+    dataflash_write_pattern(2000, 0);
+    CHECK(dataflash.get_num_logs() == 2);
+    CHECK(dataflash.find_last_log() == 2);
+
+    // pages hold 508 bytes of data after the header. A new log drops
+    // the last part page of the log before it, while
+    // get_log_boundaries() writes it
+    uint16_t start_page, end_page;
+    dataflash.get_log_boundaries(1, start_page, end_page);
+    CHECK(start_page == 1);
+    CHECK(end_page == 5);
+    dataflash.get_log_boundaries(2, start_page, end_page);
+    CHECK(start_page == 6);
+    CHECK(end_page == 9);
+}
+
+static void test_dataflash_pages(void)
+{
+    dataflash.Init();
+    dataflash.EraseAll();
+    CHECK(dataflash.start_new_log() == 1);
+    dataflash_write_pattern(DF_RAM_PAGE_SIZE * 2, 0);
+
+    // each page starts with its log and page number, then the data
+    // carries on from the previous page
+    const uint16_t header = 4;
+    for (uint16_t p=1; p<=2; p++) {
+        const uint8_t *page = dataflash.page(p);
+        uint16_t file_number, file_page;
+        memcpy(&file_number, &page[0], 2);
+        memcpy(&file_page, &page[2], 2);
+        CHECK(file_number == 1);
+        CHECK(file_page == p);
+        uint8_t expected = (p - 1) * (DF_RAM_PAGE_SIZE - header);
+        bool pattern_ok = true;
+        for (uint16_t i=header; i<DF_RAM_PAGE_SIZE; i++) {
+            if (page[i] != expected++) {
+                pattern_ok = false;
+            }
+        }
+        CHECK(pattern_ok);
+    }
+
+    // the page being written is still in its buffer
+    CHECK(dataflash.page(3)[0] == 0xFF);
+
+    // the logging format is in the last page
+    uint32_t version;
+    memcpy(&version, &dataflash.page(DF_RAM_NUM_PAGES + 1)[header], sizeof(version));
+    CHECK(version == 0x28122013);
+}
+
+static void bench_dataflash_setup(void)
+{
+    dataflash.Init();
+    dataflash.EraseAll();
+    dataflash.start_new_log();
+}
+
+// a 32 byte packet, the size of an IMU log message, on each iteration
+static void bench_dataflash_write(uint32_t n)
+{
+    uint8_t pkt[32];
+    for (uint8_t i=0; i<sizeof(pkt); i++) {
+        pkt[i] = i;
+    }
+    for (uint32_t i=0; i<n; i++) {
+        pkt[3] = i;
+        dataflash.WriteBlock(pkt, sizeof(pkt));
+    }
+    bench_sink = dataflash.page(1)[8];
+}
+
+#endif // HAL_EMPTY_HOST
@@ -0,0 +1,121 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Filter tests and benchmarks
+//
+
+#ifdef HAL_EMPTY_HOST
+
+static void test_filter_lowpass(void)
+{
+    // a first order filter reaches 63% of a step in one time constant
+    LowPassFilterFloat lpf;
+    lpf.set_time_constant(0.01f, 0.5f);
+    // the first sample is the starting value
+    float out = lpf.apply(0);
+    for (uint8_t i=0; i<50; i++) {
+        out = lpf.apply(1.0f);
+    }
+    CHECK_FLOAT(out, 1 - expf(-1), 0.02f);
+    for (uint16_t i=0; i<1000; i++) {
+        out = lpf.apply(1.0f);
+    }
+    CHECK_FLOAT(out, 1, 1.0e-4f);
+}
+
+/*
+  the amplitude of a sine of freq Hz after the filter, sampled at
+  100Hz
+ */
+static float lowpass2p_gain(float freq)
+{
+    LowPassFilter2p lpf(100, 10);
+    float peak = 0;
+    for (uint16_t i=0; i<1000; i++) {
+        float out = lpf.apply(sinf(2 * PI * freq * i * 0.01f));
+        // past the settling of the filter
+        if (i >= 500) {
+            peak = max(peak, fabsf(out));
+        }
+    }
+    return peak;
+}
+
+static void test_filter_lowpass2p(void)
+{
+    LowPassFilter2p lpf(100, 10);
+    float out = 0;
+    for (uint16_t i=0; i<200; i++) {
+        out = lpf.apply(3.0f);
+    }
+    CHECK_FLOAT(out, 3.0f, 1.0e-4f);
+
+    // passes well below the cutoff and stops well above it
+    CHECK(lowpass2p_gain(1) > 0.98f);
+    CHECK_FLOAT(lowpass2p_gain(10), 0.707f, 0.05f);
+    CHECK(lowpass2p_gain(40) < 0.1f);
+}
+
+static void test_filter_average(void)
+{
+    AverageFilterInt16_Size4 avg;
+    CHECK(avg.apply(100) == 100);
+    CHECK(avg.apply(200) == 150);
+    avg.apply(300);
+    CHECK(avg.apply(400) == 250);
+    // the oldest sample drops out
+    CHECK(avg.apply(500) == 350);
+    avg.reset();
+    CHECK(avg.apply(-8) == -8);
+}
+
+static void test_filter_mode(void)
+{
+    // the middle of five samples is their median, so a single spike
+    // is removed
+    ModeFilterInt16_Size5 mode(2);
+    static const int16_t samples[] = { 100, 102, 900, 101, 99, 103 };
+    int16_t out = 0;
+    for (uint8_t i=0; i<sizeof(samples)/sizeof(samples[0]); i++) {
+        out = mode.apply(samples[i]);
+    }
+    CHECK(out >= 99 && out <= 103);
+}
+
+static void test_filter_derivative(void)
+{
+    // the slope of a ramp, with uneven sample times
+    DerivativeFilterFloat_Size7 deriv;
+    uint32_t t = 1000;
+    for (uint8_t i=0; i<20; i++) {
+        t += (i & 1) ? 90 : 110;
+        deriv.update(3.0f * t + 7, t);
+    }
+    CHECK_FLOAT(deriv.slope(), 3.0f, 1.0e-3f);
+
+    // a repeated timestamp is ignored
+    deriv.update(0, t);
+    CHECK_FLOAT(deriv.slope(), 3.0f, 1.0e-3f);
+}
+
+static void bench_filter_lowpass2p(uint32_t n)
+{
+    LowPassFilter2p lpf(1000, 20);
+    float out = 0;
+    for (uint32_t i=0; i<n; i++) {
+        out = lpf.apply((i & 0x3F) * 0.1f + out * 1.0e-6f);
+    }
+    bench_sink = out;
+}
+
+static void bench_filter_mode(uint32_t n)
+{
+    ModeFilterInt16_Size5 mode(2);
+    int16_t out = 0;
+    for (uint32_t i=0; i<n; i++) {
+        out = mode.apply((i * 7919) & 0x3FF);
+    }
+    bench_sink = out;
+}
+
+#endif // HAL_EMPTY_HOST
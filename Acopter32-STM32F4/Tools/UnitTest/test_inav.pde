@@ -0,0 +1,65 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// AP_InertialNav tests and benchmarks, with a 10Hz GPS
+//
+
+#ifdef HAL_EMPTY_HOST
+
+/*
+  run the sensors and inertial nav at rest for the given number of
+  100Hz loops, with the GPS fix at north and east
+ */
+static void inav_run(uint16_t loops, float north, float east)
+{
+    for (uint16_t i=0; i<loops; i++) {
+        sensor_step(Vector3f(0, 0, 0), Vector3f(0, 0, -GRAVITY_MSS), 10000);
+        if (i % 10 == 0) {
+            gps_fix(north, east);
+        }
+        inertial_nav.update(0.01f);
+    }
+}
+
+static void test_inav_stationary(void)
+{
+    reset_estimators();
+    inav_run(1000, 0, 0);
+    CHECK(inertial_nav.position_ok());
+    CHECK_FLOAT(inertial_nav.get_position().length(), 0, 5);
+    CHECK_FLOAT(inertial_nav.get_velocity().length(), 0, 2);
+    CHECK(inertial_nav.get_latitude() == home_lat);
+    CHECK(inertial_nav.get_longitude() == home_lng);
+}
+
+static void test_inav_gps_offset(void)
+{
+    // the position converges on a GPS fix 10m north and 5m west
+    reset_estimators();
+    inav_run(3000, 10, -5);
+    Vector3f pos = inertial_nav.get_position();
+    CHECK_FLOAT(pos.x, 1000, 20);
+    CHECK_FLOAT(pos.y, -500, 20);
+    CHECK_FLOAT(inertial_nav.get_velocity().length(), 0, 5);
+    CHECK(labs(inertial_nav.get_latitude() - g_gps_driver.latitude) < 20);
+}
+
+static void bench_inav_setup(void)
+{
+    reset_estimators();
+    inav_run(100, 0, 0);
+}
+
+static void bench_inav_update(uint32_t n)
+{
+    for (uint32_t i=0; i<n; i++) {
+        if (i % 10 == 0) {
+            advance_clock(10000);
+            gps_fix(0, 0);
+        }
+        inertial_nav.update(0.01f);
+    }
+    bench_sink = inertial_nav.get_position().x;
+}
+
+#endif // HAL_EMPTY_HOST
@@ -0,0 +1,259 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// AP_Math tests and benchmarks
+//
+
+#ifdef HAL_EMPTY_HOST
+
+static void test_math_wrap(void)
+{
+    CHECK(wrap_180_cd(18000) == 18000 || wrap_180_cd(18000) == -18000);
+    CHECK(wrap_180_cd(18100) == -17900);
+    CHECK(wrap_180_cd(-18100) == 17900);
+    // large angles are wrapped with a modulus
+    CHECK(wrap_180_cd(396000 + 500) == 500);
+    CHECK(wrap_360_cd(-100) == 35900);
+    CHECK(wrap_360_cd(36100) == 100);
+    CHECK_FLOAT(wrap_PI(3 * PI / 2), -PI / 2, 1.0e-5f);
+    CHECK_FLOAT(wrap_PI(-3 * PI / 2), PI / 2, 1.0e-5f);
+    CHECK_FLOAT(safe_asin(1.5f), PI / 2, 1.0e-6f);
+    CHECK_FLOAT(safe_sqrt(-1), 0, 0);
+    CHECK_FLOAT(constrain_float(5, -1, 1), 1, 0);
+    CHECK(constrain_int16(-5, -1, 1) == -1);
+}
+
+static void test_math_matrix_euler(void)
+{
+    // to_euler() gives back the angles given to from_euler() away
+    // from gimbal lock
+    static const float angles[][3] = {
+        { 0, 0, 0 },
+        { 0.3f, -0.2f, 1.0f },
+        { -1.2f, 0.7f, -2.5f },
+        { 2.5f, -1.3f, 3.0f },
+    };
+    for (uint8_t i=0; i<sizeof(angles)/sizeof(angles[0]); i++) {
+        Matrix3f m;
+        float roll, pitch, yaw;
+        m.from_euler(angles[i][0], angles[i][1], angles[i][2]);
+        m.to_euler(&roll, &pitch, &yaw);
+        CHECK_FLOAT(roll, angles[i][0], 1.0e-5f);
+        CHECK_FLOAT(pitch, angles[i][1], 1.0e-5f);
+        CHECK_FLOAT(yaw, angles[i][2], 1.0e-5f);
+
+        // a rotation matrix is orthonormal
+        Matrix3f mmt = m * m.transposed();
+        CHECK_FLOAT(mmt.a.x + mmt.b.y + mmt.c.z, 3, 1.0e-5f);
+        CHECK_FLOAT(mmt.a.y, 0, 1.0e-6f);
+        CHECK_FLOAT(m.mul_transpose(m * Vector3f(1, 2, 3)).z, 3, 1.0e-5f);
+    }
+
+    // a small rotation about z with rotate() turns the yaw
+    Matrix3f m;
+    m.identity();
+    for (uint8_t i=0; i<100; i++) {
+        m.rotate(Vector3f(0, 0, 0.01f));
+    }
+    float roll, pitch, yaw;
+    m.to_euler(&roll, &pitch, &yaw);
+    CHECK_FLOAT(yaw, 1.0f, 1.0e-3f);
+    CHECK_FLOAT(roll, 0, 1.0e-6f);
+}
+
+static void test_math_quaternion(void)
+{
+    Quaternion q;
+    q.from_euler(0.3f, -0.2f, 1.0f);
+    float roll, pitch, yaw;
+    q.to_euler(&roll, &pitch, &yaw);
+    CHECK_FLOAT(roll, 0.3f, 1.0e-5f);
+    CHECK_FLOAT(pitch, -0.2f, 1.0e-5f);
+    CHECK_FLOAT(yaw, 1.0f, 1.0e-5f);
+
+    // the quaternion and matrix of the same attitude agree
+    Matrix3f mq, me;
+    q.rotation_matrix(mq);
+    me.from_euler(0.3f, -0.2f, 1.0f);
+    CHECK_FLOAT((mq.a - me.a).length() + (mq.b - me.b).length() + (mq.c - me.c).length(), 0, 1.0e-5f);
+
+    Quaternion q2;
+    q2.from_rotation_matrix(me);
+    q2.to_euler(&roll, &pitch, &yaw);
+    CHECK_FLOAT(roll, 0.3f, 1.0e-5f);
+    CHECK_FLOAT(yaw, 1.0f, 1.0e-5f);
+
+    // rotate_fast() and rotate() agree for small rotations
+    Quaternion qa = q, qb = q;
+    qa.rotate(Vector3f(0.01f, -0.02f, 0.005f));
+    qb.rotate_fast(Vector3f(0.01f, -0.02f, 0.005f));
+    qb.normalize();
+    CHECK_FLOAT(qa.q1, qb.q1, 1.0e-5f);
+    CHECK_FLOAT(qa.q4, qb.q4, 1.0e-5f);
+}
+
+static void test_math_rotations(void)
+{
+    // each standard rotation is the same as its matrix
+    for (uint8_t r=0; r<ROTATION_MAX; r++) {
+        Vector3f v(1, 2, 3);
+        Matrix3f m;
+        m.from_rotation((enum Rotation)r);
+        Vector3f mv = m * v;
+        v.rotate((enum Rotation)r);
+        CHECK_FLOAT((v - mv).length(), 0, 1.0e-5f);
+    }
+    Vector3f v(1, 0, 0);
+    v.rotate(ROTATION_YAW_90);
+    CHECK_FLOAT(v.y, 1, 1.0e-6f);
+
+    // two rotations of 90 degrees make one of 180
+    Vector3f v2(1, 2, 3), v3(1, 2, 3);
+    v2.rotate(ROTATION_YAW_90);
+    v2.rotate(ROTATION_YAW_90);
+    v3.rotate(ROTATION_YAW_180);
+    CHECK_FLOAT((v2 - v3).length(), 0, 1.0e-6f);
+}
+
+static void test_math_rotate_vectors(void)
+{
+    Matrix3f m;
+    m.from_euler(0.4f, -0.3f, 2.0f);
+    Vector3f in[13], out[13], out_t[13];
+    for (uint8_t i=0; i<13; i++) {
+        in[i] = Vector3f(i, 1.0f - i, 0.5f * i * i);
+    }
+    // any count, including those which are not a multiple of the
+    // SIMD width
+    rotate_vectors(m, in, out, 13);
+    rotate_vectors_transpose(m, in, out_t, 13);
+    for (uint8_t i=0; i<13; i++) {
+        CHECK_FLOAT((out[i] - m * in[i]).length(), 0, 1.0e-4f);
+        CHECK_FLOAT((out_t[i] - m.mul_transpose(in[i])).length(), 0, 1.0e-4f);
+    }
+    // in place
+    rotate_vectors(m, in, in, 13);
+    CHECK_FLOAT((in[12] - out[12]).length(), 0, 0);
+}
+
+static void test_math_location(void)
+{
+    struct Location loc1, loc2;
+    loc1.lat = home_lat;
+    loc1.lng = home_lng;
+    loc2 = loc1;
+    location_offset(loc2, 300, 400);
+    CHECK_FLOAT(get_distance(loc1, loc2), 500, 0.5f);
+    CHECK(labs(get_bearing_cd(loc1, loc2) - 5313) < 10);
+    CHECK(labs(get_bearing_cd(loc2, loc1) - (5313 + 18000)) < 10);
+
+    Vector2f diff = location_diff(loc1, loc2);
+    CHECK_FLOAT(diff.x, 300, 0.5f);
+    CHECK_FLOAT(diff.y, 400, 0.5f);
+
+    // the longitude scale is the cosine of the latitude
+    CHECK_FLOAT(longitude_scale(loc1), cosf(ToRad(home_lat * 1.0e-7f)), 1.0e-3f);
+}
+
+static void test_math_location_frame(void)
+{
+    struct Location origin, loc;
+    origin.lat = home_lat;
+    origin.lng = home_lng;
+    origin.alt = 0;
+    LocationFrame frame;
+    CHECK(!frame.have_origin());
+    frame.set_origin(origin);
+    CHECK(frame.have_origin());
+
+    loc = origin;
+    frame.offset(loc, -120, 250);
+    Vector2f ne = frame.position_ne(loc);
+    CHECK_FLOAT(ne.x, -120, 0.02f);
+    CHECK_FLOAT(ne.y, 250, 0.02f);
+
+    // the same results as the functions of a single location
+    CHECK_FLOAT(frame.distance(origin, loc), get_distance(origin, loc), 0.01f);
+    CHECK(labs(frame.bearing_cd(origin, loc) - get_bearing_cd(origin, loc)) <= 1);
+
+    // cm positions round trip
+    Vector3f pos = frame.position_cm(loc);
+    CHECK(labs(frame.position_cm_lat(pos) - loc.lat) <= 1);
+    CHECK(labs(frame.position_cm_lng(pos) - loc.lng) <= 1);
+}
+
+static void bench_math_matrix_rotate(uint32_t n)
+{
+    Matrix3f m;
+    m.identity();
+    Vector3f g(0.001f, -0.002f, 0.0005f);
+    for (uint32_t i=0; i<n; i++) {
+        m.rotate(g);
+        // renormalise as AP_AHRS_DCM does
+        float error = m.a * m.b;
+        Vector3f t0 = m.a - (m.b * (0.5f * error));
+        Vector3f t1 = m.b - (m.a * (0.5f * error));
+        m.a = t0 * (1.0f / t0.length());
+        m.b = t1 * (1.0f / t1.length());
+        m.c = m.a % m.b;
+    }
+    bench_sink = m.c.z;
+}
+
+static void bench_math_quaternion_rotate(uint32_t n)
+{
+    Quaternion q;
+    Vector3f g(0.001f, -0.002f, 0.0005f);
+    for (uint32_t i=0; i<n; i++) {
+        q.rotate_fast(g);
+        q.normalize();
+    }
+    bench_sink = q.q1;
+}
+
+// 64 vectors, as for a batch of IMU samples
+static void bench_math_rotate_vectors(uint32_t n)
+{
+    static Vector3f v[64];
+    Matrix3f m;
+    m.from_euler(0.1f, 0.2f, 0.3f);
+    for (uint8_t i=0; i<64; i++) {
+        v[i] = Vector3f(i, -i, 1);
+    }
+    for (uint32_t i=0; i<n; i++) {
+        rotate_vectors(m, v, v, 64);
+    }
+    bench_sink = v[63].z;
+}
+
+static void bench_math_location(uint32_t n)
+{
+    struct Location loc1, loc2;
+    loc1.lat = home_lat;
+    loc1.lng = home_lng;
+    loc2 = loc1;
+    float sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        loc2.lat = home_lat + (i & 0xFFF);
+        sum += get_distance(loc1, loc2) + get_bearing_cd(loc1, loc2);
+    }
+    bench_sink = sum;
+}
+
+static void bench_math_location_frame(uint32_t n)
+{
+    struct Location loc1, loc2;
+    loc1.lat = home_lat;
+    loc1.lng = home_lng;
+    loc2 = loc1;
+    LocationFrame frame;
+    frame.set_origin(loc1);
+    float sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        loc2.lat = home_lat + (i & 0xFFF);
+        sum += frame.distance(loc1, loc2) + frame.bearing_cd(loc1, loc2);
+    }
+    bench_sink = sum;
+}
+
+#endif // HAL_EMPTY_HOST
@@ -0,0 +1,165 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// AP_Param tests and benchmarks, with a var_info table of scalars
+// and the groups of the estimators, as a vehicle has
+//
+
+#ifdef HAL_EMPTY_HOST
+
+class ParamTest {
+public:
+    enum {
+        k_param_format_version = 0,
+        k_param_sysid_this_mav,
+        k_param_log_bitmask,
+        k_param_gain,
+        k_param_ahrs,
+        k_param_inertial_nav,
+        k_param_wp_nav,
+    };
+    AP_Int8 format_version;
+    AP_Int16 sysid_this_mav;
+    AP_Int32 log_bitmask;
+    AP_Float gain;
+};
+
+static ParamTest pt;
+
+#define PSCALAR(v, name, def) { pt.v.vtype, name, ParamTest::k_param_ ## v, &pt.v, {def_value : def} }
+#define POBJECT(v, name, class) { AP_PARAM_GROUP, name, ParamTest::k_param_ ## v, &v, {group_info : class::var_info} }
+
+const AP_Param::Info var_info[] PROGMEM = {
+    PSCALAR(format_version, "FORMAT_VERSION", 120),
+    PSCALAR(sysid_this_mav, "SYSID_THISMAV",  1),
+    PSCALAR(log_bitmask,    "LOG_BITMASK",    0x123456),
+    PSCALAR(gain,           "TEST_GAIN",      0.25f),
+    POBJECT(ahrs,           "AHRS_",          AP_AHRS),
+    POBJECT(inertial_nav,   "INAV_",          AP_InertialNav),
+    POBJECT(wp_nav,         "WPNAV_",         AC_WPNav),
+    AP_VAREND
+};
+
+AP_Param param_loader(var_info, 1024);
+
+static void param_setup(void)
+{
+    hal.storage->format_eeprom();
+    AP_Param::setup_sketch_defaults();
+}
+
+static void test_param_names(void)
+{
+    param_setup();
+
+    // every parameter is found by name, with the index and without
+    AP_Param::ParamToken token;
+    enum ap_var_type type, found_type;
+    uint16_t count = 0;
+    for (AP_Param *ap = AP_Param::first(&token, &type);
+         ap != NULL;
+         ap = AP_Param::next_scalar(&token, &type)) {
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, sizeof(name), true);
+        if (AP_Param::find(name, &found_type) != ap) {
+            check_failed(__FILE__, __LINE__, name);
+        }
+        CHECK(found_type == type);
+        CHECK(AP_Param::find_linear(name, &found_type) == ap);
+        count++;
+    }
+    CHECK(count > 20);
+
+    // case insensitive, and unknown names are not found
+    CHECK(AP_Param::find("wpnav_speed", &type) == AP_Param::find("WPNAV_SPEED", &found_type));
+    CHECK(type == AP_PARAM_FLOAT);
+    CHECK(AP_Param::find("WPNAV_SPEEDX", &type) == NULL);
+    CHECK(AP_Param::find("NO_SUCH_PARAM", &type) == NULL);
+    CHECK(AP_Param::find("", &type) == NULL);
+
+    CHECK(AP_Param::find_object("WPNAV_") == (AP_Param *)&wp_nav);
+    CHECK(AP_Param::find_object("AHRS_") == (AP_Param *)&ahrs);
+    CHECK(AP_Param::find_object("TEST_") == NULL);
+}
+
+static void test_param_defaults(void)
+{
+    param_setup();
+    CHECK(pt.format_version == 120);
+    CHECK(pt.sysid_this_mav == 1);
+    CHECK(pt.log_bitmask == 0x123456);
+    CHECK_FLOAT(pt.gain, 0.25f, 0);
+
+    // the defaults of the groups are from the constructors
+    enum ap_var_type type;
+    AP_Float *speed = (AP_Float *)AP_Param::find("WPNAV_SPEED", &type);
+    CHECK(speed != NULL && type == AP_PARAM_FLOAT);
+    if (speed != NULL) {
+        CHECK_FLOAT(speed->get(), WPNAV_WP_SPEED, 0);
+    }
+}
+
+static void test_param_save_load(void)
+{
+    param_setup();
+    CHECK(pt.sysid_this_mav.set_and_save(7));
+    CHECK(pt.gain.set_and_save(1.5f));
+    CHECK(pt.log_bitmask.set_and_save(-2));
+
+    enum ap_var_type type;
+    AP_Float *speed = (AP_Float *)AP_Param::find("WPNAV_SPEED", &type);
+    CHECK(speed != NULL);
+    if (speed == NULL) {
+        return;
+    }
+    CHECK(speed->set_and_save(800));
+
+    // changes which are not saved are lost on a load
+    pt.sysid_this_mav.set(3);
+    pt.gain.set(0);
+    pt.log_bitmask.set(0);
+    speed->set(100);
+    pt.format_version.set(5);
+    CHECK(AP_Param::load_all());
+    CHECK(pt.sysid_this_mav == 7);
+    CHECK_FLOAT(pt.gain, 1.5f, 0);
+    CHECK(pt.log_bitmask == -2);
+    CHECK_FLOAT(speed->get(), 800, 0);
+    // not saved, so not changed by the load
+    CHECK(pt.format_version == 5);
+
+    // back to the defaults for the tests which follow. The defaults
+    // of groups are set by their constructors, not the sketch
+    param_setup();
+    CHECK(pt.sysid_this_mav == 1);
+    speed->set(WPNAV_WP_SPEED);
+}
+
+/*
+  find every parameter by name, as a ground station does when it sets
+  a list of parameters
+ */
+static void bench_param_find(uint32_t n)
+{
+    static char names[64][AP_MAX_NAME_SIZE+1];
+    static uint8_t num_names;
+    if (num_names == 0) {
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+        for (AP_Param *ap = AP_Param::first(&token, &type);
+             ap != NULL && num_names < 64;
+             ap = AP_Param::next_scalar(&token, &type)) {
+            ap->copy_name_token(token, names[num_names++], AP_MAX_NAME_SIZE+1, true);
+        }
+    }
+    enum ap_var_type type;
+    uintptr_t sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        for (uint8_t j=0; j<num_names; j++) {
+            sum += (uintptr_t)AP_Param::find(names[j], &type);
+        }
+    }
+    bench_sink = sum;
+}
+
+#endif // HAL_EMPTY_HOST
@@ -0,0 +1,126 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// AC_WPNav tests and benchmarks. The vehicle is moved by setting the
+// inertial nav position, so the tests are of the controller alone
+//
+
+#ifdef HAL_EMPTY_HOST
+
+static void wpnav_set_position(const Vector3f &pos, const Vector3f &vel)
+{
+    inertial_nav.set_position_xy(pos.x, pos.y);
+    inertial_nav.set_altitude(pos.z);
+    inertial_nav.set_velocity_xy(vel.x, vel.y);
+    inertial_nav.set_velocity_z(vel.z);
+}
+
+static void test_wpnav_bearing(void)
+{
+    reset_estimators();
+    wpnav_set_position(Vector3f(0, 0, 0), Vector3f(0, 0, 0));
+    wp_nav.set_origin_and_destination(Vector3f(0, 0, 0), Vector3f(0, 1000, 0));
+    CHECK(labs(wp_nav.get_bearing_to_destination() - 9000) <= 1);
+    CHECK_FLOAT(wp_nav.get_distance_to_destination(), 1000, 0.01f);
+
+    wp_nav.set_origin_and_destination(Vector3f(0, 0, 0), Vector3f(-500, -500, 0));
+    CHECK(labs(wp_nav.get_bearing_to_destination() - 22500) <= 1);
+}
+
+static void test_wpnav_stopping_point(void)
+{
+    Vector3f target;
+
+    // at rest the stopping point is where the vehicle is
+    wp_nav.get_stopping_point(Vector3f(100, 200, 300), Vector3f(0, 0, 0), target);
+    CHECK_FLOAT((target - Vector3f(100, 200, 300)).length(), 0, 0);
+
+    // ahead of the vehicle, further for a higher speed
+    wp_nav.get_stopping_point(Vector3f(0, 0, 0), Vector3f(500, 0, 0), target);
+    CHECK(target.x > 100);
+    CHECK_FLOAT(target.y, 0, 1.0e-3f);
+    Vector3f target_slow;
+    wp_nav.get_stopping_point(Vector3f(0, 0, 0), Vector3f(200, 0, 0), target_slow);
+    CHECK(target_slow.x > 0 && target_slow.x < target.x);
+}
+
+static void test_wpnav_segment(void)
+{
+    // a vehicle which follows the intermediate target exactly stays on
+    // the track and reaches the destination
+    reset_estimators();
+    Vector3f dest(1500, 2000, 0);
+    Vector3f pos(0, 0, 0);
+    wpnav_set_position(pos, Vector3f(0, 0, 0));
+    wp_nav.set_origin_and_destination(pos, dest);
+
+    float max_track_error = 0;
+    uint16_t steps;
+    for (steps=0; steps<600 && !wp_nav.reached_destination(); steps++) {
+        advance_clock(100000);
+        wp_nav.advance_target_along_track(0.1f);
+        Vector3f target = wp_nav.get_loiter_target();
+        wpnav_set_position(target, (target - pos) * 10);
+        pos = target;
+        // the distance from the line through the origin and destination
+        float error = fabsf(pos.x * 0.8f - pos.y * 0.6f);
+        max_track_error = max(max_track_error, error);
+    }
+    CHECK(wp_nav.reached_destination());
+    CHECK_FLOAT(max_track_error, 0, 0.1f);
+    CHECK_FLOAT((pos - dest).length(), 0, wp_nav.get_waypoint_radius());
+
+    // 25m at up to the waypoint speed
+    CHECK(steps > 2500 / wp_nav.get_horizontal_velocity() * 10);
+    CHECK(steps < 400);
+}
+
+static void test_wpnav_loiter(void)
+{
+    // on the target the lean angles are zero
+    reset_estimators();
+    wpnav_set_position(Vector3f(0, 0, 0), Vector3f(0, 0, 0));
+    wp_nav.init_loiter_target(Vector3f(0, 0, 0), Vector3f(0, 0, 0));
+    for (uint8_t i=0; i<50; i++) {
+        advance_clock(10000);
+        wp_nav.update_loiter();
+    }
+    CHECK(abs(wp_nav.get_desired_roll()) < 10);
+    CHECK(abs(wp_nav.get_desired_pitch()) < 10);
+
+    // a target to the north pitches the nose down, and one to the
+    // east rolls right
+    wp_nav.set_loiter_target(Vector3f(300, 0, 0));
+    for (uint8_t i=0; i<50; i++) {
+        advance_clock(10000);
+        wp_nav.update_loiter();
+    }
+    CHECK(wp_nav.get_desired_pitch() < -500);
+    CHECK(abs(wp_nav.get_desired_roll()) < 10);
+
+    wp_nav.set_loiter_target(Vector3f(0, 300, 0));
+    for (uint8_t i=0; i<50; i++) {
+        advance_clock(10000);
+        wp_nav.update_loiter();
+    }
+    CHECK(wp_nav.get_desired_roll() > 500);
+}
+
+static void bench_wpnav_setup(void)
+{
+    reset_estimators();
+    wpnav_set_position(Vector3f(0, 0, 0), Vector3f(0, 0, 0));
+    wp_nav.set_origin_and_destination(Vector3f(0, 0, 0), Vector3f(100000, 100000, 1000));
+}
+
+// update_wpnav() at 100Hz, running one of its steps on each call
+static void bench_wpnav_update(uint32_t n)
+{
+    for (uint32_t i=0; i<n; i++) {
+        advance_clock(10000);
+        wp_nav.update_wpnav();
+    }
+    bench_sink = wp_nav.get_desired_pitch();
+}
+
+#endif // HAL_EMPTY_HOST
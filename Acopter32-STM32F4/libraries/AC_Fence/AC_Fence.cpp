@@ -15,7 +15,7 @@ const AP_Param::GroupInfo AC_Fence::var_info[] PROGMEM = {
     // @Param: TYPE
     // @DisplayName: Fence Type
     // @Description: Enabled fence types held as bitmask
-    // @Values: 0:None,1:Altitude,2:Circle,3:Altitude and Circle
+    // @Values: 0:None,1:Altitude,2:Circle,3:Altitude and Circle,4:Polygon,5:Altitude and Polygon,6:Circle and Polygon,7:All
     // @User: Standard
     AP_GROUPINFO("TYPE",        1,  AC_Fence,   _enabled_fences,  AC_FENCE_TYPE_ALT_MAX | AC_FENCE_TYPE_CIRCLE),
 
@@ -50,7 +50,16 @@ const AP_Param::GroupInfo AC_Fence::var_info[] PROGMEM = {
     // @Range: 1 10
     // @User: Standard
     AP_GROUPINFO("MARGIN",      5,  AC_Fence,   _margin, AC_FENCE_MARGIN_DEFAULT),
-    
+
+#if AC_FENCE_POLYGON
+    // @Param: TOTAL
+    // @DisplayName: Fence polygon point total
+    // @Description: Number of polygon fence points including the return point. Set by the ground station when the fence is uploaded. The polygon fence is disabled if this is more than the board can store, which is 64 points on boards that keep the fence in eeprom
+    // @Range: 0 256
+    // @User: Advanced
+    AP_GROUPINFO("TOTAL",       6,  AC_Fence,   _total, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -62,6 +71,12 @@ AC_Fence::AC_Fence(AP_InertialNav* inav) :
     _alt_max_breach_distance(0),
     _circle_breach_distance(0),
     _home_distance(0),
+#if AC_FENCE_POLYGON
+    _poly_num_zones(0),
+    _poly_backup_distance(0),
+    _poly_breach_distance(0),
+    _poly_distance(0),
+#endif
     _breached_fences(AC_FENCE_TYPE_NONE),
     _breach_time(0),
     _breach_count(0)
@@ -101,7 +116,12 @@ bool AC_Fence::pre_arm_check() const
     }
 
     // if we have horizontal limits enabled, check inertial nav position is ok
-    if ((_enabled_fences & AC_FENCE_TYPE_CIRCLE)!=0 && !_inav->position_ok()) {
+    if ((_enabled_fences & (AC_FENCE_TYPE_CIRCLE | AC_FENCE_TYPE_POLYGON))!=0 && !_inav->position_ok()) {
+        return false;
+    }
+
+    // if we have the polygon fence enabled, check it has been loaded
+    if ((_enabled_fences & AC_FENCE_TYPE_POLYGON)!=0 && !polygon_valid()) {
         return false;
     }
 
@@ -180,11 +200,47 @@ uint8_t AC_Fence::check_fence()
         }
     }
 
+#if AC_FENCE_POLYGON
+    // polygon fence check
+    if ((_enabled_fences & AC_FENCE_TYPE_POLYGON) != 0 && _poly_num_zones > 0) {
+
+        Vector2l position(_inav->get_latitude(), _inav->get_longitude());
+        float distance;
+
+        // check if we are outside the fence or inside an exclusion zone
+        if (check_polygons(position, distance)) {
+
+            // record distance outside the fence
+            _poly_breach_distance = distance;
+            _poly_distance = 0;
+
+            // check for a new breach or a breach of the backup fence
+            if ((_breached_fences & AC_FENCE_TYPE_POLYGON) == 0 || (_poly_backup_distance != 0 && distance >= _poly_backup_distance)) {
+
+                // record that we have breached the polygon
+                record_breach(AC_FENCE_TYPE_POLYGON);
+                ret = ret | AC_FENCE_TYPE_POLYGON;
+
+                // create a backup fence 20m further out
+                _poly_backup_distance = distance + AC_FENCE_POLYGON_BACKUP_DISTANCE;
+            }
+        }else{
+            _poly_distance = distance;
+
+            // clear polygon breach if present
+            if ((_breached_fences & AC_FENCE_TYPE_POLYGON) != 0) {
+                clear_breach(AC_FENCE_TYPE_POLYGON);
+                _poly_backup_distance = 0;
+                _poly_breach_distance = 0;
+            }
+        }
+    }
+#endif
+
     // return any new breaches that have occurred
     return ret;
 
-    // To-Do: add min alt and polygon check
-    //outside = Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+    // To-Do: add min alt check
 }
 
 /// record_breach - update breach bitmask, time and count
@@ -217,19 +273,160 @@ void AC_Fence::clear_breach(uint8_t fence_type)
 }
 
 /// get_breach_distance - returns distance in meters outside of the given fence
+///     for a combination of fences the largest distance is returned
 float AC_Fence::get_breach_distance(uint8_t fence_type) const
 {
-    switch (fence_type) {
-        case AC_FENCE_TYPE_ALT_MAX:
-            return _alt_max_breach_distance;
-            break;
-        case AC_FENCE_TYPE_CIRCLE:
-            return _circle_breach_distance;
-            break;
-        case AC_FENCE_TYPE_ALT_MAX | AC_FENCE_TYPE_CIRCLE:
-            return max(_alt_max_breach_distance,_circle_breach_distance);
-    }
-
-    // we don't recognise the fence type so just return 0
+    float distance = 0;
+
+    if ((fence_type & AC_FENCE_TYPE_ALT_MAX) != 0) {
+        distance = max(distance, _alt_max_breach_distance);
+    }
+    if ((fence_type & AC_FENCE_TYPE_CIRCLE) != 0) {
+        distance = max(distance, _circle_breach_distance);
+    }
+#if AC_FENCE_POLYGON
+    if ((fence_type & AC_FENCE_TYPE_POLYGON) != 0) {
+        distance = max(distance, _poly_breach_distance);
+    }
+#endif
+
+    // fence types we don't recognise add nothing
+    return distance;
+}
+
+/// get_polygon_total - returns the number of polygon fence points including the return point.  Zero if FENCE_TOTAL is more than AC_FENCE_POLYGON_POINTS_MAX
+uint16_t AC_Fence::get_polygon_total() const
+{
+#if AC_FENCE_POLYGON
+    // a fence we can't hold all of is rejected, rather than cut short
+    if (_total <= 0 || _total > AC_FENCE_POLYGON_POINTS_MAX) {
+        return 0;
+    }
+    return _total;
+#else
     return 0;
+#endif
+}
+
+/// set_polygon_point - stores a polygon fence point.  The polygon fence is disabled until the last point has been stored
+bool AC_Fence::set_polygon_point(uint16_t i, const Vector2l &point)
+{
+#if AC_FENCE_POLYGON
+    uint16_t total = get_polygon_total();
+    if (i >= total) {
+        return false;
+    }
+
+    // the zones refer to the points, so can't be used while they change
+    _poly_num_zones = 0;
+    _poly_points[i] = point;
+
+    if (i == total-1) {
+        load_polygons();
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// get_polygon_point - returns a polygon fence point as latitude and longitude in 1e-7 degrees
+Vector2l AC_Fence::get_polygon_point(uint16_t i) const
+{
+#if AC_FENCE_POLYGON
+    if (i < get_polygon_total()) {
+        return _poly_points[i];
+    }
+#endif
+    return Vector2l(0, 0);
+}
+
+/// polygon_valid - returns true if the polygon fence points hold a complete inclusion polygon and exclusion zones
+bool AC_Fence::polygon_valid() const
+{
+#if AC_FENCE_POLYGON
+    return _poly_num_zones > 0;
+#else
+    return false;
+#endif
+}
+
+/// get_polygon_distance - returns distance in meters to the nearest polygon fence boundary, up to AC_FENCE_POLYGON_DISTANCE_MAX.  Zero when breached
+float AC_Fence::get_polygon_distance() const
+{
+#if AC_FENCE_POLYGON
+    if (_poly_num_zones > 0) {
+        return _poly_distance;
+    }
+#endif
+    return AC_FENCE_POLYGON_DISTANCE_MAX;
+}
+
+/// load_polygons - split the polygon fence points into the inclusion polygon and exclusion zones and index them
+void AC_Fence::load_polygons()
+{
+#if AC_FENCE_POLYGON
+    uint16_t total = get_polygon_total();
+    uint8_t zones = 0;
+    uint16_t refs = 0;
+
+    _poly_num_zones = 0;
+
+    // point 0 is the return point, which we don't use.  Each polygon
+    // ends at the first repeat of its first point
+    uint16_t start = 1;
+    for (uint16_t i=start+1; i<total; i++) {
+        const Vector2l &first = _poly_points[start];
+        if (_poly_points[i].x != first.x || _poly_points[i].y != first.y) {
+            continue;
+        }
+        uint16_t n = i - start + 1;
+        if (zones >= AC_FENCE_POLYGON_ZONES_MAX || !Polygon_complete(&_poly_points[start], n)) {
+            return;
+        }
+        // an unindexed polygon is still checked, just more slowly.
+        // Distances use the scale of the navigation frame once home is set
+        _poly_zones[zones].set_refs(&_poly_refs[refs], AC_FENCE_POLYGON_REFS_MAX - refs);
+        _poly_zones[zones].build(&_poly_points[start], n, location_frame.lng_scale());
+        refs += _poly_zones[zones].num_refs();
+        zones++;
+        start = i + 1;
+        i = start;
+    }
+
+    // every point must belong to a polygon
+    if (start != total || zones == 0) {
+        return;
+    }
+    _poly_num_zones = zones;
+    _poly_distance = AC_FENCE_POLYGON_DISTANCE_MAX;
+#endif
+}
+
+/// check_polygons - returns true if the position is outside the inclusion polygon or inside an exclusion zone
+bool AC_Fence::check_polygons(const Vector2l &position, float &distance) const
+{
+#if AC_FENCE_POLYGON
+    bool breached = false;
+    float breach_distance = 0;
+    float inside_distance = AC_FENCE_POLYGON_DISTANCE_MAX;
+
+    for (uint8_t i=0; i<_poly_num_zones; i++) {
+        // zone 0 is the inclusion polygon, the others are exclusion zones
+        bool outside = _poly_zones[i].outside(position);
+        if (outside == (i == 0)) {
+            breached = true;
+            breach_distance = max(breach_distance, _poly_zones[i].distance(position, AC_FENCE_POLYGON_BREACH_DISTANCE_MAX));
+        } else if (!breached) {
+            // searching only as far as the nearest boundary so far
+            // keeps this quick when well inside the fence
+            inside_distance = min(inside_distance, _poly_zones[i].distance(position, inside_distance));
+        }
+    }
+    distance = breached ? breach_distance : inside_distance;
+    return breached;
+#else
+    distance = 0;
+    return false;
+#endif
 }
\ No newline at end of file
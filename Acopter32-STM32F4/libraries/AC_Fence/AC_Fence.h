@@ -3,6 +3,7 @@
 #define AC_FENCE_H
 
 #include <inttypes.h>
+#include <AP_HAL.h>
 #include <AP_Common.h>
 #include <AP_Param.h>
 #include <AP_Math.h>
@@ -12,6 +13,7 @@
 #define AC_FENCE_TYPE_NONE                          0       // fence disabled
 #define AC_FENCE_TYPE_ALT_MAX                       1       // high alt fence which usually initiates an RTL
 #define AC_FENCE_TYPE_CIRCLE                        2       // circular horizontal fence (usually initiates an RTL)
+#define AC_FENCE_TYPE_POLYGON                       4       // polygon horizontal fence with optional exclusion zones (usually initiates an RTL)
 
 // valid actions should a fence be breached
 #define AC_FENCE_ACTION_REPORT_ONLY                 0       // report to GCS that boundary has been breached but take no further action
@@ -23,6 +25,27 @@
 #define AC_FENCE_ALT_MAX_BACKUP_DISTANCE            20.0f   // after fence is broken we recreate the fence 20m further up
 #define AC_FENCE_CIRCLE_RADIUS_BACKUP_DISTANCE      20.0f   // after fence is broken we recreate the fence 20m further out
 #define AC_FENCE_MARGIN_DEFAULT                     2.0f    // default distance in meters that autopilot's should maintain from the fence to avoid a breach
+#define AC_FENCE_POLYGON_BACKUP_DISTANCE            20.0f   // after polygon fence is broken we recreate the fence 20m further out
+#define AC_FENCE_POLYGON_DISTANCE_MAX               50.0f   // furthest distance to the polygon fence reported while inside it
+#define AC_FENCE_POLYGON_BREACH_DISTANCE_MAX        1000.0f // furthest distance to the polygon fence reported while outside it
+
+// polygon fence storage. Point 0 is the return point, followed by the
+// inclusion polygon and then the exclusion zones, each closed by
+// repeating its first point.  The maximum number of points, including
+// the return point, is what the vehicle can keep in its fence storage
+#if CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2
+ # define AC_FENCE_POLYGON                          0
+ # define AC_FENCE_POLYGON_POINTS_MAX               0
+#else
+ # define AC_FENCE_POLYGON                          1
+ #if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_PX4
+  # define AC_FENCE_POLYGON_POINTS_MAX              256
+ #else
+  # define AC_FENCE_POLYGON_POINTS_MAX              64      // boards that keep the fence in eeprom
+ #endif
+ # define AC_FENCE_POLYGON_ZONES_MAX                3       // the inclusion polygon and up to 2 exclusion zones
+ # define AC_FENCE_POLYGON_REFS_MAX                 (AC_FENCE_POLYGON_POINTS_MAX * POLYGON_INDEX_REFS_PER_EDGE) // edge references shared by the zone indexes
+#endif
 
 // give up distance
 #define AC_FENCE_GIVE_UP_DISTANCE                   100.0f  // distance outside the fence at which we should give up and just land.  Note: this is not used by library directly but is intended to be used by the main code
@@ -70,6 +93,26 @@ public:
 
     /// get_safe_alt - returns maximum safe altitude (i.e. alt_max - margin)
     float get_safe_alt() const { return _alt_max - _margin; }
+
+    ///
+    /// polygon fence methods
+    ///
+
+    /// get_polygon_total - returns the number of polygon fence points including the return point.  Zero if FENCE_TOTAL is more than AC_FENCE_POLYGON_POINTS_MAX
+    uint16_t get_polygon_total() const;
+
+    /// set_polygon_point - stores a polygon fence point.  The polygon fence is disabled until the last point has been stored
+    bool set_polygon_point(uint16_t i, const Vector2l &point);
+
+    /// get_polygon_point - returns a polygon fence point as latitude and longitude in 1e-7 degrees
+    Vector2l get_polygon_point(uint16_t i) const;
+
+    /// polygon_valid - returns true if the polygon fence points hold a complete inclusion polygon and exclusion zones
+    bool polygon_valid() const;
+
+    /// get_polygon_distance - returns distance in meters to the nearest polygon fence boundary, up to AC_FENCE_POLYGON_DISTANCE_MAX.  Zero when breached
+    ///     allows the position controller to slow down before reaching the fence
+    float get_polygon_distance() const;
     
     ///
     /// time saving methods to piggy-back on main code's calculations
@@ -88,6 +131,13 @@ private:
     /// clear_breach - update breach bitmask, time and count
     void clear_breach(uint8_t fence_type);
 
+    /// load_polygons - split the polygon fence points into the inclusion polygon and exclusion zones and index them
+    void load_polygons();
+
+    /// check_polygons - returns true if the position is outside the inclusion polygon or inside an exclusion zone
+    ///     distance is set to the distance in meters beyond the breached boundaries, or to the nearest boundary if there is no breach
+    bool check_polygons(const Vector2l &position, float &distance) const;
+
     // pointers to other objects we depend upon
     AP_InertialNav* _inav;
 
@@ -98,6 +148,9 @@ private:
     AP_Float        _alt_max;               // altitude upper limit in meters
     AP_Float        _circle_radius;         // circle fence radius in meters
     AP_Float        _margin;                // distance in meters that autopilot's should maintain from the fence to avoid a breach
+#if AC_FENCE_POLYGON
+    AP_Int16        _total;                 // number of polygon fence points including the return point
+#endif
 
     // backup fences
     float           _alt_max_backup;        // backup altitude upper limit in meters used to refire the breach if the vehicle continues to move further away
@@ -110,6 +163,17 @@ private:
     // other internal variables
     float           _home_distance;         // distance from home in meters (provided by main code)
 
+#if AC_FENCE_POLYGON
+    // polygon fence
+    Vector2l        _poly_points[AC_FENCE_POLYGON_POINTS_MAX];  // fence points as received from the ground station
+    PolygonIndex    _poly_zones[AC_FENCE_POLYGON_ZONES_MAX];    // inclusion polygon followed by exclusion zones
+    uint16_t        _poly_refs[AC_FENCE_POLYGON_REFS_MAX];      // edge references of the zone indexes
+    uint8_t         _poly_num_zones;        // number of zones loaded, zero if the points are not a valid fence
+    float           _poly_backup_distance;  // backup polygon breach distance used to refire the breach if the vehicle continues to move further away
+    float           _poly_breach_distance;  // distance beyond the polygon fence
+    float           _poly_distance;         // distance inside the polygon fence
+#endif
+
     // breach information
     uint8_t         _breached_fences;       // bitmask holding the fence type that was breached (i.e. AC_FENCE_TYPE_ALT_MIN, AC_FENCE_TYPE_CIRCLE)
     uint32_t        _breach_time;           // time of last breach in milliseconds
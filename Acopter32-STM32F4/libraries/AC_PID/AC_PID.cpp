@@ -6,6 +6,9 @@
 #include <AP_Math.h>
 #include "AC_PID.h"
 
+// _filter is the time constant of the derivative low pass filter,
+// which get_d() applies with the dt it is given, so the cut off
+// frequency is the same at any main loop rate.
 // Examples for _filter:
 // f_cut = 10 Hz -> _filter = 15.9155e-3
 // f_cut = 15 Hz -> _filter = 10.6103e-3
@@ -42,13 +45,7 @@ int32_t AC_PID::get_p(int32_t error)
 int32_t AC_PID::get_i(int32_t error, float dt)
 {
     if((_ki != 0) && (dt != 0)) {
-        _integrator += ((float)error * _ki) * dt;
-        if (_integrator < -_imax) {
-            _integrator = -_imax;
-        } else if (_integrator > _imax) {
-            _integrator = _imax;
-        }
-        return _integrator;
+        return _core.integrate((float)error * _ki, dt, _imax);
     }
     return 0;
 }
@@ -59,15 +56,8 @@ int32_t AC_PID::get_i(int32_t error, float dt)
 int32_t AC_PID::get_leaky_i(int32_t error, float dt, float leak_rate)
 {
 	if((_ki != 0) && (dt != 0)){
-		_integrator -= (float)_integrator * leak_rate;
-		_integrator += ((float)error * _ki) * dt;
-		if (_integrator < -_imax) {
-			_integrator = -_imax;
-		} else if (_integrator > _imax) {
-			_integrator = _imax;
-		}
-
-		return _integrator;
+		_core.integrator -= _core.integrator * leak_rate;
+		return _core.integrate((float)error * _ki, dt, _imax);
 	}
 	return 0;
 }
@@ -75,26 +65,7 @@ int32_t AC_PID::get_leaky_i(int32_t error, float dt, float leak_rate)
 int32_t AC_PID::get_d(int32_t input, float dt)
 {
     if ((_kd != 0) && (dt != 0)) {
-        float derivative;
-		if (isnan(_last_derivative)) {
-			// we've just done a reset, suppress the first derivative
-			// term as we don't want a sudden change in input to cause
-			// a large D output change			
-			derivative = 0;
-			_last_derivative = 0;
-		} else {
-			// calculate instantaneous derivative
-			derivative = (input - _last_input) / dt;
-		}
-
-        // discrete low pass filter, cuts out the
-        // high frequency noise that can drive the controller crazy
-        derivative = _last_derivative +
-                      (dt / ( _filter + dt)) * (derivative - _last_derivative);
-
-        // update state
-        _last_input             = input;
-        _last_derivative    = derivative;
+        float derivative = _core.derivative(input, dt, _core.filter_gain(_filter, dt));
 
         // add in derivative component
         return _kd * derivative;
@@ -116,9 +87,7 @@ int32_t AC_PID::get_pid(int32_t error, float dt)
 void
 AC_PID::reset_I()
 {
-    _integrator = 0;
-	// mark derivative as invalid
-    _last_derivative = NAN;
+    _core.reset_I();
 }
 
 void
@@ -139,3 +108,41 @@ AC_PID::save_gains()
     _kd.save();
     _imax.save();
 }
+
+AC_PIDBank::AC_PIDBank(AC_PID &roll, AC_PID &pitch, AC_PID &yaw)
+{
+    _pid[0] = &roll;
+    _pid[1] = &pitch;
+    _pid[2] = &yaw;
+    memset(_terms, 0, sizeof(_terms));
+}
+
+void
+AC_PIDBank::update(const int32_t error[3], float dt, bool limit_roll_pitch, bool limit_yaw)
+{
+    float gain = AP_PIDCore<AP_PID_D_FILTER>::filter_gain(AC_PID::_filter, dt);
+
+    for (uint8_t axis=0; axis<3; axis++) {
+        AC_PID &pid = *_pid[axis];
+        struct terms &t = _terms[axis];
+        int32_t e = error[axis];
+        float ki = pid._ki;
+        float kd = pid._kd;
+
+        t.p = (float)e * pid._kp;
+
+        if (pid._core.hold_I(e, axis == 2 ? limit_yaw : limit_roll_pitch)) {
+            t.i = pid._core.integrator;
+        } else if (ki != 0 && dt != 0) {
+            t.i = pid._core.integrate((float)e * ki, dt, pid._imax);
+        } else {
+            t.i = 0;
+        }
+
+        if (kd != 0 && dt != 0) {
+            t.d = kd * pid._core.derivative(e, dt, gain);
+        } else {
+            t.d = 0;
+        }
+    }
+}
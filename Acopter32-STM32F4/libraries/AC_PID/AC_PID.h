@@ -8,6 +8,7 @@
 
 #include <AP_Common.h>
 #include <AP_Param.h>
+#include <AP_PIDCore.h>
 #include <stdlib.h>
 #include <math.h>               // for fabs()
 
@@ -38,9 +39,6 @@ public:
         _ki = initial_i;
         _kd = initial_d;
         _imax = abs(initial_imax);
-
-		// derivative is invalid on startup
-		_last_derivative = NAN;
     }
 
     /// Iterate the PID, return the new control value
@@ -114,27 +112,71 @@ public:
     }
 
     float        get_integrator() const {
-        return _integrator;
+        return _core.integrator;
     }
     void        set_integrator(float i) {
-        _integrator = i;
+        _core.integrator = i;
     }
 
     static const struct AP_Param::GroupInfo        var_info[];
 
 private:
+    friend class AC_PIDBank;
+
     AP_Float        _kp;
     AP_Float        _ki;
     AP_Float        _kd;
     AP_Int16        _imax;
 
-    float           _integrator;                                ///< integrator value
-    int32_t         _last_input;                                ///< last input for derivative
-    float           _last_derivative;                           ///< last derivative for low-pass filter
+    /// integrator and filtered derivative of the input
+    AP_PIDCore<AP_PID_I | AP_PID_D | AP_PID_D_FILTER, int32_t> _core;
 
     /// Low pass filter cut frequency for derivative calculation.
     ///
     static const float  _filter;
 };
 
+/// @class	AC_PIDBank
+/// @brief	The roll, pitch and yaw rate controllers of a multicopter,
+///         updated together
+///
+/// Each controller gives the same terms as get_p(), get_i() and get_d()
+/// called in turn, with the integrator held while the motors are at a
+/// limit unless the error would reduce it. The checks on dt and the
+/// derivative filter gain are worked out once for the three.
+class AC_PIDBank {
+public:
+    AC_PIDBank(AC_PID &roll, AC_PID &pitch, AC_PID &yaw);
+
+    /// the terms of one controller in the last update
+    struct terms {
+        int32_t p;
+        int32_t i;
+        int32_t d;
+    };
+
+    /// Update the three controllers
+    ///
+    /// @param error                roll, pitch and yaw rate errors
+    /// @param dt                   time step in seconds
+    /// @param limit_roll_pitch     motors at a roll or pitch limit
+    /// @param limit_yaw            motors at a yaw limit
+    ///
+    void update(const int32_t error[3], float dt, bool limit_roll_pitch, bool limit_yaw);
+
+    /// terms of the roll (0), pitch (1) or yaw (2) controller
+    const struct terms &get_terms(uint8_t axis) const {
+        return _terms[axis];
+    }
+
+    /// p+i+d of the roll (0), pitch (1) or yaw (2) controller
+    int32_t output(uint8_t axis) const {
+        return _terms[axis].p + _terms[axis].i + _terms[axis].d;
+    }
+
+private:
+    AC_PID *_pid[3];
+    struct terms _terms[3];
+};
+
 #endif // __AC_PID_H__
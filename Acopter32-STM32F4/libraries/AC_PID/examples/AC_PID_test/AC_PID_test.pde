@@ -9,6 +9,7 @@
 #include <AP_HAL_AVR.h>
 #include <AP_Math.h>
 #include <AP_Param.h>
+#include <AP_PIDCore.h>
 #include <AC_PID.h>
 
 const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
@@ -0,0 +1,86 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/// @file	AC_RateLoop.cpp
+/// @brief	Multicopter rate controllers run on each gyro sample
+
+#include <AP_HAL.h>
+#include "AC_RateLoop.h"
+
+extern const AP_HAL::HAL& hal;
+
+// radians to centi-degrees, as DEGX100 in ArduCopter
+#define RAD_TO_CDEG 5729.57795f
+
+AC_RateLoop::AC_RateLoop(AC_PID &pid_roll, AC_PID &pid_pitch, AC_PID &pid_yaw,
+                         RC_Channel &rc_roll, RC_Channel &rc_pitch, RC_Channel &rc_yaw,
+                         AP_Motors &motors) :
+    _pids(pid_roll, pid_pitch, pid_yaw),
+    _rc_roll(rc_roll),
+    _rc_pitch(rc_pitch),
+    _rc_yaw(rc_yaw),
+    _motors(motors),
+    _reset_latency(false),
+    _latency_sum(0),
+    _num_samples(0),
+    _latency_max(0)
+{
+}
+
+void AC_RateLoop::set_targets(int32_t roll, int32_t pitch, int32_t yaw)
+{
+    struct setpoint sp;
+    sp.roll = roll;
+    sp.pitch = pitch;
+    sp.yaw = yaw;
+    sp.time_usec = hal.scheduler->micros();
+    _setpoint.post(sp);
+}
+
+void AC_RateLoop::gyro_sample(const Vector3f &gyro, float dt)
+{
+    uint32_t start = hal.scheduler->micros();
+
+    struct setpoint sp;
+    if (!_motors.armed() ||
+        !_setpoint.read(sp) ||
+        start - sp.time_usec > AC_RATELOOP_TIMEOUT_USEC ||
+        dt <= 0 || dt > AC_RATELOOP_TIMEOUT_USEC * 1.0e-6f) {
+        // disarmed, no targets from the main loop, or a gap in the samples
+        return;
+    }
+
+    Vector3f rate = gyro * RAD_TO_CDEG;
+
+    int32_t error[3];
+    error[0] = sp.roll - (int32_t)rate.x;
+    error[1] = sp.pitch - (int32_t)rate.y;
+    error[2] = sp.yaw - (int32_t)rate.z;
+    _pids.update(error, dt, _motors.limit.roll_pitch, _motors.limit.yaw);
+
+    _rc_roll.servo_out = constrain_int32(_pids.output(0), -5000, 5000);
+    _rc_pitch.servo_out = constrain_int32(_pids.output(1), -5000, 5000);
+    _rc_yaw.servo_out = constrain_int32(_pids.output(2), -4500, 4500);
+
+    _motors.output();
+
+    uint32_t latency = hal.scheduler->micros() - start;
+    if (_reset_latency) {
+        _reset_latency = false;
+        _latency_sum = 0;
+        _num_samples = 0;
+        _latency_max = 0;
+    }
+    _latency_sum += latency;
+    _num_samples++;
+    if (latency > _latency_max) {
+        _latency_max = latency;
+    }
+}
+
+uint16_t AC_RateLoop::latency_avg_usec() const
+{
+    if (_num_samples == 0) {
+        return 0;
+    }
+    return _latency_sum / _num_samples;
+}
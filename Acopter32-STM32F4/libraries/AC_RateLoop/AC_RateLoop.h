@@ -0,0 +1,93 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/// @file	AC_RateLoop.h
+/// @brief	Multicopter rate controllers run on each gyro sample
+
+#ifndef __AC_RATELOOP_H__
+#define __AC_RATELOOP_H__
+
+#include <AP_Common.h>
+#include <AP_Math.h>
+#include <AP_Mailbox.h>
+#include <AC_PID.h>
+#include <RC_Channel.h>
+#include <AP_Motors.h>
+
+// a setpoint older than this is not used, so the motors are left
+// alone when the main loop stops
+#ifndef AC_RATELOOP_TIMEOUT_USEC
+ # define AC_RATELOOP_TIMEOUT_USEC 50000
+#endif
+
+/// @class	AC_RateLoop
+/// @brief	Runs the roll, pitch and yaw rate PIDs and the motor mixer on
+///         each gyro sample, rather than once per main loop.
+///
+/// The main loop gives the body frame rate targets to set_targets()
+/// once per loop, and gyro_sample() is given to the inertial sensor as
+/// its gyro sample hook. It runs from the timer process, so the time
+/// from a gyro sample to the motor outputs no longer includes the
+/// attitude and navigation code of the main loop, nor the scheduler
+/// tasks which run late. The controllers are the same as the
+/// multicopter rate controllers of the main loop, with the same gains.
+/// The main loop keeps setting the throttle in the throttle channel.
+///
+/// The motors are only driven from here while they are armed. While
+/// disarmed the main loop outputs to them, and it suspends the timer
+/// process while it arms, disarms or otherwise changes their state.
+class AC_RateLoop {
+public:
+    AC_RateLoop(AC_PID &pid_roll, AC_PID &pid_pitch, AC_PID &pid_yaw,
+                RC_Channel &rc_roll, RC_Channel &rc_pitch, RC_Channel &rc_yaw,
+                AP_Motors &motors);
+
+    /// Set the rate targets from the main loop
+    ///
+    /// @param roll, pitch, yaw   rate targets in centi-degrees/sec in the
+    ///                           body frame
+    ///
+    void set_targets(int32_t roll, int32_t pitch, int32_t yaw);
+
+    /// Run the controllers on one gyro sample, if the motors are armed.
+    /// This is the gyro sample hook of the inertial sensor, and is
+    /// called from the timer process
+    ///
+    /// @param gyro     the sample in radians/sec
+    /// @param dt       seconds since the previous sample
+    ///
+    void gyro_sample(const Vector3f &gyro, float dt);
+
+    /// @name	latency from a gyro sample to the motor outputs, in
+    ///         microseconds, since the last latency_reset()
+    //@{
+    uint16_t latency_avg_usec() const;
+    uint16_t latency_max_usec() const { return _latency_max; }
+    uint32_t num_samples() const { return _num_samples; }
+    void latency_reset() { _reset_latency = true; }
+    //@}
+
+private:
+    struct setpoint {
+        int32_t roll;
+        int32_t pitch;
+        int32_t yaw;
+        uint32_t time_usec;
+    };
+
+    // the rate controllers, run as the main loop runs them
+    AC_PIDBank _pids;
+    RC_Channel &_rc_roll;
+    RC_Channel &_rc_pitch;
+    RC_Channel &_rc_yaw;
+    AP_Motors &_motors;
+
+    AP_Mailbox<struct setpoint> _setpoint;
+
+    // latency statistics, updated in the timer process
+    volatile bool _reset_latency;
+    uint32_t _latency_sum;
+    uint32_t _num_samples;
+    uint16_t _latency_max;
+};
+
+#endif // __AC_RATELOOP_H__
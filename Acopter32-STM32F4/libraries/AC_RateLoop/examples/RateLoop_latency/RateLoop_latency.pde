@@ -0,0 +1,213 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Latency from a gyro sample to the motor outputs, with the rate
+// controllers run inline at the end of the fast loop and with them
+// run by AC_RateLoop on each sample.
+//
+// The gyro gives a sample every millisecond. The main loop runs at
+// 100, 200 and 400Hz, spending FAST_LOOP_USEC on the attitude and
+// navigation code before the rate controllers, followed by the
+// scheduler tasks, one of which overruns by SLOW_TASK_USEC every
+// SLOW_TASK_TICKS ticks. The timer process is simulated by polling
+// for due samples every POLL_USEC of main loop work, so the rate loop
+// figures include up to POLL_USEC of delay which a real timer
+// interrupt would not have. Run it on SITL or Linux for the timing
+// of a PC, or on a board for real figures.
+//
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_Math.h>
+#include <AP_Notify.h>
+#include <AP_Curve.h>
+#include <RC_Channel.h>
+#include <AP_Motors.h>
+#include <AP_PIDCore.h>
+#include <AC_PID.h>
+#include <AC_RateLoop.h>
+
+// needed by the SITL HAL
+#include <AP_ADC.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Baro.h>
+#include <GCS_MAVLink.h>
+#include <Filter.h>
+#include <SITL.h>
+#include <AP_Vehicle.h>
+#include <AP_Buffer.h>
+#include <AP_GPS_Glitch.h>
+#include <AP_ADC_AnalogSource.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define BENCH_SECONDS   3
+#define SAMPLE_USEC     1000
+#define FAST_LOOP_USEC  900
+#define TASKS_USEC      400
+#define SLOW_TASK_USEC  3000
+#define SLOW_TASK_TICKS 50
+#define POLL_USEC       20
+
+RC_Channel rc1(0), rc2(1), rc3(2), rc4(3);
+AP_MotorsQuad motors(&rc1, &rc2, &rc3, &rc4);
+AC_PID pid_roll(0.15f, 0.1f, 0.004f, 500);
+AC_PID pid_pitch(0.15f, 0.1f, 0.004f, 500);
+AC_PID pid_yaw(0.2f, 0.02f, 0, 800);
+AC_RateLoop rate_loop(pid_roll, pid_pitch, pid_yaw, rc1, rc2, rc4, motors);
+
+// the simulated gyro
+static uint32_t next_sample_usec;
+static const Vector3f gyro(0.02f, -0.01f, 0.005f);
+
+// latency of the outputs in the current run, with a histogram in
+// 100us steps for the 99th percentile. The maximum on a PC is mostly
+// the operating system
+#define HIST_SIZE 100
+static uint32_t latency_sum;
+static uint32_t latency_max;
+static uint32_t num_outputs;
+static uint32_t latency_hist[HIST_SIZE];
+
+static void record_output(uint32_t sample_usec)
+{
+    uint32_t latency = hal.scheduler->micros() - sample_usec;
+    latency_sum += latency;
+    latency_max = max(latency_max, latency);
+    latency_hist[min(latency / 100, HIST_SIZE-1)]++;
+    num_outputs++;
+}
+
+static uint32_t latency_p99(void)
+{
+    uint32_t count = 0;
+    for (uint8_t i=0; i<HIST_SIZE; i++) {
+        count += latency_hist[i];
+        if (count * 100 >= num_outputs * 99) {
+            return (i+1) * 100;
+        }
+    }
+    return HIST_SIZE * 100;
+}
+
+/*
+  run the rate loop on the samples which are due, as the timer process
+  would. Without a rate loop the samples are left for the main loop,
+  as the inertial sensor driver sums them
+ */
+static bool use_rate_loop;
+
+static void poll_samples(void)
+{
+    while ((int32_t)(hal.scheduler->micros() - next_sample_usec) >= 0) {
+        uint32_t sample_usec = next_sample_usec;
+        next_sample_usec += SAMPLE_USEC;
+        if (use_rate_loop) {
+            rate_loop.gyro_sample(gyro, SAMPLE_USEC * 1.0e-6f);
+            record_output(sample_usec);
+        }
+    }
+}
+
+// stand in for usec of main loop work
+static void work(uint32_t usec)
+{
+    uint32_t start = hal.scheduler->micros();
+    while (hal.scheduler->micros() - start < usec) {
+        uint32_t slice = hal.scheduler->micros();
+        while (hal.scheduler->micros() - slice < POLL_USEC) ;
+        poll_samples();
+    }
+}
+
+static void run(uint16_t rate, bool with_rate_loop)
+{
+    uint32_t period = 1000000UL / rate;
+
+    use_rate_loop = with_rate_loop;
+    latency_sum = 0;
+    latency_max = 0;
+    num_outputs = 0;
+    memset(latency_hist, 0, sizeof(latency_hist));
+    rate_loop.latency_reset();
+
+    uint32_t ticks = (uint32_t)rate * BENCH_SECONDS;
+    uint32_t next_tick = hal.scheduler->micros() + period;
+    next_sample_usec = next_tick - SAMPLE_USEC * (period / SAMPLE_USEC);
+
+    for (uint32_t i=0; i<ticks; i++) {
+        // wait for the samples of this tick, as the main loop waits
+        // for the inertial sensor
+        while ((int32_t)(hal.scheduler->micros() - next_tick) < 0) {
+            poll_samples();
+        }
+        // the newest sample in the average
+        uint32_t sample_usec = next_tick - SAMPLE_USEC;
+        next_tick += period;
+        poll_samples();
+
+        work(FAST_LOOP_USEC);
+
+        rate_loop.set_targets(1000, -500, 200);
+        if (!with_rate_loop) {
+            // as the main loop runs the rate controllers and motors
+            rate_loop.gyro_sample(gyro, period * 1.0e-6f);
+            record_output(sample_usec);
+        }
+
+        if (i % SLOW_TASK_TICKS == SLOW_TASK_TICKS-1) {
+            work(TASKS_USEC + SLOW_TASK_USEC);
+        } else {
+            work(TASKS_USEC);
+        }
+    }
+
+    hal.console->printf_P(PSTR("%3uHz %-9s outputs %5.0f/s  latency avg %6.1fus  p99 <%5luus  max %5luus  controllers %3uus\n"),
+                          (unsigned)rate,
+                          with_rate_loop ? "rate loop" : "inline",
+                          num_outputs / (float)BENCH_SECONDS,
+                          num_outputs ? latency_sum / (float)num_outputs : 0.0f,
+                          (unsigned long)latency_p99(),
+                          (unsigned long)latency_max,
+                          (unsigned)rate_loop.latency_avg_usec());
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("Rate loop latency"));
+
+    motors.set_update_rate(490);
+    motors.set_frame_orientation(AP_MOTORS_X_FRAME);
+    motors.set_min_throttle(130);
+    motors.Init();
+    rc1.set_angle(4500);
+    rc2.set_angle(4500);
+    rc3.set_range(130, 1000);
+    rc4.set_angle(4500);
+    rc3.radio_min = 1000;
+    rc3.radio_max = 2000;
+    motors.enable();
+    motors.armed(true);
+    rc3.servo_out = 500;
+}
+
+void loop(void)
+{
+    static const uint16_t rates[] = { 100, 200, 400 };
+    for (uint8_t r=0; r<3; r++) {
+        run(rates[r], false);
+        run(rates[r], true);
+    }
+    hal.console->println();
+}
+
+AP_HAL_MAIN();
@@ -61,6 +61,13 @@ const AP_Param::GroupInfo AC_WPNav::var_info[] PROGMEM = {
     // @User: Standard
     AP_GROUPINFO("ACCEL",       5, AC_WPNav, _wp_accel_cms, WPNAV_ACCELERATION),
 
+    // @Param: SPLINE
+    // @DisplayName: Waypoint Spline Segments
+    // @Description: When enabled missions fly smooth curves through the waypoints instead of straight lines between them. Waypoints with no delay are passed without stopping, with the speed reduced in tight turns
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("SPLINE",      6, AC_WPNav, _spline_enabled, 0),
+
     AP_GROUPEND
 };
 
@@ -96,6 +103,8 @@ AC_WPNav::AC_WPNav(AP_InertialNav* inav, AP_AHRS* ahrs, APM_PI* pid_pos_lat, APM
     _track_accel(0),
     _track_speed(0),
     _track_leash_length(0),
+    _spline_time(0),
+    _spline_speed(0),
     dist_error(0,0),
     desired_vel(0,0),
     desired_accel(0,0)
@@ -394,6 +403,9 @@ void AC_WPNav::set_origin_and_destination(const Vector3f& origin, const Vector3f
     // default waypoint back to slow
     _flags.fast_waypoint = false;
 
+    // default segment to a straight line
+    _flags.spline_segment = false;
+
     // initialise desired roll and pitch to current roll and pitch.  This avoids a random twitch between now and when the wpnav controller is first run
     _desired_roll = constrain_int32(_ahrs->roll_sensor,-_lean_angle_max_cd,_lean_angle_max_cd);
     _desired_pitch = constrain_int32(_ahrs->pitch_sensor,-_lean_angle_max_cd,_lean_angle_max_cd);
@@ -540,7 +552,11 @@ void AC_WPNav::update_wpnav()
 
             // advance the target if necessary
             if (dt > 0.0f) {
-                advance_target_along_track(dt);
+                if (_flags.spline_segment) {
+                    advance_spline_target_along_track(dt);
+                }else{
+                    advance_target_along_track(dt);
+                }
             }
             _wpnav_step++;
             break;
@@ -562,6 +578,198 @@ void AC_WPNav::update_wpnav()
     }
 }
 
+///
+/// spline waypoint navigation
+///
+
+/// set_spline_destination - set destination of a spline segment using cm from home
+void AC_WPNav::set_spline_destination(const Vector3f& destination, const Vector3f* next_destination)
+{
+    Vector3f origin;
+    bool stopped_at_start = true;
+
+    // if waypoint controller is active and copter has reached the previous waypoint use it for the origin
+    if( _flags.reached_destination && ((hal.scheduler->millis() - _wpnav_last_update) < 1000) ) {
+        origin = _destination;
+        // the copter is still moving if the previous waypoint was passed without stopping
+        stopped_at_start = !_flags.fast_waypoint;
+    }else{
+        // otherwise calculate origin from the current position and velocity
+        get_stopping_point(_inav->get_position(), _inav->get_velocity(), origin);
+    }
+
+    set_spline_origin_and_destination(origin, destination, stopped_at_start, next_destination);
+}
+
+/// set_spline_origin_and_destination - set origin and destination of a spline segment using cm from home
+///     the segment is a cubic hermite curve. Its coefficients, and the speed limit at points along it, are
+///     calculated here once so that moving the target along the curve costs only a polynomial evaluation
+void AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const Vector3f& destination, bool stopped_at_start, const Vector3f* next_destination)
+{
+    // capture the previous segment before it is overwritten
+    bool prev_spline = _flags.spline_segment;
+    Vector3f prev_origin = _origin;
+    float prev_speed = prev_spline ? _spline_speed : _limited_speed_xy_cms;
+
+    // set up the leash lengths and flags as for a straight segment
+    set_origin_and_destination(origin, destination);
+    _flags.spline_segment = true;
+
+    Vector3f pos_delta = destination - origin;
+    float chord = pos_delta.length();
+
+    // velocity (per unit of spline time) at the origin
+    Vector3f origin_vel;
+    if (stopped_at_start) {
+        // head straight for the destination
+        origin_vel = pos_delta * 0.1f;
+        _spline_speed = 0;
+    }else{
+        if (prev_spline) {
+            // carry on in the direction the previous segment ended in
+            origin_vel = _spline_destination_vel;
+        }else{
+            // catmull-rom tangent through the previous origin
+            origin_vel = (destination - prev_origin) * 0.5f;
+        }
+        _spline_speed = prev_speed;
+    }
+
+    // velocity at the destination
+    if (next_destination != NULL) {
+        // catmull-rom tangent, so the next segment continues in the same direction
+        _spline_destination_vel = (*next_destination - origin) * 0.5f;
+    }else{
+        // stop at the destination
+        _spline_destination_vel = pos_delta * 0.1f;
+    }
+
+    // limit the tangents to the length of the segment, so a long neighbouring leg does not make the curve loop
+    float len = origin_vel.length();
+    if (len > chord) {
+        origin_vel *= chord / len;
+    }
+    len = _spline_destination_vel.length();
+    if (len > chord) {
+        _spline_destination_vel *= chord / len;
+    }
+
+    // hermite coefficients
+    _spline_coeff[0] = origin;
+    _spline_coeff[1] = origin_vel;
+    _spline_coeff[2] = pos_delta*3.0f - origin_vel*2.0f - _spline_destination_vel;
+    _spline_coeff[3] = pos_delta*-2.0f + origin_vel + _spline_destination_vel;
+    _spline_time = 0;
+
+    // speed limits from the lateral acceleration in turns and the vertical speed limits
+    Vector3f prev_pos = origin;
+    float sample_dist[WPNAV_SPLINE_SAMPLES];
+    for (uint8_t i=0; i<WPNAV_SPLINE_SAMPLES; i++) {
+        float t = i / (float)(WPNAV_SPLINE_SAMPLES-1);
+        Vector3f pos, vel;
+        calc_spline_pos_vel(t, pos, vel);
+        Vector3f accel = _spline_coeff[2]*2.0f + _spline_coeff[3]*(6.0f*t);
+
+        float limit = _wp_speed_cms;
+        float vel_length = vel.length();
+        if (vel_length > 0.0f) {
+            // curvature is |v x a| / |v|^3, and the lateral acceleration is speed^2 * curvature
+            float curvature = (vel % accel).length() / (vel_length*vel_length*vel_length);
+            if (curvature * limit * limit > WPNAV_SPLINE_ACCEL_LAT) {
+                limit = safe_sqrt(WPNAV_SPLINE_ACCEL_LAT / curvature);
+            }
+            float speed_vert = vel.z >= 0 ? _wp_speed_up_cms : _wp_speed_down_cms;
+            if (speed_vert * vel_length < limit * fabsf(vel.z)) {
+                limit = speed_vert * vel_length / fabsf(vel.z);
+            }
+        }
+        _spline_speed_limit[i] = limit;
+        sample_dist[i] = (pos - prev_pos).length();
+        prev_pos = pos;
+    }
+    if (next_destination == NULL) {
+        _spline_speed_limit[WPNAV_SPLINE_SAMPLES-1] = 0;
+    }
+
+    // limit the speed before each point to what can be slowed down from at the waypoint acceleration
+    for (int8_t i=WPNAV_SPLINE_SAMPLES-2; i>=0; i--) {
+        float limit = safe_sqrt(sq(_spline_speed_limit[i+1]) + 2.0f*_wp_accel_cms*sample_dist[i+1]);
+        _spline_speed_limit[i] = min(_spline_speed_limit[i], limit);
+    }
+}
+
+/// advance_spline_target_along_track - move target location along the spline segment from origin to destination
+void AC_WPNav::advance_spline_target_along_track(float dt)
+{
+    Vector3f curr_pos = _inav->get_position();
+
+    if (_spline_time < 1.0f) {
+        Vector3f target_pos, target_vel;
+        calc_spline_pos_vel(_spline_time, target_pos, target_vel);
+
+        // do not move the target further away while the copter is at the end of the leash
+        Vector3f track_error = curr_pos - target_pos;
+        float track_error_xy = safe_sqrt(track_error.x*track_error.x + track_error.y*track_error.y);
+        if (track_error_xy > _wp_leash_xy || fabsf(track_error.z) > _wp_leash_z) {
+            _target_vel.x = 0;
+            _target_vel.y = 0;
+            return;
+        }
+
+        // accelerate towards the speed limit at this point of the segment
+        float index = _spline_time * (WPNAV_SPLINE_SAMPLES-1);
+        uint8_t i = (uint8_t)index;
+        float frac = index - i;
+        float limit = _spline_speed_limit[i] + (_spline_speed_limit[i+1] - _spline_speed_limit[i]) * frac;
+        _spline_speed = min(_spline_speed + _wp_accel_cms * dt, limit);
+        _spline_speed = max(_spline_speed, WPNAV_SPLINE_SPEED_MIN);
+
+        // advance the spline time by the distance covered at this speed
+        float vel_length = target_vel.length();
+        if (vel_length > _spline_speed * dt) {
+            _spline_time += _spline_speed * dt / vel_length;
+        }else{
+            _spline_time = 1.0f;
+        }
+        if (_spline_time > 1.0f) {
+            _spline_time = 1.0f;
+        }
+
+        calc_spline_pos_vel(_spline_time, _target, target_vel);
+
+        // feed forward the velocity of the target along the curve
+        vel_length = target_vel.length();
+        if (_spline_time < 1.0f && vel_length > 0.0f) {
+            _target_vel.x = target_vel.x * _spline_speed / vel_length;
+            _target_vel.y = target_vel.y * _spline_speed / vel_length;
+        }else{
+            _target_vel.x = 0;
+            _target_vel.y = 0;
+        }
+    }
+
+    // check if we've reached the waypoint
+    if( !_flags.reached_destination && _spline_time >= 1.0f ) {
+        // "fast" waypoints are complete once the intermediate point reaches the destination
+        if (_flags.fast_waypoint) {
+            _flags.reached_destination = true;
+        }else{
+            // regular waypoints also require the copter to be within the waypoint radius
+            Vector3f dist_to_dest = curr_pos - _destination;
+            if( dist_to_dest.length() <= _wp_radius_cm ) {
+                _flags.reached_destination = true;
+            }
+        }
+    }
+}
+
+/// calc_spline_pos_vel - calculates position and velocity at a point along the spline segment
+void AC_WPNav::calc_spline_pos_vel(float spline_time, Vector3f& position, Vector3f& velocity) const
+{
+    position = _spline_coeff[0] + (_spline_coeff[1] + (_spline_coeff[2] + _spline_coeff[3]*spline_time)*spline_time)*spline_time;
+    velocity = _spline_coeff[1] + (_spline_coeff[2]*2.0f + _spline_coeff[3]*(3.0f*spline_time))*spline_time;
+}
+
 ///
 /// shared methods
 ///
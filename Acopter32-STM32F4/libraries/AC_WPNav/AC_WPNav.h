@@ -35,6 +35,10 @@
 
 #define WPNAV_MIN_LEASH_LENGTH          100.0f      // minimum leash lengths in cm
 
+#define WPNAV_SPLINE_ACCEL_LAT          250.0f      // maximum lateral acceleration in cm/s/s in the turns of spline segments
+#define WPNAV_SPLINE_SPEED_MIN           50.0f      // minimum speed in cm/s of the intermediate target along a spline segment, so that it always reaches the end
+#define WPNAV_SPLINE_SAMPLES                 9      // number of points along a spline segment at which the speed limit is precomputed
+
 class AC_WPNav
 {
 public:
@@ -101,6 +105,25 @@ public:
     /// update_wp - update waypoint controller
     void update_wpnav();
 
+    ///
+    /// spline waypoint controller
+    ///
+
+    /// spline_enabled - true if missions should join waypoints with spline segments
+    bool spline_enabled() const { return _spline_enabled != 0; }
+
+    /// set_spline_destination - set destination of a spline segment using position vectors (distance from home in cm)
+    ///     the segment carries on smoothly from the previous segment if the copter has just passed its end without stopping
+    ///     next_destination is the following waypoint, which the copter turns towards without stopping, or NULL to stop at the destination
+    void set_spline_destination(const Vector3f& destination, const Vector3f* next_destination);
+
+    /// set_spline_origin_and_destination - set origin and destination of a spline segment and precompute its curve and speed limits
+    ///     stopped_at_start should be true if the copter is not already flying through the origin
+    void set_spline_origin_and_destination(const Vector3f& origin, const Vector3f& destination, bool stopped_at_start, const Vector3f* next_destination);
+
+    /// advance_spline_target_along_track - move target location along the spline segment from origin to destination
+    void advance_spline_target_along_track(float dt);
+
     ///
     /// shared methods
     ///
@@ -153,6 +176,7 @@ protected:
     struct wpnav_flags {
         uint8_t reached_destination     : 1;    // true if we have reached the destination
         uint8_t fast_waypoint           : 1;    // true if we should ignore the waypoint radius and consider the waypoint complete once the intermediate target has reached the waypoint
+        uint8_t spline_segment          : 1;    // true if the current segment is a spline rather than a straight line
     } _flags;
 
     /// translate_loiter_target_movements - consumes adjustments created by move_loiter_target
@@ -183,6 +207,10 @@ protected:
     ///    set climb param to true if track climbs vertically, false if descending
     void calculate_wp_leash_length(bool climb);
 
+    /// calc_spline_pos_vel - calculates position and velocity (per unit of spline time) at a point along the spline segment
+    ///     spline_time runs from 0 at the origin to 1 at the destination
+    void calc_spline_pos_vel(float spline_time, Vector3f& position, Vector3f& velocity) const;
+
     // pointers to inertial nav and ahrs libraries
     AP_InertialNav*	_inav;
     AP_AHRS*        _ahrs;
@@ -200,6 +228,7 @@ protected:
     AP_Float    _wp_speed_down_cms;     // descent speed target in cm/s
     AP_Float    _wp_radius_cm;          // distance from a waypoint in cm that, when crossed, indicates the wp has been reached
     AP_Float    _wp_accel_cms;          // acceleration in cm/s/s during missions
+    AP_Int8     _spline_enabled;        // join mission waypoints with spline segments
     uint8_t     _loiter_step;           // used to decide which portion of loiter controller to run during this iteration
     uint8_t     _wpnav_step;            // used to decide which portion of wpnav controller to run during this iteration
     uint32_t	_loiter_last_update;    // time of last update_loiter call
@@ -239,6 +268,13 @@ protected:
     float       _track_speed;           // speed in cm/s along track
     float       _track_leash_length;    // leash length along track
 
+    // spline controller internal variables
+    Vector3f    _spline_coeff[4];       // hermite cubic polynomial coefficients of the segment, position = c0 + c1*t + c2*t^2 + c3*t^3
+    Vector3f    _spline_destination_vel;// velocity (per unit of spline time) at the destination, used as the start of a following segment
+    float       _spline_speed_limit[WPNAV_SPLINE_SAMPLES];  // precomputed maximum speed in cm/s at evenly spaced spline times along the segment
+    float       _spline_time;           // current spline time, 0 at origin to 1 at destination
+    float       _spline_speed;          // speed in cm/s of the intermediate target along the segment
+
 public:
     // for logging purposes
     Vector2f dist_error;                // distance error calculated by loiter controller
@@ -0,0 +1,260 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Fly a survey mission through the waypoint controller with a simple
+// copter model, once with straight segments and once with spline
+// segments, and compare the flight time.
+//
+// The mission is a lawnmower pattern of passes joined by short
+// crossings. Every waypoint but the last is "fast", as with a mission
+// of waypoints with no delay. The copter model turns the lean angles
+// from the controller into horizontal acceleration, with a lag for the
+// attitude controllers and some drag, and follows the target altitude
+// with a first order lag. The inertial nav position is set directly
+// from the model.
+//
+// The SITL clock is stopped and advanced by the model, so the results
+// are deterministic and the mission runs as fast as the CPU allows.
+// For each run this prints the flight time, the largest horizontal
+// distance from the mission path, and the mean CPU time of an
+// update_wpnav() call.
+//
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_GPS.h>
+#include <AP_GPS_Glitch.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Baro.h>
+#include <GCS_MAVLink.h>
+#include <Filter.h>
+#include <SITL.h>
+#include <AP_Buffer.h>
+#include <AP_Notify.h>
+#include <AP_Vehicle.h>
+#include <AP_PIDCore.h>
+#include <AC_PID.h>
+#include <APM_PI.h>
+#include <AP_InertialNav.h>
+#include <AC_WPNav.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define SIM_DT              0.01f       // model and controller step in seconds
+#define SIM_TIME_MAX        1200        // give up on a run after this many seconds
+#define SIM_ATTITUDE_TC     0.2f        // time constant of the attitude controllers in seconds
+#define SIM_DRAG            0.1f        // drag, as a fraction of the velocity per second
+#define SIM_ALT_TC          1.0f        // time constant of the altitude controller in seconds
+
+#define MISSION_SPEED       500         // horizontal speed in cm/s
+#define MISSION_ALT         1000        // altitude in cm
+#define MISSION_PASSES      10          // number of passes of the lawnmower pattern
+#define MISSION_PASS_LENGTH 6000        // length of a pass in cm
+#define MISSION_PASS_SPACE  1500        // distance between passes in cm
+#define MISSION_WAYPOINTS   (MISSION_PASSES*2)
+
+// the HIL driver has no temperature sensor
+class MissionINS : public AP_InertialSensor_HIL
+{
+public:
+    float get_temperature(void) const { return 0; }
+};
+
+MissionINS ins;
+AP_Baro_HIL barometer;
+AP_GPS_HIL g_gps_driver;
+GPS *g_gps = &g_gps_driver;
+GPS_Glitch gps_glitch(g_gps);
+
+AP_AHRS_DCM ahrs(&ins, g_gps);
+AP_InertialNav inertial_nav(&ahrs, &ins, &barometer, g_gps, gps_glitch);
+
+// the default loiter gains of ArduCopter
+APM_PI pi_loiter_lat(1.0f);
+APM_PI pi_loiter_lon(1.0f);
+AC_PID pid_loiter_rate_lat(1.0f, 0.5f, 0, 400);
+AC_PID pid_loiter_rate_lon(1.0f, 0.5f, 0, 400);
+
+AC_WPNav wp_nav(&inertial_nav, &ahrs, &pi_loiter_lat, &pi_loiter_lon, &pid_loiter_rate_lat, &pid_loiter_rate_lon);
+
+static Vector3f mission[MISSION_WAYPOINTS];
+
+// the state of the copter model
+static uint64_t clock_usec;
+static Vector3f position;
+static Vector2f velocity;
+static float roll, pitch;
+
+// CPU time, which is not affected by the stopped clock
+static uint64_t cpu_micros(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void build_mission(void)
+{
+    for (uint8_t i=0; i<MISSION_PASSES; i++) {
+        float y = i * MISSION_PASS_SPACE;
+        float x0 = (i & 1) ? MISSION_PASS_LENGTH : 0;
+        float x1 = (i & 1) ? 0 : MISSION_PASS_LENGTH;
+        mission[i*2]   = Vector3f(x0, y, MISSION_ALT);
+        mission[i*2+1] = Vector3f(x1, y, MISSION_ALT);
+    }
+}
+
+// horizontal distance from the mission path
+static float path_distance(const Vector3f &pos)
+{
+    Vector2f p(pos.x, pos.y);
+    float dist = 1.0e9f;
+    for (uint8_t i=1; i<MISSION_WAYPOINTS; i++) {
+        Vector2f a(mission[i-1].x, mission[i-1].y);
+        Vector2f b(mission[i].x, mission[i].y);
+        Vector2f ab = b - a;
+        float t = constrain_float(((p - a) * ab) / (ab * ab), 0, 1);
+        dist = min(dist, (a + ab * t - p).length());
+    }
+    return dist;
+}
+
+// advance the copter model by one step
+static void update_model(void)
+{
+    // the attitude controllers follow the lean angles from the controller
+    roll += (ToRad(wp_nav.get_desired_roll() * 0.01f) - roll) * SIM_DT / SIM_ATTITUDE_TC;
+    pitch += (ToRad(wp_nav.get_desired_pitch() * 0.01f) - pitch) * SIM_DT / SIM_ATTITUDE_TC;
+
+    // the copter points north, so pitching forward accelerates north
+    Vector2f accel(-GRAVITY_MSS * 100 * tanf(pitch), GRAVITY_MSS * 100 * tanf(roll));
+    accel -= velocity * SIM_DRAG;
+    velocity += accel * SIM_DT;
+    position.x += velocity.x * SIM_DT;
+    position.y += velocity.y * SIM_DT;
+    float climb_rate = (wp_nav.get_desired_alt() - position.z) / SIM_ALT_TC;
+    position.z += climb_rate * SIM_DT;
+
+    inertial_nav.set_position_xy(position.x, position.y);
+    inertial_nav.set_velocity_xy(velocity.x, velocity.y);
+    inertial_nav.set_altitude(position.z);
+    inertial_nav.set_velocity_z(climb_rate);
+
+    clock_usec += SIM_DT * 1.0e6f;
+    AVR_SITL::SITLScheduler::stop_clock(clock_usec);
+}
+
+// start the navigation to waypoint i, as do_nav_wp() does
+static void start_waypoint(uint8_t i, bool spline)
+{
+    bool last = (i == MISSION_WAYPOINTS-1);
+    if (spline) {
+        wp_nav.set_spline_destination(mission[i], last ? NULL : &mission[i+1]);
+    }else{
+        wp_nav.set_destination(mission[i]);
+    }
+    wp_nav.set_fast_waypoint(!last);
+}
+
+static void fly_mission(bool spline)
+{
+    // start hovering at the first waypoint
+    position = mission[0];
+    velocity = Vector2f(0, 0);
+    roll = pitch = 0;
+    clock_usec += 10000000UL;
+    AVR_SITL::SITLScheduler::stop_clock(clock_usec);
+    inertial_nav.set_position_xy(position.x, position.y);
+    inertial_nav.set_velocity_xy(0, 0);
+    inertial_nav.set_altitude(position.z);
+    inertial_nav.set_velocity_z(0);
+
+    uint8_t wp = 1;
+    start_waypoint(wp, spline);
+
+    uint32_t steps = 0;
+    uint32_t calls = 0;
+    uint64_t cpu_usec = 0;
+    float max_distance = 0;
+
+    while (steps < SIM_TIME_MAX / SIM_DT) {
+        uint64_t t0 = cpu_micros();
+        wp_nav.update_wpnav();
+        cpu_usec += cpu_micros() - t0;
+        calls++;
+
+        update_model();
+        steps++;
+        max_distance = max(max_distance, path_distance(position));
+
+        if (wp_nav.reached_destination()) {
+            if (wp == MISSION_WAYPOINTS-1) {
+                break;
+            }
+            start_waypoint(++wp, spline);
+        }
+    }
+
+    hal.console->printf_P(PSTR("%-8s flight time %.1f s  max path distance %.2f m  update_wpnav %.3f us%s\n"),
+                          spline ? "spline" : "straight",
+                          steps * SIM_DT,
+                          max_distance * 0.01f,
+                          cpu_usec / (float)calls,
+                          wp == MISSION_WAYPOINTS-1 ? "" : "  (did not finish)");
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("WPNav mission benchmark"));
+
+    AVR_SITL::SITLScheduler::stop_clock(1);
+    ins.init(AP_InertialSensor::COLD_START,
+             AP_InertialSensor::RATE_100HZ);
+    ahrs.init();
+    inertial_nav.init();
+
+    wp_nav.set_horizontal_velocity(MISSION_SPEED);
+    wp_nav.set_cos_sin_yaw(1, 0, 1);
+    build_mission();
+}
+
+void loop(void)
+{
+    fly_mission(false);
+    fly_mission(true);
+    exit(0);
+}
+
+#else
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("WPNav mission benchmark is only supported on SITL"));
+}
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif
+
+AP_HAL_MAIN();
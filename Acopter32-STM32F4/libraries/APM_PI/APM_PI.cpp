@@ -22,15 +22,9 @@ int32_t APM_PI::get_p(int32_t error)
 int32_t APM_PI::get_i(int32_t error, float dt)
 {
     if(dt != 0) {
-        _integrator += ((float)error * _ki) * dt;
-
-        if (_integrator < -_imax) {
-            _integrator = -_imax;
-        } else if (_integrator > _imax) {
-            _integrator = _imax;
-        }
+        _core.integrate((float)error * _ki, dt, _imax);
     }
-    return _integrator;
+    return _core.integrator;
 }
 
 int32_t APM_PI::get_pi(int32_t error, float dt)
@@ -41,7 +35,7 @@ int32_t APM_PI::get_pi(int32_t error, float dt)
 void
 APM_PI::reset_I()
 {
-    _integrator = 0;
+    _core.reset_I();
 }
 
 void
@@ -8,6 +8,7 @@
 
 #include <stdlib.h>
 #include <AP_Param.h>
+#include <AP_PIDCore.h>
 
 /// @class	APM_PI
 /// @brief	Object managing one PI control
@@ -95,10 +96,10 @@ public:
         _imax.set(abs(v));
     }
     float           get_integrator() const {
-        return _integrator;
+        return _core.integrator;
     }
     void            set_integrator(float i) {
-        _integrator = i;
+        _core.integrator = i;
     }
 
     static const struct AP_Param::GroupInfo        var_info[];
@@ -109,7 +110,7 @@ private:
     AP_Int16        _imax;
 
     // integrator value
-    float           _integrator;
+    AP_PIDCore<AP_PID_I> _core;
 };
 
 #endif
@@ -105,6 +105,20 @@ const AP_Param::GroupInfo AP_AHRS::var_info[] PROGMEM = {
     // @User: Advanced
     AP_GROUPINFO("GPS_MINSATS", 11, AP_AHRS, _gps_minsats, 6),
 
+    // @Param: EKF_USE
+    // @DisplayName: Use the EKF for attitude and position
+    // @Description: This controls whether the EKF attitude and position estimate is used in place of DCM. The DCM estimate is always calculated and is used whenever the EKF is disabled or unhealthy. This only has an effect on boards which build the EKF.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("EKF_USE", 12, AP_AHRS, _ekf_use, 0),
+
+    // @Param: QUAT_USE
+    // @DisplayName: Use quaternion attitude integration
+    // @Description: This controls whether DCM integrates the gyros into an attitude quaternion instead of rotating and renormalising the DCM matrix on every update. The quaternion only needs one square root per update to stay normalised. The matrix is still recomputed from it on each update for the drift correction.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("QUAT_USE", 13, AP_AHRS, _quat_use, 0),
+
     AP_GROUPEND
 };
 
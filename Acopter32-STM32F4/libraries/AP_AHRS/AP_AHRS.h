@@ -242,6 +242,8 @@ protected:
     AP_Int8 _wind_max;
     AP_Int8 _board_orientation;
     AP_Int8 _gps_minsats;
+    AP_Int8 _ekf_use;
+    AP_Int8 _quat_use;
 
     // flags structure
     struct ahrs_flags {
@@ -284,6 +286,7 @@ protected:
 };
 
 #include <AP_AHRS_DCM.h>
+#include <AP_AHRS_EKF.h>
 #include <AP_AHRS_HIL.h>
 
 #endif // __AP_AHRS_H__
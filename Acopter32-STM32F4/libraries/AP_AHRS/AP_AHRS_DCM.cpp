@@ -66,11 +66,31 @@ AP_AHRS_DCM::update(void)
     _gyro_vector  = _ins->get_gyro();
     _accel_vector = _ins->get_accel();
 
-    // Integrate the DCM matrix using gyro inputs
-    matrix_update(delta_t);
+    // use the coning and sculling compensated increments when the IMU
+    // driver accumulates them at its sample rate
+    Vector3f delta_velocity;
+    if (delta_t > 0 &&
+        _ins->get_delta_angle(_delta_angle) &&
+        _ins->get_delta_velocity(delta_velocity)) {
+        // the velocity change is in the body frame at the start of
+        // the period. drift_correction() pairs the acceleration with
+        // the attitude at the end of it, so rotate it into that frame
+        _accel_vector = (delta_velocity + (delta_velocity % _delta_angle)) / delta_t;
+    } else {
+        _delta_angle = _gyro_vector * delta_t;
+    }
 
-    // Normalize the DCM matrix
-    normalize();
+    if (_quat_use) {
+        // Integrate the attitude quaternion using gyro inputs. This
+        // replaces the matrix rotation and renormalisation
+        quaternion_update(delta_t);
+    } else {
+        // Integrate the DCM matrix using gyro inputs
+        matrix_update(delta_t);
+
+        // Normalize the DCM matrix
+        normalize();
+    }
 
     // Perform drift correction
     drift_correction(delta_t);
@@ -93,7 +113,36 @@ AP_AHRS_DCM::matrix_update(float _G_Dt)
     // value
     _omega = _gyro_vector + _omega_I;
 
-    _dcm_matrix.rotate((_omega + _omega_P + _omega_yaw_P) * _G_Dt);
+    _dcm_matrix.rotate(_delta_angle + (_omega_I + _omega_P + _omega_yaw_P) * _G_Dt);
+    _q_stale = true;
+}
+
+// update the attitude quaternion using only the gyros, and the DCM
+// matrix from it. The drift correction works on the matrix, so it is
+// recomputed on every update
+void
+AP_AHRS_DCM::quaternion_update(float _G_Dt)
+{
+    // see matrix_update() for why the P terms are not in _omega
+    _omega = _gyro_vector + _omega_I;
+
+    if (_q_stale) {
+        // the matrix was changed directly, or we have just switched
+        // from matrix integration
+        _q.from_rotation_matrix(_dcm_matrix);
+        _q_stale = false;
+    }
+    _q.rotate_fast(_delta_angle + (_omega_I + _omega_P + _omega_yaw_P) * _G_Dt);
+    _q.normalize();
+    _q.rotation_matrix(_dcm_matrix);
+}
+
+// set the DCM matrix from Euler angles, keeping the quaternion in step
+void
+AP_AHRS_DCM::set_dcm_from_euler(float r, float p, float y)
+{
+    _dcm_matrix.from_euler(r, p, y);
+    _q_stale = true;
 }
 
 
@@ -114,10 +163,10 @@ AP_AHRS_DCM::reset(bool recover_eulers)
     // attitude then calculate the dcm matrix from the current
     // roll/pitch/yaw values
     if (recover_eulers && !isnan(roll) && !isnan(pitch) && !isnan(yaw)) {
-        _dcm_matrix.from_euler(roll, pitch, yaw);
+        set_dcm_from_euler(roll, pitch, yaw);
     } else {
         // otherwise make it flat
-        _dcm_matrix.from_euler(0, 0, 0);
+        set_dcm_from_euler(0, 0, 0);
     }
 }
 
@@ -227,6 +276,7 @@ AP_AHRS_DCM::normalize(void)
     t1 = _dcm_matrix.b - (_dcm_matrix.a * (0.5f * error));              // eq.19
     t2 = t0 % t1;                                                       // c= a x b // eq.20
 
+    _q_stale = true;
     if (!renorm(t0, _dcm_matrix.a) ||
         !renorm(t1, _dcm_matrix.b) ||
         !renorm(t2, _dcm_matrix.c)) {
@@ -340,7 +390,7 @@ AP_AHRS_DCM::drift_correction_yaw(void)
             // the first compass value, which can be bad
             if (!_flags.have_initial_yaw && _compass->read()) {
                 float heading = _compass->calculate_heading(_dcm_matrix);
-                _dcm_matrix.from_euler(roll, pitch, heading);
+                set_dcm_from_euler(roll, pitch, heading);
                 _omega_yaw_P.zero();
                 _flags.have_initial_yaw = true;
             }
@@ -380,7 +430,7 @@ AP_AHRS_DCM::drift_correction_yaw(void)
                 yaw_deltat > 20 ||
                 (_gps->ground_speed_cm >= 3*GPS_SPEED_MIN && fabsf(yaw_error_rad) >= 1.047f)) {
                 // reset DCM matrix based on current yaw
-                _dcm_matrix.from_euler(roll, pitch, gps_course_rad);
+                set_dcm_from_euler(roll, pitch, gps_course_rad);
                 _omega_yaw_P.zero();
                 _flags.have_initial_yaw = true;
                 yaw_error = 0;
@@ -731,7 +781,11 @@ void AP_AHRS_DCM::estimate_wind(Vector3f &velocity)
 void
 AP_AHRS_DCM::euler_angles(void)
 {
-    _dcm_matrix.to_euler(&roll, &pitch, &yaw);
+    if (_quat_use && !_q_stale) {
+        _q.to_euler(&roll, &pitch, &yaw);
+    } else {
+        _dcm_matrix.to_euler(&roll, &pitch, &yaw);
+    }
 
     roll_sensor     = degrees(roll)  * 100;
     pitch_sensor    = degrees(pitch) * 100;
@@ -27,6 +27,7 @@ public:
     // Constructors
     AP_AHRS_DCM(AP_InertialSensor *ins, GPS *&gps) :
         AP_AHRS(ins, gps),
+        _q_stale(true),
         _last_declination(0),
         _mag_earth(1,0)
     {
@@ -79,6 +80,8 @@ private:
 
     // Methods
     void            matrix_update(float _G_Dt);
+    void            quaternion_update(float _G_Dt);
+    void            set_dcm_from_euler(float r, float p, float y);
     void            normalize(void);
     void            check_matrix(void);
     bool            renorm(Vector3f const &a, Vector3f &result);
@@ -89,11 +92,16 @@ private:
     void            estimate_wind(Vector3f &velocity);
     bool            have_gps(void) const;
 
-    // primary representation of attitude
+    // primary representation of attitude. With AHRS_QUAT_USE set the
+    // quaternion is integrated instead, and the matrix is recomputed
+    // from it on each update for the drift correction
     Matrix3f _dcm_matrix;
+    Quaternion _q;
+    bool _q_stale;                              // _q is behind _dcm_matrix
 
     Vector3f _gyro_vector;                      // Store the gyros turn rate in a vector
     Vector3f _accel_vector;                     // current accel vector
+    Vector3f _delta_angle;                      // gyro rotation over the last update
 
     Vector3f _omega_P;                          // accel Omega proportional correction
     Vector3f _omega_yaw_P;                      // proportional yaw correction
@@ -0,0 +1,580 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ *       AP_AHRS_EKF.cpp
+ *
+ *       AHRS system using an error state extended Kalman filter,
+ *       with the DCM estimator running alongside as a fallback
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_AHRS.h>
+#include <AP_HAL.h>
+
+extern const AP_HAL::HAL& hal;
+
+// process noise. Gyro and accel noise are in rad/s and m/s/s, the
+// gyro bias random walk is in rad/s/s
+#define EKF_GYRO_NOISE          0.015f
+#define EKF_ACCEL_NOISE         0.35f
+#define EKF_GBIAS_NOISE         0.0001f
+#define EKF_POS_NOISE           0.01f
+
+// initial uncertainty
+#define EKF_INIT_ATT            0.1f
+#define EKF_INIT_YAW            0.5f
+#define EKF_INIT_VEL            5.0f
+#define EKF_INIT_POS            10.0f
+#define EKF_INIT_GBIAS          0.02f
+
+// measurement noise
+#define EKF_GPS_VEL_NOISE       0.5f
+#define EKF_GPS_POS_NOISE       2.5f
+#define EKF_BARO_NOISE          1.5f
+#define EKF_YAW_NOISE           0.15f
+#define EKF_GRAVITY_NOISE       1.5f
+#define EKF_ZERO_VEL_NOISE      5.0f
+
+// innovation gate, in standard deviations
+#define EKF_GATE                5.0f
+
+// time in ms after which GPS rejections cause a reset to GPS
+#define EKF_GPS_RESET_MS        5000
+
+// limits on the covariance diagonal beyond which the EKF is
+// considered unhealthy
+#define EKF_MAX_ATT_VAR         0.25f
+#define EKF_MAX_GBIAS_VAR       0.01f
+
+// run a full EKF update round
+void
+AP_AHRS_EKF::update(void)
+{
+    // the DCM update also reads the IMU
+    AP_AHRS_DCM::update();
+
+    _dcm_roll  = roll;
+    _dcm_pitch = pitch;
+    _dcm_yaw   = yaw;
+
+    if (!_ekf_use) {
+        _ekf_initialised = false;
+        _ekf_healthy = false;
+        return;
+    }
+
+    float delta_t = _ins->get_delta_time();
+    if (delta_t > 0.2f || delta_t <= 0) {
+        return;
+    }
+
+    if (!_ekf_initialised) {
+        ekf_init();
+    }
+
+    ekf_predict(delta_t);
+
+    fuse_gps();
+    fuse_baro();
+    fuse_compass();
+    if (!_have_origin) {
+        fuse_gravity();
+    }
+
+    store_history();
+
+    _ekf_healthy = check_health();
+    if (!_ekf_healthy) {
+        // start again from the DCM attitude on the next update
+        _ekf_initialised = false;
+        return;
+    }
+
+    update_outputs();
+}
+
+/*
+ *  reset the EKF and the DCM estimator
+ */
+void
+AP_AHRS_EKF::reset(bool recover_eulers)
+{
+    AP_AHRS_DCM::reset(recover_eulers);
+    _ekf_initialised = false;
+    _ekf_healthy = false;
+}
+
+/*
+ *  initialise the state from the DCM attitude
+ */
+void
+AP_AHRS_EKF::ekf_init(void)
+{
+    _q.from_rotation_matrix(AP_AHRS_DCM::get_dcm_matrix());
+    _q.normalize();
+    _vel.zero();
+    _pos.zero();
+    _gyro_bias = -AP_AHRS_DCM::get_gyro_drift();
+
+    memset(_P, 0, sizeof(_P));
+    for (uint8_t i=0; i<3; i++) {
+        _P[EKF_STATE_ATT+i][EKF_STATE_ATT+i]     = sq(EKF_INIT_ATT);
+        _P[EKF_STATE_VEL+i][EKF_STATE_VEL+i]     = sq(EKF_INIT_VEL);
+        _P[EKF_STATE_POS+i][EKF_STATE_POS+i]     = sq(EKF_INIT_POS);
+        _P[EKF_STATE_GBIAS+i][EKF_STATE_GBIAS+i] = sq(EKF_INIT_GBIAS);
+    }
+    _P[EKF_STATE_ATT+2][EKF_STATE_ATT+2] = sq(EKF_INIT_YAW);
+
+    _ekf_time_ms = 0;
+    _ekf_time_frac = 0;
+    _last_gps_accept_ms = 0;
+    _last_gps_fix_ms = _gps ? _gps->last_fix_time : 0;
+    _last_baro_update = _baro.get_last_update();
+    _last_compass_update = _compass ? _compass->last_update : 0;
+    _history_head = 0;
+    _history_count = 0;
+    _have_origin = false;
+    _ekf_initialised = true;
+}
+
+/*
+ *  integrate the nominal state and propagate the covariance
+ */
+void
+AP_AHRS_EKF::ekf_predict(float dt)
+{
+    // the coning and sculling compensated increments when the IMU
+    // driver accumulates them
+    Vector3f delta_angle, delta_velocity;
+    if (!_ins->get_delta_angle(delta_angle) ||
+        !_ins->get_delta_velocity(delta_velocity)) {
+        delta_angle = _ins->get_gyro() * dt;
+        delta_velocity = _ins->get_accel() * dt;
+    }
+    delta_angle -= _gyro_bias * dt;
+
+    Matrix3f R;
+    _q.rotation_matrix(R);
+
+    // acceleration in the earth frame, with gravity removed. The
+    // velocity change is in the body frame at the start of the
+    // period, which is the attitude in R
+    Vector3f u = R * (delta_velocity / dt);
+    Vector3f accel_ned = u + Vector3f(0, 0, GRAVITY_MSS);
+
+    _pos += _vel * dt + accel_ned * (0.5f * dt * dt);
+    _vel += accel_ned * dt;
+    _q.rotate(delta_angle);
+    _q.normalize();
+    _ekf_time_frac += dt * 1000.0f;
+    uint32_t ms = _ekf_time_frac;
+    _ekf_time_ms += ms;
+    _ekf_time_frac -= ms;
+
+    /*
+      P = Phi P Phi' + Q, with Phi = I + F dt. The non-zero blocks
+      of F are:
+        d(att)/d(gbias) = -R
+        d(vel)/d(att)   = -[u x]
+        d(pos)/d(vel)   = I
+      The rows are updated in an order which only reads rows that
+      have not yet been modified. Applying the row transform,
+      transposing and applying it again gives Phi P Phi'.
+     */
+    for (uint8_t pass=0; pass<2; pass++) {
+        // R times the gyro bias block of every column in one batch
+        Vector3f Rb[EKF_NUM_STATES];
+        for (uint8_t j=0; j<EKF_NUM_STATES; j++) {
+            Rb[j] = Vector3f(_P[EKF_STATE_GBIAS][j], _P[EKF_STATE_GBIAS+1][j], _P[EKF_STATE_GBIAS+2][j]);
+        }
+        rotate_vectors(R, Rb, Rb, EKF_NUM_STATES);
+
+        for (uint8_t j=0; j<EKF_NUM_STATES; j++) {
+            float v[3], a[3];
+            for (uint8_t i=0; i<3; i++) {
+                v[i] = _P[EKF_STATE_VEL+i][j];
+                a[i] = _P[EKF_STATE_ATT+i][j];
+            }
+            for (uint8_t i=0; i<3; i++) {
+                _P[EKF_STATE_POS+i][j] += v[i] * dt;
+            }
+            _P[EKF_STATE_VEL+0][j] += (u.z * a[1] - u.y * a[2]) * dt;
+            _P[EKF_STATE_VEL+1][j] += (u.x * a[2] - u.z * a[0]) * dt;
+            _P[EKF_STATE_VEL+2][j] += (u.y * a[0] - u.x * a[1]) * dt;
+            _P[EKF_STATE_ATT+0][j] -= Rb[j].x * dt;
+            _P[EKF_STATE_ATT+1][j] -= Rb[j].y * dt;
+            _P[EKF_STATE_ATT+2][j] -= Rb[j].z * dt;
+        }
+        // transpose in place
+        for (uint8_t i=0; i<EKF_NUM_STATES; i++) {
+            for (uint8_t j=i+1; j<EKF_NUM_STATES; j++) {
+                float tmp = _P[i][j];
+                _P[i][j] = _P[j][i];
+                _P[j][i] = tmp;
+            }
+        }
+    }
+
+    for (uint8_t i=0; i<3; i++) {
+        _P[EKF_STATE_ATT+i][EKF_STATE_ATT+i]     += sq(EKF_GYRO_NOISE) * dt;
+        _P[EKF_STATE_VEL+i][EKF_STATE_VEL+i]     += sq(EKF_ACCEL_NOISE) * dt;
+        _P[EKF_STATE_POS+i][EKF_STATE_POS+i]     += sq(EKF_POS_NOISE) * dt;
+        _P[EKF_STATE_GBIAS+i][EKF_STATE_GBIAS+i] += sq(EKF_GBIAS_NOISE) * dt;
+    }
+}
+
+/*
+ *  fuse a scalar measurement with observation vector h, innovation
+ *  (measurement minus prediction) and measurement variance R. The
+ *  error state correction is applied to the nominal state
+ *  immediately, so each scalar update starts from a zero error
+ *  state
+ */
+void
+AP_AHRS_EKF::ekf_fuse(const float h[EKF_NUM_STATES], float innovation, float R)
+{
+    float PHt[EKF_NUM_STATES];
+    float S = R;
+    for (uint8_t i=0; i<EKF_NUM_STATES; i++) {
+        PHt[i] = 0;
+        for (uint8_t j=0; j<EKF_NUM_STATES; j++) {
+            if (h[j] != 0) {
+                PHt[i] = mul_add(_P[i][j], h[j], PHt[i]);
+            }
+        }
+        S += h[i] * PHt[i];
+    }
+    if (S <= 0) {
+        return;
+    }
+    float Sinv = 1.0f / S;
+    for (uint8_t i=0; i<EKF_NUM_STATES; i++) {
+        _dx[i] = PHt[i] * Sinv * innovation;
+    }
+    // P = P - K H P, which is symmetric as K = P H' / S
+    for (uint8_t i=0; i<EKF_NUM_STATES; i++) {
+        for (uint8_t j=i; j<EKF_NUM_STATES; j++) {
+            _P[i][j] = mul_add(-(PHt[i] * PHt[j]), Sinv, _P[i][j]);
+            _P[j][i] = _P[i][j];
+        }
+    }
+    ekf_correct();
+}
+
+/*
+ *  inject the error state estimate into the nominal state
+ */
+void
+AP_AHRS_EKF::ekf_correct(void)
+{
+    Quaternion dq;
+    dq.from_axis_angle(Vector3f(_dx[EKF_STATE_ATT], _dx[EKF_STATE_ATT+1], _dx[EKF_STATE_ATT+2]));
+    _q = dq * _q;
+    _q.normalize();
+    _vel       += Vector3f(_dx[EKF_STATE_VEL],   _dx[EKF_STATE_VEL+1],   _dx[EKF_STATE_VEL+2]);
+    _pos       += Vector3f(_dx[EKF_STATE_POS],   _dx[EKF_STATE_POS+1],   _dx[EKF_STATE_POS+2]);
+    _gyro_bias += Vector3f(_dx[EKF_STATE_GBIAS], _dx[EKF_STATE_GBIAS+1], _dx[EKF_STATE_GBIAS+2]);
+
+    // shift the history by the same correction, so delayed
+    // measurements are compared against a consistent trajectory
+    Vector3f dv(_dx[EKF_STATE_VEL], _dx[EKF_STATE_VEL+1], _dx[EKF_STATE_VEL+2]);
+    Vector3f dp(_dx[EKF_STATE_POS], _dx[EKF_STATE_POS+1], _dx[EKF_STATE_POS+2]);
+    for (uint8_t i=0; i<_history_count; i++) {
+        _history[i].vel += dv;
+        _history[i].pos += dp;
+    }
+}
+
+/*
+ *  fuse GPS velocity and position. The GPS measurements lag the IMU,
+ *  so they are compared against the state at the time of the fix
+ */
+void
+AP_AHRS_EKF::fuse_gps(void)
+{
+    if (!_gps || !_gps_use || _gps->status() < GPS::GPS_OK_FIX_3D ||
+        _gps->num_sats < _gps_minsats) {
+        return;
+    }
+    if (_gps->last_fix_time == _last_gps_fix_ms) {
+        return;
+    }
+    _last_gps_fix_ms = _gps->last_fix_time;
+
+    struct Location loc;
+    loc.lat = _gps->latitude;
+    loc.lng = _gps->longitude;
+
+    if (!_have_origin) {
+        _origin = loc;
+        _have_origin = true;
+        reset_to_gps();
+        return;
+    }
+
+    Vector2f ne = location_diff(_origin, loc);
+    float meas[4] = { _gps->velocity_north(), _gps->velocity_east(), ne.x, ne.y };
+    const uint8_t state[4] = { EKF_STATE_VEL, EKF_STATE_VEL+1, EKF_STATE_POS, EKF_STATE_POS+1 };
+    const float noise[4] = { EKF_GPS_VEL_NOISE, EKF_GPS_VEL_NOISE, EKF_GPS_POS_NOISE, EKF_GPS_POS_NOISE };
+    uint32_t fix_time = _ekf_time_ms - (uint32_t)(_gps->get_lag() * 1000.0f);
+
+    bool accepted = false;
+    float h[EKF_NUM_STATES];
+    for (uint8_t i=0; i<4; i++) {
+        // fetch the delayed state again for each axis, as the
+        // history is corrected along with the current state
+        Vector3f vel, pos;
+        if (!get_history(fix_time, vel, pos)) {
+            vel = _vel;
+            pos = _pos;
+        }
+        float pred;
+        switch (i) {
+        case 0:  pred = vel.x; break;
+        case 1:  pred = vel.y; break;
+        case 2:  pred = pos.x; break;
+        default: pred = pos.y; break;
+        }
+        float innov = meas[i] - pred;
+        float S = _P[state[i]][state[i]] + sq(noise[i]);
+        if (sq(innov) < sq(EKF_GATE) * S) {
+            memset(h, 0, sizeof(h));
+            h[state[i]] = 1;
+            ekf_fuse(h, innov, sq(noise[i]));
+            accepted = true;
+        }
+    }
+
+    if (accepted) {
+        _last_gps_accept_ms = _ekf_time_ms;
+    } else if (_ekf_time_ms - _last_gps_accept_ms > EKF_GPS_RESET_MS) {
+        // we have been rejecting the GPS for too long. Trust it
+        // over our own dead-reckoning
+        reset_to_gps();
+    }
+}
+
+/*
+ *  set the velocity and position to the current GPS values
+ */
+void
+AP_AHRS_EKF::reset_to_gps(void)
+{
+    struct Location loc;
+    loc.lat = _gps->latitude;
+    loc.lng = _gps->longitude;
+    Vector2f ne = location_diff(_origin, loc);
+
+    _vel.x = _gps->velocity_north();
+    _vel.y = _gps->velocity_east();
+    _pos.x = ne.x;
+    _pos.y = ne.y;
+
+    for (uint8_t i=0; i<2; i++) {
+        for (uint8_t j=0; j<EKF_NUM_STATES; j++) {
+            _P[EKF_STATE_VEL+i][j] = _P[j][EKF_STATE_VEL+i] = 0;
+            _P[EKF_STATE_POS+i][j] = _P[j][EKF_STATE_POS+i] = 0;
+        }
+        _P[EKF_STATE_VEL+i][EKF_STATE_VEL+i] = sq(EKF_GPS_VEL_NOISE);
+        _P[EKF_STATE_POS+i][EKF_STATE_POS+i] = sq(EKF_GPS_POS_NOISE);
+    }
+
+    // the history no longer matches the state
+    _history_count = 0;
+    _last_gps_accept_ms = _ekf_time_ms;
+}
+
+/*
+ *  fuse the barometric altitude into the down position
+ */
+void
+AP_AHRS_EKF::fuse_baro(void)
+{
+    if (!_baro.healthy || _baro.get_last_update() == _last_baro_update) {
+        return;
+    }
+    _last_baro_update = _baro.get_last_update();
+
+    float h[EKF_NUM_STATES];
+    memset(h, 0, sizeof(h));
+    h[EKF_STATE_POS+2] = 1;
+    float innov = -_baro.get_altitude() - _pos.z;
+    float S = _P[EKF_STATE_POS+2][EKF_STATE_POS+2] + sq(EKF_BARO_NOISE);
+    if (sq(innov) < sq(EKF_GATE) * S) {
+        ekf_fuse(h, innov, sq(EKF_BARO_NOISE));
+    }
+}
+
+/*
+ *  fuse the compass heading
+ */
+void
+AP_AHRS_EKF::fuse_compass(void)
+{
+    if (!use_compass() || _compass->last_update == _last_compass_update) {
+        return;
+    }
+    _last_compass_update = _compass->last_update;
+
+    Matrix3f R;
+    _q.rotation_matrix(R);
+
+    // yaw = atan2(R.b.x, R.a.x). Its derivative with respect to an
+    // earth frame attitude error gives the observation vector
+    float d = sq(R.a.x) + sq(R.b.x);
+    if (d < 0.01f) {
+        // close to vertical, the heading is not defined
+        return;
+    }
+    float h[EKF_NUM_STATES];
+    memset(h, 0, sizeof(h));
+    h[EKF_STATE_ATT]   = -R.a.x * R.c.x / d;
+    h[EKF_STATE_ATT+1] = -R.b.x * R.c.x / d;
+    h[EKF_STATE_ATT+2] = 1;
+
+    float heading = _compass->calculate_heading(R);
+    float innov = wrap_PI(heading - atan2f(R.b.x, R.a.x));
+    ekf_fuse(h, innov, sq(EKF_YAW_NOISE));
+}
+
+/*
+ *  without GPS assume the vehicle is not accelerating, so the
+ *  accelerometers measure gravity. This keeps roll and pitch
+ *  observable, and a weak zero velocity measurement bounds the
+ *  horizontal velocity error
+ */
+void
+AP_AHRS_EKF::fuse_gravity(void)
+{
+    Vector3f accel = _ins->get_accel();
+    float accel_len = accel.length();
+    if (fabsf(accel_len - GRAVITY_MSS) > 0.3f * GRAVITY_MSS) {
+        return;
+    }
+
+    Matrix3f R;
+    float h[EKF_NUM_STATES];
+
+    // the north and east components of the earth frame specific
+    // force should be zero
+    _q.rotation_matrix(R);
+    Vector3f u = R * accel;
+    memset(h, 0, sizeof(h));
+    h[EKF_STATE_ATT+1] = u.z;
+    h[EKF_STATE_ATT+2] = -u.y;
+    ekf_fuse(h, -u.x, sq(EKF_GRAVITY_NOISE));
+
+    _q.rotation_matrix(R);
+    u = R * accel;
+    memset(h, 0, sizeof(h));
+    h[EKF_STATE_ATT]   = -u.z;
+    h[EKF_STATE_ATT+2] = u.x;
+    ekf_fuse(h, -u.y, sq(EKF_GRAVITY_NOISE));
+
+    for (uint8_t i=0; i<2; i++) {
+        memset(h, 0, sizeof(h));
+        h[EKF_STATE_VEL+i] = 1;
+        ekf_fuse(h, i == 0 ? -_vel.x : -_vel.y, sq(EKF_ZERO_VEL_NOISE));
+    }
+}
+
+/*
+ *  record the velocity and position for delayed GPS fusion
+ */
+void
+AP_AHRS_EKF::store_history(void)
+{
+    uint32_t now = _ekf_time_ms;
+    if (_history_count != 0) {
+        uint8_t last = (_history_head + EKF_HISTORY_LEN - 1) % EKF_HISTORY_LEN;
+        if (now - _history[last].time_ms < EKF_HISTORY_MS) {
+            return;
+        }
+    }
+    _history[_history_head].time_ms = now;
+    _history[_history_head].vel = _vel;
+    _history[_history_head].pos = _pos;
+    _history_head = (_history_head + 1) % EKF_HISTORY_LEN;
+    if (_history_count < EKF_HISTORY_LEN) {
+        _history_count++;
+    }
+}
+
+/*
+ *  find the velocity and position at the given EKF time. Returns
+ *  false if the history does not reach back that far
+ */
+bool
+AP_AHRS_EKF::get_history(uint32_t time_ms, Vector3f &vel, Vector3f &pos) const
+{
+    for (uint8_t i=0; i<_history_count; i++) {
+        uint8_t idx = (_history_head + EKF_HISTORY_LEN - 1 - i) % EKF_HISTORY_LEN;
+        if ((int32_t)(_history[idx].time_ms - time_ms) <= 0) {
+            vel = _history[idx].vel;
+            pos = _history[idx].pos;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ *  check the covariance is sane
+ */
+bool
+AP_AHRS_EKF::check_health(void)
+{
+    if (_q.is_nan() || _vel.is_nan() || _pos.is_nan()) {
+        return false;
+    }
+    for (uint8_t i=0; i<3; i++) {
+        if (!(_P[EKF_STATE_ATT+i][EKF_STATE_ATT+i] < EKF_MAX_ATT_VAR) ||
+            !(_P[EKF_STATE_GBIAS+i][EKF_STATE_GBIAS+i] < EKF_MAX_GBIAS_VAR)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ *  update the public attitude from the EKF state
+ */
+void
+AP_AHRS_EKF::update_outputs(void)
+{
+    _q.rotation_matrix(_ekf_dcm);
+    _ekf_dcm.to_euler(&roll, &pitch, &yaw);
+
+    roll_sensor     = degrees(roll)  * 100;
+    pitch_sensor    = degrees(pitch) * 100;
+    yaw_sensor      = degrees(yaw)   * 100;
+
+    if (yaw_sensor < 0)
+        yaw_sensor += 36000;
+
+    _omega_ekf  = _ins->get_gyro() - _gyro_bias;
+    _gyro_drift = -_gyro_bias;
+    _accel_ef   = _ekf_dcm * _ins->get_accel();
+}
+
+// return our current position estimate
+bool AP_AHRS_EKF::get_position(struct Location &loc)
+{
+    if (!_ekf_healthy || !_have_origin) {
+        return AP_AHRS_DCM::get_position(loc);
+    }
+    loc.lat = _origin.lat;
+    loc.lng = _origin.lng;
+    location_offset(loc, _pos.x, _pos.y);
+    return true;
+}
@@ -0,0 +1,164 @@
+#ifndef __AP_AHRS_EKF_H__
+#define __AP_AHRS_EKF_H__
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  Extended Kalman filter based AHRS (Attitude Heading Reference
+ *  System) interface for ArduPilot
+ *
+ *  The DCM estimator always runs alongside the EKF. It provides the
+ *  initial attitude, acts as the fallback when the EKF is disabled
+ *  or unhealthy, and its attitude is kept available for comparison.
+ *
+ *  The filter is an error state filter. The nominal state is the
+ *  attitude quaternion, NED velocity, NED position relative to the
+ *  first GPS fix and the gyro bias. The covariance holds 12 error
+ *  states: attitude (earth frame small angles), velocity, position
+ *  and gyro bias.
+ */
+
+// number of error states
+#define EKF_NUM_STATES      12
+
+// error state indexes
+#define EKF_STATE_ATT       0
+#define EKF_STATE_VEL       3
+#define EKF_STATE_POS       6
+#define EKF_STATE_GBIAS     9
+
+// number of past velocity/position samples kept to match against
+// delayed GPS measurements, and the interval between them
+#define EKF_HISTORY_LEN     64
+#define EKF_HISTORY_MS      20
+
+class AP_AHRS_EKF : public AP_AHRS_DCM
+{
+public:
+    // Constructor
+    AP_AHRS_EKF(AP_InertialSensor *ins, AP_Baro &baro, GPS *&gps) :
+        AP_AHRS_DCM(ins, gps),
+        _baro(baro),
+        _ekf_initialised(false),
+        _ekf_healthy(false),
+        _have_origin(false)
+    {
+        _ekf_dcm.identity();
+    }
+
+    // Methods
+    void            update(void);
+    void            reset(bool recover_eulers = false);
+
+    // return a DCM rotation matrix representing our current
+    // attitude
+    const Matrix3f &get_dcm_matrix(void) const {
+        return _ekf_healthy ? _ekf_dcm : AP_AHRS_DCM::get_dcm_matrix();
+    }
+
+    // return the gyro vector corrected for the estimated bias
+    const Vector3f get_gyro(void) const {
+        return _ekf_healthy ? _omega_ekf : AP_AHRS_DCM::get_gyro();
+    }
+
+    // return the current gyro drift estimate
+    const Vector3f &get_gyro_drift(void) const {
+        return _ekf_healthy ? _gyro_drift : AP_AHRS_DCM::get_gyro_drift();
+    }
+
+    // dead-reckoning support
+    bool get_position(struct Location &loc);
+
+    // return true if the EKF solution is in use
+    bool            ekf_healthy(void) const { return _ekf_healthy; }
+
+    // return the EKF velocity estimate in NED m/s
+    const Vector3f &get_velocity_ned(void) const { return _vel; }
+
+    // return the EKF position estimate in NED meters relative to
+    // the first GPS fix
+    const Vector3f &get_relative_position_ned(void) const { return _pos; }
+
+    // return the DCM Euler angles, for comparison with the EKF
+    void            get_dcm_euler(float *r, float *p, float *y) const {
+        *r = _dcm_roll; *p = _dcm_pitch; *y = _dcm_yaw;
+    }
+
+private:
+    // Methods
+    void            ekf_init(void);
+    void            ekf_predict(float dt);
+    void            ekf_fuse(const float h[EKF_NUM_STATES], float innovation, float R);
+    void            ekf_correct(void);
+    void            fuse_gps(void);
+    void            fuse_baro(void);
+    void            fuse_compass(void);
+    void            fuse_gravity(void);
+    void            store_history(void);
+    bool            get_history(uint32_t time_ms, Vector3f &vel, Vector3f &pos) const;
+    void            reset_to_gps(void);
+    void            update_outputs(void);
+    bool            check_health(void);
+
+    AP_Baro         &_baro;
+
+    // nominal state
+    Quaternion      _q;
+    Vector3f        _vel;
+    Vector3f        _pos;
+    Vector3f        _gyro_bias;
+
+    // error state covariance and accumulated correction
+    float           _P[EKF_NUM_STATES][EKF_NUM_STATES];
+    float           _dx[EKF_NUM_STATES];
+
+    // outputs derived from the state
+    Matrix3f        _ekf_dcm;
+    Vector3f        _omega_ekf;
+    Vector3f        _gyro_drift;
+
+    // the DCM attitude from this update, for comparison
+    float           _dcm_roll, _dcm_pitch, _dcm_yaw;
+
+    // time integrated from the IMU delta times, in milliseconds
+    uint32_t        _ekf_time_ms;
+    float           _ekf_time_frac;
+
+    // time of the last sample of each measurement
+    uint32_t        _last_gps_fix_ms;
+    uint32_t        _last_baro_update;
+    uint32_t        _last_compass_update;
+
+    // time of the last accepted GPS measurement, in EKF time
+    uint32_t        _last_gps_accept_ms;
+
+    // origin of the NED position
+    struct Location _origin;
+
+    // past velocity and position, for delayed GPS fusion
+    struct ekf_history {
+        uint32_t time_ms;
+        Vector3f vel;
+        Vector3f pos;
+    } _history[EKF_HISTORY_LEN];
+    uint8_t         _history_head;
+    uint8_t         _history_count;
+
+    bool            _ekf_initialised:1;
+    bool            _ekf_healthy:1;
+    bool            _have_origin:1;
+};
+
+#endif // __AP_AHRS_EKF_H__
@@ -0,0 +1,331 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Compare the cost and accuracy of the DCM matrix and quaternion
+// attitude integration (AHRS_QUAT_USE).
+//
+// Two things are measured over the same gyro samples:
+//
+//  - the time of a complete AP_AHRS_DCM::update() with each
+//    integrator, which is what a vehicle pays. The drift correction
+//    works on the DCM matrix, so with the quaternion the matrix is
+//    still recomputed on every update
+//
+//  - the bare integrators, DCM matrix rotation plus renormalisation
+//    against quaternion rotation plus normalisation, with no drift
+//    correction. The attitude error is measured against the true
+//    attitude for the built in coning motion, and between the two
+//    integrators for recorded data
+//
+// By default the samples are a coning motion, which stresses the
+// integrators. On SITL and Linux the IMU records of an AHRS_Replay log
+// named by REPLAY_LOG are used instead when it is set. These are
+// assumed to be 100Hz samples.
+//
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Baro.h>
+#include <GCS_MAVLink.h>
+#include <Filter.h>
+#include <SITL.h>
+#include <AP_Buffer.h>
+#include <AP_Notify.h>
+#include <AP_Vehicle.h>
+#include <DataFlash.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define BENCHMARK_READ_LOG 1
+#else
+#define BENCHMARK_READ_LOG 0
+#endif
+
+// coning motion: half angle, rate and duration
+#define CONING_ANGLE    0.1f
+#define CONING_RATE     (2*PI*5)
+#define CONING_SAMPLES  10000
+#define SAMPLE_DT       0.01f
+
+// an inertial sensor with a fixed time step
+class BenchINS : public AP_InertialSensor_HIL
+{
+public:
+    bool update(void) { return true; }
+    float get_temperature(void) const { return 0; }
+    float get_delta_time(void) { return SAMPLE_DT; }
+};
+
+// a DCM AHRS with the integrator selected
+class BenchAHRS : public AP_AHRS_DCM
+{
+public:
+    BenchAHRS(AP_InertialSensor *ins, GPS *&gps, bool quaternion) :
+        AP_AHRS_DCM(ins, gps) {
+        _quat_use.set(quaternion);
+    }
+};
+
+BenchINS ins;
+GPS *g_gps = NULL;
+
+BenchAHRS ahrs_matrix(&ins, g_gps, false);
+BenchAHRS ahrs_quat(&ins, g_gps, true);
+
+#if BENCHMARK_READ_LOG
+static FILE *log_file;
+#endif
+static uint16_t sample_count;
+
+// the true attitude of the coning motion at sample i
+static Quaternion coning_attitude(uint16_t i)
+{
+    float t = i * SAMPLE_DT;
+    float s = sinf(CONING_ANGLE/2);
+    return Quaternion(cosf(CONING_ANGLE/2),
+                      s * cosf(CONING_RATE * t),
+                      s * sinf(CONING_RATE * t),
+                      0);
+}
+
+// the rotation vector of the unit quaternion q, taking the shorter
+// of the two rotations it can represent
+static Vector3f rotation_vector(const Quaternion &q)
+{
+    Vector3f v(q.q2, q.q3, q.q4);
+    float len = v.length();
+    if (len < 1.0e-12f) {
+        return Vector3f(0, 0, 0);
+    }
+    float angle = 2 * atan2f(len, fabsf(q.q1));
+    if (q.q1 < 0) {
+        angle = -angle;
+    }
+    return v * (angle / len);
+}
+
+// the angle between two attitudes, in radians
+static float attitude_error(const Quaternion &a, const Quaternion &b)
+{
+    Quaternion a_inv(a.q1, -a.q2, -a.q3, -a.q4);
+    return rotation_vector(a_inv * b).length();
+}
+
+// the angle between a DCM matrix and a quaternion attitude
+static float attitude_error(const Matrix3f &m, const Quaternion &b)
+{
+    Quaternion a;
+    a.from_rotation_matrix(m);
+    a.normalize();
+    return attitude_error(a, b);
+}
+
+/*
+  get the next gyro and accel sample. Returns false when there are no
+  more samples
+ */
+static bool next_sample(Vector3f &gyro, Vector3f &accel)
+{
+#if BENCHMARK_READ_LOG
+    if (log_file != NULL) {
+        char line[200];
+        float t, v[6];
+        while (fgets(line, sizeof(line), log_file) != NULL) {
+            if (sscanf(line, "IMU,%f,%f,%f,%f,%f,%f,%f",
+                       &t, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 7) {
+                gyro = Vector3f(v[0], v[1], v[2]);
+                accel = Vector3f(v[3], v[4], v[5]);
+                sample_count++;
+                return true;
+            }
+        }
+        return false;
+    }
+#endif
+    if (sample_count >= CONING_SAMPLES) {
+        return false;
+    }
+    // the constant rate which gives exactly the rotation from this
+    // sample to the next
+    Quaternion q0 = coning_attitude(sample_count);
+    Quaternion q1 = coning_attitude(sample_count+1);
+    Quaternion q0_inv(q0.q1, -q0.q2, -q0.q3, -q0.q4);
+    gyro = rotation_vector(q0_inv * q1) / SAMPLE_DT;
+
+    // gravity in the body frame
+    Matrix3f m;
+    q1.rotation_matrix(m);
+    accel = m.mul_transpose(Vector3f(0, 0, -GRAVITY_MSS));
+    sample_count++;
+    return true;
+}
+
+// go back to the first sample
+static void restart_samples(void)
+{
+#if BENCHMARK_READ_LOG
+    if (log_file != NULL) {
+        rewind(log_file);
+    }
+#endif
+    sample_count = 0;
+}
+
+/*
+  the time of one pass over the samples in microseconds, updating ahrs
+  with each, or only giving them to the inertial sensor when ahrs is
+  NULL
+ */
+static uint32_t time_updates(AP_AHRS_DCM *ahrs)
+{
+    Vector3f gyro, accel;
+    restart_samples();
+    uint32_t t0 = hal.scheduler->micros();
+    while (next_sample(gyro, accel)) {
+        ins.set_gyro(gyro);
+        ins.set_accel(accel);
+        if (ahrs != NULL) {
+            ahrs->update();
+        }
+    }
+    return hal.scheduler->micros() - t0;
+}
+
+/*
+  renormalise a DCM matrix as AP_AHRS_DCM does
+ */
+static void dcm_normalize(Matrix3f &m)
+{
+    float error = m.a * m.b;
+    Vector3f t0 = m.a - (m.b * (0.5f * error));
+    Vector3f t1 = m.b - (m.a * (0.5f * error));
+    Vector3f t2 = t0 % t1;
+    m.a = t0 * (1.0f / t0.length());
+    m.b = t1 * (1.0f / t1.length());
+    m.c = t2 * (1.0f / t2.length());
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("AHRS integrator benchmark"));
+
+#if BENCHMARK_READ_LOG
+    const char *fname = getenv("REPLAY_LOG");
+    if (fname != NULL) {
+        log_file = fopen(fname, "r");
+        if (log_file == NULL) {
+            hal.console->printf("Unable to open %s\n", fname);
+            exit(1);
+        }
+    }
+#endif
+
+    ins.init(AP_InertialSensor::COLD_START,
+             AP_InertialSensor::RATE_100HZ);
+    ahrs_matrix.init();
+    ahrs_quat.init();
+}
+
+void loop(void)
+{
+    Matrix3f dcm;
+    Quaternion quat;
+    Vector3f gyro, accel;
+    float max_err_matrix = 0, max_err_quat = 0;
+    uint32_t integrate_matrix_us = 0, integrate_quat_us = 0;
+    uint32_t t0;
+
+    // the cost of making the samples is taken off the update times
+    uint32_t samples_us = time_updates(NULL);
+    uint32_t update_matrix_us = time_updates(&ahrs_matrix);
+    uint32_t update_quat_us = time_updates(&ahrs_quat);
+    update_matrix_us -= min(update_matrix_us, samples_us);
+    update_quat_us -= min(update_quat_us, samples_us);
+    restart_samples();
+
+    dcm.identity();
+    quat = coning_attitude(0);
+    quat.rotation_matrix(dcm);
+#if BENCHMARK_READ_LOG
+    if (log_file != NULL) {
+        quat = Quaternion();
+        dcm.identity();
+    }
+#endif
+
+    while (next_sample(gyro, accel)) {
+        Vector3f rotation = gyro * SAMPLE_DT;
+
+        t0 = hal.scheduler->micros();
+        dcm.rotate(rotation);
+        dcm_normalize(dcm);
+        integrate_matrix_us += hal.scheduler->micros() - t0;
+
+        t0 = hal.scheduler->micros();
+        quat.rotate_fast(rotation);
+        quat.normalize();
+        integrate_quat_us += hal.scheduler->micros() - t0;
+
+#if BENCHMARK_READ_LOG
+        if (log_file != NULL) {
+            // no truth for recorded data, so compare the two
+            max_err_quat = max(max_err_quat, attitude_error(dcm, quat));
+        } else
+#endif
+        {
+            Quaternion truth = coning_attitude(sample_count);
+            max_err_matrix = max(max_err_matrix, attitude_error(dcm, truth));
+            max_err_quat = max(max_err_quat, attitude_error(quat, truth));
+        }
+    }
+
+    float n = sample_count > 0 ? sample_count : 1;
+    hal.console->printf_P(PSTR("%u samples\n"), (unsigned)sample_count);
+    hal.console->printf_P(PSTR("update     matrix %.3f us  quaternion %.3f us\n"),
+                          update_matrix_us / n, update_quat_us / n);
+    hal.console->printf_P(PSTR("integrate  matrix %.3f us  quaternion %.3f us\n"),
+                          integrate_matrix_us / n, integrate_quat_us / n);
+#if BENCHMARK_READ_LOG
+    if (log_file != NULL) {
+        hal.console->printf_P(PSTR("max difference between integrators %.6f degrees\n"),
+                              ToDeg(max_err_quat));
+    } else
+#endif
+    {
+        hal.console->printf_P(PSTR("max drift  matrix %.6f degrees  quaternion %.6f degrees\n"),
+                              ToDeg(max_err_matrix), ToDeg(max_err_quat));
+    }
+    hal.console->printf_P(PSTR("AHRS attitude difference r:%.3f p:%.3f y:%.3f degrees\n"),
+                          ToDeg(wrap_PI(ahrs_matrix.roll - ahrs_quat.roll)),
+                          ToDeg(wrap_PI(ahrs_matrix.pitch - ahrs_quat.pitch)),
+                          ToDeg(wrap_PI(ahrs_matrix.yaw - ahrs_quat.yaw)));
+
+#if BENCHMARK_READ_LOG
+    exit(0);
+#endif
+    for (;;) {
+        hal.scheduler->delay(1000);
+    }
+}
+
+AP_HAL_MAIN();
@@ -0,0 +1,242 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Replay recorded sensor data through the DCM and EKF AHRS and
+// compare the two. Only works on SITL and Linux, as it reads the log
+// with stdio.
+//
+// The log is a CSV file, named by the REPLAY_LOG environment
+// variable (default replay.csv), with one record per line. Times are
+// in milliseconds, angles in degrees:
+//
+//   IMU,time,gyro_x,gyro_y,gyro_z,accel_x,accel_y,accel_z   (rad/s, m/s/s)
+//   GPS,time,lat,lng,alt,ground_speed,ground_course,num_sats (deg, m, m/s)
+//   MAG,time,mag_x,mag_y,mag_z                                (milligauss)
+//   BARO,time,alt                                             (m)
+//
+// Each IMU record is one AHRS update. The attitude from both
+// estimators is printed at 10Hz, followed by the RMS difference
+// between them over the whole log.
+//
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Baro.h>
+#include <GCS_MAVLink.h>
+#include <Filter.h>
+#include <SITL.h>
+#include <AP_Buffer.h>
+#include <AP_Notify.h>
+#include <AP_Vehicle.h>
+#include <DataFlash.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// an inertial sensor which takes its time step from the log
+class ReplayINS : public AP_InertialSensor_HIL
+{
+public:
+    bool update(void) { return true; }
+    float get_temperature(void) const { return 0; }
+    void set_delta_time(uint32_t usec) { _delta_time_usec = usec; }
+};
+
+// a barometer which takes its timestamps from the log
+class ReplayBaro : public AP_Baro_HIL
+{
+public:
+    uint8_t read(void) {
+        uint8_t ret = AP_Baro_HIL::read();
+        _last_update = replay_ms;
+        return ret;
+    }
+    uint32_t replay_ms;
+};
+
+// the AHRS under test, with the EKF enabled
+class ReplayAHRS : public AP_AHRS_EKF
+{
+public:
+    ReplayAHRS(AP_InertialSensor *ins, AP_Baro &baro, GPS *&gps) :
+        AP_AHRS_EKF(ins, baro, gps) {
+        _ekf_use.set(1);
+    }
+};
+
+ReplayINS ins;
+ReplayBaro barometer;
+AP_Compass_HIL compass;
+AP_GPS_HIL g_gps_driver;
+GPS *g_gps = &g_gps_driver;
+
+ReplayAHRS ahrs(&ins, barometer, g_gps);
+
+static FILE *log_file;
+static uint32_t last_imu_ms;
+static uint32_t last_print_ms;
+static bool have_baro;
+
+// sums for the RMS difference between the EKF and DCM
+static float sum_roll, sum_pitch, sum_yaw;
+static uint32_t sum_count;
+
+static void handle_imu(uint32_t t, const float *v)
+{
+    ins.set_gyro(Vector3f(v[0], v[1], v[2]));
+    ins.set_accel(Vector3f(v[3], v[4], v[5]));
+    if (last_imu_ms != 0) {
+        ins.set_delta_time((t - last_imu_ms) * 1000UL);
+    }
+    last_imu_ms = t;
+
+    ahrs.update();
+
+    float roll, pitch, yaw;
+    ahrs.get_dcm_euler(&roll, &pitch, &yaw);
+    if (!ahrs.ekf_healthy()) {
+        return;
+    }
+    float droll  = wrap_PI(ahrs.roll - roll);
+    float dpitch = wrap_PI(ahrs.pitch - pitch);
+    float dyaw   = wrap_PI(ahrs.yaw - yaw);
+    sum_roll  += sq(droll);
+    sum_pitch += sq(dpitch);
+    sum_yaw   += sq(dyaw);
+    sum_count++;
+
+    if (t - last_print_ms >= 100) {
+        const Vector3f &pos = ahrs.get_relative_position_ned();
+        hal.console->printf_P(PSTR("%lu DCM r:%6.1f p:%6.1f y:%6.1f "
+                                   "EKF r:%6.1f p:%6.1f y:%6.1f pos:%7.1f %7.1f %6.1f\n"),
+                              (unsigned long)t,
+                              ToDeg(roll), ToDeg(pitch), ToDeg(yaw),
+                              ToDeg(ahrs.roll), ToDeg(ahrs.pitch), ToDeg(ahrs.yaw),
+                              pos.x, pos.y, pos.z);
+        last_print_ms = t;
+    }
+}
+
+static void handle_gps(uint32_t t, const float *v)
+{
+    g_gps->setHIL(t, v[0], v[1], v[2], v[3], v[4], 0, v[5]);
+    g_gps->update();
+    g_gps->last_fix_time = t;
+}
+
+static void handle_mag(uint32_t t, const float *v)
+{
+    compass.setHIL(Vector3f(v[0], v[1], v[2]));
+    compass.read();
+    compass.last_update = t * 1000UL;
+}
+
+static void handle_baro(uint32_t t, const float *v)
+{
+    barometer.replay_ms = t;
+    barometer.setHIL(v[0]);
+    barometer.read();
+    if (!have_baro) {
+        // use the first reading as the ground altitude
+        barometer.update_calibration();
+        have_baro = true;
+    }
+}
+
+void setup(void)
+{
+    const char *fname = getenv("REPLAY_LOG");
+    if (fname == NULL) {
+        fname = "replay.csv";
+    }
+    log_file = fopen(fname, "r");
+    if (log_file == NULL) {
+        hal.console->printf("Unable to open %s\n", fname);
+        exit(1);
+    }
+
+    ins.init(AP_InertialSensor::COLD_START,
+             AP_InertialSensor::RATE_100HZ);
+    compass.init();
+    compass.set_offsets(Vector3f(0, 0, 0));
+    ahrs.init();
+    ahrs.set_compass(&compass);
+    barometer.init();
+    g_gps->init(NULL);
+}
+
+void loop(void)
+{
+    char line[200];
+    if (fgets(line, sizeof(line), log_file) == NULL) {
+        float n = sum_count > 0 ? sum_count : 1;
+        hal.console->printf_P(PSTR("RMS EKF-DCM difference over %lu samples: "
+                                   "roll %.2f pitch %.2f yaw %.2f degrees\n"),
+                              (unsigned long)sum_count,
+                              ToDeg(sqrtf(sum_roll/n)),
+                              ToDeg(sqrtf(sum_pitch/n)),
+                              ToDeg(sqrtf(sum_yaw/n)));
+        exit(0);
+    }
+
+    char *saveptr = NULL;
+    const char *type = strtok_r(line, ",", &saveptr);
+    const char *tstr = strtok_r(NULL, ",", &saveptr);
+    if (type == NULL || tstr == NULL) {
+        return;
+    }
+    uint32_t t = strtoul(tstr, NULL, 10);
+    float v[6];
+    uint8_t n = 0;
+    const char *s;
+    while (n < 6 && (s = strtok_r(NULL, ",", &saveptr)) != NULL) {
+        v[n++] = atof(s);
+    }
+
+    if (strcmp(type, "IMU") == 0 && n == 6) {
+        handle_imu(t, v);
+    } else if (strcmp(type, "GPS") == 0 && n == 6) {
+        handle_gps(t, v);
+    } else if (strcmp(type, "MAG") == 0 && n == 3) {
+        handle_mag(t, v);
+    } else if (strcmp(type, "BARO") == 0 && n == 1) {
+        handle_baro(t, v);
+    }
+}
+
+#else
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("AHRS_Replay is only supported on SITL and Linux"));
+}
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif
+
+AP_HAL_MAIN();
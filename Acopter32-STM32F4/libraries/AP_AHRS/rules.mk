@@ -12,6 +12,7 @@ cSRCS_$(d) :=
 
 cppSRCS_$(d) :=
 cppSRCS_$(d) += AP_AHRS_DCM.cpp
+cppSRCS_$(d) += AP_AHRS_EKF.cpp
 cppSRCS_$(d) += AP_AHRS_HIL.cpp
 cppSRCS_$(d) += AP_AHRS.cpp
 
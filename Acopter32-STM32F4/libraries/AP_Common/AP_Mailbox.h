@@ -0,0 +1,85 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AP_MAILBOX_H__
+#define __AP_MAILBOX_H__
+
+/*
+  a lock free mailbox holding the latest value of a T, posted by one
+  writer and read by one reader, where the reader may be a timer
+  process or interrupt which preempts the writer
+
+  The value is kept in two slots. post() fills the slot the reader is
+  not using and then bumps the sequence number, which makes it the
+  current one. A reader which preempts post() always finds a complete
+  value in the current slot. Where the reader runs in its own thread
+  on another core, a second post could overwrite the slot it is
+  copying. It sees from the sequence number that a post completed
+  meanwhile, and read() then fails rather than return a torn value.
+ */
+
+#include <stdint.h>
+#include <AP_HAL_Boards.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+// timer threads may run on another core
+ # define AP_MAILBOX_BARRIER() __sync_synchronize()
+#else
+// the reader only ever preempts the writer on this core
+ # define AP_MAILBOX_BARRIER() __asm__ __volatile__("" ::: "memory")
+#endif
+
+template <typename T>
+class AP_Mailbox
+{
+public:
+    AP_Mailbox() : _seq(0), _posted(false) {}
+
+    // make v the current value. Only one writer may call this
+    void post(const T &v) {
+        AP_MAILBOX_BARRIER();
+        _slot[(_seq + 1) & 1] = v;
+        AP_MAILBOX_BARRIER();
+        _seq++;
+        _posted = true;
+    }
+
+    // copy the current value to v. Returns false, leaving v
+    // unchanged, if nothing has been posted or a post completed
+    // while it was being copied
+    bool read(T &v) const {
+        if (!_posted) {
+            return false;
+        }
+        uint8_t seq = _seq;
+        AP_MAILBOX_BARRIER();
+        T ret = _slot[seq & 1];
+        AP_MAILBOX_BARRIER();
+        if (_seq != seq) {
+            return false;
+        }
+        v = ret;
+        return true;
+    }
+
+private:
+    T _slot[2];
+    // a byte, so it is updated atomically on all boards
+    volatile uint8_t _seq;
+    volatile bool _posted;
+};
+
+#endif // __AP_MAILBOX_H__
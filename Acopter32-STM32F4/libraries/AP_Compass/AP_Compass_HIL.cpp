@@ -50,9 +50,6 @@ void AP_Compass_HIL::_setup_earth_field(void)
 
 bool AP_Compass_HIL::read()
 {
-    // get offsets
-    Vector3f ofs = _offset.get();
-
     // apply motor compensation
     if(_motor_comp_type != AP_COMPASS_MOT_COMP_DISABLED && _thr_or_curr != 0.0f) {
         _motor_offset = _motor_compensation.get() * _thr_or_curr;
@@ -63,9 +60,10 @@ bool AP_Compass_HIL::read()
     }
 
     // return last values provided by setHIL function
-    mag_x = _hil_mag.x + ofs.x + _motor_offset.x;
-    mag_y = _hil_mag.y + ofs.y + _motor_offset.y;
-    mag_z = _hil_mag.z + ofs.z + _motor_offset.z;
+    Vector3f mag = correct_field(_hil_mag) + _motor_offset;
+    mag_x = mag.x;
+    mag_y = mag.y;
+    mag_z = mag.z;
 
     // values set by setHIL function
     last_update = hal.scheduler->micros();      // record time of update
@@ -107,6 +105,17 @@ void AP_Compass_HIL::setHIL(float roll, float pitch, float yaw)
         _hil_mag.rotate(_board_orientation);
     }
 
+    calibration_sample(_hil_mag);
+    healthy = true;
+}
+
+// Update raw magnetometer values from a recorded body frame field,
+// as used for log replay
+//
+void AP_Compass_HIL::setHIL(const Vector3f &mag)
+{
+    _hil_mag = mag;
+    calibration_sample(_hil_mag);
     healthy = true;
 }
 
@@ -17,6 +17,8 @@
 #include <AP_Math.h>
 #include <AP_HAL.h>
 
+// the compass on the second I2C bus of the STM32 boards
+#if CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
 #include "AP_Compass_HMC5843_EXT.h"
 
 extern const AP_HAL::HAL& hal;
@@ -140,6 +142,13 @@ void AP_Compass_HMC5843_EXT::accumulate(void)
 		 _accum_count = 7;
 	  }
 	  _last_accum_time = tnow;
+
+	  // the calibrator takes each reading, rather than the average
+	  if (_calibrator != NULL) {
+		 calibration_sample(rotate_field(Vector3f(_mag_x * calibration[0],
+		                                          _mag_y * calibration[1],
+		                                          _mag_z * calibration[2])));
+	  }
    }
 }
 
@@ -286,6 +295,26 @@ AP_Compass_HMC5843_EXT::init()
     return success;
 }
 
+// rotate a reading to the desired orientation
+Vector3f AP_Compass_HMC5843_EXT::rotate_field(Vector3f mag) const
+{
+    if (product_id == AP_COMPASS_TYPE_HMC5883L) {
+        mag.rotate(ROTATION_YAW_90);
+    }
+
+    // apply default board orientation for this compass type. This is
+    // a noop on most boards
+    mag.rotate(MAG_BOARD_ORIENTATION);
+
+    // add user selectable orientation
+    mag.rotate((enum Rotation)_orientation.get());
+
+    // add in board orientation from AHRS
+    mag.rotate(_board_orientation);
+
+    return mag;
+}
+
 // Read Sensor data
 bool AP_Compass_HMC5843_EXT::read()
 {
@@ -324,23 +353,7 @@ bool AP_Compass_HMC5843_EXT::read()
 
     last_update = hal.scheduler->micros(); // record time of update
 
-    // rotate to the desired orientation
-    Vector3f rot_mag = Vector3f(mag_x,mag_y,mag_z);
-    if (product_id == AP_COMPASS_TYPE_HMC5883L) {
-        rot_mag.rotate(ROTATION_YAW_90);
-    }
-
-    // apply default board orientation for this compass type. This is
-    // a noop on most boards
-    rot_mag.rotate(MAG_BOARD_ORIENTATION);
-
-    // add user selectable orientation
-    rot_mag.rotate((enum Rotation)_orientation.get());
-
-    // add in board orientation from AHRS
-    rot_mag.rotate(_board_orientation);
-
-    rot_mag += _offset.get();
+    Vector3f rot_mag = correct_field(rotate_field(Vector3f(mag_x,mag_y,mag_z)));
 
     // apply motor compensation
     if(_motor_comp_type != AP_COMPASS_MOT_COMP_DISABLED && _thr_or_curr != 0.0f) {
@@ -359,3 +372,5 @@ bool AP_Compass_HMC5843_EXT::read()
 
     return true;
 }
+
+#endif // CONFIG_HAL_BOARD
@@ -114,7 +114,10 @@ bool AP_Compass_PX4::read(void)
         _sum.rotate(_board_orientation);
     }
 
-    _sum += _offset.get();
+    // the calibrator takes the average of the reports since the last read
+    calibration_sample(_sum);
+
+    _sum = correct_field(_sum);
 
     // apply motor compensation
     if (_motor_comp_type != AP_COMPASS_MOT_COMP_DISABLED && _thr_or_curr != 0.0f) {
@@ -98,6 +98,38 @@ const AP_Param::GroupInfo Compass::var_info[] PROGMEM = {
     // @User: Advanced
     AP_GROUPINFO("EXTERNAL", 9, Compass, _external, 0),
 
+    // @Param: DIA_X
+    // @DisplayName: Compass soft iron diagonal X component
+    // @Description: DIA_X in the compass soft iron calibration matrix: [[DIA_X, ODI_X, ODI_Y], [ODI_X, DIA_Y, ODI_Z], [ODI_Y, ODI_Z, DIA_Z]]. Zero on all three axes is taken as no soft iron correction
+    // @User: Advanced
+
+    // @Param: DIA_Y
+    // @DisplayName: Compass soft iron diagonal Y component
+    // @Description: DIA_Y in the compass soft iron calibration matrix
+    // @User: Advanced
+
+    // @Param: DIA_Z
+    // @DisplayName: Compass soft iron diagonal Z component
+    // @Description: DIA_Z in the compass soft iron calibration matrix
+    // @User: Advanced
+    AP_GROUPINFO("DIA",    10, Compass, _diagonals, 0),
+
+    // @Param: ODI_X
+    // @DisplayName: Compass soft iron off-diagonal X component
+    // @Description: ODI_X in the compass soft iron calibration matrix, the XY element
+    // @User: Advanced
+
+    // @Param: ODI_Y
+    // @DisplayName: Compass soft iron off-diagonal Y component
+    // @Description: ODI_Y in the compass soft iron calibration matrix, the XZ element
+    // @User: Advanced
+
+    // @Param: ODI_Z
+    // @DisplayName: Compass soft iron off-diagonal Z component
+    // @Description: ODI_Z in the compass soft iron calibration matrix, the YZ element
+    // @User: Advanced
+    AP_GROUPINFO("ODI",    11, Compass, _offdiagonals, 0),
+
     AP_GROUPEND
 };
 
@@ -107,7 +139,8 @@ const AP_Param::GroupInfo Compass::var_info[] PROGMEM = {
 //
 Compass::Compass(void) :
     product_id(AP_COMPASS_TYPE_UNKNOWN),
-    _null_init_done(false)
+    _null_init_done(false),
+    _calibrator(NULL)
 {
     AP_Param::setup_object_defaults(this, var_info);
 }
@@ -138,6 +171,36 @@ Compass::get_offsets() const
     return _offset;
 }
 
+void
+Compass::set_calibration(const Vector3f &offsets, const Vector3f &diagonals, const Vector3f &offdiagonals)
+{
+    _offset.set(offsets);
+    _diagonals.set(diagonals);
+    _offdiagonals.set(offdiagonals);
+}
+
+void
+Compass::save_calibration()
+{
+    _offset.save();
+    _diagonals.save();
+    _offdiagonals.save();
+}
+
+Vector3f
+Compass::correct_field(const Vector3f &field) const
+{
+    Vector3f v = field + _offset.get();
+    if (!soft_iron_calibrated()) {
+        return v;
+    }
+    const Vector3f &d = _diagonals.get();
+    const Vector3f &o = _offdiagonals.get();
+    return Vector3f(d.x*v.x + o.x*v.y + o.y*v.z,
+                    o.x*v.x + d.y*v.y + o.z*v.z,
+                    o.y*v.x + o.z*v.y + d.z*v.z);
+}
+
 void
 Compass::set_motor_compensation(const Vector3f &motor_comp_factor)
 {
@@ -243,6 +306,13 @@ Compass::null_offsets(void)
         return;
     }
 
+    if (soft_iron_calibrated()) {
+        // the learning assumes the field is the raw field plus the
+        // offsets, which is not true with a soft iron matrix, so it
+        // would undo the calibration
+        return;
+    }
+
     // this gain is set so we converge on the offsets in about 5
     // minutes with a 10Hz compass
     const float gain = 0.01;
@@ -7,6 +7,7 @@
 #include <AP_Param.h>
 #include <AP_Math.h>
 #include <AP_Declination.h> // ArduPilot Mega Declination Helper Library
+#include "CompassCalibrator.h"
 
 // compass product id
 #define AP_COMPASS_TYPE_UNKNOWN  0x00
@@ -33,6 +34,8 @@
 # define MAG_BOARD_ORIENTATION ROTATION_NONE
 #elif CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 # define MAG_BOARD_ORIENTATION ROTATION_NONE
+#elif CONFIG_HAL_BOARD == HAL_BOARD_EMPTY
+# define MAG_BOARD_ORIENTATION ROTATION_NONE
 #elif CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
 # define MAG_BOARD_ORIENTATION ROTATION_YAW_180
 #elif CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
@@ -97,6 +100,35 @@ public:
     ///
     const Vector3f &get_offsets() const;
 
+    /// Sets the offsets and soft iron matrix of a calibration, as
+    /// found by CompassCalibrator.
+    ///
+    /// @param  offsets             Offsets added to the rotated field.
+    /// @param  diagonals           Diagonal of the soft iron matrix.
+    /// @param  offdiagonals        XY, XZ and YZ elements of the soft iron matrix.
+    ///
+    void set_calibration(const Vector3f &offsets, const Vector3f &diagonals, const Vector3f &offdiagonals);
+
+    /// Saves the offsets and soft iron matrix.
+    ///
+    void save_calibration();
+
+    const Vector3f &get_diagonals() const { return _diagonals; }
+
+    /// true if a soft iron matrix is set. A zero diagonal means none
+    bool soft_iron_calibrated() const {
+        const Vector3f &d = _diagonals.get();
+        return d.x != 0 || d.y != 0 || d.z != 0;
+    }
+    const Vector3f &get_offdiagonals() const { return _offdiagonals; }
+
+    /// Sets the calibrator the rotated field is passed to at the
+    /// sensor rate, or NULL for none.
+    ///
+    void set_calibrator(CompassCalibrator *calibrator) {
+        _calibrator = calibrator;
+    }
+
     /// Sets the initial location used to get declination
     ///
     /// @param  latitude             GPS Latitude.
@@ -198,8 +230,20 @@ public:
     AP_Int8 _learn;                             ///<enable calibration learning
 
 protected:
+    /// the rotated field corrected by the offsets and soft iron matrix
+    Vector3f correct_field(const Vector3f &field) const;
+
+    /// pass a rotated field without offsets to the calibrator
+    void calibration_sample(const Vector3f &field) {
+        if (_calibrator != NULL) {
+            _calibrator->new_sample(field);
+        }
+    }
+
     AP_Int8 _orientation;
     AP_Vector3f _offset;
+    AP_Vector3f _diagonals;                     ///<soft iron matrix diagonal
+    AP_Vector3f _offdiagonals;                  ///<soft iron matrix XY, XZ and YZ
     AP_Float _declination;
     AP_Int8 _use_for_yaw;                       ///<enable use for yaw calculation
     AP_Int8 _auto_declination;                  ///<enable automatic declination code
@@ -220,5 +264,7 @@ protected:
 
     // board orientation from AHRS
     enum Rotation _board_orientation;
+
+    CompassCalibrator *_calibrator;
 };
 #endif
@@ -0,0 +1,397 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  least squares hard and soft iron calibration of a compass
+
+  The samples are fitted to an ellipsoid: the field plus the offsets,
+  multiplied by a symmetric soft iron matrix W, should have the length
+  of the radius. A sphere fit, with W the identity, is run first as it
+  converges from a rough start, then the ellipsoid fit refines it.
+ */
+
+#include "CompassCalibrator.h"
+
+// bounds of the Levenberg-Marquardt damping factor
+#define LAMBDA_MIN 1.0e-6f
+#define LAMBDA_MAX 1.0e6f
+
+/*
+  solve A x = b by Gaussian elimination with partial pivoting. A is n
+  by n, row major, and both A and b are changed. Returns false if A is
+  singular
+ */
+static bool solve_linear(float *A, float *b, float *x, uint8_t n)
+{
+    for (uint8_t col=0; col<n; col++) {
+        uint8_t pivot = col;
+        for (uint8_t row=col+1; row<n; row++) {
+            if (fabsf(A[row*n+col]) > fabsf(A[pivot*n+col])) {
+                pivot = row;
+            }
+        }
+        if (fabsf(A[pivot*n+col]) < 1.0e-20f) {
+            return false;
+        }
+        if (pivot != col) {
+            for (uint8_t k=0; k<n; k++) {
+                float t = A[col*n+k];
+                A[col*n+k] = A[pivot*n+k];
+                A[pivot*n+k] = t;
+            }
+            float t = b[col];
+            b[col] = b[pivot];
+            b[pivot] = t;
+        }
+        for (uint8_t row=col+1; row<n; row++) {
+            float f = A[row*n+col] / A[col*n+col];
+            for (uint8_t k=col; k<n; k++) {
+                A[row*n+k] -= f * A[col*n+k];
+            }
+            b[row] -= f * b[col];
+        }
+    }
+    for (int8_t row=n-1; row>=0; row--) {
+        float sum = b[row];
+        for (uint8_t k=row+1; k<n; k++) {
+            sum -= A[row*n+k] * x[k];
+        }
+        x[row] = sum / A[row*n+row];
+    }
+    return true;
+}
+
+/*
+  the Levenberg-Marquardt step of the normal equations JTJ and JTr:
+  (JTJ + lambda * diag(JTJ)) delta = -JTr
+ */
+static bool lm_step(float *JTJ, float *JTr, float *delta, uint8_t n, float lambda)
+{
+    for (uint8_t i=0; i<n; i++) {
+        JTJ[i*n+i] *= 1.0f + lambda;
+        JTr[i] = -JTr[i];
+    }
+    return solve_linear(JTJ, JTr, delta, n);
+}
+
+// the soft iron matrix times v
+static Vector3f soft_iron(const Vector3f &v, const Vector3f &diagonals, const Vector3f &offdiagonals)
+{
+    return Vector3f(diagonals.x*v.x    + offdiagonals.x*v.y + offdiagonals.y*v.z,
+                    offdiagonals.x*v.x + diagonals.y*v.y    + offdiagonals.z*v.z,
+                    offdiagonals.y*v.x + offdiagonals.z*v.y + diagonals.z*v.z);
+}
+
+CompassCalibrator::CompassCalibrator() :
+    _status(CAL_NOT_STARTED),
+    _tolerance(COMPASS_CAL_DEFAULT_TOLERANCE),
+    _fifo_head(0),
+    _fifo_count(0),
+    _num_samples(0),
+    _diagonals(1, 1, 1),
+    _radius(0),
+    _fitness(0),
+    _sphere_lambda(1),
+    _ellipsoid_lambda(1),
+    _sphere_steps(0),
+    _ellipsoid_steps(0)
+{
+    memset(_bucket_used, 0, sizeof(_bucket_used));
+}
+
+void CompassCalibrator::start(float tolerance)
+{
+    _tolerance = tolerance;
+    _fifo_head = 0;
+    _fifo_count = 0;
+    _num_samples = 0;
+    memset(_bucket_used, 0, sizeof(_bucket_used));
+    _bucket_offsets.zero();
+    _offsets.zero();
+    _diagonals = Vector3f(1, 1, 1);
+    _offdiagonals.zero();
+    _radius = 0;
+    _fitness = 0;
+    _sphere_lambda = 1;
+    _ellipsoid_lambda = 1;
+    _sphere_steps = 0;
+    _ellipsoid_steps = 0;
+    _status = CAL_COLLECTING;
+}
+
+void CompassCalibrator::stop(void)
+{
+    _status = CAL_NOT_STARTED;
+    _fifo_count = 0;
+}
+
+void CompassCalibrator::new_sample(const Vector3f &field)
+{
+    if (_status != CAL_COLLECTING) {
+        return;
+    }
+    if (_fifo_count == COMPASS_CAL_FIFO_SIZE) {
+        // drop the oldest
+        _fifo_head = (_fifo_head + 1) % COMPASS_CAL_FIFO_SIZE;
+        _fifo_count--;
+    }
+    _fifo[(_fifo_head + _fifo_count) % COMPASS_CAL_FIFO_SIZE] = field;
+    _fifo_count++;
+}
+
+Vector3f CompassCalibrator::correct(const Vector3f &field) const
+{
+    return soft_iron(field + _offsets, _diagonals, _offdiagonals);
+}
+
+/*
+  the bucket of a field direction: the face of the cube it points
+  through, then a cell of equal angle on that face
+ */
+uint8_t CompassCalibrator::bucket(const Vector3f &field) const
+{
+    float ax = fabsf(field.x), ay = fabsf(field.y), az = fabsf(field.z);
+    uint8_t face;
+    float m, u, v;
+    if (ax >= ay && ax >= az) {
+        face = field.x > 0 ? 0 : 1;
+        m = ax; u = field.y; v = field.z;
+    } else if (ay >= az) {
+        face = field.y > 0 ? 2 : 3;
+        m = ay; u = field.x; v = field.z;
+    } else {
+        face = field.z > 0 ? 4 : 5;
+        m = az; u = field.x; v = field.y;
+    }
+    if (m <= 0) {
+        return 0;
+    }
+    const float scale = COMPASS_CAL_FACE_CELLS / (PI/2);
+    int8_t i = constrain_int16((atanf(u/m) + PI/4) * scale, 0, COMPASS_CAL_FACE_CELLS-1);
+    int8_t j = constrain_int16((atanf(v/m) + PI/4) * scale, 0, COMPASS_CAL_FACE_CELLS-1);
+    return (face * COMPASS_CAL_FACE_CELLS + i) * COMPASS_CAL_FACE_CELLS + j;
+}
+
+// keep a sample if its bucket is empty
+void CompassCalibrator::add_sample(const Vector3f &field)
+{
+    uint8_t b = bucket(field + _bucket_offsets);
+    if (_bucket_used[b/8] & (1U<<(b%8))) {
+        return;
+    }
+    _bucket_used[b/8] |= (1U<<(b%8));
+    _samples[_num_samples++] = field;
+}
+
+/*
+  choose the buckets again about the latest offsets, keeping the first
+  sample in each bucket
+ */
+void CompassCalibrator::rebucket(void)
+{
+    uint8_t n = _num_samples;
+    _num_samples = 0;
+    memset(_bucket_used, 0, sizeof(_bucket_used));
+    _bucket_offsets = _offsets;
+    for (uint8_t i=0; i<n; i++) {
+        add_sample(_samples[i]);
+    }
+}
+
+// a sphere about the mean of the samples
+void CompassCalibrator::initial_sphere(void)
+{
+    Vector3f centre;
+    for (uint8_t i=0; i<_num_samples; i++) {
+        centre += _samples[i];
+    }
+    centre /= _num_samples;
+    float radius = 0;
+    for (uint8_t i=0; i<_num_samples; i++) {
+        radius += (_samples[i] - centre).length();
+    }
+    _offsets = -centre;
+    _radius = radius / _num_samples;
+    _diagonals = Vector3f(1, 1, 1);
+    _offdiagonals.zero();
+}
+
+float CompassCalibrator::rms_error(float radius, const Vector3f &offsets,
+                                   const Vector3f &diagonals, const Vector3f &offdiagonals) const
+{
+    float sum = 0;
+    for (uint8_t i=0; i<_num_samples; i++) {
+        float r = radius - soft_iron(_samples[i] + offsets, diagonals, offdiagonals).length();
+        sum += r * r;
+    }
+    return sqrtf(sum / _num_samples);
+}
+
+/*
+  one step of the sphere fit. The residual of a sample is the radius
+  less the length of the sample plus the offsets
+ */
+void CompassCalibrator::sphere_step(void)
+{
+    float JTJ[SPHERE_PARAMS*SPHERE_PARAMS] = {};
+    float JTr[SPHERE_PARAMS] = {};
+    for (uint8_t i=0; i<_num_samples; i++) {
+        Vector3f v = _samples[i] + _offsets;
+        float len = v.length();
+        if (len < 1.0e-6f) {
+            continue;
+        }
+        float r = _radius - len;
+        float J[SPHERE_PARAMS];
+        J[PARAM_RADIUS] = 1;
+        J[PARAM_OFS_X] = -v.x / len;
+        J[PARAM_OFS_Y] = -v.y / len;
+        J[PARAM_OFS_Z] = -v.z / len;
+        for (uint8_t a=0; a<SPHERE_PARAMS; a++) {
+            for (uint8_t b=0; b<SPHERE_PARAMS; b++) {
+                JTJ[a*SPHERE_PARAMS+b] += J[a] * J[b];
+            }
+            JTr[a] += J[a] * r;
+        }
+    }
+
+    float delta[SPHERE_PARAMS];
+    if (!lm_step(JTJ, JTr, delta, SPHERE_PARAMS, _sphere_lambda)) {
+        _sphere_lambda = min(_sphere_lambda * 10, LAMBDA_MAX);
+        return;
+    }
+    float radius = _radius + delta[PARAM_RADIUS];
+    Vector3f offsets = _offsets + Vector3f(delta[PARAM_OFS_X], delta[PARAM_OFS_Y], delta[PARAM_OFS_Z]);
+    float fitness = rms_error(radius, offsets, _diagonals, _offdiagonals);
+    if (fitness < _fitness) {
+        _radius = radius;
+        _offsets = offsets;
+        _fitness = fitness;
+        _sphere_lambda = max(_sphere_lambda * 0.1f, LAMBDA_MIN);
+    } else {
+        _sphere_lambda = min(_sphere_lambda * 10, LAMBDA_MAX);
+    }
+}
+
+/*
+  one step of the ellipsoid fit of the offsets and the soft iron
+  matrix, with the radius of the sphere fit
+ */
+void CompassCalibrator::ellipsoid_step(void)
+{
+    float JTJ[ELLIPSOID_PARAMS*ELLIPSOID_PARAMS] = {};
+    float JTr[ELLIPSOID_PARAMS] = {};
+    const Vector3f &d = _diagonals;
+    const Vector3f &o = _offdiagonals;
+    for (uint8_t i=0; i<_num_samples; i++) {
+        Vector3f v = _samples[i] + _offsets;
+        Vector3f u = soft_iron(v, d, o);
+        float len = u.length();
+        if (len < 1.0e-6f) {
+            continue;
+        }
+        float r = _radius - len;
+        // W is symmetric, so the derivative by the offsets is W u
+        Vector3f Wu = soft_iron(u, d, o) / len;
+        float J[ELLIPSOID_PARAMS];
+        J[PARAM_E_OFS_X] = -Wu.x;
+        J[PARAM_E_OFS_Y] = -Wu.y;
+        J[PARAM_E_OFS_Z] = -Wu.z;
+        J[PARAM_DIAG_X] = -u.x * v.x / len;
+        J[PARAM_DIAG_Y] = -u.y * v.y / len;
+        J[PARAM_DIAG_Z] = -u.z * v.z / len;
+        J[PARAM_OFFDIAG_XY] = -(u.x * v.y + u.y * v.x) / len;
+        J[PARAM_OFFDIAG_XZ] = -(u.x * v.z + u.z * v.x) / len;
+        J[PARAM_OFFDIAG_YZ] = -(u.y * v.z + u.z * v.y) / len;
+        for (uint8_t a=0; a<ELLIPSOID_PARAMS; a++) {
+            for (uint8_t b=a; b<ELLIPSOID_PARAMS; b++) {
+                JTJ[a*ELLIPSOID_PARAMS+b] += J[a] * J[b];
+            }
+            JTr[a] += J[a] * r;
+        }
+    }
+    for (uint8_t a=1; a<ELLIPSOID_PARAMS; a++) {
+        for (uint8_t b=0; b<a; b++) {
+            JTJ[a*ELLIPSOID_PARAMS+b] = JTJ[b*ELLIPSOID_PARAMS+a];
+        }
+    }
+
+    float delta[ELLIPSOID_PARAMS];
+    if (!lm_step(JTJ, JTr, delta, ELLIPSOID_PARAMS, _ellipsoid_lambda)) {
+        _ellipsoid_lambda = min(_ellipsoid_lambda * 10, LAMBDA_MAX);
+        return;
+    }
+    Vector3f offsets = _offsets + Vector3f(delta[PARAM_E_OFS_X], delta[PARAM_E_OFS_Y], delta[PARAM_E_OFS_Z]);
+    Vector3f diagonals = _diagonals + Vector3f(delta[PARAM_DIAG_X], delta[PARAM_DIAG_Y], delta[PARAM_DIAG_Z]);
+    Vector3f offdiagonals = _offdiagonals + Vector3f(delta[PARAM_OFFDIAG_XY], delta[PARAM_OFFDIAG_XZ], delta[PARAM_OFFDIAG_YZ]);
+    float fitness = rms_error(_radius, offsets, diagonals, offdiagonals);
+    if (fitness < _fitness) {
+        _offsets = offsets;
+        _diagonals = diagonals;
+        _offdiagonals = offdiagonals;
+        _fitness = fitness;
+        _ellipsoid_lambda = max(_ellipsoid_lambda * 0.1f, LAMBDA_MIN);
+    } else {
+        _ellipsoid_lambda = min(_ellipsoid_lambda * 10, LAMBDA_MAX);
+    }
+}
+
+bool CompassCalibrator::fit_acceptable(void) const
+{
+    if (isnan(_fitness) || _fitness > _tolerance) {
+        return false;
+    }
+    if (_offsets.is_nan() || _offsets.length() > COMPASS_CAL_MAX_OFFSET) {
+        return false;
+    }
+    for (uint8_t i=0; i<3; i++) {
+        const float *d = &_diagonals.x;
+        const float *o = &_offdiagonals.x;
+        if (isnan(d[i]) || d[i] < COMPASS_CAL_MIN_DIAGONAL || d[i] > COMPASS_CAL_MAX_DIAGONAL) {
+            return false;
+        }
+        if (isnan(o[i]) || fabsf(o[i]) > COMPASS_CAL_MAX_OFFDIAGONAL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CompassCalibrator::update(void)
+{
+    if (_status != CAL_COLLECTING) {
+        return false;
+    }
+    while (_fifo_count > 0) {
+        add_sample(_fifo[_fifo_head]);
+        _fifo_head = (_fifo_head + 1) % COMPASS_CAL_FIFO_SIZE;
+        _fifo_count--;
+    }
+    if (_num_samples < COMPASS_CAL_MIN_SAMPLES) {
+        return false;
+    }
+
+    if (_sphere_steps == 0 && _ellipsoid_steps == 0 && _radius == 0) {
+        initial_sphere();
+    }
+    // new samples change the error of the fit
+    _fitness = rms_error(_radius, _offsets, _diagonals, _offdiagonals);
+    if (_sphere_steps < COMPASS_CAL_SPHERE_STEPS) {
+        sphere_step();
+        _sphere_steps++;
+    } else {
+        ellipsoid_step();
+        if (get_coverage() >= COMPASS_CAL_MIN_COVERAGE) {
+            _ellipsoid_steps++;
+        }
+    }
+
+    // the buckets follow the centre of the fit
+    if ((_offsets - _bucket_offsets).length() > 0.1f * _radius) {
+        rebucket();
+    }
+
+    if (_ellipsoid_steps >= COMPASS_CAL_ELLIPSOID_STEPS) {
+        _status = fit_acceptable() ? CAL_SUCCESS : CAL_FAILED;
+        return true;
+    }
+    return false;
+}
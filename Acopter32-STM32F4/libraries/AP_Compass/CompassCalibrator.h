@@ -0,0 +1,167 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+#ifndef CompassCalibrator_h
+#define CompassCalibrator_h
+
+#include <AP_Common.h>
+#include <AP_Math.h>
+
+// the sphere of field directions is split into buckets on the six
+// faces of a cube, 4x4 on each face, and one sample is kept in each
+#define COMPASS_CAL_FACE_CELLS          4
+#define COMPASS_CAL_NUM_BUCKETS         (6*COMPASS_CAL_FACE_CELLS*COMPASS_CAL_FACE_CELLS)
+
+// samples waiting for update()
+#define COMPASS_CAL_FIFO_SIZE           16
+
+// samples needed before fitting starts
+#define COMPASS_CAL_MIN_SAMPLES         20
+
+// fraction of the buckets that must have a sample to finish
+#define COMPASS_CAL_MIN_COVERAGE        0.6f
+
+// steps of the sphere fit before the ellipsoid fit takes over, and
+// steps of the ellipsoid fit with enough coverage before finishing
+#define COMPASS_CAL_SPHERE_STEPS        10
+#define COMPASS_CAL_ELLIPSOID_STEPS     20
+
+// default largest RMS error of a good fit, in the units of the field
+#define COMPASS_CAL_DEFAULT_TOLERANCE   10.0f
+
+// limits of a sane calibration
+#define COMPASS_CAL_MAX_OFFSET          1000.0f
+#define COMPASS_CAL_MIN_DIAGONAL        0.2f
+#define COMPASS_CAL_MAX_DIAGONAL        5.0f
+#define COMPASS_CAL_MAX_OFFDIAGONAL     1.0f
+
+/// @class	CompassCalibrator
+/// @brief	least squares hard and soft iron calibration of a compass
+///
+/// Samples of the field, without offsets, are queued with new_sample()
+/// at the sensor rate, and update() is called from the main loop. Each
+/// update() takes the queued samples, keeps those in a new bucket of
+/// the sphere of field directions, and runs one Levenberg-Marquardt
+/// step of a sphere fit (radius and offsets) and then of an ellipsoid
+/// fit (offsets and a symmetric soft iron matrix). The work of a step
+/// is bounded by the number of buckets, so update() can run in flight.
+///
+/// The result is in the form Compass applies it: the corrected field
+/// is the soft iron matrix times the field plus the offsets.
+///
+class CompassCalibrator
+{
+public:
+    enum cal_status {
+        CAL_NOT_STARTED = 0,
+        CAL_COLLECTING,
+        CAL_SUCCESS,
+        CAL_FAILED
+    };
+
+    /// Constructor
+    ///
+    CompassCalibrator();
+
+    /// Start a new calibration, dropping any samples and fit.
+    ///
+    /// @param  tolerance           largest RMS error of a good fit
+    ///
+    void start(float tolerance = COMPASS_CAL_DEFAULT_TOLERANCE);
+
+    /// Abandon a calibration.
+    ///
+    void stop(void);
+
+    /// Queue a sample of the field, rotated to the body frame but
+    /// without offsets or soft iron correction. When the queue is full
+    /// the oldest sample is dropped.
+    ///
+    void new_sample(const Vector3f &field);
+
+    /// Take the queued samples and run one step of the fit.
+    ///
+    /// @returns    true when the calibration has just finished
+    ///
+    bool update(void);
+
+    enum cal_status status(void) const { return _status; }
+    bool running(void) const { return _status == CAL_COLLECTING; }
+
+    /// the fit, in the form of the COMPASS_OFS, COMPASS_DIA and
+    /// COMPASS_ODI parameters
+    const Vector3f &get_offsets(void) const { return _offsets; }
+    const Vector3f &get_diagonals(void) const { return _diagonals; }
+    const Vector3f &get_offdiagonals(void) const { return _offdiagonals; }
+
+    /// the field strength the fit corrects to
+    float get_radius(void) const { return _radius; }
+
+    /// RMS error of the corrected samples from the radius
+    float get_fitness(void) const { return _fitness; }
+
+    /// fraction of the buckets with a sample, from 0 to 1
+    float get_coverage(void) const { return _num_samples / (float)COMPASS_CAL_NUM_BUCKETS; }
+
+    uint8_t get_num_samples(void) const { return _num_samples; }
+
+    /// the field corrected by the fit
+    Vector3f correct(const Vector3f &field) const;
+
+private:
+    // the parameters of the fits. The sphere fit uses the first four
+    enum {
+        PARAM_RADIUS = 0,
+        PARAM_OFS_X,
+        PARAM_OFS_Y,
+        PARAM_OFS_Z,
+        SPHERE_PARAMS
+    };
+    enum {
+        PARAM_E_OFS_X = 0,
+        PARAM_E_OFS_Y,
+        PARAM_E_OFS_Z,
+        PARAM_DIAG_X,
+        PARAM_DIAG_Y,
+        PARAM_DIAG_Z,
+        PARAM_OFFDIAG_XY,
+        PARAM_OFFDIAG_XZ,
+        PARAM_OFFDIAG_YZ,
+        ELLIPSOID_PARAMS
+    };
+
+    void        add_sample(const Vector3f &field);
+    uint8_t     bucket(const Vector3f &field) const;
+    void        rebucket(void);
+    void        initial_sphere(void);
+    void        sphere_step(void);
+    void        ellipsoid_step(void);
+    float       rms_error(float radius, const Vector3f &offsets,
+                          const Vector3f &diagonals, const Vector3f &offdiagonals) const;
+    bool        fit_acceptable(void) const;
+
+    enum cal_status _status;
+    float       _tolerance;
+
+    // queue of new samples
+    Vector3f    _fifo[COMPASS_CAL_FIFO_SIZE];
+    uint8_t     _fifo_head;
+    uint8_t     _fifo_count;
+
+    // the kept samples and their buckets
+    Vector3f    _samples[COMPASS_CAL_NUM_BUCKETS];
+    uint8_t     _num_samples;
+    uint8_t     _bucket_used[(COMPASS_CAL_NUM_BUCKETS+7)/8];
+    Vector3f    _bucket_offsets;        // offsets the buckets were chosen with
+
+    // the fit
+    Vector3f    _offsets;
+    Vector3f    _diagonals;
+    Vector3f    _offdiagonals;
+    float       _radius;
+    float       _fitness;
+    float       _sphere_lambda;
+    float       _ellipsoid_lambda;
+    uint8_t     _sphere_steps;
+    uint8_t     _ellipsoid_steps;
+};
+
+#endif // CompassCalibrator_h
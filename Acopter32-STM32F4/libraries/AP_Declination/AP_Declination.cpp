@@ -117,32 +117,92 @@ static const row_value declination_values[] PROGMEM = \
 
 #define PGM_UINT8(p) pgm_read_byte_far(p)
 
-float
-AP_Declination::get_declination(float lat, float lon)
-{
-    int16_t decSW, decSE, decNW, decNE, lonmin, latmin;
-    uint8_t latmin_index,lonmin_index;
-    float decmin, decmax;
+// the corners of a cell, as offsets in grid steps from the south west
+enum { CORNER_SW=0, CORNER_SE, CORNER_NE, CORNER_NW, NUM_CORNERS };
+static const uint8_t corner_lat[NUM_CORNERS] = { 0, 0, 1, 1 };
+static const uint8_t corner_lon[NUM_CORNERS] = { 0, 1, 1, 0 };
+
+// the cell of the last call to get_declination()
+static struct {
+    bool valid;
+    int16_t latmin, lonmin;
+    int16_t dec[NUM_CORNERS];
+} cell;
 
+/*
+  constrain the location and find the south west corner of its cell
+ */
+static void find_cell(float &lat, float &lon, int16_t &latmin, int16_t &lonmin)
+{
     // Constrain to valid inputs
     lat = constrain_float(lat, -90, 90);
     lon = constrain_float(lon, -180, 180);
 
     latmin = floorf(lat/5)*5;
     lonmin = floorf(lon/5)*5;
+}
 
-    latmin_index= (90+latmin)/5;
-    lonmin_index= (180+lonmin)/5;
+/*
+  approximate declination within the grid using bilinear interpolation
+ */
+static float interpolate(float lat, float lon, int16_t latmin, int16_t lonmin,
+                         const int16_t dec[NUM_CORNERS])
+{
+    float decmin = (lon - lonmin) / 5 * (dec[CORNER_SE] - dec[CORNER_SW]) + dec[CORNER_SW];
+    float decmax = (lon - lonmin) / 5 * (dec[CORNER_NE] - dec[CORNER_NW]) + dec[CORNER_NW];
+    return (lat - latmin) / 5 * (decmax - decmin) + decmin;
+}
 
-    decSW = get_lookup_value(latmin_index, lonmin_index);
-    decSE = get_lookup_value(latmin_index, lonmin_index+1);
-    decNE = get_lookup_value(latmin_index+1, lonmin_index+1);
-    decNW = get_lookup_value(latmin_index+1, lonmin_index);
+float
+AP_Declination::get_declination(float lat, float lon)
+{
+    int16_t latmin, lonmin;
+    find_cell(lat, lon, latmin, lonmin);
+
+    if (!cell.valid || latmin != cell.latmin || lonmin != cell.lonmin) {
+        int16_t dec[NUM_CORNERS];
+        for (uint8_t i=0; i<NUM_CORNERS; i++) {
+            int16_t corner_latmin = latmin + corner_lat[i]*5;
+            int16_t corner_lonmin = lonmin + corner_lon[i]*5;
+            // a corner shared with the last cell needs no decoding
+            bool found = false;
+            for (uint8_t j=0; cell.valid && j<NUM_CORNERS; j++) {
+                if (cell.latmin + corner_lat[j]*5 == corner_latmin &&
+                    cell.lonmin + corner_lon[j]*5 == corner_lonmin) {
+                    dec[i] = cell.dec[j];
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                dec[i] = get_lookup_value((90+corner_latmin)/5, (180+corner_lonmin)/5);
+            }
+        }
+        memcpy(cell.dec, dec, sizeof(dec));
+        cell.latmin = latmin;
+        cell.lonmin = lonmin;
+        cell.valid = true;
+    }
 
-    /* approximate declination within the grid using bilinear interpolation */
-    decmin = (lon - lonmin) / 5 * (decSE - decSW) + decSW;
-    decmax = (lon - lonmin) / 5 * (decNE - decNW) + decNW;
-    return (lat - latmin) / 5 * (decmax - decmin) + decmin;
+    return interpolate(lat, lon, latmin, lonmin, cell.dec);
+}
+
+float
+AP_Declination::get_declination_uncached(float lat, float lon)
+{
+    int16_t latmin, lonmin;
+    find_cell(lat, lon, latmin, lonmin);
+
+    uint8_t latmin_index = (90+latmin)/5;
+    uint8_t lonmin_index = (180+lonmin)/5;
+
+    int16_t dec[NUM_CORNERS];
+    dec[CORNER_SW] = get_lookup_value(latmin_index, lonmin_index);
+    dec[CORNER_SE] = get_lookup_value(latmin_index, lonmin_index+1);
+    dec[CORNER_NE] = get_lookup_value(latmin_index+1, lonmin_index+1);
+    dec[CORNER_NW] = get_lookup_value(latmin_index+1, lonmin_index);
+
+    return interpolate(lat, lon, latmin, lonmin, dec);
 }
 
 int16_t
@@ -15,7 +15,14 @@
 class AP_Declination
 {
 public:
+    // declination in degrees at lat, lon. The table values at the
+    // corners of the 5 degree cell of the last call are kept, so
+    // calls within the same cell are only an interpolation, and
+    // moving to a neighbouring cell decodes only the new corners
     static float            get_declination(float lat, float lon);
+
+    // the same, decoding all four corners on every call
+    static float            get_declination_uncached(float lat, float lon);
 private:
     static int16_t          get_lookup_value(uint8_t x, uint8_t y);
 };
@@ -80,6 +80,87 @@ static float get_declination(float lat, float lon)
     return (lat - latmin) / 5 * (decmax - decmin) + decmin;
 }
 
+// grid step of the whole globe comparison, in degrees
+#define SWEEP_STEP 0.25f
+
+/*
+  compare the cached and uncached lookups and the reference table over
+  the whole globe. The sweep moves along rows of latitude, so the cache
+  sees both neighbouring cells and jumps back to the start of a row
+ */
+static void test_sweep(void)
+{
+    uint32_t count = 0, fail = 0;
+    hal.console->printf("Comparing over the globe at %.2f degree steps...\n", SWEEP_STEP);
+    for (float lat = -90; lat <= 90; lat += SWEEP_STEP) {
+        for (float lon = -180; lon <= 180; lon += SWEEP_STEP) {
+            float cached = AP_Declination::get_declination(lat, lon);
+            float uncached = AP_Declination::get_declination_uncached(lat, lon);
+            float reference = get_declination(lat, lon);
+            count++;
+            if (cached != uncached || cached != reference) {
+                if (fail < 10) {
+                    hal.console->printf("FAIL: %f, %f : %f, %f, %f\n",
+                                        lat, lon, cached, uncached, reference);
+                }
+                fail++;
+            }
+        }
+    }
+    hal.console->printf("Sweep: %lu locations, %lu failures\n",
+                        (unsigned long)count, (unsigned long)fail);
+}
+
+/*
+  calls per second along a track crossing the grid diagonally, as a
+  vehicle updating its declination from the GPS would, and at random
+  locations, which defeats the cache
+ */
+static void test_speed(void)
+{
+    const uint16_t n = 20000;
+    float sink = 0;
+    uint32_t t0, track_cached, track_uncached, random_cached, random_uncached;
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<n; i++) {
+        sink += AP_Declination::get_declination(-40 + i*0.004f, 100 + i*0.003f);
+    }
+    track_cached = hal.scheduler->micros() - t0;
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<n; i++) {
+        sink += AP_Declination::get_declination_uncached(-40 + i*0.004f, 100 + i*0.003f);
+    }
+    track_uncached = hal.scheduler->micros() - t0;
+
+    srandom(1);
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<n; i++) {
+        sink += AP_Declination::get_declination((random() % 18000) * 0.01f - 90,
+                                                (random() % 36000) * 0.01f - 180);
+    }
+    random_cached = hal.scheduler->micros() - t0;
+
+    srandom(1);
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<n; i++) {
+        sink += AP_Declination::get_declination_uncached((random() % 18000) * 0.01f - 90,
+                                                         (random() % 36000) * 0.01f - 180);
+    }
+    random_uncached = hal.scheduler->micros() - t0;
+
+    hal.console->printf("Calls per second on a track:   cached %.0f uncached %.0f\n",
+                        n * 1.0e6f / max(track_cached, 1UL),
+                        n * 1.0e6f / max(track_uncached, 1UL));
+    hal.console->printf("Calls per second at random:    cached %.0f uncached %.0f\n",
+                        n * 1.0e6f / max(random_cached, 1UL),
+                        n * 1.0e6f / max(random_uncached, 1UL));
+    if (sink == 1.0e30f) {
+        hal.console->println("");
+    }
+}
+
 void setup(void)
 {
     float declination, declination_test;
@@ -113,6 +194,9 @@ void setup(void)
     hal.console->printf("Total Fail: %i\n", fail);
     hal.console->printf("Average time per call: %.1f usec\n",
                   total_time/(float)(pass+fail));
+
+    test_sweep();
+    test_speed();
 }
 
 void loop(void)
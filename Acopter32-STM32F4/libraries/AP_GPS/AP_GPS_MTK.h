@@ -76,7 +76,7 @@ private:
     // Receive buffer
     union PACKED {
         diyd_mtk_msg msg;
-        uint8_t bytes[];
+        uint8_t bytes[sizeof(diyd_mtk_msg)];
     } _buffer;
 
     // Buffer parse & GPS state update
@@ -87,7 +87,7 @@ private:
     // Receive buffer
     union {
         diyd_mtk_msg msg;
-        uint8_t bytes[];
+        uint8_t bytes[sizeof(diyd_mtk_msg)];
     } _buffer;
 };
 
@@ -104,7 +104,7 @@ private:
     // Message buffer
     union {
         sirf_geonav nav;
-        uint8_t bytes[];
+        uint8_t bytes[sizeof(sirf_geonav)];
     } _buffer;
 
     bool        _parse_gps(void);
@@ -159,7 +159,7 @@ private:
         ubx_nav_solution solution;
         ubx_nav_velned velned;
         ubx_cfg_nav_settings nav_settings;
-        uint8_t bytes[];
+        uint8_t bytes[sizeof(ubx_nav_solution)];    // the largest message
     } _buffer;
 
     enum ubs_protocol_bytes {
@@ -26,8 +26,10 @@
   board. This prevents us having a mess of ifdefs in every example
   sketch
  */
+#ifndef CONFIG_HAL_BOARD
 #define CONFIG_HAL_BOARD HAL_BOARD_REVOMINI
 //#define CONFIG_HAL_BOARD HAL_BOARD_VRBRAIN
+#endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_APM1
 #define AP_HAL_BOARD_DRIVER AP_HAL_AVR_APM1
 #define HAL_BOARD_NAME "APM 1"
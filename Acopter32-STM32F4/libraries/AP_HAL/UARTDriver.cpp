@@ -27,9 +27,20 @@
 
 void AP_HAL::UARTDriver::print_P(const prog_char_t *s) 
 {
+    // copied out of progmem in chunks, for a bulk write of each
+    uint8_t buf[32];
+    uint8_t n = 0;
     char    c;
-    while ('\0' != (c = pgm_read_byte((const prog_char *)s++)))
-        write(c);
+    while ('\0' != (c = pgm_read_byte((const prog_char *)s++))) {
+        buf[n++] = c;
+        if (n == sizeof(buf)) {
+            write(buf, n);
+            n = 0;
+        }
+    }
+    if (n != 0) {
+        write(buf, n);
+    }
 }
 
 void AP_HAL::UARTDriver::println_P(const prog_char_t *s) 
@@ -63,3 +74,45 @@ void AP_HAL::UARTDriver::vprintf_P(const prog_char *fmt, va_list ap)
 {
     print_vprintf((AP_HAL::Print*)this, 1, fmt, ap);
 }
+
+bool AP_HAL::UARTDriver::printf_bounded(const char *fmt, ...) 
+{
+    va_list ap;
+    va_start(ap, fmt);
+    bool ret = vprintf_bounded(0, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+bool AP_HAL::UARTDriver::_printf_bounded_P(const prog_char *fmt, ...) 
+{
+    va_list ap;
+    va_start(ap, fmt);
+    bool ret = vprintf_bounded(1, (const char *)fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+bool AP_HAL::UARTDriver::vprintf_bounded(unsigned char in_progmem, const char *fmt, va_list ap) 
+{
+    // one more than the limit, to tell if the output was cut short
+    char buf[UART_PRINTF_BOUNDED_MAX+1];
+    size_t len = print_vsnprintf(buf, sizeof(buf), in_progmem, fmt, ap);
+    bool truncated = false;
+    if (len > UART_PRINTF_BOUNDED_MAX) {
+        len = UART_PRINTF_BOUNDED_MAX;
+        truncated = true;
+    }
+    int16_t space = txspace();
+    if (space < 0) {
+        space = 0;
+    }
+    if (len > (size_t)space) {
+        len = space;
+        truncated = true;
+    }
+    if (len != 0) {
+        write((const uint8_t *)buf, len);
+    }
+    return !truncated;
+}
@@ -7,6 +7,11 @@
 #include "AP_HAL_Namespace.h"
 #include "utility/BetterStream.h"
 
+// the longest output of the bounded time printf calls
+#ifndef UART_PRINTF_BOUNDED_MAX
+ # define UART_PRINTF_BOUNDED_MAX 128
+#endif
+
 /* Pure virtual UARTDriver class */
 class AP_HAL::UARTDriver : public AP_HAL::BetterStream {
 public:
@@ -52,6 +57,19 @@ public:
 
     void vprintf(const char *s, va_list ap);
     void vprintf_P(const prog_char *s, va_list ap);
+
+    /* Bounded time printf, for debug output from code with a time
+     * budget. The output is formatted on the stack, up to
+     * UART_PRINTF_BOUNDED_MAX characters, and only as much of it as
+     * txspace() has room for is written, so these never wait for the
+     * port. They return false if the output was truncated
+     */
+    bool printf_bounded(const char *s, ...)
+            __attribute__ ((format(__printf__, 2, 3)));
+    bool _printf_bounded_P(const prog_char *s, ...)
+            __attribute__ ((format(__printf__, 2, 3)));
+#define printf_bounded_P(fmt, ...) _printf_bounded_P((const prog_char *)fmt, ## __VA_ARGS__)
+    bool vprintf_bounded(unsigned char in_progmem, const char *s, va_list ap);
 };
 
 #endif // __AP_HAL_UART_DRIVER_H__
@@ -0,0 +1,201 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Microbenchmark of the printf path of the UART drivers.
+//
+// A typical debug line is formatted BENCH_REPEAT times into a buffer,
+// to a stream which takes the output as the formatter hands it over,
+// and to a stream which takes it one character per write() call, as
+// the drivers did before. The number of write() calls per line is
+// what matters on SITL, where each one is a system call.
+//
+// It then checks that the bounded time printf truncates a line which
+// is too long, or which does not fit in the transmit buffer, and that
+// it does not take longer when the port is full.
+//
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_Math.h>
+#include <utility/print_vprintf.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define BENCH_REPEAT 500
+
+/*
+  a stream which throws its output away, counting the write() calls.
+  With per_char set each character is passed on as its own call
+ */
+class NullStream : public AP_HAL::Print {
+public:
+    NullStream(bool per_char) : calls(0), bytes(0), _per_char(per_char) {}
+    size_t write(uint8_t c) {
+        calls++;
+        bytes++;
+        return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) {
+        if (_per_char) {
+            for (size_t i=0; i<size; i++) {
+                write(buffer[i]);
+            }
+            return size;
+        }
+        calls++;
+        bytes += size;
+        return size;
+    }
+    uint32_t calls;
+    uint32_t bytes;
+private:
+    bool _per_char;
+};
+
+/*
+  a port with a fixed amount of transmit space, recording what the
+  bounded time printf writes to it
+ */
+class FullPort : public AP_HAL::UARTDriver {
+public:
+    FullPort() : space(0), written(0) {}
+    void begin(uint32_t baud) {}
+    void begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace) {}
+    void end() {}
+    void flush() {}
+    bool is_initialized() { return true; }
+    void set_blocking_writes(bool blocking) {}
+    bool tx_pending() { return false; }
+    int16_t available() { return 0; }
+    int16_t txspace() { return space; }
+    int16_t read() { return -1; }
+    size_t write(uint8_t c) { written++; return 1; }
+    size_t write(const uint8_t *buffer, size_t size) { written += size; return size; }
+    int16_t space;
+    uint32_t written;
+};
+
+static void format_to(AP_HAL::Print *s, const prog_char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    print_vprintf(s, 1, (const char *)fmt, ap);
+    va_end(ap);
+}
+
+static size_t format_into(char *buf, size_t size, const prog_char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    size_t ret = print_vsnprintf(buf, size, 1, (const char *)fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+#define DEBUG_LINE PSTR("PERF: %u/%u %lu latency %u/%u roll %.2f pitch %.2f yaw %.1f\n")
+#define DEBUG_ARGS 12, 4000, 11234UL, 1850, 3920, 1.25, -0.5, 271.3
+
+static void report(const char *name, uint32_t usec, uint32_t calls, uint32_t bytes)
+{
+    hal.console->printf_P(PSTR("%-22s %8.2fus/line %6.1f writes/line %5.1f bytes/write\n"),
+                          name,
+                          usec / (float)BENCH_REPEAT,
+                          calls / (float)BENCH_REPEAT,
+                          calls ? bytes / (float)calls : 0.0f);
+}
+
+static void bench_format(void)
+{
+    char buf[128];
+    uint32_t start = hal.scheduler->micros();
+    size_t len = 0;
+    for (uint16_t i=0; i<BENCH_REPEAT; i++) {
+        len = format_into(buf, sizeof(buf), DEBUG_LINE, DEBUG_ARGS);
+    }
+    report("format into buffer", hal.scheduler->micros() - start, 0, 0);
+    hal.console->printf_P(PSTR("  %u chars: %s"), (unsigned)len, buf);
+
+    NullStream bulk(false);
+    start = hal.scheduler->micros();
+    for (uint16_t i=0; i<BENCH_REPEAT; i++) {
+        format_to(&bulk, DEBUG_LINE, DEBUG_ARGS);
+    }
+    report("stream, bulk writes", hal.scheduler->micros() - start, bulk.calls, bulk.bytes);
+
+    NullStream per_char(true);
+    start = hal.scheduler->micros();
+    for (uint16_t i=0; i<BENCH_REPEAT; i++) {
+        format_to(&per_char, DEBUG_LINE, DEBUG_ARGS);
+    }
+    report("stream, per character", hal.scheduler->micros() - start, per_char.calls, per_char.bytes);
+}
+
+static void test_bounded(void)
+{
+    FullPort port;
+    uint8_t failures = 0;
+
+    // room for all of it
+    port.space = 1000;
+    if (!port.printf_bounded_P(PSTR("short line %d\n"), 42) || port.written != 15) {
+        hal.console->printf_P(PSTR("Failed bounded: short line wrote %lu\n"),
+                              (unsigned long)port.written);
+        failures++;
+    }
+
+    // a line longer than the limit
+    port.written = 0;
+    char long_line[UART_PRINTF_BOUNDED_MAX + 20];
+    memset(long_line, 'x', sizeof(long_line) - 1);
+    long_line[sizeof(long_line) - 1] = 0;
+    if (port.printf_bounded("%s", long_line) || port.written != UART_PRINTF_BOUNDED_MAX) {
+        hal.console->printf_P(PSTR("Failed bounded: long line wrote %lu\n"),
+                              (unsigned long)port.written);
+        failures++;
+    }
+
+    // a port with only a little space
+    port.written = 0;
+    port.space = 5;
+    if (port.printf_bounded_P(PSTR("short line %d\n"), 42) || port.written != 5) {
+        hal.console->printf_P(PSTR("Failed bounded: partial line wrote %lu\n"),
+                              (unsigned long)port.written);
+        failures++;
+    }
+
+    // a full port gets nothing, in about the time it takes to format
+    port.written = 0;
+    port.space = 0;
+    uint32_t start = hal.scheduler->micros();
+    for (uint16_t i=0; i<BENCH_REPEAT; i++) {
+        port.printf_bounded_P(DEBUG_LINE, DEBUG_ARGS);
+    }
+    uint32_t usec = hal.scheduler->micros() - start;
+    if (port.written != 0) {
+        hal.console->printf_P(PSTR("Failed bounded: full port wrote %lu\n"),
+                              (unsigned long)port.written);
+        failures++;
+    }
+    report("bounded, port full", usec, 0, 0);
+
+    hal.console->printf_P(PSTR("%u bounded printf failures\n"), (unsigned)failures);
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("Printf benchmark"));
+}
+
+void loop(void)
+{
+    bench_format();
+    test_bounded();
+    hal.console->println();
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
@@ -70,7 +70,39 @@
 #define FL_FLTEXP	FL_PREC
 #define	FL_FLTFIX	FL_LONG
 
-void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt, va_list ap)
+/*
+  where the formatted characters go. They are gathered in buf and
+  handed to the stream with one bulk write each time it fills and at
+  the end, so the stream sees a few write() calls rather than one
+  virtual call per character. Without a stream the output stops when
+  buf is full
+ */
+struct print_sink {
+        AP_HAL::Print *stream;
+        unsigned char *buf;
+        size_t size;
+        size_t len;
+};
+
+static void sink_flush(struct print_sink *s)
+{
+        if (s->stream != NULL && s->len != 0) {
+                s->stream->write(s->buf, s->len);
+                s->len = 0;
+        }
+}
+
+static inline void sink_put(struct print_sink *s, unsigned char c)
+{
+        if (s->len == s->size) {
+                if (s->stream == NULL)
+                        return;
+                sink_flush(s);
+        }
+        s->buf[s->len++] = c;
+}
+
+static void vprintf_engine (struct print_sink *s, unsigned char in_progmem, const char *fmt, va_list ap)
 {
         unsigned char c;        /* holds a char from the format string */
         unsigned char flags;
@@ -92,8 +124,8 @@ void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt,
                         }
                         /* emit cr before lf to make most terminals happy */
                         if (c == '\n')
-                                s->write('\r');
-                        s->write(c);
+                                sink_put(s, '\r');
+                        sink_put(s, c);
                 }
 
                 flags = 0;
@@ -211,21 +243,21 @@ void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt,
                                         width -= ndigs;
                                         if (!(flags & FL_LPAD)) {
                                                 do {
-                                                        s->write(' ');
+                                                        sink_put(s, ' ');
                                                 } while (--width);
                                         }
                                 } else {
                                         width = 0;
                                 }
                                 if (sign)
-                                        s->write(sign);
+                                        sink_put(s, sign);
                                 const prog_char_t *p = PSTR("inf");
                                 if (vtype & FTOA_NAN)
                                         p = PSTR("nan");
                                 while ( (ndigs = pgm_read_byte((const prog_char *)p)) != 0) {
                                         if (flags & FL_FLTUPP)
                                                 ndigs += 'I' - 'i';
-                                        s->write(ndigs);
+                                        sink_put(s, ndigs);
                                         p++;
                                 }
                                 goto tail;
@@ -264,14 +296,14 @@ void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt,
                         /* Output before first digit    */
                         if (!(flags & (FL_LPAD | FL_ZFILL))) {
                                 while (width) {
-                                        s->write(' ');
+                                        sink_put(s, ' ');
                                         width--;
                                 }
                         }
-                        if (sign) s->write(sign);
+                        if (sign) sink_put(s, sign);
                         if (!(flags & FL_LPAD)) {
                                 while (width) {
-                                        s->write('0');
+                                        sink_put(s, '0');
                                         width--;
                                 }
                         }
@@ -281,12 +313,12 @@ void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt,
                                 n = exp > 0 ? exp : 0;          /* exponent of left digit */
                                 do {
                                         if (n == -1)
-                                                s->write('.');
+                                                sink_put(s, '.');
                                         flags = (n <= exp && n > exp - ndigs)
                                                 ? buf[exp - n + 1] : '0';
                                         if (--n < -prec || flags == 0)
                                                 break;
-                                        s->write(flags);
+                                        sink_put(s, flags);
                                 } while (1);
                                 if (n == exp
                                     && (buf[1] > '5'
@@ -294,34 +326,34 @@ void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt,
                                         {
                                                 flags = '1';
                                         }
-                                if (flags) s->write(flags);
+                                if (flags) sink_put(s, flags);
         
                         } else {                                /* 'e(E)' format        */
 
                                 /* mantissa     */
                                 if (buf[1] != '1')
                                         vtype &= ~FTOA_CARRY;
-                                s->write(buf[1]);
+                                sink_put(s, buf[1]);
                                 if (prec) {
-                                        s->write('.');
+                                        sink_put(s, '.');
                                         sign = 2;
                                         do {
-                                                s->write(buf[sign++]);
+                                                sink_put(s, buf[sign++]);
                                         } while (--prec);
                                 }
 
                                 /* exponent     */
-                                s->write(flags & FL_FLTUPP ? 'E' : 'e');
+                                sink_put(s, flags & FL_FLTUPP ? 'E' : 'e');
                                 ndigs = '+';
                                 if (exp < 0 || (exp == 0 && (vtype & FTOA_CARRY) != 0)) {
                                         exp = -exp;
                                         ndigs = '-';
                                 }
-                                s->write(ndigs);
+                                sink_put(s, ndigs);
                                 for (ndigs = '0'; exp >= 10; exp -= 10)
                                         ndigs += 1;
-                                s->write(ndigs);
-                                s->write('0' + exp);
+                                sink_put(s, ndigs);
+                                sink_put(s, '0' + exp);
                         }
 
                         goto tail;
@@ -358,12 +390,12 @@ void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt,
                         str_lpad:
                                 if (!(flags & FL_LPAD)) {
                                         while (size < width) {
-                                                s->write(' ');
+                                                sink_put(s, ' ');
                                                 width--;
                                         }
                                 }
                                 while (size) {
-                                        s->write(GETBYTE (flags, FL_PGMSTRING, pnt));
+                                        sink_put(s, GETBYTE (flags, FL_PGMSTRING, pnt));
                                         if (width) width -= 1;
                                         size -= 1;
                                 }
@@ -459,7 +491,7 @@ void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt,
                                         }
                                 }
                                 while (len < width) {
-                                        s->write(' ');
+                                        sink_put(s, ' ');
                                         len++;
                                 }
                         }
@@ -467,32 +499,54 @@ void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt,
                         width =  (len < width) ? width - len : 0;
 
                         if (flags & FL_ALT) {
-                                s->write('0');
+                                sink_put(s, '0');
                                 if (flags & FL_ALTHEX)
-                                        s->write(flags & FL_ALTUPP ? 'X' : 'x');
+                                        sink_put(s, flags & FL_ALTUPP ? 'X' : 'x');
                         } else if (flags & (FL_NEGATIVE | FL_PLUS | FL_SPACE)) {
                                 unsigned char z = ' ';
                                 if (flags & FL_PLUS) z = '+';
                                 if (flags & FL_NEGATIVE) z = '-';
-                                s->write(z);
+                                sink_put(s, z);
                         }
                 
                         while (prec > c) {
-                                s->write('0');
+                                sink_put(s, '0');
                                 prec--;
                         }
         
                         do {
-                                s->write(buf[--c]);
+                                sink_put(s, buf[--c]);
                         } while (c);
                 }
         
         tail:
                 /* Tail is possible.    */
                 while (width) {
-                        s->write(' ');
+                        sink_put(s, ' ');
                         width--;
                 }
         } /* for (;;) */
 }
 
+void print_vprintf_buffered (AP_HAL::Print *s, unsigned char *scratch, size_t size,
+                             unsigned char in_progmem, const char *fmt, va_list ap)
+{
+        struct print_sink sink = { s, scratch, size, 0 };
+        vprintf_engine(&sink, in_progmem, fmt, ap);
+        sink_flush(&sink);
+}
+
+void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt, va_list ap)
+{
+        unsigned char scratch[PRINT_VPRINTF_SCRATCH];
+        print_vprintf_buffered(s, scratch, sizeof(scratch), in_progmem, fmt, ap);
+}
+
+size_t print_vsnprintf (char *str, size_t size, unsigned char in_progmem, const char *fmt, va_list ap)
+{
+        struct print_sink sink = { NULL, (unsigned char *)str, size, 0 };
+        vprintf_engine(&sink, in_progmem, fmt, ap);
+        if (sink.len < size)
+                str[sink.len] = 0;
+        return sink.len;
+}
@@ -5,7 +5,23 @@
 #include <AP_HAL.h>
 #include <stdarg.h>
 
+// size of the stack buffer print_vprintf() gathers its output in
+#ifndef PRINT_VPRINTF_SCRATCH
+ # define PRINT_VPRINTF_SCRATCH 64
+#endif
+
+// format to s, with one bulk write to s for each PRINT_VPRINTF_SCRATCH
+// characters
 void print_vprintf (AP_HAL::Print *s, unsigned char in_progmem, const char *fmt, va_list ap);
 
+// format to s, gathering the output in the caller's scratch buffer of
+// size bytes, which is written to s each time it fills and at the end
+void print_vprintf_buffered (AP_HAL::Print *s, unsigned char *scratch, size_t size,
+                             unsigned char in_progmem, const char *fmt, va_list ap);
+
+// format into str, storing at most size characters and a nul after
+// them if there is room. Returns the number of characters stored
+size_t print_vsnprintf (char *str, size_t size, unsigned char in_progmem, const char *fmt, va_list ap);
+
 
 #endif //__AP_HAL_UTILITY_VPRINTF_H__
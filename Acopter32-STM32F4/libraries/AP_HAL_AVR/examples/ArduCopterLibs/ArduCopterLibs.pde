@@ -18,6 +18,7 @@
 #include <AP_InertialSensor.h>  // ArduPilot Mega Inertial Sensor (accel & gyro) Library
                                 // (only included for makefile libpath to work)
 #include <AP_AHRS.h>
+#include <AP_PIDCore.h>         // PID state shared by the PID libraries
 #include <APM_PI.h>             // PI library
 #include <AC_PID.h>             // PID library
 #include <RC_Channel.h>         // RC Channel Library
@@ -7,5 +7,8 @@
 #include "HAL_AVR_SITL_Class.h"
 #include "AP_HAL_AVR_SITL_Main.h"
 
+// tools which stop the clock, such as log replay, need the scheduler
+#include "Scheduler.h"
+
 #endif // __AP_HAL_AVR_SITL_H__
 
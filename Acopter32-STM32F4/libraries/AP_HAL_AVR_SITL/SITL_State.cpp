@@ -18,6 +18,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <sys/select.h>
+#include <sys/time.h>
 
 #include <AP_Param.h>
 
@@ -64,6 +65,12 @@ uint16_t SITL_State::current_pin_value;
 
 AP_Baro_HIL *SITL_State::_barometer;
 AP_InertialSensor_HIL *SITL_State::_ins;
+SITL_IMU SITL_State::_imu;
+SITL_Random SITL_State::_mag_random;
+SITL_Random SITL_State::_gps_random;
+uint32_t SITL_State::_seed;
+uint32_t SITL_State::_seed_override;
+bool SITL_State::_repeatable;
 SITLScheduler *SITL_State::_scheduler;
 AP_Compass_HIL *SITL_State::_compass;
 
@@ -89,6 +96,7 @@ void SITL_State::_usage(void)
 	fprintf(stdout, "\t-H HEIGHT   initial barometric height\n");
 	fprintf(stdout, "\t-C          use console instead of TCP ports\n");
 	fprintf(stdout, "\t-I          set instance of SITL (adds 10*instance to all port numbers)\n");
+	fprintf(stdout, "\t-S SEED     repeatable run, with the sensor noise from SEED (1 to 16777215)\n");
 }
 
 void SITL_State::_parse_command_line(int argc, char * const argv[])
@@ -100,7 +108,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     setvbuf(stdout, (char *)0, _IONBF, 0);
     setvbuf(stderr, (char *)0, _IONBF, 0);
 
-	while ((opt = getopt(argc, argv, "swhr:H:CI:")) != -1) {
+	while ((opt = getopt(argc, argv, "swhr:H:CI:S:")) != -1) {
 		switch (opt) {
 		case 'w':
 			AP_Param::erase_all();
@@ -122,6 +130,13 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
             _simin_port += instance * 10;
         }
 			break;
+		case 'S':
+			_seed_override = strtoul(optarg, NULL, 0);
+			if (_seed_override > SITL_SEED_MAX) {
+				fprintf(stdout, "SEED must be at most %lu\n", (unsigned long)SITL_SEED_MAX);
+				exit(1);
+			}
+			break;
 		default:
 			_usage();
 			exit(1);
@@ -177,6 +192,7 @@ void SITL_State::_sitl_setup(void)
 
     if (_sitl != NULL) {
         // setup some initial values
+        _update_seed();
         _update_barometer(_initial_height);
         _update_ins(0, 0, 0, 0, 0, 0, 0, 0, -9.8, 0);
         _update_compass(0, 0, 0);
@@ -287,6 +303,7 @@ void SITL_State::_timer_handler(int signum)
 	last_update_count = _update_count;
 
     if (_sitl != NULL) {
+        _update_seed();
         _update_gps(_sitl->state.latitude, _sitl->state.longitude,
                     _sitl->state.altitude,
                     _sitl->state.speedN, _sitl->state.speedE, _sitl->state.speedD,
@@ -528,22 +545,53 @@ void SITL_State::_setup_timer(void)
 	setitimer(ITIMER_REAL, &it, NULL);
 }
 
-// generate a random float between -1 and 1
-float SITL_State::_rand_float(void)
+/*
+  the time the sensors are simulated at. For a repeatable run this is
+  the simulated time, counted in simulator frames, otherwise it is the
+  time since the start
+ */
+uint64_t SITL_State::_sim_time_usec(void)
 {
-    return ((((unsigned)random()) % 2000000) - 1.0e6) / 1.0e6;
+    if (_repeatable) {
+        return (uint64_t)_update_count * 1000000ULL / _framerate;
+    }
+    return _scheduler->_micros();
 }
 
-// generate a random Vector3f of size 1
-Vector3f SITL_State::_rand_vec3f(void)
+/*
+  follow changes to SIM_SEED and SIM_REPEATABLE. A seed of zero is
+  replaced by one from the clock, which is set in SIM_SEED so that it
+  is in the parameters written at the start of each log. It is kept
+  to SITL_SEED_MAX so the logged value is exact
+ */
+void SITL_State::_update_seed(void)
 {
-	Vector3f v = Vector3f(_rand_float(),
-                          _rand_float(),
-                          _rand_float());
-	if (v.length() != 0.0) {
-		v.normalize();
-	}
-	return v;
+    if (_seed_override != 0) {
+        _sitl->seed.set(_seed_override);
+        _sitl->repeatable.set(1);
+    }
+    if (_sitl->seed < 0 || _sitl->seed > (int32_t)SITL_SEED_MAX) {
+        fprintf(stdout, "SIM_SEED must be at most %lu\n", (unsigned long)SITL_SEED_MAX);
+        _sitl->seed.set(0);
+    }
+    if (_sitl->seed == 0) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        uint32_t seed = tv.tv_sec ^ tv.tv_usec ^ ((uint32_t)getpid() << 16);
+        seed %= SITL_SEED_MAX;
+        _sitl->seed.set(seed ? seed : 1);
+    }
+    bool repeatable = _sitl->repeatable != 0;
+    if ((uint32_t)_sitl->seed == _seed && repeatable == _repeatable) {
+        return;
+    }
+    _seed = _sitl->seed;
+    _repeatable = repeatable;
+    _imu.set_seed(_seed, RANDOM_IMU, _repeatable);
+    _mag_random.set_seed(_seed, RANDOM_MAG);
+    _gps_random.set_seed(_seed, RANDOM_GPS);
+    fprintf(stdout, "SITL seed %lu%s\n", (unsigned long)_seed,
+            _repeatable ? " (repeatable)" : "");
 }
 
 
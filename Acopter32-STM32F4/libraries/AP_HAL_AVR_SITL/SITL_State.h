@@ -20,6 +20,8 @@
 #include "../AP_InertialSensor/AP_InertialSensor.h"
 #include "../AP_Compass/AP_Compass.h"
 #include "../SITL/SITL.h"
+#include "../SITL/SITL_IMU.h"
+#include "../SITL/SITL_Random.h"
 
 class HAL_AVR_SITL;
 
@@ -73,6 +75,7 @@ private:
     #define MAX_GPS_DELAY 100
     static gps_data _gps_data[MAX_GPS_DELAY];
 
+    static void _gps_time(struct timeval *tv);
     static void _gps_write(const uint8_t *p, uint16_t size);
     static void _gps_send_ubx(uint8_t msgid, uint8_t *buf, uint16_t size);
     static void _update_gps_ubx(const struct gps_data *d);
@@ -90,13 +93,26 @@ private:
 			    double rollRate, 	double pitchRate,double yawRate,	// Local to plane
 			    double xAccel, 	double yAccel, 	double zAccel,		// Local to plane
 			    float airspeed);
+    static void _ins_sample(const Vector3f &gyro, const Vector3f &accel, float dt);
     static void _fdm_input(void);
     static void _simulator_output(void);
     static void _apply_servo_filter(float deltat);
     static uint16_t _airspeed_sensor(float airspeed);
     static float _gyro_drift(void);
-    static float _rand_float(void);
-    static Vector3f _rand_vec3f(void);
+    static uint64_t _sim_time_usec(void);
+    static void _update_seed(void);
+
+    // the random number stream of each simulated sensor
+    enum random_stream {
+        RANDOM_IMU = 1,
+        RANDOM_MAG = 2,
+        RANDOM_GPS = 3
+    };
+    static SITL_Random _mag_random;
+    static SITL_Random _gps_random;
+    static uint32_t _seed;
+    static uint32_t _seed_override;
+    static bool _repeatable;
 
     // signal handlers
     static void _sig_fpe(int signum);
@@ -114,6 +130,7 @@ private:
 
     static AP_Baro_HIL *_barometer;
     static AP_InertialSensor_HIL *_ins;
+    static SITL_IMU _imu;
     static SITLScheduler *_scheduler;
     static AP_Compass_HIL *_compass;
 
@@ -37,6 +37,7 @@ uint8_t SITLScheduler::_num_io_procs = 0;
 bool SITLScheduler::_in_io_proc = false;
 
 struct timeval SITLScheduler::_sketch_start_time;
+uint64_t SITLScheduler::_stopped_clock_usec = 0;
 
 #ifdef __CYGWIN__
 double SITLScheduler::_cyg_freq = 0;
@@ -72,6 +73,9 @@ double SITLScheduler::_cyg_sec()
 
 uint32_t SITLScheduler::_micros() 
 {
+    if (_stopped_clock_usec) {
+        return _stopped_clock_usec;
+    }
 #ifdef __CYGWIN__
 	return (uint32_t)(_cyg_sec() * 1.0e6);
 #else   
@@ -90,6 +94,9 @@ uint32_t SITLScheduler::micros()
 
 uint32_t SITLScheduler::millis() 
 {
+    if (_stopped_clock_usec) {
+        return _stopped_clock_usec / 1000;
+    }
 #ifdef __CYGWIN__
 	// 1000 ms in a second
 	return (uint32_t)(_cyg_sec() * 1000);
@@ -104,6 +111,10 @@ uint32_t SITLScheduler::millis()
 
 void SITLScheduler::delay_microseconds(uint16_t usec) 
 {
+    if (_stopped_clock_usec) {
+        _stopped_clock_usec += usec;
+        return;
+    }
 	uint32_t start = micros();
 	while (micros() - start < usec) {
 		usleep(usec - (micros() - start));
@@ -112,6 +123,10 @@ void SITLScheduler::delay_microseconds(uint16_t usec)
 
 void SITLScheduler::delay(uint16_t ms)
 {
+    if (_stopped_clock_usec) {
+        _stopped_clock_usec += ms * 1000UL;
+        return;
+    }
 	uint32_t start = micros();
     
     while (ms > 0) {
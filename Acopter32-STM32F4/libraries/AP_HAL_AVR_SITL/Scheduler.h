@@ -44,6 +44,12 @@ public:
 
     // callable from interrupt handler
     static uint32_t _micros();
+
+    // stop the clock at the given time. From then on time only
+    // advances through further calls and through delay(), which
+    // makes log replay independent of the host speed
+    static void stop_clock(uint64_t time_usec) { _stopped_clock_usec = time_usec; }
+
     static void timer_event() { _run_timer_procs(true); _run_io_procs(true); }
 
 private:
@@ -51,6 +57,7 @@ private:
     AP_HAL::Proc _delay_cb;
     uint16_t _min_delay_cb_ms;
     static struct timeval _sketch_start_time;
+    static uint64_t _stopped_clock_usec;
     static AP_HAL::Proc _failsafe;
 
     static void _run_timer_procs(bool called_from_isr);
@@ -80,4 +80,12 @@ void SITLEEPROMStorage::write_block(uint16_t dst, const void *src, size_t n)
 	assert(pwrite(_eeprom_fd, src, n, dst) == (ssize_t)n);
 }
 
+void SITLEEPROMStorage::format_eeprom(void)
+{
+	// clear the whole file
+	_eeprom_open();
+	assert(ftruncate(_eeprom_fd, 0) == 0);
+	assert(ftruncate(_eeprom_fd, 4096) == 0);
+}
+
 #endif
@@ -22,6 +22,8 @@ public:
     void write_dword(uint16_t loc, uint32_t value);
     void write_block(uint16_t dst, const void* src, size_t n);
 
+    void format_eeprom(void);
+
 private:
     int _eeprom_fd;
     void _eeprom_open(void);
@@ -176,11 +176,22 @@ size_t SITLUARTDriver::write(uint8_t c)
 
 size_t SITLUARTDriver::write(const uint8_t *buffer, size_t size)
 {
-    size_t n = 0;
-    while (size--) {
-        n += write(*buffer++);
+    // one system call for the whole buffer
+    int flags = MSG_NOSIGNAL;
+    _check_connection();
+    if (!_connected) {
+        return 0;
+    }
+    if (_nonblocking_writes) {
+        flags |= MSG_DONTWAIT;
+    }
+    ssize_t ret;
+    if (_console) {
+        ret = ::write(_fd, buffer, size);
+    } else {
+        ret = send(_fd, buffer, size, flags);
     }
-    return n;
+    return ret > 0 ? ret : 0;
 }
 
 /*
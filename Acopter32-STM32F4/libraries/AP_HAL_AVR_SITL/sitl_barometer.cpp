@@ -37,10 +37,11 @@ void SITL_State::_update_barometer(float altitude)
 	}
 
 	// 80Hz, to match the real APM2 barometer
-	if (hal.scheduler->millis() - last_update < 12) {
+	uint32_t now = _sim_time_usec() / 1000;
+	if (now - last_update < 12) {
 		return;
 	}
-	last_update = hal.scheduler->millis();
+	last_update = now;
 
 	_barometer->setHIL(altitude);
 }
@@ -39,7 +39,10 @@ void SITL_State::_update_compass(float rollDeg, float pitchDeg, float yawDeg)
 		yawDeg += 360.0f;
 	}
 	_compass->setHIL(radians(rollDeg), radians(pitchDeg), radians(yawDeg));
-	Vector3f noise = _rand_vec3f() * _sitl->mag_noise;
+	if (_repeatable) {
+		_mag_random.set_time(_seed, RANDOM_MAG, _sim_time_usec());
+	}
+	Vector3f noise = _mag_random.rand_vec3f() * _sitl->mag_noise;
 	_compass->mag_x += noise.x;
 	_compass->mag_y += noise.y;
 	_compass->mag_z += noise.z;
@@ -72,7 +72,7 @@ int SITL_State::gps_pipe(void)
 	pipe(fd);
 	gps_state.gps_fd    = fd[1];
 	gps_state.client_fd = fd[0];
-	gps_state.last_update = _scheduler->millis();
+	gps_state.last_update = _sim_time_usec() / 1000;
 	AVR_SITL::SITLUARTDriver::_set_nonblocking(gps_state.gps_fd);
 	AVR_SITL::SITLUARTDriver::_set_nonblocking(fd[0]);
 	return gps_state.client_fd;
@@ -85,7 +85,7 @@ void SITL_State::_gps_write(const uint8_t *p, uint16_t size)
 {
 	while (size--) {
 		if (_sitl->gps_byteloss > 0.0) {
-			float r = ((((unsigned)random()) % 1000000)) / 1.0e4;
+			float r = (_gps_random.next() % 1000000) / 1.0e4;
 			if (r < _sitl->gps_byteloss) {
 				// lose the byte
 				p++;
@@ -123,14 +123,29 @@ void SITL_State::_gps_send_ubx(uint8_t msgid, uint8_t *buf, uint16_t size)
 	_gps_write(chk, sizeof(chk));
 }
 
+/*
+  the UTC time the simulated GPS gives. For a repeatable run this
+  counts the simulated time from a fixed start, otherwise it is the
+  time of the host
+ */
+void SITL_State::_gps_time(struct timeval *tv)
+{
+	if (_repeatable) {
+		// 2014-01-01 00:00:00 UTC
+		uint64_t usec = 1388534400ULL * 1000000ULL + _sim_time_usec();
+		tv->tv_sec  = usec / 1000000;
+		tv->tv_usec = usec % 1000000;
+		return;
+	}
+	gettimeofday(tv, NULL);
+}
+
 /*
   return GPS time of week in milliseconds
  */
-static uint32_t millis_time_of_week(void)
+static uint32_t millis_time_of_week(const struct timeval &tv)
 {
 	struct tm tm;
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
 	tm = *gmtime(&tv.tv_sec);
 	uint32_t tsec;
 	tsec = 
@@ -199,7 +214,10 @@ void SITL_State::_update_gps_ubx(const struct gps_data *d)
 	const uint8_t MSG_VELNED = 0x12;
         const uint8_t MSG_SOL = 0x6;
 
-	pos.time = hal.scheduler->millis(); // FIX
+	struct timeval tv;
+	_gps_time(&tv);
+
+	pos.time = _sim_time_usec() / 1000; // FIX
 	pos.longitude = d->longitude * 1.0e7;
 	pos.latitude  = d->latitude * 1.0e7;
 	pos.altitude_ellipsoid = d->altitude*1000.0;
@@ -207,13 +225,13 @@ void SITL_State::_update_gps_ubx(const struct gps_data *d)
 	pos.horizontal_accuracy = 5;
 	pos.vertical_accuracy = 10;
 
-	status.time = millis_time_of_week();
+	status.time = millis_time_of_week(tv);
 	status.fix_type = d->have_lock?3:0;
 	status.fix_status = d->have_lock?1:0;
 	status.differential_status = 0;
 	status.res = 0;
 	status.time_to_first_fix = 0;
-	status.uptime = hal.scheduler->millis();
+	status.uptime = _sim_time_usec() / 1000;
 
 	velned.time = status.time;
 	velned.ned_north = 100.0 * d->speedN;
@@ -302,7 +320,7 @@ void SITL_State::_update_gps_mtk(const struct gps_data *d)
 	// of 100.  Quite bizarre.
 	struct tm tm;
 	struct timeval tv;
-	gettimeofday(&tv, NULL);
+	_gps_time(&tv);
 	tm = *gmtime(&tv.tv_sec);
 
     p.utc_time = tm.tm_sec + tm.tm_min*100 + tm.tm_hour*100*100;
@@ -357,7 +375,7 @@ void SITL_State::_update_gps_mtk16(const struct gps_data *d)
 	// The data is powers of 100 as well, but in days since 1/1/2000
 	struct tm tm;
 	struct timeval tv;
-	gettimeofday(&tv, NULL);
+	_gps_time(&tv);
 	tm = *gmtime(&tv.tv_sec);
 
     p.utc_date = (tm.tm_year-2000) + tm.tm_mon*100 + tm.tm_mday*100*100;
@@ -413,7 +431,7 @@ void SITL_State::_update_gps_mtk19(const struct gps_data *d)
 	// The data is powers of 100 as well, but in days since 1/1/2000
 	struct tm tm;
 	struct timeval tv;
-	gettimeofday(&tv, NULL);
+	_gps_time(&tv);
 	tm = *gmtime(&tv.tv_sec);
 
     p.utc_date = (tm.tm_year-2000) + tm.tm_mon*100 + tm.tm_mday*100*100;
@@ -473,7 +491,7 @@ void SITL_State::_update_gps_nmea(const struct gps_data *d)
     char lat_string[20];
     char lng_string[20];
 
-    gettimeofday(&tv, NULL);
+    _gps_time(&tv);
 
     tm = gmtime(&tv.tv_sec);
 
@@ -531,7 +549,8 @@ void SITL_State::_update_gps(double latitude, double longitude, float altitude,
     Vector3f glitch_offsets = _sitl->gps_glitch;
 
 	// 5Hz, to match the real config in APM
-	if (hal.scheduler->millis() - gps_state.last_update < 1000/_sitl->gps_hertz) {
+	uint32_t now = _sim_time_usec() / 1000;
+	if (now - gps_state.last_update < 1000/_sitl->gps_hertz) {
 		return;
 	}
 
@@ -540,7 +559,11 @@ void SITL_State::_update_gps(double latitude, double longitude, float altitude,
 		read(gps_state.gps_fd, &c, 1);
 	}
 
-	gps_state.last_update = hal.scheduler->millis();
+	gps_state.last_update = now;
+	if (_repeatable) {
+		// the bytes lost depend only on the time of the update
+		_gps_random.set_time(_seed, RANDOM_GPS, _sim_time_usec());
+	}
 
 	d.latitude = latitude + glitch_offsets.x;
 	d.longitude = longitude + glitch_offsets.y;
@@ -46,7 +46,7 @@ float SITL_State::_gyro_drift(void)
 		return 0;
 	}
 	double period  = _sitl->drift_time * 2;
-	double minutes = fmod(_scheduler->_micros() / 60.0e6, period);
+	double minutes = fmod(_sim_time_usec() / 60.0e6, period);
 	if (minutes < period/2) {
 		return minutes * ToRad(_sitl->drift_speed);
 	}
@@ -55,7 +55,19 @@ float SITL_State::_gyro_drift(void)
 }
 
 /*
-  setup the INS input channels with new input
+  pass one sample of the IMU model to the inertial sensor, which
+  averages them as a sensor driver does
+ */
+void SITL_State::_ins_sample(const Vector3f &gyro, const Vector3f &accel, float dt)
+{
+	_ins->accumulate(gyro, accel, dt);
+}
+
+/*
+  setup the INS input channels with new input. The IMU model turns
+  each simulator frame into samples at SIM_IMU_RATE, with vibration
+  while the motors are on, noise, the SIM_IMU_FILTER low pass filter
+  and SIM_IMU_DELAY
 
   Note that this uses roll, pitch and yaw only as inputs. The
   simulator rollrates are instantaneous, whereas we need to use
@@ -103,24 +115,26 @@ void SITL_State::_update_ins(float roll, 	float pitch, 	float yaw,		// Relative
         // minimum gyro noise is also less than 1 bit
 	float gyro_noise = ToRad(0.04);
 	if (_motors_on) {
-		// add extra noise when the motors are on
+		// add extra noise and the motor vibration when the motors are on
 		accel_noise += _sitl->accel_noise;
 		gyro_noise += ToRad(_sitl->gyro_noise);
+		_imu.set_vibration(_sitl->vib_freq, ToRad(_sitl->gyro_vib),
+				   _sitl->accel_vib, _sitl->vib_harmonics);
+	} else {
+		_imu.set_vibration(0, 0, 0, 1);
 	}
-	xAccel += accel_noise * _rand_float();
-	yAccel += accel_noise * _rand_float();
-	zAccel += accel_noise * _rand_float();
-
-	p += gyro_noise * _rand_float();
-	q += gyro_noise * _rand_float();
-	r += gyro_noise * _rand_float();
-
-	p += _gyro_drift();
-	q += _gyro_drift();
-	r += _gyro_drift();
-
-	_ins->set_gyro(Vector3f(p, q, r) + _ins->get_gyro_offsets());
-	_ins->set_accel(Vector3f(xAccel, yAccel, zAccel) + _ins->get_accel_offsets());
+	_imu.set_noise(gyro_noise, accel_noise);
+	_imu.set_sensor(_sitl->imu_rate, _sitl->imu_delay, _sitl->imu_filter);
+
+	float drift = _gyro_drift();
+	p += drift;
+	q += drift;
+	r += drift;
+
+	_imu.update(_sim_time_usec(),
+		    Vector3f(p, q, r) + _ins->get_gyro_offsets(),
+		    Vector3f(xAccel, yAccel, zAccel) + _ins->get_accel_offsets(),
+		    _ins_sample);
 
 	airspeed_pin_value = _airspeed_sensor(airspeed);
 }
@@ -30,5 +30,8 @@
 #include "HAL_Empty_Class.h"
 #include "AP_HAL_Empty_Main.h"
 
+// the host build of the unit tests stops the clock of the scheduler
+#include "Scheduler.h"
+
 #endif //__AP_HAL_EMPTY_H__
 
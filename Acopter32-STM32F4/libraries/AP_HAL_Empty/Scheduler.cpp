@@ -1,29 +1,82 @@
 
 #include "Scheduler.h"
 
+#ifdef HAL_EMPTY_HOST
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
 using namespace Empty;
 
 extern const AP_HAL::HAL& hal;
 
+#ifdef HAL_EMPTY_HOST
+/*
+  on a host build the clock is the time since init(), so library code
+  which measures time, and tests of it, can run natively
+ */
+uint64_t EmptyScheduler::_start_usec = 0;
+uint64_t EmptyScheduler::_stopped_clock_usec = 0;
+
+uint64_t EmptyScheduler::_micros64()
+{
+    if (_stopped_clock_usec) {
+        return _stopped_clock_usec;
+    }
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    return tp.tv_sec * 1000000ULL + tp.tv_usec - _start_usec;
+}
+#endif
+
 EmptyScheduler::EmptyScheduler()
 {}
 
 void EmptyScheduler::init(void* machtnichts)
-{}
+{
+#ifdef HAL_EMPTY_HOST
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    _start_usec = tp.tv_sec * 1000000ULL + tp.tv_usec;
+#endif
+}
 
 void EmptyScheduler::delay(uint16_t ms)
-{}
+{
+#ifdef HAL_EMPTY_HOST
+    while (ms--) {
+        delay_microseconds(1000);
+    }
+#endif
+}
 
 uint32_t EmptyScheduler::millis() {
+#ifdef HAL_EMPTY_HOST
+    return _micros64() / 1000;
+#else
     return 10000;
+#endif
 }
 
 uint32_t EmptyScheduler::micros() {
+#ifdef HAL_EMPTY_HOST
+    return _micros64();
+#else
     return 200000;
+#endif
 }
 
 void EmptyScheduler::delay_microseconds(uint16_t us)
-{}
+{
+#ifdef HAL_EMPTY_HOST
+    if (_stopped_clock_usec) {
+        _stopped_clock_usec += us;
+        return;
+    }
+    usleep(us);
+#endif
+}
 
 void EmptyScheduler::register_delay_callback(AP_HAL::Proc k,
             uint16_t min_time_ms)
@@ -63,9 +116,15 @@ void EmptyScheduler::system_initialized()
 
 void EmptyScheduler::panic(const prog_char_t *errormsg) {
     hal.console->println_P(errormsg);
+#ifdef HAL_EMPTY_HOST
+    exit(1);
+#endif
     for(;;);
 }
 
 void EmptyScheduler::reboot(bool hold_in_bootloader) {
+#ifdef HAL_EMPTY_HOST
+    exit(1);
+#endif
     for(;;);
 }
@@ -33,6 +33,16 @@ public:
     void     panic(const prog_char_t *errormsg);
     void     reboot(bool hold_in_bootloader);
 
+#ifdef HAL_EMPTY_HOST
+    // stop the clock at the given time, as on SITL. From then on time
+    // only advances through further calls and through delay()
+    static void stop_clock(uint64_t time_usec) { _stopped_clock_usec = time_usec; }
+
+private:
+    static uint64_t _micros64();
+    static uint64_t _start_usec;
+    static uint64_t _stopped_clock_usec;
+#endif
 };
 
 #endif // __AP_HAL_EMPTY_SCHEDULER_H__
@@ -4,6 +4,16 @@
 
 using namespace Empty;
 
+#ifdef HAL_EMPTY_HOST
+/*
+  on a host build the storage is kept in memory, so AP_Param and other
+  users of the EEPROM can be tested natively. It starts erased on each
+  run
+ */
+#define EMPTY_STORAGE_SIZE 4096
+static uint8_t _storage[EMPTY_STORAGE_SIZE];
+#endif
+
 EmptyStorage::EmptyStorage()
 {}
 
@@ -11,30 +21,60 @@ void EmptyStorage::init(void*)
 {}
 
 uint8_t EmptyStorage::read_byte(uint16_t loc){
-    return 0;
+    uint8_t value = 0;
+    read_block(&value, loc, sizeof(value));
+    return value;
 }
 
 uint16_t EmptyStorage::read_word(uint16_t loc){
-    return 0;
+    uint16_t value = 0;
+    read_block(&value, loc, sizeof(value));
+    return value;
 }
 
 uint32_t EmptyStorage::read_dword(uint16_t loc){
-    return 0;
+    uint32_t value = 0;
+    read_block(&value, loc, sizeof(value));
+    return value;
 }
 
 void EmptyStorage::read_block(void* dst, uint16_t src, size_t n) {
+#ifdef HAL_EMPTY_HOST
+    if (src < EMPTY_STORAGE_SIZE && n <= (size_t)(EMPTY_STORAGE_SIZE - src)) {
+        memcpy(dst, &_storage[src], n);
+        return;
+    }
+#endif
     memset(dst, 0, n);
 }
 
 void EmptyStorage::write_byte(uint16_t loc, uint8_t value)
-{}
+{
+    write_block(loc, &value, sizeof(value));
+}
 
 void EmptyStorage::write_word(uint16_t loc, uint16_t value)
-{}
+{
+    write_block(loc, &value, sizeof(value));
+}
 
 void EmptyStorage::write_dword(uint16_t loc, uint32_t value)
-{}
+{
+    write_block(loc, &value, sizeof(value));
+}
 
 void EmptyStorage::write_block(uint16_t loc, const void* src, size_t n)
-{}
+{
+#ifdef HAL_EMPTY_HOST
+    if (loc < EMPTY_STORAGE_SIZE && n <= (size_t)(EMPTY_STORAGE_SIZE - loc)) {
+        memcpy(&_storage[loc], src, n);
+    }
+#endif
+}
 
+void EmptyStorage::format_eeprom(void)
+{
+#ifdef HAL_EMPTY_HOST
+    memset(_storage, 0, sizeof(_storage));
+#endif
+}
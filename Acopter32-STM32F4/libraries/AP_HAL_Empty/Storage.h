@@ -17,6 +17,8 @@ public:
     void write_word(uint16_t loc, uint16_t value);
     void write_dword(uint16_t loc, uint32_t value);
     void write_block(uint16_t dst, const void* src, size_t n);
+
+    void format_eeprom(void);
 };
 
 #endif // __AP_HAL_EMPTY_STORAGE_H__
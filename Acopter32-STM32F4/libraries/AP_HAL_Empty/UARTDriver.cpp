@@ -1,8 +1,14 @@
 
 #include "UARTDriver.h"
 
+#ifdef HAL_EMPTY_HOST
+#include <stdio.h>
+#endif
+
 using namespace Empty;
 
+extern const AP_HAL::HAL& hal;
+
 EmptyUARTDriver::EmptyUARTDriver() {}
 
 void EmptyUARTDriver::begin(uint32_t b) {}
@@ -18,8 +24,18 @@ int16_t EmptyUARTDriver::available() { return 0; }
 int16_t EmptyUARTDriver::txspace() { return 1; }
 int16_t EmptyUARTDriver::read() { return -1; }
 
-/* Empty implementations of Print virtual methods */
-size_t EmptyUARTDriver::write(uint8_t c) { return 0; }
+/* Empty implementations of Print virtual methods. On a host build the
+ * console goes to stdout */
+size_t EmptyUARTDriver::write(uint8_t c)
+{
+#ifdef HAL_EMPTY_HOST
+    if (this == hal.console) {
+        putchar(c);
+        return 1;
+    }
+#endif
+    return 0;
+}
 
 size_t EmptyUARTDriver::write(const uint8_t *buffer, size_t size)
 {
@@ -165,11 +165,18 @@ size_t REVOMINIUARTDriver::write(uint8_t c) {
 
 size_t REVOMINIUARTDriver::write(const uint8_t *buffer, size_t size)
 {
-    size_t n = 0;
-    while (size--) {
-        n += write(*buffer++);
+    if (hal.scheduler->in_timerprocess()) {
+        // not allowed from timers
+        return 0;
+    }
+
+    // one copy into the transmit buffer for the whole buffer
+    if(_usb_present == 1){
+	return usb_write((uint8_t *)buffer, size);
+    }
+    else{
+	return usart_tx(_usart_device, buffer, size);
     }
-    return n;
 }
 
 #endif // CONFIG_HAL_BOARD
@@ -20,6 +20,7 @@
 #include <AP_Airspeed.h>
 #include <AP_Vehicle.h>
 #include <DataFlash.h>
+#include <AP_PIDCore.h>         // PID state shared by the PID libraries
 #include <AC_PID.h>             // PID library
 #include <APM_PI.h>             // PID library
 #include <AP_Buffer.h>          // ArduPilot general purpose FIFO buffer
@@ -93,11 +93,88 @@ const AP_Param::GroupInfo AP_InertialSensor::var_info[] PROGMEM = {
 
 AP_InertialSensor::AP_InertialSensor() :
     _accel(),
-    _gyro()
+    _gyro(),
+    _have_delta(false),
+    _gyro_sample_hook(NULL),
+    _last_gyro_sample_usec(0)
 {
     AP_Param::setup_object_defaults(this, var_info);        
 }
 
+/*
+  set the gyro from a driver without a sample stream of its own, such
+  as HIL. Each value is passed to the gyro sample hook as one sample
+ */
+void AP_InertialSensor::set_gyro(Vector3f gyro)
+{
+    _gyro = gyro;
+    if (_gyro_sample_hook != NULL) {
+        uint32_t now = hal.scheduler->micros();
+        float dt = (now - _last_gyro_sample_usec) * 1.0e-6f;
+        _last_gyro_sample_usec = now;
+        _gyro_sample_hook(_gyro, dt);
+    }
+}
+
+bool AP_InertialSensor::get_delta_angle(Vector3f &delta_angle) const
+{
+    if (!_have_delta) {
+        return false;
+    }
+    delta_angle = _delta_angle;
+    return true;
+}
+
+bool AP_InertialSensor::get_delta_velocity(Vector3f &delta_velocity) const
+{
+    if (!_have_delta) {
+        return false;
+    }
+    delta_velocity = _delta_velocity;
+    return true;
+}
+
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+/*
+  accumulate one sensor sample. Summing the increments alone loses
+  the non-commutativity of rotations within the period (coning) and
+  the rotation of the accelerations while the body turns (sculling),
+  which appear as attitude drift and a velocity bias under vibration.
+  These are the two sample algorithms with the previous increment as
+  the first sample, see Savage, "Strapdown Inertial Navigation
+  Integration Algorithm Design", JGCD 1998
+ */
+void AP_InertialSensor::_delta_accumulate(struct delta_accumulator &acc,
+                                          const Vector3f &gyro, const Vector3f &accel)
+{
+    Vector3f alpha_prev = acc.alpha + acc.last_gyro * (1.0f/6.0f);
+    Vector3f vel_prev = acc.vel + acc.last_accel * (1.0f/6.0f);
+    acc.beta += (alpha_prev % gyro) * 0.5f;
+    acc.sculling += ((alpha_prev % accel) + (vel_prev % gyro)) * 0.5f;
+
+    acc.alpha += gyro;
+    acc.vel += accel;
+    acc.last_gyro = gyro;
+    acc.last_accel = accel;
+}
+
+void AP_InertialSensor::_delta_latch(struct delta_accumulator &acc, float sample_dt)
+{
+    // the first order sums scale with the sample period and the
+    // correction terms with its square
+    _delta_angle = (acc.alpha + acc.beta * sample_dt) * sample_dt;
+    // the rotation term takes the velocity sum back to the frame at
+    // the start of the period
+    _delta_velocity = (acc.vel + ((acc.alpha % acc.vel) * 0.5f + acc.sculling) * sample_dt) * sample_dt;
+    _have_delta = true;
+
+    acc.alpha.zero();
+    acc.beta.zero();
+    acc.vel.zero();
+    acc.sculling.zero();
+}
+#endif // AP_INERTIALSENSOR_DELTA_ANGLES
+
 void
 AP_InertialSensor::init( Start_style style,
                          Sample_rate sample_rate)
@@ -117,6 +194,22 @@ AP_InertialSensor::init( Start_style style,
     }
 }
 
+Matrix3f AP_InertialSensor::_sensor_transform(enum Rotation orientation,
+                                              const uint8_t index[3], uint8_t first,
+                                              const int8_t sign[3], float scale)
+{
+    float remap[3][3];
+    memset(remap, 0, sizeof(remap));
+    for (uint8_t i=0; i<3; i++) {
+        remap[i][index[i] - first] = sign[i] * scale;
+    }
+    Matrix3f rotation;
+    rotation.from_rotation(orientation);
+    return rotation * Matrix3f(Vector3f(remap[0][0], remap[0][1], remap[0][2]),
+                               Vector3f(remap[1][0], remap[1][1], remap[1][2]),
+                               Vector3f(remap[2][0], remap[2][1], remap[2][2]));
+}
+
 // save parameters to eeprom
 void AP_InertialSensor::_save_parameters()
 {
@@ -11,6 +11,16 @@
 #include <AP_HAL.h>
 #include <AP_Math.h>
 #include "AP_InertialSensor_UserInteract.h"
+
+// drivers which support it accumulate coning and sculling compensated
+// delta angles and velocities at the sensor sample rate. This is too
+// much floating point work for the timer process on the AVR boards
+#if CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2
+ # define AP_INERTIALSENSOR_DELTA_ANGLES 0
+#else
+ # define AP_INERTIALSENSOR_DELTA_ANGLES 1
+#endif
+
 /* AP_InertialSensor is an abstraction for gyro and accel measurements
  * which are correctly aligned to the body axes and scaled to SI units.
  *
@@ -33,6 +43,7 @@ public:
         RATE_50HZ,
         RATE_100HZ,
         RATE_200HZ,
+        RATE_400HZ,
         RATE_500HZ,
         RATE_1000HZ
     };
@@ -86,7 +97,16 @@ public:
     /// @returns	vector of rotational rates in radians/sec
     ///
     Vector3f            get_gyro(void) const { return _gyro; }
-    void                set_gyro(Vector3f gyro) { _gyro = gyro; }
+    void                set_gyro(Vector3f gyro);
+
+    /// A function called with each gyro sample as the driver reads
+    /// it, before any averaging, with the time in seconds since the
+    /// last sample. The gyro is in radians/sec with the offsets
+    /// removed. For the MPU6000 this is called from the timer process
+    /// at the sensor rate, and for HIL from set_gyro(), so the
+    /// function must be short and must not block
+    typedef void (*gyro_sample_fn_t)(const Vector3f &gyro, float dt);
+    void                set_gyro_sample_hook(gyro_sample_fn_t fn) { _gyro_sample_hook = fn; }
 
     // set gyro offsets in radians/sec
     Vector3f get_gyro_offsets(void) { return _gyro_offset; }
@@ -106,6 +126,25 @@ public:
     // get accel scale
     Vector3f get_accel_scale() { return _accel_scale; }
 
+    /// Fetch the rotation of the body over the last update period, as
+    /// a rotation vector in radians, with coning compensation
+    ///
+    /// @returns	false if the driver does not accumulate delta angles,
+    ///             in which case get_gyro() * get_delta_time() should
+    ///             be used instead
+    ///
+    bool get_delta_angle(Vector3f &delta_angle) const;
+
+    /// Fetch the change in velocity over the last update period in
+    /// m/s, with sculling compensation. This is expressed in the body
+    /// frame at the start of the period
+    ///
+    /// @returns	false if the driver does not accumulate delta
+    ///             velocities, in which case get_accel() *
+    ///             get_delta_time() should be used instead
+    ///
+    bool get_delta_velocity(Vector3f &delta_velocity) const;
+
     //get temperature
     virtual float get_temperature(void) const = 0;
 
@@ -170,12 +209,53 @@ protected:
     // save parameters to eeprom
     void  _save_parameters();
 
+    // the matrix taking the three raw sensor axes starting at raw
+    // sample index first to the body frame. index and sign give the
+    // sensor axis and sign of each body axis before the board
+    // orientation is applied, and the result is multiplied by scale
+    static Matrix3f _sensor_transform(enum Rotation orientation,
+                                      const uint8_t index[3], uint8_t first,
+                                      const int8_t sign[3], float scale);
+
     // Most recent accelerometer reading obtained by ::update
     Vector3f _accel;
 
     // Most recent gyro reading obtained by ::update
     Vector3f _gyro;
 
+    // delta angle and velocity over the period of the most recent
+    // ::update, valid when _have_delta is set
+    Vector3f _delta_angle;
+    Vector3f _delta_velocity;
+    bool _have_delta;
+
+    // called with each raw gyro sample, or NULL
+    gyro_sample_fn_t _gyro_sample_hook;
+    uint32_t _last_gyro_sample_usec;
+
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+    // running sums of the sensor samples since the last ::update. The
+    // sample period is applied when the sums are latched, so the
+    // sums are in units of one sample period. The previous sample is
+    // kept across updates for the coning and sculling terms
+    struct delta_accumulator {
+        Vector3f alpha;         // sum of angle increments
+        Vector3f beta;          // coning correction
+        Vector3f last_gyro;
+        Vector3f vel;           // sum of velocity increments
+        Vector3f sculling;      // sculling correction
+        Vector3f last_accel;
+    };
+
+    // add one sensor sample, in rad/s and m/s/s
+    static void _delta_accumulate(struct delta_accumulator &acc,
+                                  const Vector3f &gyro, const Vector3f &accel);
+
+    // set _delta_angle and _delta_velocity from the sums, given the
+    // sensor sample period in seconds, and start a new period
+    void _delta_latch(struct delta_accumulator &acc, float sample_dt);
+#endif
+
     // product id
     AP_Int16 _product_id;
 
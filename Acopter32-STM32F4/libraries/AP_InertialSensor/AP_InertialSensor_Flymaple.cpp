@@ -90,6 +90,10 @@ uint16_t AP_InertialSensor_Flymaple::_init_sensor( Sample_rate sample_rate )
         _sample_divider = raw_sample_rate_hz / 100;
         _default_filter_hz = 20;
         break;
+    case RATE_400HZ:
+        _sample_divider = raw_sample_rate_hz / 400;
+        _default_filter_hz = 20;
+        break;
     case RATE_200HZ:
     default:
         _sample_divider = raw_sample_rate_hz / 200;
@@ -4,7 +4,13 @@
 #include <AP_HAL.h>
 const extern AP_HAL::HAL& hal;
 
-AP_InertialSensor_HIL::AP_InertialSensor_HIL() : AP_InertialSensor() {
+AP_InertialSensor_HIL::AP_InertialSensor_HIL() :
+    AP_InertialSensor(),
+    _sums_index(0),
+    _sample_dt(0)
+{
+        _sums[0].count = 0;
+        _sums[1].count = 0;
         Vector3f accels;
         accels.z = -GRAVITY_MSS;
         set_accel(accels);
@@ -13,13 +19,17 @@ AP_InertialSensor_HIL::AP_InertialSensor_HIL() : AP_InertialSensor() {
 uint16_t AP_InertialSensor_HIL::_init_sensor( Sample_rate sample_rate ) {
     switch (sample_rate) {
     case RATE_50HZ:
-        _sample_period_ms = 20;
+        _sample_period_usec = 20000;
         break;
     case RATE_100HZ:
-        _sample_period_ms = 10;
+        _sample_period_usec = 10000;
+        break;
+    case RATE_400HZ:
+        _sample_period_usec = 2500;
         break;
     case RATE_200HZ:
-        _sample_period_ms = 5;
+    default:
+        _sample_period_usec = 5000;
         break;
     }
     return AP_PRODUCT_ID_NONE;
@@ -28,12 +38,62 @@ uint16_t AP_InertialSensor_HIL::_init_sensor( Sample_rate sample_rate ) {
 /*================ AP_INERTIALSENSOR PUBLIC INTERFACE ==================== */
 
 bool AP_InertialSensor_HIL::update( void ) {
-    uint32_t now = hal.scheduler->millis();
-    _delta_time_usec = (now - _last_update_ms) * 1000;
-    _last_update_ms = now;
+    uint32_t now = hal.scheduler->micros();
+    _delta_time_usec = now - _last_update_usec;
+    _last_update_usec = now;
+
+    // without accumulated samples the values are those last given
+    // to set_gyro() and set_accel()
+    uint8_t i = _sums_index;
+    struct sample_sums &sums = _sums[i];
+    if (sums.count != 0) {
+        // later samples go to the other set, so this one is ours
+        _sums_index = i ^ 1;
+        __asm__ __volatile__("" ::: "memory");
+
+        float count_scale = 1.0f / sums.count;
+        _gyro = sums.gyro * count_scale;
+        _accel = sums.accel * count_scale;
+        sums.gyro.zero();
+        sums.accel.zero();
+        sums.count = 0;
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+        _delta_latch(sums.delta, _sample_dt);
+#endif
+    }
     return true;
 }
 
+void AP_InertialSensor_HIL::accumulate(const Vector3f &gyro, const Vector3f &accel, float dt)
+{
+    uint8_t i = _sums_index;
+    struct sample_sums &sums = _sums[i];
+    sums.gyro += gyro;
+    sums.accel += accel;
+    _sample_dt = dt;
+    sums.count++;
+
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+    _delta_accumulate(sums.delta, gyro - _gyro_offset, accel - _accel_offset);
+    // the next period carries on from this sample in either set.
+    // update() doesn't touch the last samples
+    _sums[i^1].delta.last_gyro = sums.delta.last_gyro;
+    _sums[i^1].delta.last_accel = sums.delta.last_accel;
+#endif
+
+    if (_gyro_sample_hook != NULL) {
+        _gyro_sample_hook(gyro, dt);
+    }
+
+    if (sums.count == 1000) {
+        // the main loop has stopped reading the sensor. Keep the
+        // average of the most recent samples
+        sums.gyro *= 0.5f;
+        sums.accel *= 0.5f;
+        sums.count /= 2;
+    }
+}
+
 float AP_InertialSensor_HIL::get_delta_time() {
     return _delta_time_usec * 1.0e-6;
 }
@@ -45,10 +105,7 @@ float AP_InertialSensor_HIL::get_gyro_drift_rate(void) {
 
 bool AP_InertialSensor_HIL::sample_available()
 {
-    uint16_t ret = (hal.scheduler->millis() - _last_update_ms) 
-        / _sample_period_ms;
-    
-    return ret > 0;
+    return (hal.scheduler->micros() - _last_update_usec) >= _sample_period_usec;
 }
 
 bool AP_InertialSensor_HIL::wait_for_sample(uint16_t timeout_ms)
@@ -58,7 +115,7 @@ bool AP_InertialSensor_HIL::wait_for_sample(uint16_t timeout_ms)
     }
     uint32_t start = hal.scheduler->millis();
     while ((hal.scheduler->millis() - start) < timeout_ms) {
-        hal.scheduler->delay(1);
+        hal.scheduler->delay_microseconds(100);
         if (sample_available()) {
             return true;
         }
@@ -18,12 +18,35 @@ public:
     float           get_gyro_drift_rate();
     bool            sample_available();
     bool            wait_for_sample(uint16_t timeout_ms);
+    float           get_temperature() const { return 0; }
+
+    /// Add one raw sample from a simulated sensor, taken at the
+    /// sensor rate with dt seconds between samples. update() averages
+    /// the samples since the last update, as a sensor driver does
+    void            accumulate(const Vector3f &gyro, const Vector3f &accel, float dt);
 
 protected:
     uint16_t        _init_sensor( Sample_rate sample_rate );
-    uint32_t        _sample_period_ms;
-    uint32_t        _last_update_ms;
+    uint32_t        _sample_period_usec;
+    uint32_t        _last_update_usec;
     uint32_t        _delta_time_usec;
+
+    // sums of the samples given to accumulate() since the last update
+    struct sample_sums {
+        Vector3f    gyro;
+        Vector3f    accel;
+        uint16_t    count;
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+        struct delta_accumulator delta;
+#endif
+    };
+
+    // accumulate() runs from the timer, which can preempt update().
+    // It adds to _sums[_sums_index] while update() reads the other
+    // set, so update() never sees a sample half added
+    struct sample_sums _sums[2];
+    volatile uint8_t _sums_index;
+    float           _sample_dt;
 };
 
 #endif // __AP_INERTIAL_SENSOR_STUB_H__
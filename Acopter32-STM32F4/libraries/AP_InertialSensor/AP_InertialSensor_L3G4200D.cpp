@@ -108,6 +108,11 @@ uint16_t AP_InertialSensor_L3G4200D::_init_sensor( Sample_rate sample_rate )
         _sample_period_usec = (1000*1000) / 100;
         _gyro_samples_needed = 8;
         break;
+    case RATE_400HZ:
+        _default_filter_hz = 20;
+        _sample_period_usec = (1000*1000) / 400;
+        _gyro_samples_needed = 2;
+        break;
     case RATE_200HZ:
     default:
         _default_filter_hz = 20;
@@ -8,6 +8,10 @@ extern const AP_HAL::HAL& hal;
 // MPU6000 accelerometer scaling
 #define MPU6000_ACCEL_SCALE_1G    (GRAVITY_MSS / 4096.0f)
 
+// the raw sample index of the first accel and gyro axis
+#define MPU6000_ACCEL_FIRST       0
+#define MPU6000_GYRO_FIRST        4
+
 // MPU 6000 registers
 #define MPUREG_XG_OFFS_TC                               0x00
 #define MPUREG_YG_OFFS_TC                               0x01
@@ -196,17 +200,31 @@ const uint8_t AP_InertialSensor_MPU6000::_temp_data_index = 3;
 AP_InertialSensor_MPU6000::AP_InertialSensor_MPU6000() : 
 	AP_InertialSensor(),
     _drdy_pin(NULL),
+    _transform_orientation(ROTATION_MAX),
     _temp(0),
     _initialised(false),
     _mpu6000_product_id(AP_PRODUCT_ID_NONE)
 {
 }
 
+void AP_InertialSensor_MPU6000::_update_transforms(void)
+{
+    _gyro_transform = _sensor_transform(_board_orientation,
+                                        _gyro_data_index, MPU6000_GYRO_FIRST,
+                                        _gyro_data_sign, _gyro_scale);
+    _accel_transform = _sensor_transform(_board_orientation,
+                                         _accel_data_index, MPU6000_ACCEL_FIRST,
+                                         _accel_data_sign, MPU6000_ACCEL_SCALE_1G);
+    _transform_orientation = _board_orientation;
+}
+
 uint16_t AP_InertialSensor_MPU6000::_init_sensor( Sample_rate sample_rate )
 {
     if (_initialised) return _mpu6000_product_id;
     _initialised = true;
 
+    _update_transforms();
+
     _spi = hal.spi->device(AP_HAL::SPIDevice_MPU6000);
     _spi_sem = _spi->get_semaphore();
 
@@ -303,23 +321,31 @@ bool AP_InertialSensor_MPU6000::update( void )
 
         _num_samples = _count;
         _count = 0;
+        // with 2.5 samples per update this alternates between 3 and 2
+        _sample_carry = (_num_samples*2 + _sample_carry > _sample_halves) ? 1 : 0;
+
+        if (_transform_orientation != _board_orientation) {
+            _update_transforms();
+        }
+
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+        _delta_latch(_delta_acc, _sample_period());
+#endif
     }
     hal.scheduler->resume_timer_procs();
 
     count_scale = 1.0f / _num_samples;
 
-    _gyro  = Vector3f(_gyro_data_sign[0] * sum[_gyro_data_index[0]],
-                      _gyro_data_sign[1] * sum[_gyro_data_index[1]],
-                      _gyro_data_sign[2] * sum[_gyro_data_index[2]]);
-    _gyro.rotate(_board_orientation);
-    _gyro *= _gyro_scale * count_scale;
+    _gyro  = _gyro_transform * Vector3f(sum[MPU6000_GYRO_FIRST],
+                                        sum[MPU6000_GYRO_FIRST+1],
+                                        sum[MPU6000_GYRO_FIRST+2]);
+    _gyro *= count_scale;
     _gyro -= _gyro_offset;
 
-    _accel   = Vector3f(_accel_data_sign[0] * sum[_accel_data_index[0]],
-                        _accel_data_sign[1] * sum[_accel_data_index[1]],
-                        _accel_data_sign[2] * sum[_accel_data_index[2]]);
-    _accel.rotate(_board_orientation);
-    _accel *= count_scale * MPU6000_ACCEL_SCALE_1G;
+    _accel = _accel_transform * Vector3f(sum[MPU6000_ACCEL_FIRST],
+                                         sum[MPU6000_ACCEL_FIRST+1],
+                                         sum[MPU6000_ACCEL_FIRST+2]);
+    _accel *= count_scale;
     _accel.x *= accel_scale.x;
     _accel.y *= accel_scale.y;
     _accel.z *= accel_scale.z;
@@ -433,17 +459,59 @@ void AP_InertialSensor_MPU6000::_read_data_transaction() {
     tx[0] = MPUREG_ACCEL_XOUT_H | 0x80;
     _spi->transaction(tx, rx, 15);
 
+    int16_t raw[7];
     for (uint8_t i = 0; i < 7; i++) {
-        _sum[i] += (int16_t)(((uint16_t)rx[2*i+1] << 8) | rx[2*i+2]);
+        raw[i] = (int16_t)(((uint16_t)rx[2*i+1] << 8) | rx[2*i+2]);
+        _sum[i] += raw[i];
     }   
+
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+    _accumulate_delta(raw);
+#endif
     
+    if (_gyro_sample_hook != NULL) {
+        Vector3f gyro = _gyro_transform * Vector3f(raw[MPU6000_GYRO_FIRST],
+                                                   raw[MPU6000_GYRO_FIRST+1],
+                                                   raw[MPU6000_GYRO_FIRST+2]);
+        _gyro_sample_hook(gyro - _gyro_offset, _sample_period());
+    }
+
     _count++;
     if (_count == 0) {
         // rollover - v unlikely
         memset((void*)_sum, 0, sizeof(_sum));
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+        _delta_latch(_delta_acc, 0);
+#endif
     }
 }
 
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+/*
+  scale one raw sample as update() does for the averages, and add it
+  to the delta angle and velocity sums
+ */
+void AP_InertialSensor_MPU6000::_accumulate_delta(const int16_t raw[7])
+{
+    Vector3f accel_scale = _accel_scale.get();
+
+    Vector3f gyro = _gyro_transform * Vector3f(raw[MPU6000_GYRO_FIRST],
+                                               raw[MPU6000_GYRO_FIRST+1],
+                                               raw[MPU6000_GYRO_FIRST+2]);
+    gyro -= _gyro_offset;
+
+    Vector3f accel = _accel_transform * Vector3f(raw[MPU6000_ACCEL_FIRST],
+                                                 raw[MPU6000_ACCEL_FIRST+1],
+                                                 raw[MPU6000_ACCEL_FIRST+2]);
+    accel.x *= accel_scale.x;
+    accel.y *= accel_scale.y;
+    accel.z *= accel_scale.z;
+    accel -= _accel_offset;
+
+    _delta_accumulate(_delta_acc, gyro, accel);
+}
+#endif
+
 uint8_t AP_InertialSensor_MPU6000::_register_read( uint8_t reg )
 {
     uint8_t addr = reg | 0x80; // Set most significant bit
@@ -556,22 +624,37 @@ bool AP_InertialSensor_MPU6000::hardware_init(Sample_rate sample_rate)
 #if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
 	_sample_rate = MPUREG_SMPLRT_200HZ;
-	_sample_time_usec = 50000;
+	_sample_time_usec = 5000;
 #endif
 #endif
         default_filter = BITS_DLPF_CFG_10HZ;
-        _sample_shift = 2;
+        _sample_halves = 8;
 
         break;
     case RATE_100HZ:
 #if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
 	_sample_rate = MPUREG_SMPLRT_200HZ;
-	_sample_time_usec = 10000;
+	_sample_time_usec = 5000;
+#endif
+#endif
+        default_filter = BITS_DLPF_CFG_20HZ;
+        _sample_halves = 4;
+        break;
+    case RATE_400HZ:
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
+#ifdef ENHANCED
+	_sample_rate = MPUREG_SMPLRT_1000HZ;
+	_sample_time_usec = 1000;
+        _sample_halves = 5;
+#else
+        _sample_halves = 2;
 #endif
+#else
+        // the sensor runs at 200Hz on these boards
+        _sample_halves = 2;
 #endif
         default_filter = BITS_DLPF_CFG_20HZ;
-        _sample_shift = 1;
         break;
     case RATE_1000HZ:
 #if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
@@ -581,7 +664,7 @@ bool AP_InertialSensor_MPU6000::hardware_init(Sample_rate sample_rate)
 #endif
 #endif
         default_filter = BITS_DLPF_CFG_20HZ;
-        _sample_shift = 0;
+        _sample_halves = 2;
         break;
     case RATE_200HZ:
     default:
@@ -592,9 +675,10 @@ bool AP_InertialSensor_MPU6000::hardware_init(Sample_rate sample_rate)
 #endif
 #endif
         default_filter = BITS_DLPF_CFG_20HZ;
-        _sample_shift = 0;
+        _sample_halves = 2;
         break;
     }
+    _sample_carry = 0;
 
     _set_filter_register(_mpu6000_filter, default_filter);
 
@@ -675,7 +759,7 @@ float AP_InertialSensor_MPU6000::get_gyro_drift_rate(void)
 bool AP_InertialSensor_MPU6000::sample_available()
 {
     _poll_data();
-    return (_count >> _sample_shift) > 0;
+    return _count*2 + _sample_carry >= _sample_halves;
 }
 
 
@@ -697,18 +781,24 @@ void AP_InertialSensor_MPU6000::_dump_registers(void)
 
 
 // get_delta_time returns the time period in seconds overwhich the sensor data was collected
-float AP_InertialSensor_MPU6000::get_delta_time() 
+float AP_InertialSensor_MPU6000::get_delta_time()
 {
-#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+    return _sample_period() * _num_samples;
+}
+
+// the time in seconds between two samples from the sensor
+float AP_InertialSensor_MPU6000::_sample_period() const
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
-    // the sensor runs at 200Hz
-    return _sample_time_usec * 1.0e-6f * _num_samples;
+    // the sensor runs at the rate _init_sensor() chose, up to 1kHz
+    return _sample_time_usec * 1.0e-6f;
 #else
     // the sensor runs at 200Hz
-    return 0.005 * _num_samples;
+    return 0.005f;
 #endif
 #else
     // the sensor runs at 200Hz
-    return 0.005 * _num_samples;
+    return 0.005f;
 #endif
 }
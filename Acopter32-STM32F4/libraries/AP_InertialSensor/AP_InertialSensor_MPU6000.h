@@ -72,6 +72,14 @@ private:
 
     static const uint8_t        _temp_data_index;
 
+    // the axis remapping, board orientation and scale of the gyro
+    // and accel samples, combined into one matrix each. Rebuilt by
+    // update() when the board orientation changes
+    void                        _update_transforms(void);
+    Matrix3f                    _gyro_transform;
+    Matrix3f                    _accel_transform;
+    enum Rotation               _transform_orientation;
+
     uint32_t _last_sample_time_micros;
 
     float                       _temp;
@@ -79,8 +87,14 @@ private:
     bool                        _initialised;
     int16_t              _mpu6000_product_id;
 
-    // how many hardware samples before we report a sample to the caller
-    uint8_t _sample_shift;
+    // how many hardware samples before we report a sample to the
+    // caller, in half samples so that the 1kHz sensor rate can give
+    // 400Hz. A half sample left over is carried to the next update
+    uint8_t _sample_halves;
+    uint8_t _sample_carry;
+
+    // the time in seconds between two samples from the sensor
+    float _sample_period() const;
 
     // support for updating filter at runtime
     uint8_t _last_filter_hz;
@@ -94,6 +108,12 @@ private:
 
     void _set_filter_register(uint8_t filter_hz, uint8_t default_filter);
 
+#if AP_INERTIALSENSOR_DELTA_ANGLES
+    // coning and sculling sums, updated in the timer process
+    struct delta_accumulator _delta_acc;
+    void _accumulate_delta(const int16_t raw[7]);
+#endif
+
 public:
 
 #if MPU6000_DEBUG
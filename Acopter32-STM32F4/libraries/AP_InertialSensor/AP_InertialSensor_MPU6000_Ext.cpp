@@ -8,6 +8,10 @@ extern const AP_HAL::HAL& hal;
 // MPU6000 accelerometer scaling
 #define MPU6000_ACCEL_SCALE_1G    (GRAVITY_MSS / 4096.0f)
 
+// the raw sample index of the first accel and gyro axis
+#define MPU6000_ACCEL_FIRST       0
+#define MPU6000_GYRO_FIRST        4
+
 // MPU 6000 registers
 #define MPUREG_XG_OFFS_TC                               0x00
 #define MPUREG_YG_OFFS_TC                               0x01
@@ -154,7 +158,7 @@ extern const AP_HAL::HAL& hal;
  *  RM-MPU-6000A-00.pdf, page 33, section 4.25 lists LSB sensitivity of
  *  gyro as 16.4 LSB/DPS at scale factor of +/- 2000dps (FS_SEL==3)
  */
-#if  CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
 const float AP_InertialSensor_MPU6000_Ext::_gyro_scale = (0.0174532 / 32.8);
 #else
@@ -195,15 +199,29 @@ AP_InertialSensor_MPU6000_Ext::AP_InertialSensor_MPU6000_Ext() :
     _mpu6000_product_id(AP_PRODUCT_ID_NONE),
     _drdy_pin(NULL),
     _temp(0),
+    _transform_orientation(ROTATION_MAX),
     _initialised(false)
 {
 }
 
+void AP_InertialSensor_MPU6000_Ext::_update_transforms(void)
+{
+    _gyro_transform = _sensor_transform(_board_orientation,
+                                        _gyro_data_index, MPU6000_GYRO_FIRST,
+                                        _gyro_data_sign, _gyro_scale);
+    _accel_transform = _sensor_transform(_board_orientation,
+                                         _accel_data_index, MPU6000_ACCEL_FIRST,
+                                         _accel_data_sign, MPU6000_ACCEL_SCALE_1G);
+    _transform_orientation = _board_orientation;
+}
+
 uint16_t AP_InertialSensor_MPU6000_Ext::_init_sensor( Sample_rate sample_rate )
 {
     if (_initialised) return _mpu6000_product_id;
     _initialised = true;
 
+    _update_transforms();
+
     _spi = hal.spi->device(AP_HAL::SPIDevice_MPU6000_Ext);
     _spi_sem = _spi->get_semaphore();
 
@@ -295,23 +313,27 @@ bool AP_InertialSensor_MPU6000_Ext::update( void )
 
         _num_samples = _count;
         _count = 0;
+        // with 2.5 samples per update this alternates between 3 and 2
+        _sample_carry = (_num_samples*2 + _sample_carry > _sample_halves) ? 1 : 0;
+
+        if (_transform_orientation != _board_orientation) {
+            _update_transforms();
+        }
     }
     hal.scheduler->resume_timer_procs();
 
     count_scale = 1.0f / _num_samples;
 
-    _gyro  = Vector3f(_gyro_data_sign[0] * sum[_gyro_data_index[0]],
-                      _gyro_data_sign[1] * sum[_gyro_data_index[1]],
-                      _gyro_data_sign[2] * sum[_gyro_data_index[2]]);
-    _gyro.rotate(_board_orientation);
-    _gyro *= _gyro_scale * count_scale;
+    _gyro  = _gyro_transform * Vector3f(sum[MPU6000_GYRO_FIRST],
+                                        sum[MPU6000_GYRO_FIRST+1],
+                                        sum[MPU6000_GYRO_FIRST+2]);
+    _gyro *= count_scale;
     _gyro -= _gyro_offset;
 
-    _accel   = Vector3f(_accel_data_sign[0] * sum[_accel_data_index[0]],
-                        _accel_data_sign[1] * sum[_accel_data_index[1]],
-                        _accel_data_sign[2] * sum[_accel_data_index[2]]);
-    _accel.rotate(_board_orientation);
-    _accel *= count_scale * MPU6000_ACCEL_SCALE_1G;
+    _accel = _accel_transform * Vector3f(sum[MPU6000_ACCEL_FIRST],
+                                         sum[MPU6000_ACCEL_FIRST+1],
+                                         sum[MPU6000_ACCEL_FIRST+2]);
+    _accel *= count_scale;
     _accel.x *= accel_scale.x;
     _accel.y *= accel_scale.y;
     _accel.z *= accel_scale.z;
@@ -423,10 +445,19 @@ void AP_InertialSensor_MPU6000_Ext::_read_data_transaction() {
     tx[0] = MPUREG_ACCEL_XOUT_H | 0x80;
     _spi->transaction(tx, rx, 15);
 
+    int16_t raw[7];
     for (uint8_t i = 0; i < 7; i++) {
-        _sum[i] += (int16_t)(((uint16_t)rx[2*i+1] << 8) | rx[2*i+2]);
+        raw[i] = (int16_t)(((uint16_t)rx[2*i+1] << 8) | rx[2*i+2]);
+        _sum[i] += raw[i];
     }   
     
+    if (_gyro_sample_hook != NULL) {
+        Vector3f gyro = _gyro_transform * Vector3f(raw[MPU6000_GYRO_FIRST],
+                                                   raw[MPU6000_GYRO_FIRST+1],
+                                                   raw[MPU6000_GYRO_FIRST+2]);
+        _gyro_sample_hook(gyro - _gyro_offset, _sample_period());
+    }
+
     _count++;
     if (_count == 0) {
         // rollover - v unlikely
@@ -540,54 +571,70 @@ bool AP_InertialSensor_MPU6000_Ext::hardware_init(Sample_rate sample_rate)
         // this is used for plane and rover, where noise resistance is
         // more important than update rate. Tests on an aerobatic plane
         // show that 10Hz is fine, and makes it very noise resistant
-#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
 	_sample_rate = MPUREG_SMPLRT_200HZ;
-	_sample_time_usec = 50000;
+	_sample_time_usec = 5000;
 #endif
 #endif
         default_filter = BITS_DLPF_CFG_10HZ;
-        _sample_shift = 2;
+        _sample_halves = 8;
 
         break;
     case RATE_100HZ:
-#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
 	_sample_rate = MPUREG_SMPLRT_200HZ;
-	_sample_time_usec = 10000;
+	_sample_time_usec = 5000;
 #endif
 #endif
         default_filter = BITS_DLPF_CFG_20HZ;
-        _sample_shift = 1;
+        _sample_halves = 4;
+        break;
+    case RATE_400HZ:
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
+#ifdef ENHANCED
+	_sample_rate = MPUREG_SMPLRT_1000HZ;
+	_sample_time_usec = 1000;
+        _sample_halves = 5;
+#else
+        _sample_halves = 2;
+#endif
+#else
+        // the sensor runs at 200Hz on these boards
+        _sample_halves = 2;
+#endif
+        default_filter = BITS_DLPF_CFG_20HZ;
         break;
     case RATE_1000HZ:
-#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
 	_sample_rate = MPUREG_SMPLRT_1000HZ;
 	_sample_time_usec = 1000;
 #endif
 #endif
         default_filter = BITS_DLPF_CFG_20HZ;
-        _sample_shift = 0;
+        _sample_halves = 2;
         break;
     case RATE_200HZ:
     default:
-#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
 	_sample_rate = MPUREG_SMPLRT_200HZ;
 	_sample_time_usec = 5000;
 #endif
 #endif
         default_filter = BITS_DLPF_CFG_20HZ;
-        _sample_shift = 0;
+        _sample_halves = 2;
         break;
     }
+    _sample_carry = 0;
 
     _set_filter_register(_mpu6000_filter, default_filter);
 
     // set sample rate to 200Hz, and use _sample_divider to give
     // the requested rate to the application
-#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
     register_write(MPUREG_SMPLRT_DIV, _sample_rate);
 #else
@@ -599,7 +646,7 @@ bool AP_InertialSensor_MPU6000_Ext::hardware_init(Sample_rate sample_rate)
 
     hal.scheduler->delay(1);
 
-#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
     register_write(MPUREG_GYRO_CONFIG, BITS_GYRO_FS_1000DPS);  // Gyro scale 2000º/s
 #else
@@ -658,7 +705,7 @@ float AP_InertialSensor_MPU6000_Ext::get_gyro_drift_rate(void)
 bool AP_InertialSensor_MPU6000_Ext::sample_available()
 {
     _poll_data();
-    return (_count >> _sample_shift) > 0;
+    return _count*2 + _sample_carry >= _sample_halves;
 }
 
 
@@ -682,16 +729,22 @@ void AP_InertialSensor_MPU6000_Ext::_dump_registers(void)
 // get_delta_time returns the time period in seconds over which the sensor data was collected
 float AP_InertialSensor_MPU6000_Ext::get_delta_time()
 {
-#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+    return _sample_period() * _num_samples;
+}
+
+// the time in seconds between two samples from the sensor
+float AP_InertialSensor_MPU6000_Ext::_sample_period() const
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 #ifdef ENHANCED
-    // the sensor runs at 200Hz
-    return _sample_time_usec * 1.0e-6f * _num_samples;
+    // the sensor runs at the rate _init_sensor() chose, up to 1kHz
+    return _sample_time_usec * 1.0e-6f;
 #else
     // the sensor runs at 200Hz
-    return 0.005 * _num_samples;
+    return 0.005f;
 #endif
 #else
     // the sensor runs at 200Hz
-    return 0.005 * _num_samples;
+    return 0.005f;
 #endif
 }
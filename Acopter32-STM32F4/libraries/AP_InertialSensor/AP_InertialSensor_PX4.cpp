@@ -26,6 +26,10 @@ uint16_t AP_InertialSensor_PX4::_init_sensor( Sample_rate sample_rate )
         _default_filter_hz = 30;
         _sample_time_usec = 10000;
         break;
+    case RATE_400HZ:
+        _default_filter_hz = 30;
+        _sample_time_usec = 2500;
+        break;
     case RATE_200HZ:
     default:
         _default_filter_hz = 30;
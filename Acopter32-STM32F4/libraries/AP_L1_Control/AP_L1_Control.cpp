@@ -73,6 +73,14 @@ float AP_L1_Control::turn_distance(float wp_radius) const
 	return min(wp_radius, _L1_dist);
 }
 
+// bearing in centi-degrees (0 ~ 36000) of a north/east vector
+static int32_t bearing_cd(const Vector2f &ne)
+{
+    int32_t bearing = fast_atan2(ne.y, ne.x) * 5729.57795f;
+    if (bearing < 0) bearing += 36000;
+    return bearing;
+}
+
 bool AP_L1_Control::reached_loiter_target(void)
 {
 	return _WPcircle;
@@ -83,8 +91,38 @@ float AP_L1_Control::crosstrack_error(void) const
 	return _crosstrack_error;
 }
 
+// recalculate the geometry of the segment from prev_WP to next_WP if
+// it has changed since the last update. It also changes if the origin
+// of location_frame is set, as that changes the longitude scale
+void AP_L1_Control::_update_segment(const struct Location &prev_WP, const struct Location &next_WP)
+{
+	float lng_scale = location_frame.lng_scale();
+	if (_have_segment &&
+		_segment.prev_lat == prev_WP.lat && _segment.prev_lng == prev_WP.lng &&
+		_segment.next_lat == next_WP.lat && _segment.next_lng == next_WP.lng &&
+		_segment.lng_scale == lng_scale) {
+		return;
+	}
+	_segment.prev_lat = prev_WP.lat;
+	_segment.prev_lng = prev_WP.lng;
+	_segment.next_lat = next_WP.lat;
+	_segment.next_lng = next_WP.lng;
+	_segment.lng_scale = lng_scale;
+
+	// Calculate the NE position of WP B relative to WP A
+	Vector2f AB = location_frame.diff(prev_WP, next_WP);
+	_segment.too_short = AB.length() < 1.0e-6f;
+	if (!_segment.too_short) {
+		AB.normalize();
+		_segment.AB = AB;
+		_segment.AB_bearing = fast_atan2(AB.y, AB.x);
+	}
+	_have_segment = true;
+}
+
 // update L1 control for waypoint navigation
-// this function costs about 3.5 milliseconds on a AVR2560
+// the geometry of the segment is only calculated when it changes, so
+// each update only calculates the terms relative to the aircraft
 void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct Location &next_WP)
 {
 
@@ -104,18 +142,21 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
     // update the position for lag. This helps especially for rovers
     // where waypoints may be very close together
     Vector2f lag_offset = _groundspeed_vector * _ahrs.get_position_lag();
-    location_offset(_current_loc, lag_offset.x, lag_offset.y);
+    location_frame.offset(_current_loc, lag_offset.x, lag_offset.y);
 
 	// update _target_bearing_cd
-	_target_bearing_cd = get_bearing_cd(_current_loc, next_WP);
+	Vector2f air_B = location_frame.diff(_current_loc, next_WP);
+	_target_bearing_cd = bearing_cd(air_B);
 	
 	//Calculate groundspeed
 	float groundSpeed = _groundspeed_vector.length();
     if (groundSpeed < 0.1f) {
         // use a small ground speed vector in the right direction,
         // allowing us to use the compass heading at zero GPS velocity
+        float sin_yaw, cos_yaw;
+        fast_sincos(_ahrs.yaw, sin_yaw, cos_yaw);
         groundSpeed = 0.1f;
-        _groundspeed_vector = Vector2f(cosf(_ahrs.yaw), sinf(_ahrs.yaw)) * groundSpeed;
+        _groundspeed_vector = Vector2f(cos_yaw, sin_yaw) * groundSpeed;
     }
 
 	// Calculate time varying control parameters
@@ -123,18 +164,21 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 	// 0.3183099 = 1/1/pipi
 	_L1_dist = 0.3183099f * _L1_damping * _L1_period * groundSpeed;
 	
-	// Calculate the NE position of WP B relative to WP A
-    Vector2f AB = location_diff(prev_WP, next_WP);
+	// Get the unit vector from WP A to WP B and its bearing
+	_update_segment(prev_WP, next_WP);
+	Vector2f AB = _segment.AB;
+	float AB_bearing = _segment.AB_bearing;
 	
 	// Check for AB zero length and track directly to the destination
 	// if too small
-	if (AB.length() < 1.0e-6f) {
-		AB = location_diff(_current_loc, next_WP);
+	if (_segment.too_short) {
+		AB = air_B;
+		AB.normalize();
+		AB_bearing = fast_atan2(AB.y, AB.x);
 	}
-	AB.normalize();
 
 	// Calculate the NE position of the aircraft relative to WP A
-    Vector2f A_air = location_diff(prev_WP, _current_loc);
+    Vector2f A_air = location_frame.diff(prev_WP, _current_loc);
 
 	// calculate distance to target track, for reporting
 	_crosstrack_error = AB % A_air;
@@ -150,28 +194,30 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 		Vector2f A_air_unit = (A_air).normalized(); // Unit vector from WP A to aircraft
 		xtrackVel = _groundspeed_vector % (-A_air_unit); // Velocity across line
 		ltrackVel = _groundspeed_vector * (-A_air_unit); // Velocity along line
-		Nu = atan2f(xtrackVel,ltrackVel);
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
+		Nu = fast_atan2(xtrackVel,ltrackVel);
+		_nav_bearing = fast_atan2(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
 		
 	} else { //Calc Nu to fly along AB line
 			
 		//Calculate Nu2 angle (angle of velocity vector relative to line connecting waypoints)
 		xtrackVel = _groundspeed_vector % AB; // Velocity cross track
 		ltrackVel = _groundspeed_vector * AB; // Velocity along track
-		float Nu2 = atan2f(xtrackVel,ltrackVel);
+		float Nu2 = fast_atan2(xtrackVel,ltrackVel);
 		//Calculate Nu1 angle (Angle to L1 reference point)
 		float xtrackErr = A_air % AB;
 		float sine_Nu1 = xtrackErr/max(_L1_dist, 0.1f);
 		//Limit sine of Nu1 to provide a controlled track capture angle of 45 deg
 		sine_Nu1 = constrain_float(sine_Nu1, -0.7071f, 0.7071f);
-		float Nu1 = asinf(sine_Nu1);
+		float Nu1 = fast_atan2(sine_Nu1, safe_sqrt(1 - sq(sine_Nu1))); // asin of sine_Nu1
 		Nu = Nu1 + Nu2;
-		_nav_bearing = atan2f(AB.y, AB.x) + Nu1; // bearing (radians) from AC to L1 point		
+		_nav_bearing = AB_bearing + Nu1; // bearing (radians) from AC to L1 point		
 	}	
 			
 	//Limit Nu to +-pi
 	Nu = constrain_float(Nu, -1.5708f, +1.5708f);
-	_latAccDem = K_L1 * groundSpeed * groundSpeed / _L1_dist * sinf(Nu);
+	float sin_Nu, cos_Nu;
+	fast_sincos(Nu, sin_Nu, cos_Nu);
+	_latAccDem = K_L1 * groundSpeed * groundSpeed / _L1_dist * sin_Nu;
 	
 	// Waypoint capture status is always false during waypoint following
 	_WPcircle = false;
@@ -204,35 +250,39 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
     // update the position for lag. This helps especially for rovers
     // where waypoints may be very close together
     Vector2f lag_offset = _groundspeed_vector * _ahrs.get_position_lag();
-    location_offset(_current_loc, lag_offset.x, lag_offset.y);
+    location_frame.offset(_current_loc, lag_offset.x, lag_offset.y);
 
 	//Calculate groundspeed
 	float groundSpeed = max(_groundspeed_vector.length() , 1.0f);
 
 
-	// update _target_bearing_cd
-	_target_bearing_cd = get_bearing_cd(_current_loc, center_WP);
-
-
 	// Calculate time varying control parameters
 	// Calculate the L1 length required for specified period
 	// 0.3183099 = 1/pi
 	_L1_dist = 0.3183099f * _L1_damping * _L1_period * groundSpeed;
 
 	//Calculate the NE position of the aircraft relative to WP A
-    Vector2f A_air = location_diff(center_WP, _current_loc);
+    Vector2f A_air = location_frame.diff(center_WP, _current_loc);
+
+	// update _target_bearing_cd
+	_target_bearing_cd = bearing_cd(-A_air);
 	
     //Calculate the unit vector from WP A to aircraft
     Vector2f A_air_unit = A_air.normalized();
 
+	// bearing (radians) from AC to L1 point
+	_nav_bearing = fast_atan2(-A_air_unit.y , -A_air_unit.x);
+
 	//Calculate Nu to capture center_WP
 	float xtrackVelCap = A_air_unit % _groundspeed_vector; // Velocity across line - perpendicular to radial inbound to WP
 	float ltrackVelCap = - (_groundspeed_vector * A_air_unit); // Velocity along line - radial inbound to WP
-	float Nu = atan2f(xtrackVelCap,ltrackVelCap);
+	float Nu = fast_atan2(xtrackVelCap,ltrackVelCap);
 	Nu = constrain_float(Nu, -1.5708f, +1.5708f); //Limit Nu to +- Pi/2
 
 	//Calculate lat accln demand to capture center_WP (use L1 guidance law)
-	float latAccDemCap = K_L1 * groundSpeed * groundSpeed / _L1_dist * sinf(Nu);
+	float sin_Nu, cos_Nu;
+	fast_sincos(Nu, sin_Nu, cos_Nu);
+	float latAccDemCap = K_L1 * groundSpeed * groundSpeed / _L1_dist * sin_Nu;
 	
 	//Calculate radial position and velocity errors
 	float xtrackVelCirc = -ltrackVelCap; // Radial outbound velocity - reuse previous radial inbound velocity
@@ -264,12 +314,10 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
 		_latAccDem = latAccDemCap;
 		_WPcircle = false;
 		_bearing_error = Nu; // angle between demanded and achieved velocity vector, +ve to left of track
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
 	} else {
 		_latAccDem = latAccDemCirc;
 		_WPcircle = true;
 		_bearing_error = 0.0f; // bearing error (radians), +ve to left of track
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians)from AC to L1 point
 	}
 }
 
@@ -310,7 +358,9 @@ void AP_L1_Control::update_heading_hold(int32_t navigation_heading_cd)
 
 	// Limit Nu to +-pi
 	Nu = constrain_float(Nu, -1.5708f, +1.5708f);
-	_latAccDem = 2.0f*sinf(Nu)*VomegaA;
+	float sin_Nu, cos_Nu;
+	fast_sincos(Nu, sin_Nu, cos_Nu);
+	_latAccDem = 2.0f*sin_Nu*VomegaA;
 }
 
 // update L1 control for level flight on current heading
@@ -24,7 +24,8 @@
 class AP_L1_Control : public AP_Navigation {
 public:
 	AP_L1_Control(AP_AHRS &ahrs) :
-		_ahrs(ahrs)
+		_ahrs(ahrs),
+		_have_segment(false)
 		{
 			AP_Param::setup_object_defaults(this, var_info);
 		}
@@ -94,6 +95,21 @@ private:
 	//Calculate the maximum of two floating point numbers
 	float _maxf(const float &num1, const float &num2) const;
 
+	// geometry of the waypoint segment from the last update_waypoint(),
+	// which is only recalculated when the segment changes
+	struct {
+		int32_t prev_lat, prev_lng;
+		int32_t next_lat, next_lng;
+		float lng_scale;		// location_frame.lng_scale() used
+		Vector2f AB;			// unit vector from WP A to WP B
+		float AB_bearing;		// bearing of AB (radians)
+		bool too_short;			// true if AB is too short to give a direction
+	} _segment;
+	bool _have_segment;
+
+	// recalculate _segment if the segment has changed
+	void _update_segment(const struct Location &prev_WP, const struct Location &next_WP);
+
 };
 
 
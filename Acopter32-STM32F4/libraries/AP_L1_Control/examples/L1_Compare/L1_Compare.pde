@@ -0,0 +1,556 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Compare AP_L1_Control with the implementation it replaced, which
+// recalculated the segment geometry on every update and used the
+// libm trigonometric functions. It is kept here as L1_Reference.
+//
+// Both controllers are given the same trajectory, and the difference
+// in each of their outputs is checked against a tolerance which
+// covers the error of fast_atan2() and fast_sincos(). The trajectory
+// is then run through AP_L1_Control a second time, which must give
+// exactly the same outputs. The mean time of an update of each
+// controller is also printed.
+//
+// The built in trajectory is a plane flying a mission of waypoints
+// and a loiter, in a cross wind, steered by the reference controller.
+// On SITL and Linux a trajectory can be saved to the file named by
+// L1_RECORD, and a recorded trajectory is used instead of the built in
+// one when L1_TRAJECTORY names a file. Each line of the file is
+//
+//   mode,lat,lng,ground_speed_cm,ground_course_cd,prev_lat,prev_lng,next_lat,next_lng
+//
+// with mode 0 for update_waypoint() from prev to next, and 1 for
+// update_loiter() around next.
+//
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Baro.h>
+#include <GCS_MAVLink.h>
+#include <Filter.h>
+#include <SITL.h>
+#include <AP_Buffer.h>
+#include <AP_Notify.h>
+#include <AP_Vehicle.h>
+#include <DataFlash.h>
+#include <AP_Navigation.h>
+#include <AP_L1_Control.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <stdio.h>
+#include <stdlib.h>
+#define COMPARE_FILES 1
+#else
+#define COMPARE_FILES 0
+#endif
+
+// the built in flight: nav update period, airspeed and wind, and the
+// radius at which a waypoint is reached
+#define SIM_DT              0.1f
+#define SIM_AIRSPEED        20.0f
+#define SIM_WIND_NORTH      4.0f
+#define SIM_WIND_EAST       -3.0f
+#define SIM_WP_RADIUS       30.0f
+#define SIM_LOITER_RADIUS   60.0f
+#define SIM_LOITER_STEPS    1500
+
+// largest differences allowed between the two controllers
+#define TOL_LAT_ACC         0.01f   // m/s/s
+#define TOL_BEARING_CD      2       // centi-degrees
+
+/*
+  the AP_L1_Control implementation of update_waypoint() and
+  update_loiter() before the segment geometry was cached, with the
+  default parameters
+ */
+class L1_Reference
+{
+public:
+    L1_Reference(AP_AHRS &ahrs) :
+        latAccDem(0), L1_dist(0), WPcircle(false), nav_bearing(0),
+        bearing_error(0), crosstrack_error(0), target_bearing_cd(0),
+        _ahrs(ahrs), _L1_period(25), _L1_damping(0.75f) {}
+
+    void update_waypoint(const struct Location &prev_WP, const struct Location &next_WP);
+    void update_loiter(const struct Location &center_WP, float radius, int8_t loiter_direction);
+
+    float latAccDem;
+    float L1_dist;
+    bool WPcircle;
+    float nav_bearing;
+    float bearing_error;
+    float crosstrack_error;
+    int32_t target_bearing_cd;
+
+private:
+    AP_AHRS &_ahrs;
+    float _L1_period;
+    float _L1_damping;
+};
+
+void L1_Reference::update_waypoint(const struct Location &prev_WP, const struct Location &next_WP)
+{
+    struct Location current_loc;
+    float Nu;
+    float xtrackVel;
+    float ltrackVel;
+
+    float K_L1 = 4.0f * _L1_damping * _L1_damping;
+
+    _ahrs.get_position(current_loc);
+    Vector2f groundspeed_vector = _ahrs.groundspeed_vector();
+    Vector2f lag_offset = groundspeed_vector * _ahrs.get_position_lag();
+    location_frame.offset(current_loc, lag_offset.x, lag_offset.y);
+
+    target_bearing_cd = location_frame.bearing_cd(current_loc, next_WP);
+
+    float groundSpeed = groundspeed_vector.length();
+    if (groundSpeed < 0.1f) {
+        groundSpeed = 0.1f;
+        groundspeed_vector = Vector2f(cosf(_ahrs.yaw), sinf(_ahrs.yaw)) * groundSpeed;
+    }
+
+    L1_dist = 0.3183099f * _L1_damping * _L1_period * groundSpeed;
+
+    Vector2f AB = location_frame.diff(prev_WP, next_WP);
+    if (AB.length() < 1.0e-6f) {
+        AB = location_frame.diff(current_loc, next_WP);
+    }
+    AB.normalize();
+
+    Vector2f A_air = location_frame.diff(prev_WP, current_loc);
+    crosstrack_error = AB % A_air;
+
+    float WP_A_dist = A_air.length();
+    float alongTrackDist = A_air * AB;
+    if (WP_A_dist > L1_dist && alongTrackDist/max(WP_A_dist, 1.0f) < -0.7071f) {
+        Vector2f A_air_unit = (A_air).normalized();
+        xtrackVel = groundspeed_vector % (-A_air_unit);
+        ltrackVel = groundspeed_vector * (-A_air_unit);
+        Nu = atan2f(xtrackVel,ltrackVel);
+        nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x);
+    } else {
+        xtrackVel = groundspeed_vector % AB;
+        ltrackVel = groundspeed_vector * AB;
+        float Nu2 = atan2f(xtrackVel,ltrackVel);
+        float xtrackErr = A_air % AB;
+        float sine_Nu1 = xtrackErr/max(L1_dist, 0.1f);
+        sine_Nu1 = constrain_float(sine_Nu1, -0.7071f, 0.7071f);
+        float Nu1 = asinf(sine_Nu1);
+        Nu = Nu1 + Nu2;
+        nav_bearing = atan2f(AB.y, AB.x) + Nu1;
+    }
+
+    Nu = constrain_float(Nu, -1.5708f, +1.5708f);
+    latAccDem = K_L1 * groundSpeed * groundSpeed / L1_dist * sinf(Nu);
+    WPcircle = false;
+    bearing_error = Nu;
+}
+
+void L1_Reference::update_loiter(const struct Location &center_WP, float radius, int8_t loiter_direction)
+{
+    struct Location current_loc;
+
+    radius *= sq(_ahrs.get_EAS2TAS());
+
+    float omega = (6.2832f / _L1_period);
+    float Kx = omega * omega;
+    float Kv = 2.0f * _L1_damping * omega;
+    float K_L1 = 4.0f * _L1_damping * _L1_damping;
+
+    _ahrs.get_position(current_loc);
+    Vector2f groundspeed_vector = _ahrs.groundspeed_vector();
+    Vector2f lag_offset = groundspeed_vector * _ahrs.get_position_lag();
+    location_frame.offset(current_loc, lag_offset.x, lag_offset.y);
+
+    float groundSpeed = max(groundspeed_vector.length() , 1.0f);
+
+    target_bearing_cd = location_frame.bearing_cd(current_loc, center_WP);
+
+    L1_dist = 0.3183099f * _L1_damping * _L1_period * groundSpeed;
+
+    Vector2f A_air = location_frame.diff(center_WP, current_loc);
+    Vector2f A_air_unit = A_air.normalized();
+
+    float xtrackVelCap = A_air_unit % groundspeed_vector;
+    float ltrackVelCap = - (groundspeed_vector * A_air_unit);
+    float Nu = atan2f(xtrackVelCap,ltrackVelCap);
+    Nu = constrain_float(Nu, -1.5708f, +1.5708f);
+
+    float latAccDemCap = K_L1 * groundSpeed * groundSpeed / L1_dist * sinf(Nu);
+
+    float xtrackVelCirc = -ltrackVelCap;
+    float xtrackErrCirc = A_air.length() - radius;
+    crosstrack_error = xtrackErrCirc;
+
+    float latAccDemCircPD = (xtrackErrCirc * Kx + xtrackVelCirc * Kv);
+    float velTangent = xtrackVelCap * float(loiter_direction);
+    if ( velTangent < 0.0f ) {
+        latAccDemCircPD =  max(latAccDemCircPD, 0.0f);
+    }
+    float latAccDemCircCtr = velTangent * velTangent / max((0.5f * radius), (radius + xtrackErrCirc));
+    float latAccDemCirc = loiter_direction * (latAccDemCircPD + latAccDemCircCtr);
+
+    if ((latAccDemCap < latAccDemCirc && loiter_direction > 0 && xtrackErrCirc > 0.0f) | (latAccDemCap > latAccDemCirc && loiter_direction < 0 && xtrackErrCirc > 0.0f)) {
+        latAccDem = latAccDemCap;
+        WPcircle = false;
+        bearing_error = Nu;
+        nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x);
+    } else {
+        latAccDem = latAccDemCirc;
+        WPcircle = true;
+        bearing_error = 0.0f;
+        nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x);
+    }
+}
+
+// one step of a trajectory
+struct sample {
+    uint8_t mode;           // 0 waypoint, 1 loiter
+    int32_t lat, lng;
+    uint32_t ground_speed_cm;
+    int32_t ground_course_cd;
+    struct Location prev_WP, next_WP;
+};
+
+// the outputs of a controller for one step
+struct outputs {
+    float lat_acc;
+    int32_t nav_bearing_cd;
+    int32_t bearing_error_cd;
+    int32_t target_bearing_cd;
+    float crosstrack_error;
+    bool wp_circle;
+};
+
+class CompareINS : public AP_InertialSensor_HIL
+{
+public:
+    float get_temperature(void) const { return 0; }
+};
+
+CompareINS ins;
+AP_GPS_HIL g_gps_driver;
+GPS *g_gps = &g_gps_driver;
+AP_AHRS_HIL ahrs(&ins, g_gps);
+
+L1_Reference l1_ref(ahrs);
+
+#if COMPARE_FILES
+static FILE *trajectory_file;
+static FILE *record_file;
+#endif
+
+// the mission of the built in flight, from home
+static const int16_t mission_ne[][2] = {
+    { 0, 0 }, { 800, 0 }, { 800, 600 }, { -200, 900 }, { -300, -400 }, { 400, -150 }
+};
+#define MISSION_LEN (sizeof(mission_ne)/sizeof(mission_ne[0]))
+
+// state of the built in flight
+static struct {
+    Vector2f pos;           // meters from home
+    float heading;          // radians
+    uint8_t wp;             // index of the next waypoint
+    uint16_t loiter_steps;
+} sim;
+
+static struct Location home;
+
+static struct Location mission_location(uint8_t i)
+{
+    struct Location loc = home;
+    location_offset(loc, mission_ne[i][0], mission_ne[i][1]);
+    return loc;
+}
+
+/*
+  get the next step of the built in flight, moving the plane by the
+  lateral acceleration of the reference controller in the last step
+ */
+static bool sim_next(struct sample &s, float lat_acc)
+{
+    if (sim.wp >= MISSION_LEN) {
+        if (sim.loiter_steps >= SIM_LOITER_STEPS) {
+            return false;
+        }
+        sim.loiter_steps++;
+    }
+
+    sim.heading = wrap_PI(sim.heading + lat_acc / SIM_AIRSPEED * SIM_DT);
+    Vector2f ground_vel(SIM_AIRSPEED * cosf(sim.heading) + SIM_WIND_NORTH,
+                        SIM_AIRSPEED * sinf(sim.heading) + SIM_WIND_EAST);
+    sim.pos += ground_vel * SIM_DT;
+
+    struct Location loc = home;
+    location_offset(loc, sim.pos.x, sim.pos.y);
+    s.lat = loc.lat;
+    s.lng = loc.lng;
+    s.ground_speed_cm = ground_vel.length() * 100;
+    s.ground_course_cd = wrap_360_cd(degrees(atan2f(ground_vel.y, ground_vel.x)) * 100);
+
+    if (sim.wp < MISSION_LEN) {
+        s.mode = 0;
+        s.prev_WP = mission_location(sim.wp - 1);
+        s.next_WP = mission_location(sim.wp);
+        if (get_distance(loc, s.next_WP) < SIM_WP_RADIUS) {
+            sim.wp++;
+        }
+    } else {
+        s.mode = 1;
+        s.next_WP = mission_location(MISSION_LEN - 1);
+    }
+    return true;
+}
+
+/*
+  get the next step of the trajectory. Returns false at the end
+ */
+static bool next_sample(struct sample &s, float lat_acc)
+{
+#if COMPARE_FILES
+    if (trajectory_file != NULL) {
+        char line[200];
+        unsigned mode;
+        long v[8];
+        while (fgets(line, sizeof(line), trajectory_file) != NULL) {
+            if (sscanf(line, "%u,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld",
+                       &mode, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) == 9) {
+                s.mode = mode;
+                s.lat = v[0];
+                s.lng = v[1];
+                s.ground_speed_cm = v[2];
+                s.ground_course_cd = v[3];
+                s.prev_WP = home;
+                s.prev_WP.lat = v[4];
+                s.prev_WP.lng = v[5];
+                s.next_WP = home;
+                s.next_WP.lat = v[6];
+                s.next_WP.lng = v[7];
+                return true;
+            }
+        }
+        return false;
+    }
+#endif
+    if (!sim_next(s, lat_acc)) {
+        return false;
+    }
+#if COMPARE_FILES
+    if (record_file != NULL) {
+        fprintf(record_file, "%u,%ld,%ld,%lu,%ld,%ld,%ld,%ld,%ld\n",
+                (unsigned)s.mode, (long)s.lat, (long)s.lng,
+                (unsigned long)s.ground_speed_cm, (long)s.ground_course_cd,
+                (long)s.prev_WP.lat, (long)s.prev_WP.lng,
+                (long)s.next_WP.lat, (long)s.next_WP.lng);
+    }
+#endif
+    return true;
+}
+
+static void set_gps(const struct sample &s)
+{
+    g_gps->setHIL(0, 0, 0, 0, s.ground_speed_cm * 0.01f, s.ground_course_cd * 0.01f, 0, 10);
+    // setHIL() goes through a float, so set the exact values
+    g_gps->latitude = s.lat;
+    g_gps->longitude = s.lng;
+    g_gps->ground_speed_cm = s.ground_speed_cm;
+    g_gps->ground_course_cd = s.ground_course_cd;
+    g_gps->update();
+}
+
+static void run_ref(const struct sample &s, struct outputs &o)
+{
+    if (s.mode == 0) {
+        l1_ref.update_waypoint(s.prev_WP, s.next_WP);
+    } else {
+        l1_ref.update_loiter(s.next_WP, SIM_LOITER_RADIUS, 1);
+    }
+    o.lat_acc = l1_ref.latAccDem;
+    o.nav_bearing_cd = wrap_180_cd(RadiansToCentiDegrees(l1_ref.nav_bearing));
+    o.bearing_error_cd = RadiansToCentiDegrees(l1_ref.bearing_error);
+    o.target_bearing_cd = l1_ref.target_bearing_cd;
+    o.crosstrack_error = l1_ref.crosstrack_error;
+    o.wp_circle = l1_ref.WPcircle;
+}
+
+static void run_l1(AP_L1_Control &l1, const struct sample &s, struct outputs &o)
+{
+    if (s.mode == 0) {
+        l1.update_waypoint(s.prev_WP, s.next_WP);
+    } else {
+        l1.update_loiter(s.next_WP, SIM_LOITER_RADIUS, 1);
+    }
+    o.lat_acc = l1.lateral_acceleration();
+    o.nav_bearing_cd = l1.nav_bearing_cd();
+    o.bearing_error_cd = l1.bearing_error_cd();
+    o.target_bearing_cd = l1.target_bearing_cd();
+    o.crosstrack_error = l1.crosstrack_error();
+    o.wp_circle = l1.reached_loiter_target();
+}
+
+// the difference between two bearings in centi-degrees
+static int32_t bearing_diff_cd(int32_t a, int32_t b)
+{
+    return labs(wrap_180_cd(a - b));
+}
+
+// a checksum of the outputs of the second run
+static uint32_t checksum_add(uint32_t sum, const struct outputs &o)
+{
+    const uint8_t *b = (const uint8_t *)&o;
+    for (uint8_t i=0; i<sizeof(o); i++) {
+        sum = sum * 31 + b[i];
+    }
+    return sum;
+}
+
+/*
+  run a trajectory through the controllers. With compare true the
+  reference controller steers the built in flight and the two are
+  compared, otherwise l1 is run alone, steering the flight, and a
+  checksum of its outputs is returned
+ */
+static uint32_t run_trajectory(AP_L1_Control &l1, bool compare)
+{
+    struct sample s;
+    struct outputs ref, out;
+    float max_lat_acc = 0, max_crosstrack = 0;
+    int32_t max_nav_bearing = 0, max_bearing_error = 0, max_target_bearing = 0;
+    uint16_t wp_circle_mismatch = 0;
+    uint32_t ref_us = 0, l1_us = 0, t0;
+    uint32_t count = 0, sum = 0;
+    float lat_acc = 0;
+
+    memset(&sim, 0, sizeof(sim));
+    sim.wp = 1;
+    sim.heading = radians(90);
+#if COMPARE_FILES
+    if (trajectory_file != NULL) {
+        rewind(trajectory_file);
+    }
+#endif
+
+    while (next_sample(s, lat_acc)) {
+        set_gps(s);
+        count++;
+
+        if (compare) {
+            t0 = hal.scheduler->micros();
+            run_ref(s, ref);
+            ref_us += hal.scheduler->micros() - t0;
+        }
+
+        t0 = hal.scheduler->micros();
+        run_l1(l1, s, out);
+        l1_us += hal.scheduler->micros() - t0;
+
+        if (!compare) {
+            sum = checksum_add(sum, out);
+            lat_acc = out.lat_acc;
+            continue;
+        }
+        lat_acc = ref.lat_acc;
+        max_lat_acc = max(max_lat_acc, fabsf(out.lat_acc - ref.lat_acc));
+        max_crosstrack = max(max_crosstrack, fabsf(out.crosstrack_error - ref.crosstrack_error));
+        max_nav_bearing = max(max_nav_bearing, bearing_diff_cd(out.nav_bearing_cd, ref.nav_bearing_cd));
+        max_bearing_error = max(max_bearing_error, labs(out.bearing_error_cd - ref.bearing_error_cd));
+        max_target_bearing = max(max_target_bearing, bearing_diff_cd(out.target_bearing_cd, ref.target_bearing_cd));
+        if (out.wp_circle != ref.wp_circle) {
+            wp_circle_mismatch++;
+        }
+    }
+
+    if (compare) {
+        bool ok = max_lat_acc <= TOL_LAT_ACC &&
+            max_nav_bearing <= TOL_BEARING_CD &&
+            max_bearing_error <= TOL_BEARING_CD &&
+            max_target_bearing <= TOL_BEARING_CD &&
+            max_crosstrack == 0 &&
+            wp_circle_mismatch == 0;
+        hal.console->printf_P(PSTR("%lu steps\n"), (unsigned long)count);
+        hal.console->printf_P(PSTR("max difference: lat_acc %.6f nav_bearing %ld cd bearing_error %ld cd target_bearing %ld cd crosstrack %.6f loiter %u\n"),
+                              max_lat_acc, (long)max_nav_bearing, (long)max_bearing_error,
+                              (long)max_target_bearing, max_crosstrack, (unsigned)wp_circle_mismatch);
+        hal.console->printf_P(PSTR("update time: reference %.2f us  AP_L1_Control %.2f us\n"),
+                              ref_us / (float)count, l1_us / (float)count);
+        hal.console->printf_P(PSTR("comparison %s\n"), ok ? "PASSED" : "FAILED");
+    }
+    return sum;
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("L1 controller comparison"));
+
+#if COMPARE_FILES
+    const char *fname = getenv("L1_TRAJECTORY");
+    if (fname != NULL) {
+        trajectory_file = fopen(fname, "r");
+        if (trajectory_file == NULL) {
+            hal.console->printf("Unable to open %s\n", fname);
+            exit(1);
+        }
+    }
+    fname = getenv("L1_RECORD");
+    if (fname != NULL && trajectory_file == NULL) {
+        record_file = fopen(fname, "w");
+    }
+#endif
+
+    home.lat = -353632610;
+    home.lng = 1491652300;
+    location_frame.set_origin(home);
+
+    ins.init(AP_InertialSensor::COLD_START,
+             AP_InertialSensor::RATE_100HZ);
+    ahrs.init();
+    g_gps->init(NULL);
+}
+
+void loop(void)
+{
+    // compare with the reference, then run the same trajectory through
+    // two new controllers, which must agree exactly
+    AP_L1_Control l1(ahrs), l1_a(ahrs), l1_b(ahrs);
+    run_trajectory(l1, true);
+#if COMPARE_FILES
+    if (record_file != NULL) {
+        fclose(record_file);
+        record_file = NULL;
+    }
+#endif
+    uint32_t sum_a = run_trajectory(l1_a, false);
+    uint32_t sum_b = run_trajectory(l1_b, false);
+    hal.console->printf_P(PSTR("repeat run %s (checksum %08lx)\n"),
+                          sum_a == sum_b ? "identical" : "DIFFERENT",
+                          (unsigned long)sum_a);
+
+#if COMPARE_FILES
+    exit(0);
+#endif
+    for (;;) {
+        hal.scheduler->delay(1000);
+    }
+}
+
+AP_HAL_MAIN();
@@ -38,6 +38,66 @@ float fast_atan(float v)
     return (v*(1.6867629106f + v2*0.4378497304f)/(1.6867633134f + v2));
 }
 
+float fast_atan2(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+
+    // atan of the ratio of the smaller to the larger, which is between 0 and 1.
+    // Polynomial from Abramowitz and Stegun 4.4.49
+    float z = min(ax, ay) / max(ax, ay);
+    float z2 = z*z;
+    float ret = z*(0.99997726f + z2*(-0.33262347f + z2*(0.19354346f +
+                z2*(-0.11643287f + z2*(0.05265332f + z2*-0.01172120f)))));
+
+    // move to the right octant
+    if (ay > ax) {
+        ret = PI/2 - ret;
+    }
+    if (x < 0) {
+        ret = PI - ret;
+    }
+    if (y < 0) {
+        ret = -ret;
+    }
+    return ret;
+}
+
+void fast_sincos(float angle, float &s, float &c)
+{
+    // reduce to -pi/4 ~ pi/4 and the quadrant. pi/2 is split in two
+    // parts so the reduction is accurate for larger angles
+    float n = floorf(angle * (2/PI) + 0.5f);
+    float r = (angle - n * 1.5707963705062866f) + n * 4.371139000186243e-08f;
+    float r2 = r*r;
+
+    // Taylor series, which are accurate to better than 3.0e-7 in this range
+    float sr = r*(1 + r2*(-1.0f/6 + r2*(1.0f/120 + r2*(-1.0f/5040))));
+    float cr = 1 + r2*(-0.5f + r2*(1.0f/24 + r2*(-1.0f/720 + r2*(1.0f/40320))));
+
+    switch ((int32_t)n & 3) {
+    case 0:
+        s = sr;
+        c = cr;
+        break;
+    case 1:
+        s = cr;
+        c = -sr;
+        break;
+    case 2:
+        s = -sr;
+        c = -cr;
+        break;
+    default:
+        s = -cr;
+        c = sr;
+        break;
+    }
+}
+
 #if ROTATION_COMBINATION_SUPPORT
 // find a rotation that is the combination of two other
 // rotations. This is used to allow us to add an overall board
@@ -18,6 +18,7 @@
 #include "matrix3.h"
 #include "quaternion.h"
 #include "polygon.h"
+#include "kernels.h"
 
 #ifndef PI
  # define PI 3.141592653589793f
@@ -56,6 +57,13 @@ float           safe_sqrt(float v);
 // a faster varient of atan.  accurate to 6 decimal places for values between -1 ~ 1 but then diverges quickly
 float           fast_atan(float v);
 
+// a faster varient of atan2 using a polynomial, with a maximum error of 2.0e-6 radians over the whole circle
+float           fast_atan2(float y, float x);
+
+// sine and cosine of an angle in radians using polynomials, with a maximum error of 5.0e-7
+// for angles between -2*pi ~ 2*pi, growing to 1.0e-6 at +-10*pi
+void            fast_sincos(float angle, float &s, float &c);
+
 #if ROTATION_COMBINATION_SUPPORT
 // find a rotation that is the combination of two other
 // rotations. This is used to allow us to add an overall board
@@ -139,6 +147,8 @@ float pythagorous3(float a, float b, float c);
 #define max(a,b) ((a)>(b)?(a):(b))
 #define min(a,b) ((a)<(b)?(a):(b))
 
+#include "location_frame.h"
+
 
 #endif // AP_MATH_H
 
@@ -0,0 +1,203 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Microbenchmark of the AP_Math kernels against the plain per-vector
+// code they replace, reporting the cost of each operation and the
+// largest difference between the results.
+//
+// Costs are in CPU cycles from the DWT cycle counter on the
+// Cortex-M4 boards, in time stamp counter cycles on x86 and in
+// nanoseconds from micros() elsewhere. Each operation is timed over
+// BENCH_REPEAT calls and the fastest of BENCH_ROUNDS batches is kept,
+// which removes most of the cost of interrupts and the timer itself.
+//
+// On SITL the differences should all be zero. The fused multiply-add
+// of the Cortex-M4 gives differences of the order of 1e-7.
+//
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define BENCH_REPEAT  200
+#define BENCH_ROUNDS  10
+#define NUM_VECTORS   64
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define CYCLE_UNITS "TSC cycles"
+static void cycles_init(void) {}
+static uint32_t cycles(void) { return (uint32_t)__rdtsc(); }
+#elif defined(__ARM_ARCH_7EM__)
+// the DWT cycle counter of the Cortex-M4
+#define DEMCR      (*(volatile uint32_t *)0xE000EDFC)
+#define DWT_CTRL   (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#define CYCLE_UNITS "cycles"
+static void cycles_init(void)
+{
+    DEMCR |= (1UL<<24);
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1;
+}
+static uint32_t cycles(void) { return DWT_CYCCNT; }
+#else
+#define CYCLE_UNITS "ns"
+#define CYCLES_FROM_MICROS 1
+static void cycles_init(void) {}
+static uint32_t cycles(void) { return hal.scheduler->micros() * 1000UL; }
+#endif
+
+/*
+  time BENCH_REPEAT runs of code, keeping the fastest batch, and give
+  the cost of one run in cost
+ */
+#define BENCH(cost, code) do {                              \
+        uint32_t best = 0xFFFFFFFF;                         \
+        for (uint8_t round=0; round<BENCH_ROUNDS; round++) { \
+            uint32_t start = cycles();                      \
+            for (uint16_t rep=0; rep<BENCH_REPEAT; rep++) { \
+                code;                                       \
+            }                                               \
+            best = min(best, cycles() - start);             \
+        }                                                   \
+        cost = best / (float)BENCH_REPEAT;                  \
+    } while (0)
+
+static Vector3f vin[NUM_VECTORS];
+static Vector3f vout_scalar[NUM_VECTORS];
+static Vector3f vout_kernel[NUM_VECTORS];
+
+// keeps the results of the single operations live
+static volatile float sink;
+
+static float random_float(void)
+{
+    return ((random() % 20001) - 10000) * 1.0e-4f;
+}
+
+static float max_diff(const Vector3f *a, const Vector3f *b, uint16_t n)
+{
+    float ret = 0;
+    for (uint16_t i=0; i<n; i++) {
+        ret = max(ret, (a[i] - b[i]).length());
+    }
+    return ret;
+}
+
+static void report(const char *name, float scalar, float kernel, uint16_t n, float diff)
+{
+    hal.console->printf("%-28s %9.1f %9.1f %8.2f %6.2fx   %g\n",
+                        name, scalar, kernel, kernel / n,
+                        kernel > 0 ? scalar / kernel : 0, diff);
+}
+
+// renormalise a DCM matrix as AP_AHRS_DCM does
+static void dcm_normalize(Matrix3f &m)
+{
+    float error = m.a * m.b;
+    Vector3f t0 = m.a - (m.b * (0.5f * error));
+    Vector3f t1 = m.b - (m.a * (0.5f * error));
+    Vector3f t2 = t0 % t1;
+    m.a = t0 * (1.0f / t0.length());
+    m.b = t1 * (1.0f / t1.length());
+    m.c = t2 * (1.0f / t2.length());
+}
+
+/*
+  the batched rotations against a loop of single ones, for n
+  vectors. 12 is the number of columns rotated by the EKF covariance
+  prediction
+ */
+static void bench_rotate_vectors(const Matrix3f &m, uint16_t n)
+{
+    float scalar, kernel;
+    char name[30];
+
+    BENCH(scalar, for (uint16_t i=0; i<n; i++) { vout_scalar[i] = m * vin[i]; });
+    BENCH(kernel, rotate_vectors(m, vin, vout_kernel, n));
+    snprintf(name, sizeof(name), "rotate %u vectors", (unsigned)n);
+    report(name, scalar, kernel, n, max_diff(vout_scalar, vout_kernel, n));
+
+    BENCH(scalar, for (uint16_t i=0; i<n; i++) { vout_scalar[i] = m.mul_transpose(vin[i]); });
+    BENCH(kernel, rotate_vectors_transpose(m, vin, vout_kernel, n));
+    snprintf(name, sizeof(name), "mul_transpose %u vectors", (unsigned)n);
+    report(name, scalar, kernel, n, max_diff(vout_scalar, vout_kernel, n));
+}
+
+static void bench_matrix(const Matrix3f &m)
+{
+    float cost;
+    Vector3f g(0.01f, -0.02f, 0.005f);
+
+    Matrix3f r = m;
+    BENCH(cost, r.rotate(g); sink = r.a.x);
+    report("Matrix3f::rotate", cost, cost, 1, 0);
+
+    r = m;
+    BENCH(cost, dcm_normalize(r); sink = r.c.z);
+    report("DCM normalise", cost, cost, 1, 0);
+
+    Matrix3f p;
+    BENCH(cost, p = r * m; sink = p.b.y);
+    report("Matrix3f * Matrix3f", cost, cost, 1, 0);
+
+    Vector3f v = vin[0];
+    BENCH(cost, v.rotate(ROTATION_ROLL_180_YAW_45); sink = v.x);
+    report("Vector3f::rotate(enum)", cost, cost, 1, 0);
+
+    // the same rotation from its precomputed matrix, as the inertial
+    // sensor drivers apply the board orientation
+    Matrix3f board;
+    board.from_rotation(ROTATION_ROLL_180_YAW_45);
+    v = vin[0];
+    BENCH(cost, v = board * v; sink = v.x);
+    report("board orientation matrix", cost, cost, 1, 0);
+}
+
+void setup(void)
+{
+    hal.console->println("AP_Math kernels benchmark");
+#if AP_MATH_KERNELS_SSE
+    hal.console->println("backend: SSE");
+#elif AP_MATH_KERNELS_NEON
+    hal.console->println("backend: NEON");
+#else
+    hal.console->println("backend: scalar");
+#endif
+#if AP_MATH_KERNELS_FMA
+    hal.console->println("fused multiply-add: yes");
+#endif
+    cycles_init();
+
+    for (uint16_t i=0; i<NUM_VECTORS; i++) {
+        vin[i] = Vector3f(random_float(), random_float(), random_float());
+    }
+}
+
+void loop(void)
+{
+    Matrix3f m;
+    m.from_euler(0.3f, -0.2f, 1.1f);
+
+    hal.console->printf("%-28s %9s %9s %8s %7s   %s\n",
+                        "operation (" CYCLE_UNITS ")", "scalar", "kernel", "per item", "speedup", "max diff");
+    bench_rotate_vectors(m, 12);
+    bench_rotate_vectors(m, NUM_VECTORS);
+    bench_matrix(m);
+#ifdef CYCLES_FROM_MICROS
+    hal.console->println("timed with micros(), so costs below 1000/BENCH_REPEAT ns are not resolved");
+#endif
+    hal.console->println();
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
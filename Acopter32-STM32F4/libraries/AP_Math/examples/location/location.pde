@@ -247,6 +247,61 @@ static void test_wrap_cd(void)
     hal.console->printf("wrap_cd tests done\n");
 }
 
+/*
+  compare LocationFrame with the location functions for points up to
+  2km north and east of the origin, and time both
+ */
+#define FRAME_TEST_POINTS 100
+
+static void test_frame(void)
+{
+    struct Location origin = {0};
+    origin.lat = -35.362938e7;
+    origin.lng = 149.165085e7;
+
+    struct Location points[FRAME_TEST_POINTS];
+    for (uint8_t i=0; i<FRAME_TEST_POINTS; i++) {
+        points[i] = origin;
+        location_offset(points[i], (int32_t)(i*7919 % 4000) - 2000, (int32_t)(i*104729 % 4000) - 2000);
+    }
+
+    LocationFrame frame;
+    frame.set_origin(origin);
+
+    float max_dist_err = 0, max_brg_err = 0, max_pos_err = 0;
+    for (uint8_t i=1; i<FRAME_TEST_POINTS; i++) {
+        const struct Location &a = points[i-1];
+        const struct Location &b = points[i];
+        max_dist_err = max(max_dist_err, fabsf(frame.distance(a, b) - get_distance(a, b)));
+        max_brg_err = max(max_brg_err, labs(wrap_180_cd(frame.bearing_cd(a, b) - get_bearing_cd(a, b))) * 0.01f);
+        Vector2f ne = frame.position_ne(b) - location_diff(origin, b);
+        max_pos_err = max(max_pos_err, ne.length());
+    }
+    hal.console->printf("frame max errors: distance %.3fm bearing %.2fdeg position %.3fm\n",
+                        max_dist_err, max_brg_err, max_pos_err);
+
+    // consecutive points are often further apart in latitude than the
+    // range over which longitude_scale() reuses its last result, as
+    // the waypoints of a mission can be
+    volatile float sink = 0;
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint8_t i=1; i<FRAME_TEST_POINTS; i++) {
+        sink += get_distance(points[i-1], points[i]);
+        sink += get_bearing_cd(points[i-1], points[i]);
+        sink += location_diff(points[i-1], points[i]).x;
+    }
+    uint32_t t1 = hal.scheduler->micros();
+    for (uint8_t i=1; i<FRAME_TEST_POINTS; i++) {
+        sink += frame.distance(points[i-1], points[i]);
+        sink += frame.bearing_cd(points[i-1], points[i]);
+        sink += frame.diff(points[i-1], points[i]).x;
+    }
+    uint32_t t2 = hal.scheduler->micros();
+    hal.console->printf("distance, bearing and diff of %u pairs: location %lu usec frame %lu usec\n",
+                        (unsigned)(FRAME_TEST_POINTS-1),
+                        (unsigned long)(t1 - t0), (unsigned long)(t2 - t1));
+}
+
 /*
  *  polygon tests
  */
@@ -256,6 +311,7 @@ void setup(void)
     test_offset();
     test_accuracy();
     test_wrap_cd();
+    test_frame();
 }
 
 void loop(void){}
@@ -61,6 +61,48 @@ static const struct {
 
 #define ARRAY_LENGTH(x) (sizeof((x))/sizeof((x)[0]))
 
+/*
+ *  a large fence for the indexed tests: a wavy outline around the OBC
+ *  area, about 1km across, with the last point the same as the first
+ */
+#if CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2
+#define BIG_POINTS 60
+#else
+#define BIG_POINTS 400
+#endif
+#define BIG_TESTS  2000
+
+static Vector2l big_boundary[BIG_POINTS+1];
+static PolygonIndex obc_index;
+static PolygonIndex big_index;
+static uint16_t obc_refs[ARRAY_LENGTH(OBC_boundary) * POLYGON_INDEX_REFS_PER_EDGE];
+static uint16_t big_refs[BIG_POINTS * POLYGON_INDEX_REFS_PER_EDGE];
+
+static void make_big_boundary(void)
+{
+    const Vector2l centre(-265900000, 1518500000);
+    float lng_scale = cosf(ToRad(centre.x * 1.0e-7f));
+    for (unsigned i=0; i<BIG_POINTS; i++) {
+        float theta = 2 * PI * i / BIG_POINTS;
+        float r = 45000 * (1 + 0.3f * sinf(7*theta) + 0.1f * sinf(31*theta));
+        big_boundary[i] = Vector2l(centre.x + r * cosf(theta),
+                                   centre.y + r * sinf(theta) / lng_scale);
+    }
+    big_boundary[BIG_POINTS] = big_boundary[0];
+}
+
+// repeatable pseudo-random test points around the large fence
+static uint32_t rand_state = 1;
+
+static Vector2l random_point(void)
+{
+    rand_state = rand_state * 1103515245UL + 12345;
+    int32_t dx = (int32_t)((rand_state >> 8) % 130000) - 65000;
+    rand_state = rand_state * 1103515245UL + 12345;
+    int32_t dy = (int32_t)((rand_state >> 8) % 150000) - 75000;
+    return Vector2l(-265900000 + dx, 1518500000 + dy);
+}
+
 /*
  *  polygon tests
  */
@@ -111,6 +153,87 @@ void setup(void)
     }
     hal.console->printf("%u usec/call\n", (unsigned)((hal.scheduler->micros() 
                     - start_time)/(count*ARRAY_LENGTH(test_points))));
+
+    hal.console->println("Indexed tests:");
+    obc_index.set_refs(obc_refs, ARRAY_LENGTH(obc_refs));
+    if (!obc_index.build(OBC_boundary, ARRAY_LENGTH(OBC_boundary))) {
+        hal.console->println("OBC index build failed");
+        all_passed = false;
+    }
+    for (i=0; i<ARRAY_LENGTH(test_points); i++) {
+        if (obc_index.outside(test_points[i].point) != test_points[i].outside) {
+            hal.console->printf_P(PSTR("index FAIL at point %u\n"), i);
+            all_passed = false;
+        }
+    }
+
+    make_big_boundary();
+    big_index.set_refs(big_refs, ARRAY_LENGTH(big_refs));
+    start_time = hal.scheduler->micros();
+    if (!big_index.build(big_boundary, ARRAY_LENGTH(big_boundary))) {
+        hal.console->println("large index build failed");
+        all_passed = false;
+    }
+    hal.console->printf_P(PSTR("%u points, index built in %lu usec\n"),
+                          (unsigned)ARRAY_LENGTH(big_boundary),
+                          (unsigned long)(hal.scheduler->micros() - start_time));
+
+    // the index must give the same answers as the plain tests
+    unsigned inside = 0, mismatch = 0, distance_mismatch = 0;
+    float lng_scale = cosf(ToRad(big_boundary[0].x * 1.0e-7f));
+    rand_state = 1;
+    for (count=0; count<BIG_TESTS; count++) {
+        Vector2l p = random_point();
+        bool result = Polygon_outside(p, big_boundary, ARRAY_LENGTH(big_boundary));
+        if (big_index.outside(p) != result) {
+            mismatch++;
+        }
+        if (!result) {
+            inside++;
+        }
+        float d = min(Polygon_distance(p, big_boundary, ARRAY_LENGTH(big_boundary), lng_scale), 100);
+        if (fabsf(big_index.distance(p, 100) - d) > 0.01f) {
+            distance_mismatch++;
+        }
+    }
+    hal.console->printf_P(PSTR("%u of %u points inside, %u outside mismatches, %u distance mismatches\n"),
+                          inside, count, mismatch, distance_mismatch);
+    if (mismatch != 0 || distance_mismatch != 0) {
+        all_passed = false;
+    }
+
+    hal.console->println("Indexed speed test:");
+    uint32_t plain_us, indexed_us;
+    rand_state = 1;
+    start_time = hal.scheduler->micros();
+    for (count=0; count<BIG_TESTS; count++) {
+        inside += Polygon_outside(random_point(), big_boundary, ARRAY_LENGTH(big_boundary));
+    }
+    plain_us = hal.scheduler->micros() - start_time;
+    rand_state = 1;
+    start_time = hal.scheduler->micros();
+    for (count=0; count<BIG_TESTS; count++) {
+        inside += big_index.outside(random_point());
+    }
+    indexed_us = hal.scheduler->micros() - start_time;
+    hal.console->printf_P(PSTR("Polygon_outside %.3f usec/call  indexed %.3f usec/call\n"),
+                          (float)plain_us / count, (float)indexed_us / count);
+
+    rand_state = 1;
+    start_time = hal.scheduler->micros();
+    for (count=0; count<BIG_TESTS; count++) {
+        Polygon_distance(random_point(), big_boundary, ARRAY_LENGTH(big_boundary), lng_scale);
+    }
+    plain_us = hal.scheduler->micros() - start_time;
+    rand_state = 1;
+    start_time = hal.scheduler->micros();
+    for (count=0; count<BIG_TESTS; count++) {
+        big_index.distance(random_point(), 100);
+    }
+    indexed_us = hal.scheduler->micros() - start_time;
+    hal.console->printf_P(PSTR("Polygon_distance %.3f usec/call  indexed (100m) %.3f usec/call\n"),
+                          (float)plain_us / count, (float)indexed_us / count);
+
     hal.console->println(all_passed ? "ALL TESTS PASSED" : "TEST FAILED");
 }
 
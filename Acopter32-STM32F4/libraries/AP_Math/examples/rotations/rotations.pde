@@ -86,6 +86,16 @@ static void test_euler(enum Rotation rotation, float roll, float pitch, float ya
         print_vector(v1);
         print_vector(v2);
     }
+
+    // the precomputed matrix of the rotation should agree too
+    rotmat.from_rotation(rotation);
+    v2 = rotmat * v;
+    diff = (v2 - v1);
+    if (diff.length() > accuracy) {
+        hal.console->printf("rotation matrix %u incorrect\n", (unsigned)rotation);
+        print_vector(v1);
+        print_vector(v2);
+    }
 }
 
 static void test_eulers(void)
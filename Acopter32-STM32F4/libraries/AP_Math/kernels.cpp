@@ -0,0 +1,97 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * kernels.cpp
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Math.h"
+
+#if AP_MATH_KERNELS_SSE
+#include <xmmintrin.h>
+
+typedef __m128 vec4;
+#define vec4_store(p, v)  _mm_storeu_ps(p, v)
+#define vec4_set1(x)      _mm_set1_ps(x)
+#define vec4_set(x, y, z) _mm_setr_ps(x, y, z, 0)
+#define vec4_add(a, b)    _mm_add_ps(a, b)
+#define vec4_mul(a, b)    _mm_mul_ps(a, b)
+#define AP_MATH_KERNELS_VEC4 1
+
+#elif AP_MATH_KERNELS_NEON
+#include <arm_neon.h>
+
+typedef float32x4_t vec4;
+#define vec4_store(p, v)  vst1q_f32(p, v)
+#define vec4_set1(x)      vdupq_n_f32(x)
+#define vec4_add(a, b)    vaddq_f32(a, b)
+#define vec4_mul(a, b)    vmulq_f32(a, b)
+#define AP_MATH_KERNELS_VEC4 1
+
+static inline float32x4_t vec4_set(float x, float y, float z)
+{
+    const float v[4] = { x, y, z, 0 };
+    return vld1q_f32(v);
+}
+#endif
+
+#if AP_MATH_KERNELS_VEC4
+/*
+  multiply n vectors by the matrix with columns c0, c1 and c2. Each
+  lane is summed in the same order as Matrix3f::operator*(), so the
+  results are identical
+ */
+static void rotate_columns(vec4 c0, vec4 c1, vec4 c2,
+                           const Vector3f *in, Vector3f *out, uint16_t n)
+{
+    for (uint16_t i=0; i<n; i++) {
+        vec4 r = vec4_add(vec4_add(vec4_mul(c0, vec4_set1(in[i].x)),
+                                   vec4_mul(c1, vec4_set1(in[i].y))),
+                          vec4_mul(c2, vec4_set1(in[i].z)));
+        float v[4];
+        vec4_store(v, r);
+        out[i].x = v[0];
+        out[i].y = v[1];
+        out[i].z = v[2];
+    }
+}
+#endif
+
+void rotate_vectors(const Matrix3f &m, const Vector3f *in, Vector3f *out, uint16_t n)
+{
+#if AP_MATH_KERNELS_VEC4
+    rotate_columns(vec4_set(m.a.x, m.b.x, m.c.x),
+                   vec4_set(m.a.y, m.b.y, m.c.y),
+                   vec4_set(m.a.z, m.b.z, m.c.z),
+                   in, out, n);
+#else
+    for (uint16_t i=0; i<n; i++) {
+        out[i] = m * in[i];
+    }
+#endif
+}
+
+void rotate_vectors_transpose(const Matrix3f &m, const Vector3f *in, Vector3f *out, uint16_t n)
+{
+#if AP_MATH_KERNELS_VEC4
+    rotate_columns(vec4_set(m.a.x, m.a.y, m.a.z),
+                   vec4_set(m.b.x, m.b.y, m.b.z),
+                   vec4_set(m.c.x, m.c.y, m.c.z),
+                   in, out, n);
+#else
+    for (uint16_t i=0; i<n; i++) {
+        out[i] = m.mul_transpose(in[i]);
+    }
+#endif
+}
@@ -0,0 +1,79 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * kernels.h
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  float kernels for the inner loops of the estimators, with a backend
+  for each kind of FPU:
+
+  - SSE on x86 (SITL and Linux builds)
+  - NEON on ARM Linux builds
+  - fused multiply-add on the Cortex-M4F boards. The M4F has no
+    floating point SIMD, but a multiply-add is one instruction which
+    rounds once
+  - plain C everywhere else, including AVR
+
+  The SSE and NEON backends do the same operations in the same order
+  as the plain C code, so SITL and replay results are unchanged. The
+  fused multiply-add results may differ from them in the last bit.
+
+  Define AP_MATH_KERNELS_SIMD to 0 to use the plain C code on all
+  boards.
+ */
+
+#ifndef AP_MATH_KERNELS_H
+#define AP_MATH_KERNELS_H
+
+#ifndef AP_MATH_KERNELS_SIMD
+ # define AP_MATH_KERNELS_SIMD 1
+#endif
+
+#if AP_MATH_KERNELS_SIMD && defined(__SSE__)
+ # define AP_MATH_KERNELS_SSE 1
+#elif AP_MATH_KERNELS_SIMD && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+ # define AP_MATH_KERNELS_NEON 1
+#endif
+
+#if AP_MATH_KERNELS_SIMD && (defined(__FMA__) || \
+    (defined(__ARM_ARCH_7EM__) && defined(__VFP_FP__) && !defined(__SOFTFP__)))
+ # define AP_MATH_KERNELS_FMA 1
+#endif
+
+// a*b + c, as a single instruction on FPUs which have one
+static inline float mul_add(float a, float b, float c)
+{
+#if AP_MATH_KERNELS_FMA
+    return __builtin_fmaf(a, b, c);
+#else
+    return a*b + c;
+#endif
+}
+
+template <typename T>
+static inline T mul_add(T a, T b, T c)
+{
+    return a*b + c;
+}
+
+// out[i] = m * in[i] for n vectors. in and out may be the same array
+void rotate_vectors(const Matrix3f &m, const Vector3f *in, Vector3f *out, uint16_t n);
+
+// out[i] = m.mul_transpose(in[i]) for n vectors. in and out may be
+// the same array
+void rotate_vectors_transpose(const Matrix3f &m, const Vector3f *in, Vector3f *out, uint16_t n);
+
+#endif // AP_MATH_KERNELS_H
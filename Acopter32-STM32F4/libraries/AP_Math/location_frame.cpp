@@ -0,0 +1,97 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * location_frame.cpp
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL.h>
+#include <string.h>
+#include "AP_Math.h"
+
+// scaling factor from 1e-7 degrees to meters at equator, as in location.cpp
+#define LOCATION_SCALING_FACTOR 0.011131884502145034f
+// inverse of LOCATION_SCALING_FACTOR
+#define LOCATION_SCALING_FACTOR_INV 89.83204953368922f
+
+LocationFrame location_frame;
+
+LocationFrame::LocationFrame() :
+    _have_origin(false),
+    _lng_scale(1),
+    _lng_scale_inv(1)
+{
+    memset(&_origin, 0, sizeof(_origin));
+}
+
+void LocationFrame::set_origin(const struct Location &origin)
+{
+    _origin = origin;
+    _lng_scale = cosf(origin.lat * 1.0e-7f * DEG_TO_RAD);
+    // keep the inverse finite at the poles
+    _lng_scale_inv = 1.0f / max(_lng_scale, 0.01f);
+    _have_origin = true;
+}
+
+Vector2f LocationFrame::position_ne(const struct Location &loc) const
+{
+    return Vector2f((loc.lat - _origin.lat) * LOCATION_SCALING_FACTOR,
+                    (loc.lng - _origin.lng) * LOCATION_SCALING_FACTOR * _lng_scale);
+}
+
+Vector3f LocationFrame::position_cm(const struct Location &loc) const
+{
+    return Vector3f((loc.lat - _origin.lat) * LATLON_TO_CM,
+                    (loc.lng - _origin.lng) * LATLON_TO_CM * _lng_scale,
+                    loc.alt);
+}
+
+int32_t LocationFrame::position_cm_lat(const Vector3f &pos) const
+{
+    return _origin.lat + (int32_t)(pos.x / LATLON_TO_CM);
+}
+
+int32_t LocationFrame::position_cm_lng(const Vector3f &pos) const
+{
+    return _origin.lng + (int32_t)(pos.y / LATLON_TO_CM * _lng_scale_inv);
+}
+
+Vector2f LocationFrame::diff(const struct Location &loc1, const struct Location &loc2) const
+{
+    return Vector2f((loc2.lat - loc1.lat) * LOCATION_SCALING_FACTOR,
+                    (loc2.lng - loc1.lng) * LOCATION_SCALING_FACTOR * lng_scale(loc1));
+}
+
+float LocationFrame::distance(const struct Location &loc1, const struct Location &loc2) const
+{
+    return diff(loc1, loc2).length();
+}
+
+int32_t LocationFrame::bearing_cd(const struct Location &loc1, const struct Location &loc2) const
+{
+    Vector2f ne = diff(loc1, loc2);
+    int32_t bearing = atan2f(ne.y, ne.x) * 5729.57795f;
+    if (bearing < 0) bearing += 36000;
+    return bearing;
+}
+
+void LocationFrame::offset(struct Location &loc, float ofs_north, float ofs_east) const
+{
+    if (!_have_origin) {
+        location_offset(loc, ofs_north, ofs_east);
+        return;
+    }
+    loc.lat += (int32_t)(ofs_north * LOCATION_SCALING_FACTOR_INV);
+    loc.lng += (int32_t)(ofs_east * LOCATION_SCALING_FACTOR_INV * _lng_scale_inv);
+}
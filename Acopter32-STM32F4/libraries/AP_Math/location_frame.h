@@ -0,0 +1,95 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * location_frame.h
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  a local north/east frame with its origin at a fixed location,
+  normally home
+
+  The longitude scale is calculated once when the origin is set, so
+  conversions between locations and positions in the frame cost a few
+  multiplies, with no trigonometry. The scale is only right at the
+  latitude of the origin. The error in east-west distances grows with
+  the distance north or south of the origin, by tan(latitude) / 6371
+  for each km: about 0.016% per km at 45 degrees and 0.027% per km at
+  60 degrees. At 45 degrees a location 10km north and 10km east of
+  home is about 16m out east-west. longitude_scale() instead works the
+  scale out again each time the latitude changes by 0.01 degrees
+  (about 1.1km), so its error stays below about 0.02% at mid latitudes
+  however far the vehicle is from home. The frame is for vehicles that
+  stay within a few km of home.
+
+  Until the origin is set the distance and bearing functions fall back
+  to longitude_scale() of the first location, and so give the same
+  results as location_diff(), get_distance() and get_bearing_cd()
+ */
+
+class LocationFrame
+{
+public:
+    LocationFrame();
+
+    // set the origin of the frame
+    void set_origin(const struct Location &origin);
+
+    // true once the origin has been set
+    bool have_origin(void) const { return _have_origin; }
+
+    const struct Location &get_origin(void) const { return _origin; }
+
+    // the longitude scale at the origin, or at loc if the origin is not set
+    float lng_scale(const struct Location &loc) const {
+        return _have_origin ? _lng_scale : longitude_scale(loc);
+    }
+
+    // the longitude scale at the origin, or 0 if the origin is not set
+    float lng_scale(void) const { return _have_origin ? _lng_scale : 0; }
+
+    // position of loc relative to the origin in meters north and east
+    Vector2f position_ne(const struct Location &loc) const;
+
+    // position of loc relative to the origin in cm north and east,
+    // with z the altitude of loc. This is the position vector of
+    // AP_InertialNav and AC_WPNav
+    Vector3f position_cm(const struct Location &loc) const;
+
+    // latitude and longitude of a position in cm from the origin
+    int32_t position_cm_lat(const Vector3f &pos) const;
+    int32_t position_cm_lng(const Vector3f &pos) const;
+
+    // meters north and east from loc1 to loc2
+    Vector2f diff(const struct Location &loc1, const struct Location &loc2) const;
+
+    // distance in meters between two locations
+    float distance(const struct Location &loc1, const struct Location &loc2) const;
+
+    // bearing in centi-degrees from loc1 to loc2
+    int32_t bearing_cd(const struct Location &loc1, const struct Location &loc2) const;
+
+    // move loc by distances in meters north and east
+    void offset(struct Location &loc, float ofs_north, float ofs_east) const;
+
+private:
+    struct Location _origin;
+    bool _have_origin;
+    float _lng_scale;           // cosine of the latitude of the origin
+    float _lng_scale_inv;       // its inverse
+};
+
+// the frame shared by the vehicle code and the navigation libraries,
+// with its origin set by the vehicle when home is set
+extern LocationFrame location_frame;
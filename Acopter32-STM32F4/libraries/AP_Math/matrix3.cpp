@@ -44,6 +44,105 @@ void Matrix3<T>::from_euler(float roll, float pitch, float yaw)
     c.z = cr * cp;
 }
 
+/*
+  the matrices of the standard rotations, a row at a time. Column j
+  is the unit vector along axis j rotated by Vector3f::rotate()
+ */
+#define H HALF_SQRT_2
+static const float rotation_matrices[ROTATION_MAX][9] PROGMEM = {
+    // ROTATION_NONE
+    {  1, 0, 0,   0, 1, 0,   0, 0, 1 },
+    // ROTATION_YAW_45
+    {  H,-H, 0,   H, H, 0,   0, 0, 1 },
+    // ROTATION_YAW_90
+    {  0,-1, 0,   1, 0, 0,   0, 0, 1 },
+    // ROTATION_YAW_135
+    { -H,-H, 0,   H,-H, 0,   0, 0, 1 },
+    // ROTATION_YAW_180
+    { -1, 0, 0,   0,-1, 0,   0, 0, 1 },
+    // ROTATION_YAW_225
+    { -H, H, 0,  -H,-H, 0,   0, 0, 1 },
+    // ROTATION_YAW_270
+    {  0, 1, 0,  -1, 0, 0,   0, 0, 1 },
+    // ROTATION_YAW_315
+    {  H, H, 0,  -H, H, 0,   0, 0, 1 },
+    // ROTATION_ROLL_180
+    {  1, 0, 0,   0,-1, 0,   0, 0,-1 },
+    // ROTATION_ROLL_180_YAW_45
+    {  H, H, 0,   H,-H, 0,   0, 0,-1 },
+    // ROTATION_ROLL_180_YAW_90
+    {  0, 1, 0,   1, 0, 0,   0, 0,-1 },
+    // ROTATION_ROLL_180_YAW_135
+    { -H, H, 0,   H, H, 0,   0, 0,-1 },
+    // ROTATION_PITCH_180
+    { -1, 0, 0,   0, 1, 0,   0, 0,-1 },
+    // ROTATION_ROLL_180_YAW_225
+    { -H,-H, 0,  -H, H, 0,   0, 0,-1 },
+    // ROTATION_ROLL_180_YAW_270
+    {  0,-1, 0,  -1, 0, 0,   0, 0,-1 },
+    // ROTATION_ROLL_180_YAW_315
+    {  H,-H, 0,  -H,-H, 0,   0, 0,-1 },
+    // ROTATION_ROLL_90
+    {  1, 0, 0,   0, 0,-1,   0, 1, 0 },
+    // ROTATION_ROLL_90_YAW_45
+    {  H, 0, H,   H, 0,-H,   0, 1, 0 },
+    // ROTATION_ROLL_90_YAW_90
+    {  0, 0, 1,   1, 0, 0,   0, 1, 0 },
+    // ROTATION_ROLL_90_YAW_135
+    { -H, 0, H,   H, 0, H,   0, 1, 0 },
+    // ROTATION_ROLL_270
+    {  1, 0, 0,   0, 0, 1,   0,-1, 0 },
+    // ROTATION_ROLL_270_YAW_45
+    {  H, 0,-H,   H, 0, H,   0,-1, 0 },
+    // ROTATION_ROLL_270_YAW_90
+    {  0, 0,-1,   1, 0, 0,   0,-1, 0 },
+    // ROTATION_ROLL_270_YAW_135
+    { -H, 0,-H,   H, 0,-H,   0,-1, 0 },
+    // ROTATION_PITCH_90
+    {  0, 0, 1,   0, 1, 0,  -1, 0, 0 },
+    // ROTATION_PITCH_270
+    {  0, 0,-1,   0, 1, 0,   1, 0, 0 },
+    // ROTATION_PITCH_180_YAW_90
+    {  0,-1, 0,  -1, 0, 0,   0, 0,-1 },
+    // ROTATION_PITCH_180_YAW_270
+    {  0, 1, 0,   1, 0, 0,   0, 0,-1 },
+    // ROTATION_ROLL_90_PITCH_90
+    {  0, 1, 0,   0, 0,-1,  -1, 0, 0 },
+    // ROTATION_ROLL_180_PITCH_90
+    {  0, 0,-1,   0,-1, 0,  -1, 0, 0 },
+    // ROTATION_ROLL_270_PITCH_90
+    {  0,-1, 0,   0, 0, 1,  -1, 0, 0 },
+    // ROTATION_ROLL_90_PITCH_180
+    { -1, 0, 0,   0, 0,-1,   0,-1, 0 },
+    // ROTATION_ROLL_270_PITCH_180
+    { -1, 0, 0,   0, 0, 1,   0, 1, 0 },
+    // ROTATION_ROLL_90_PITCH_270
+    {  0,-1, 0,   0, 0,-1,   1, 0, 0 },
+    // ROTATION_ROLL_180_PITCH_270
+    {  0, 0, 1,   0,-1, 0,   1, 0, 0 },
+    // ROTATION_ROLL_270_PITCH_270
+    {  0, 1, 0,   0, 0, 1,   1, 0, 0 },
+    // ROTATION_ROLL_90_PITCH_180_YAW_90
+    {  0, 0, 1,  -1, 0, 0,   0,-1, 0 },
+    // ROTATION_ROLL_90_YAW_270
+    {  0, 0,-1,  -1, 0, 0,   0, 1, 0 }
+};
+#undef H
+
+// create the matrix of a standard rotation
+template <typename T>
+void Matrix3<T>::from_rotation(enum Rotation rotation)
+{
+    if (rotation >= ROTATION_MAX) {
+        identity();
+        return;
+    }
+    const float *m = rotation_matrices[rotation];
+    a = Vector3<T>(pgm_read_float(&m[0]), pgm_read_float(&m[1]), pgm_read_float(&m[2]));
+    b = Vector3<T>(pgm_read_float(&m[3]), pgm_read_float(&m[4]), pgm_read_float(&m[5]));
+    c = Vector3<T>(pgm_read_float(&m[6]), pgm_read_float(&m[7]), pgm_read_float(&m[8]));
+}
+
 // calculate euler angles from a rotation matrix
 // this is based on http://gentlenav.googlecode.com/files/EulerAngles.pdf
 template <typename T>
@@ -66,15 +165,15 @@ template <typename T>
 void Matrix3<T>::rotate(const Vector3<T> &g)
 {
     Matrix3f temp_matrix;
-    temp_matrix.a.x = a.y * g.z - a.z * g.y;
-    temp_matrix.a.y = a.z * g.x - a.x * g.z;
-    temp_matrix.a.z = a.x * g.y - a.y * g.x;
-    temp_matrix.b.x = b.y * g.z - b.z * g.y;
-    temp_matrix.b.y = b.z * g.x - b.x * g.z;
-    temp_matrix.b.z = b.x * g.y - b.y * g.x;
-    temp_matrix.c.x = c.y * g.z - c.z * g.y;
-    temp_matrix.c.y = c.z * g.x - c.x * g.z;
-    temp_matrix.c.z = c.x * g.y - c.y * g.x;
+    temp_matrix.a.x = mul_add(a.y, g.z, -(a.z * g.y));
+    temp_matrix.a.y = mul_add(a.z, g.x, -(a.x * g.z));
+    temp_matrix.a.z = mul_add(a.x, g.y, -(a.y * g.x));
+    temp_matrix.b.x = mul_add(b.y, g.z, -(b.z * g.y));
+    temp_matrix.b.y = mul_add(b.z, g.x, -(b.x * g.z));
+    temp_matrix.b.z = mul_add(b.x, g.y, -(b.y * g.x));
+    temp_matrix.c.x = mul_add(c.y, g.z, -(c.z * g.y));
+    temp_matrix.c.y = mul_add(c.z, g.x, -(c.x * g.z));
+    temp_matrix.c.z = mul_add(c.x, g.y, -(c.y * g.x));
 
     (*this) += temp_matrix;
 }
@@ -102,9 +201,9 @@ void Matrix3<T>::rotateXY(const Vector3<T> &g)
 template <typename T>
 Vector3<T> Matrix3<T>::operator *(const Vector3<T> &v) const
 {
-    return Vector3<T>(a.x * v.x + a.y * v.y + a.z * v.z,
-                      b.x * v.x + b.y * v.y + b.z * v.z,
-                      c.x * v.x + c.y * v.y + c.z * v.z);
+    return Vector3<T>(mul_add(a.z, v.z, mul_add(a.y, v.y, a.x * v.x)),
+                      mul_add(b.z, v.z, mul_add(b.y, v.y, b.x * v.x)),
+                      mul_add(c.z, v.z, mul_add(c.y, v.y, c.x * v.x)));
 }
 
 // multiplication by a vector, extracting only the xy components
@@ -119,9 +218,9 @@ Vector2<T> Matrix3<T>::mulXY(const Vector3<T> &v) const
 template <typename T>
 Vector3<T> Matrix3<T>::mul_transpose(const Vector3<T> &v) const
 {
-    return Vector3<T>(a.x * v.x + b.x * v.y + c.x * v.z,
-                      a.y * v.x + b.y * v.y + c.y * v.z,
-                      a.z * v.x + b.z * v.y + c.z * v.z);
+    return Vector3<T>(mul_add(c.x, v.z, mul_add(b.x, v.y, a.x * v.x)),
+                      mul_add(c.y, v.z, mul_add(b.y, v.y, a.y * v.x)),
+                      mul_add(c.z, v.z, mul_add(b.z, v.y, a.z * v.x)));
 }
 
 // multiplication by another Matrix3<T>
@@ -162,6 +261,7 @@ template void Matrix3<float>::zero(void);
 template void Matrix3<float>::rotate(const Vector3<float> &g);
 template void Matrix3<float>::rotateXY(const Vector3<float> &g);
 template void Matrix3<float>::from_euler(float roll, float pitch, float yaw);
+template void Matrix3<float>::from_rotation(enum Rotation rotation);
 template void Matrix3<float>::to_euler(float *roll, float *pitch, float *yaw);
 template Vector3<float> Matrix3<float>::operator *(const Vector3<float> &v) const;
 template Vector3<float> Matrix3<float>::mul_transpose(const Vector3<float> &v) const;
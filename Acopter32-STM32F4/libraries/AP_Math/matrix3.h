@@ -188,6 +188,10 @@ public:
     // create a rotation matrix from Euler angles
     void        from_euler(float roll, float pitch, float yaw);
 
+    // the matrix of a standard board rotation. Multiplying a vector
+    // by it gives the same result as Vector3f::rotate(rotation)
+    void        from_rotation(enum Rotation rotation);
+
     // create eulers from a rotation matrix
     void        to_euler(float *roll, float *pitch, float *yaw);
 
@@ -18,6 +18,7 @@
  */
 
 #include "AP_Math.h"
+#include <string.h>
 
 /*
  *  The point in polygon algorithm is based on:
@@ -25,6 +26,45 @@
  */
 
 
+/*
+ *  true if the ray from P used by Polygon_outside() crosses the edge
+ *  from Vi to Vj
+ */
+static inline bool Polygon_crosses(const Vector2l &P, const Vector2l &Vi, const Vector2l &Vj)
+{
+    if ((Vi.y > P.y) == (Vj.y > P.y)) {
+        return false;
+    }
+    int32_t dx1, dx2, dy1, dy2;
+    dx1 = P.x - Vi.x;
+    dx2 = Vj.x - Vi.x;
+    dy1 = P.y - Vi.y;
+    dy2 = Vj.y - Vi.y;
+    int8_t dx1s, dx2s, dy1s, dy2s, m1, m2;
+#define sign(x) ((x)<0 ? -1 : 1)
+    dx1s = sign(dx1);
+    dx2s = sign(dx2);
+    dy1s = sign(dy1);
+    dy2s = sign(dy2);
+    m1 = dx1s * dy2s;
+    m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        }
+        return dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1;
+    }
+    if (m1 < m2) {
+        return true;
+    } else if (m1 > m2) {
+        return false;
+    }
+    return dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1;
+}
+
 /*
  *  Polygon_outside(): test for a point in a polygon
  *     Input:   P = a point,
@@ -40,39 +80,8 @@ bool Polygon_outside(const Vector2l &P, const Vector2l *V, unsigned n)
     unsigned i, j;
     bool outside = true;
     for (i = 0, j = n-1; i < n; j = i++) {
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        int32_t dx1, dx2, dy1, dy2;
-        dx1 = P.x - V[i].x;
-        dx2 = V[j].x - V[i].x;
-        dy1 = P.y - V[i].y;
-        dy2 = V[j].y - V[i].y;
-        int8_t dx1s, dx2s, dy1s, dy2s, m1, m2;
-#define sign(x) ((x)<0 ? -1 : 1)
-        dx1s = sign(dx1);
-        dx2s = sign(dx2);
-        dy1s = sign(dy1);
-        dy2s = sign(dy2);
-        m1 = dx1s * dy2s;
-        m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
+        if (Polygon_crosses(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
@@ -89,3 +98,255 @@ bool Polygon_complete(const Vector2l *V, unsigned n)
 {
     return (n >= 4 && V[n-1].x == V[0].x && V[n-1].y == V[0].y);
 }
+
+/*
+ *  square of the distance from P to the edge from A to B, in units of
+ *  1e-7 degrees of latitude
+ */
+static float Polygon_edge_distance_sq(const Vector2l &P, const Vector2l &A, const Vector2l &B, float lng_scale)
+{
+    // work relative to P, with longitude in the units of latitude
+    float ax = A.x - P.x;
+    float ay = (A.y - P.y) * lng_scale;
+    float dx = (B.x - P.x) - ax;
+    float dy = (B.y - P.y) * lng_scale - ay;
+    float len_sq = dx*dx + dy*dy;
+    float t = 0;
+    if (len_sq > 0) {
+        t = constrain_float(-(ax*dx + ay*dy) / len_sq, 0, 1);
+    }
+    float cx = ax + t*dx;
+    float cy = ay + t*dy;
+    return cx*cx + cy*cy;
+}
+
+/*
+ *  Polygon_distance(): distance in meters from P to the nearest edge
+ *  of the polygon V[n], whether P is inside or outside it
+ */
+float Polygon_distance(const Vector2l &P, const Vector2l *V, unsigned n, float lng_scale)
+{
+    unsigned i, j;
+    float best = -1;
+    for (i = 0, j = n-1; i < n; j = i++) {
+        float d = Polygon_edge_distance_sq(P, V[i], V[j], lng_scale);
+        if (best < 0 || d < best) {
+            best = d;
+        }
+    }
+    if (best < 0) {
+        return 0;
+    }
+    return sqrtf(best) * LATLON_TO_M;
+}
+
+PolygonIndex::PolygonIndex() :
+    _refs(NULL),
+    _max_refs(0)
+{
+    clear();
+}
+
+void PolygonIndex::set_refs(uint16_t *refs, uint16_t max_refs)
+{
+    clear();
+    _refs = refs;
+    _max_refs = refs != NULL ? max_refs : 0;
+}
+
+void PolygonIndex::clear(void)
+{
+    _V = NULL;
+    _n = 0;
+    _indexed = false;
+    _lng_scale = 1;
+}
+
+// the grid row holding longitude y, clamped to the grid
+uint8_t PolygonIndex::_row(int32_t y) const
+{
+    if (y <= _min.y) {
+        return 0;
+    }
+    uint32_t r = ((uint32_t)y - (uint32_t)_min.y) / (uint32_t)_cell_y;
+    return r < POLYGON_INDEX_SIZE ? r : POLYGON_INDEX_SIZE-1;
+}
+
+// the grid column holding latitude x, clamped to the grid
+uint8_t PolygonIndex::_column(int32_t x) const
+{
+    if (x <= _min.x) {
+        return 0;
+    }
+    uint32_t c = ((uint32_t)x - (uint32_t)_min.x) / (uint32_t)_cell_x;
+    return c < POLYGON_INDEX_SIZE ? c : POLYGON_INDEX_SIZE-1;
+}
+
+/*
+  build the index. This costs a point in polygon test for each cell,
+  so should not be called in flight more than necessary
+ */
+bool PolygonIndex::build(const Vector2l *V, unsigned n, float lng_scale)
+{
+    clear();
+    if (V == NULL || n < 3 || n > 0xFFFF) {
+        return false;
+    }
+    _V = V;
+    _n = n;
+    _lng_scale = lng_scale > 0 ? lng_scale : cosf(ToRad(V[0].x * 1.0e-7f));
+
+    _min = _max = V[0];
+    for (uint16_t i=1; i<n; i++) {
+        _min.x = min(_min.x, V[i].x);
+        _min.y = min(_min.y, V[i].y);
+        _max.x = max(_max.x, V[i].x);
+        _max.y = max(_max.y, V[i].y);
+    }
+    uint32_t span_x = (uint32_t)_max.x - (uint32_t)_min.x;
+    uint32_t span_y = (uint32_t)_max.y - (uint32_t)_min.y;
+    if (span_x >= 0x7FFF0000UL || span_y >= 0x7FFF0000UL) {
+        // the edge arithmetic would overflow
+        return false;
+    }
+    _cell_x = span_x / POLYGON_INDEX_SIZE + 1;
+    _cell_y = span_y / POLYGON_INDEX_SIZE + 1;
+
+    memset(_cells, CELL_OUTSIDE, sizeof(_cells));
+
+    // list the edges reaching into each row, and mark the cells the
+    // part of the edge within the row passes through
+    uint16_t count = 0;
+    for (uint8_t r=0; r<POLYGON_INDEX_SIZE; r++) {
+        int32_t y0 = _min.y + (int32_t)r * _cell_y;
+        int32_t y1 = y0 + _cell_y - 1;
+        _row_start[r] = count;
+        for (uint16_t i=0; i<n; i++) {
+            const Vector2l &A = V[i];
+            const Vector2l &B = V[i ? i-1 : n-1];
+            int32_t lo = min(A.y, B.y);
+            int32_t hi = max(A.y, B.y);
+            if (hi < y0 || lo > y1) {
+                continue;
+            }
+            if (count == _max_refs) {
+                return false;
+            }
+            _refs[count++] = i;
+
+            int32_t xa, xb;
+            if (A.y == B.y) {
+                xa = A.x;
+                xb = B.x;
+            } else {
+                // latitude of the edge where it enters and leaves
+                // the row
+                int32_t ya = max(lo, y0);
+                int32_t yb = min(hi, y1);
+                int64_t dx = B.x - A.x;
+                int32_t dy = B.y - A.y;
+                xa = A.x + (int32_t)(dx * (ya - A.y) / dy);
+                xb = A.x + (int32_t)(dx * (yb - A.y) / dy);
+            }
+            // widen by one for the rounding of the division
+            uint8_t c_lo = _column(min(xa, xb) - 1);
+            uint8_t c_hi = _column(max(xa, xb) + 1);
+            for (uint8_t c=c_lo; c<=c_hi; c++) {
+                _cells[r][c] = CELL_EDGE;
+            }
+        }
+    }
+    _row_start[POLYGON_INDEX_SIZE] = count;
+
+    // no edge passes through the other cells, so all of each is on
+    // the same side as its centre
+    for (uint8_t r=0; r<POLYGON_INDEX_SIZE; r++) {
+        for (uint8_t c=0; c<POLYGON_INDEX_SIZE; c++) {
+            if (_cells[r][c] == CELL_EDGE) {
+                continue;
+            }
+            Vector2l centre(_min.x + (int32_t)c * _cell_x + _cell_x/2,
+                            _min.y + (int32_t)r * _cell_y + _cell_y/2);
+            _cells[r][c] = Polygon_outside(centre, V, n) ? CELL_OUTSIDE : CELL_INSIDE;
+        }
+    }
+
+    _indexed = true;
+    return true;
+}
+
+bool PolygonIndex::outside(const Vector2l &P) const
+{
+    if (!_indexed) {
+        return _V == NULL || Polygon_outside(P, _V, _n);
+    }
+    // a closed polygon crosses a line outside its bounding box an
+    // even number of times, so Polygon_outside() is true there
+    if (P.x < _min.x || P.x > _max.x || P.y < _min.y || P.y > _max.y) {
+        return true;
+    }
+    uint8_t r = _row(P.y);
+    switch (_cells[r][_column(P.x)]) {
+    case CELL_OUTSIDE:
+        return true;
+    case CELL_INSIDE:
+        return false;
+    }
+
+    // the row holds every edge the ray from P could cross
+    bool outside = true;
+    for (uint16_t k=_row_start[r]; k<_row_start[r+1]; k++) {
+        uint16_t i = _refs[k];
+        if (Polygon_crosses(P, _V[i], _V[i ? i-1 : _n-1])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+float PolygonIndex::distance(const Vector2l &P, float max_distance) const
+{
+    if (!_indexed) {
+        if (_V == NULL) {
+            return max_distance;
+        }
+        return min(Polygon_distance(P, _V, _n, _lng_scale), max_distance);
+    }
+
+    // search the rows outwards from P, until the gap in longitude to
+    // the next rows on both sides is more than the nearest edge found
+    float best_sq = sq(max_distance / LATLON_TO_M);
+    int16_t r0 = _row(P.y);
+    for (int16_t k=0; k<POLYGON_INDEX_SIZE; k++) {
+        bool searched = false;
+        for (int16_t r=r0-k; r<=r0+k; r+=2*k) {
+            if (r >= 0 && r < POLYGON_INDEX_SIZE) {
+                int32_t y0 = _min.y + (int32_t)r * _cell_y;
+                int32_t y1 = y0 + _cell_y - 1;
+                float gap = 0;
+                if (P.y < y0) {
+                    gap = ((uint32_t)y0 - (uint32_t)P.y) * _lng_scale;
+                } else if (P.y > y1) {
+                    gap = ((uint32_t)P.y - (uint32_t)y1) * _lng_scale;
+                }
+                if (sq(gap) < best_sq) {
+                    searched = true;
+                    for (uint16_t j=_row_start[r]; j<_row_start[r+1]; j++) {
+                        uint16_t i = _refs[j];
+                        float d = Polygon_edge_distance_sq(P, _V[i], _V[i ? i-1 : _n-1], _lng_scale);
+                        if (d < best_sq) {
+                            best_sq = d;
+                        }
+                    }
+                }
+            }
+            if (k == 0) {
+                break;
+            }
+        }
+        if (!searched) {
+            break;
+        }
+    }
+    return min(sqrtf(best_sq) * LATLON_TO_M, max_distance);
+}
@@ -20,3 +20,98 @@
 bool        Polygon_outside(const Vector2l &P, const Vector2l *V, unsigned n);
 bool        Polygon_complete(const Vector2l *V, unsigned n);
 
+// distance in meters from P to the nearest edge of the polygon. The
+// points are latitude (x) and longitude (y) in 1e-7 degrees, with
+// lng_scale the cosine of the latitude
+float       Polygon_distance(const Vector2l &P, const Vector2l *V, unsigned n, float lng_scale);
+
+// number of rows and columns in the grid of a PolygonIndex
+#ifdef __AVR__
+ # define POLYGON_INDEX_SIZE     8
+#else
+ # define POLYGON_INDEX_SIZE     16
+#endif
+
+// edge references to give a PolygonIndex for each edge it indexes. An
+// edge is listed in each grid row it reaches into, which for the
+// edges of a fence is a few rows
+#define POLYGON_INDEX_REFS_PER_EDGE 4
+
+/*
+  a uniform grid over the bounding box of a complete polygon, for fast
+  point in polygon tests and distances on polygons with many vertices
+
+  The grid rows are bands of longitude, each holding a list of the
+  edges which reach into the band. Cells which no edge touches are
+  entirely inside or outside the polygon, so a test of a point in one
+  of them is a single lookup. A point in a cell which an edge touches
+  is tested against the edges of its band only, giving the same
+  result as Polygon_outside().
+
+  The index keeps a pointer to the vertices, which must not change
+  without calling build() again. The edge references are kept in
+  memory given to set_refs(), so the caller sizes it for the polygons
+  it has. If the polygon needs more references than that, build()
+  returns false and the tests fall back to the unindexed functions.
+ */
+class PolygonIndex
+{
+public:
+    PolygonIndex();
+
+    // the memory for up to max_refs edge references
+    void set_refs(uint16_t *refs, uint16_t max_refs);
+
+    // index the polygon V[n], with V[n-1]==V[0]. lng_scale is the
+    // cosine of the latitude used for distances, or 0 to use that of
+    // the first vertex. Returns false if the polygon could not be
+    // indexed
+    bool build(const Vector2l *V, unsigned n, float lng_scale = 0);
+
+    // forget the polygon
+    void clear(void);
+
+    // true if P is outside the polygon, as Polygon_outside()
+    bool outside(const Vector2l &P) const;
+
+    // distance in meters from P to the nearest edge, as
+    // Polygon_distance(), searching no further than max_distance. If
+    // there is no edge that close max_distance is returned
+    float distance(const Vector2l &P, float max_distance) const;
+
+    // true if build() was able to index the polygon
+    bool indexed(void) const { return _indexed; }
+
+    // the edge references used by the polygon
+    uint16_t num_refs(void) const { return _indexed ? _row_start[POLYGON_INDEX_SIZE] : 0; }
+
+private:
+    enum cell_state {
+        CELL_OUTSIDE = 0,
+        CELL_INSIDE,
+        CELL_EDGE
+    };
+
+    const Vector2l *_V;
+    uint16_t _n;
+    bool _indexed;
+    float _lng_scale;
+
+    // bounding box, and the size of a cell
+    Vector2l _min;
+    Vector2l _max;
+    int32_t _cell_x;
+    int32_t _cell_y;
+
+    uint8_t _cells[POLYGON_INDEX_SIZE][POLYGON_INDEX_SIZE];
+
+    // the edges of row r are _refs[_row_start[r]] to
+    // _refs[_row_start[r+1]-1]. Edge i runs from V[i-1] to V[i]
+    uint16_t _row_start[POLYGON_INDEX_SIZE+1];
+    uint16_t *_refs;
+    uint16_t _max_refs;
+
+    uint8_t _row(int32_t y) const;
+    uint8_t _column(int32_t x) const;
+};
+
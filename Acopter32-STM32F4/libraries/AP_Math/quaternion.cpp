@@ -20,7 +20,7 @@
 #include "AP_Math.h"
 
 // return the rotation matrix equivalent for this quaternion
-void Quaternion::rotation_matrix(Matrix3f &m)
+void Quaternion::rotation_matrix(Matrix3f &m) const
 {
     float q3q3 = q3 * q3;
     float q3q4 = q3 * q4;
@@ -87,3 +87,91 @@ void Quaternion::to_euler(float *roll, float *pitch, float *yaw)
                       1 - 2.0f*(q3*q3 + q4*q4));
     }
 }
+
+// create a quaternion from a rotation matrix
+void Quaternion::from_rotation_matrix(const Matrix3f &m)
+{
+    float tr = m.a.x + m.b.y + m.c.z;
+    if (tr > 0) {
+        float s = sqrtf(tr + 1.0f) * 2.0f;
+        q1 = 0.25f * s;
+        q2 = (m.c.y - m.b.z) / s;
+        q3 = (m.a.z - m.c.x) / s;
+        q4 = (m.b.x - m.a.y) / s;
+    } else if (m.a.x > m.b.y && m.a.x > m.c.z) {
+        float s = sqrtf(1.0f + m.a.x - m.b.y - m.c.z) * 2.0f;
+        q1 = (m.c.y - m.b.z) / s;
+        q2 = 0.25f * s;
+        q3 = (m.a.y + m.b.x) / s;
+        q4 = (m.a.z + m.c.x) / s;
+    } else if (m.b.y > m.c.z) {
+        float s = sqrtf(1.0f + m.b.y - m.a.x - m.c.z) * 2.0f;
+        q1 = (m.a.z - m.c.x) / s;
+        q2 = (m.a.y + m.b.x) / s;
+        q3 = 0.25f * s;
+        q4 = (m.b.z + m.c.y) / s;
+    } else {
+        float s = sqrtf(1.0f + m.c.z - m.a.x - m.b.y) * 2.0f;
+        q1 = (m.b.x - m.a.y) / s;
+        q2 = (m.a.z + m.c.x) / s;
+        q3 = (m.b.z + m.c.y) / s;
+        q4 = 0.25f * s;
+    }
+}
+
+// create a quaternion from a rotation vector
+void Quaternion::from_axis_angle(const Vector3f &v)
+{
+    float theta = v.length();
+    if (theta == 0.0f) {
+        q1 = 1;
+        q2 = q3 = q4 = 0;
+        return;
+    }
+    float st2 = sinf(theta*0.5f) / theta;
+    q1 = cosf(theta*0.5f);
+    q2 = v.x * st2;
+    q3 = v.y * st2;
+    q4 = v.z * st2;
+}
+
+// rotate by a body frame rotation vector
+void Quaternion::rotate(const Vector3f &v)
+{
+    Quaternion r;
+    r.from_axis_angle(v);
+    *this = *this * r;
+}
+
+// rotate by a small body frame rotation vector. The terms are the
+// series expansions of cos(theta/2) and sin(theta/2)/theta, dropping
+// terms of order theta^4
+void Quaternion::rotate_fast(const Vector3f &v)
+{
+    float theta_sq = v.x*v.x + v.y*v.y + v.z*v.z;
+    float c = 1.0f - theta_sq * (1.0f/8);
+    float s = 0.5f - theta_sq * (1.0f/48);
+    *this = *this * Quaternion(c, v.x*s, v.y*s, v.z*s);
+}
+
+// scale to unit length
+void Quaternion::normalize(void)
+{
+    float quatMag = sqrtf(q1*q1 + q2*q2 + q3*q3 + q4*q4);
+    if (quatMag != 0.0f) {
+        float quatMagInv = 1.0f/quatMag;
+        q1 *= quatMagInv;
+        q2 *= quatMagInv;
+        q3 *= quatMagInv;
+        q4 *= quatMagInv;
+    }
+}
+
+// quaternion product
+Quaternion Quaternion::operator*(const Quaternion &v) const
+{
+    return Quaternion(q1*v.q1 - q2*v.q2 - q3*v.q3 - q4*v.q4,
+                      q1*v.q2 + q2*v.q1 + q3*v.q4 - q4*v.q3,
+                      q1*v.q3 - q2*v.q4 + q3*v.q1 + q4*v.q2,
+                      q1*v.q4 + q2*v.q3 - q3*v.q2 + q4*v.q1);
+}
@@ -50,7 +50,7 @@ public:
     }
 
     // return the rotation matrix equivalent for this quaternion
-    void        rotation_matrix(Matrix3f &m);
+    void        rotation_matrix(Matrix3f &m) const;
 
     // convert a vector from earth to body frame
     void        earth_to_body(Vector3f &v);
@@ -60,5 +60,27 @@ public:
 
     // create eulers from a quaternion
     void        to_euler(float *roll, float *pitch, float *yaw);
+
+    // create a quaternion from a rotation matrix
+    void        from_rotation_matrix(const Matrix3f &m);
+
+    // create a quaternion from a rotation vector, whose direction is
+    // the axis of rotation and whose length is the angle in radians
+    void        from_axis_angle(const Vector3f &v);
+
+    // rotate by a body frame rotation vector, as used when
+    // integrating gyro rates
+    void        rotate(const Vector3f &v);
+
+    // rotate by a small body frame rotation vector, using a series
+    // expansion in place of sin() and cos(). The error is below 1e-6
+    // for rotations of up to 0.1 radians
+    void        rotate_fast(const Vector3f &v);
+
+    // scale to unit length
+    void        normalize(void);
+
+    // quaternion product, giving the rotation this followed by v
+    Quaternion  operator*(const Quaternion &v) const;
 };
 #endif // QUATERNION_H
@@ -12,7 +12,9 @@ cSRCS_$(d) :=
 
 cppSRCS_$(d) :=
 cppSRCS_$(d) += AP_Math.cpp
+cppSRCS_$(d) += kernels.cpp
 cppSRCS_$(d) += location.cpp
+cppSRCS_$(d) += location_frame.cpp
 cppSRCS_$(d) += matrix3.cpp
 cppSRCS_$(d) += polygon.cpp
 cppSRCS_$(d) += quaternion.cpp
@@ -236,7 +236,7 @@ Vector3<T> Vector3<T>::operator %(const Vector3<T> &v) const
 template <typename T>
 T Vector3<T>::operator *(const Vector3<T> &v) const
 {
-    return x*v.x + y*v.y + z*v.z;
+    return mul_add(z, v.z, mul_add(y, v.y, x*v.x));
 }
 
 template <typename T>
@@ -0,0 +1,215 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <AP_HAL.h>
+#include <AP_Math.h>
+#include <string.h>
+#include "AP_MissionStore.h"
+
+extern const AP_HAL::HAL& hal;
+
+#define PAGE_NONE 0xFFFF
+
+// the stored form of an item
+struct PACKED mission_item {
+    uint8_t id;
+    uint8_t options;
+    uint8_t p1;
+    int32_t alt;
+    int32_t lat;
+    int32_t lng;
+};
+
+AP_MissionStore::AP_MissionStore(AP_MissionStore_Backend &backend) :
+    hits(0),
+    misses(0),
+    _backend(backend),
+    _healthy(false),
+    _use_counter(0),
+    _prefetch_page(0),
+    _prefetch_end(0)
+{
+    for (uint8_t i=0; i<AP_MISSIONSTORE_CACHE_PAGES; i++) {
+        _pages[i].number = PAGE_NONE;
+        _pages[i].dirty = false;
+        _pages[i].last_used = 0;
+    }
+}
+
+void AP_MissionStore::init(void)
+{
+    _healthy = _backend.init();
+    for (uint8_t i=0; i<AP_MISSIONSTORE_CACHE_PAGES; i++) {
+        _pages[i].number = PAGE_NONE;
+        _pages[i].dirty = false;
+    }
+    _prefetch_page = _prefetch_end = 0;
+}
+
+uint16_t AP_MissionStore::max_items(void) const
+{
+    uint32_t n = _backend.size() / AP_MISSIONSTORE_ITEM_SIZE;
+    // keep clear of PAGE_NONE, and of the top of the int16 parameters
+    // which hold item numbers
+    return min(n, 0x7FFFU);
+}
+
+/*
+  the number of bytes of storage in a page, which is less than a full
+  page for the last one
+ */
+uint16_t AP_MissionStore::_page_bytes(uint16_t number) const
+{
+    uint16_t first = number * AP_MISSIONSTORE_PAGE_ITEMS;
+    uint16_t count = min(max_items() - first, AP_MISSIONSTORE_PAGE_ITEMS);
+    return count * AP_MISSIONSTORE_ITEM_SIZE;
+}
+
+AP_MissionStore::page *AP_MissionStore::_find_page(uint16_t number)
+{
+    for (uint8_t i=0; i<AP_MISSIONSTORE_CACHE_PAGES; i++) {
+        if (_pages[i].number == number) {
+            return &_pages[i];
+        }
+    }
+    return NULL;
+}
+
+bool AP_MissionStore::_write_page(struct page &p)
+{
+    uint32_t ofs = (uint32_t)p.number * sizeof(p.data);
+    if (!_backend.write(ofs, p.data, _page_bytes(p.number))) {
+        return false;
+    }
+    p.dirty = false;
+    return true;
+}
+
+/*
+  load a page into the least recently used slot, writing back the
+  slot first if it has been modified
+ */
+AP_MissionStore::page *AP_MissionStore::_load_page(uint16_t number)
+{
+    struct page *p = NULL;
+    for (uint8_t i=0; i<AP_MISSIONSTORE_CACHE_PAGES; i++) {
+        if (_pages[i].number == PAGE_NONE) {
+            p = &_pages[i];
+            break;
+        }
+        if (p == NULL || _pages[i].last_used < p->last_used) {
+            p = &_pages[i];
+        }
+    }
+    if (p->number != PAGE_NONE && p->dirty && !_write_page(*p)) {
+        return NULL;
+    }
+
+    p->number = PAGE_NONE;
+    uint32_t ofs = (uint32_t)number * sizeof(p->data);
+    if (!_backend.read(ofs, p->data, _page_bytes(number))) {
+        return NULL;
+    }
+    p->number = number;
+    p->dirty = false;
+    p->last_used = ++_use_counter;
+    return p;
+}
+
+bool AP_MissionStore::read(uint16_t index, struct Location &loc)
+{
+    if (!_healthy || index >= max_items()) {
+        return false;
+    }
+    uint16_t number = index / AP_MISSIONSTORE_PAGE_ITEMS;
+    struct page *p = _find_page(number);
+    if (p != NULL) {
+        hits++;
+        p->last_used = ++_use_counter;
+    } else {
+        misses++;
+        p = _load_page(number);
+        if (p == NULL) {
+            return false;
+        }
+    }
+
+    struct mission_item item;
+    memcpy(&item, &p->data[(index % AP_MISSIONSTORE_PAGE_ITEMS) * AP_MISSIONSTORE_ITEM_SIZE], sizeof(item));
+    loc.id      = item.id;
+    loc.options = item.options;
+    loc.p1      = item.p1;
+    loc.alt     = item.alt;
+    loc.lat     = item.lat;
+    loc.lng     = item.lng;
+    return true;
+}
+
+bool AP_MissionStore::write(uint16_t index, const struct Location &loc)
+{
+    if (!_healthy || index >= max_items()) {
+        return false;
+    }
+    uint16_t number = index / AP_MISSIONSTORE_PAGE_ITEMS;
+    struct page *p = _find_page(number);
+    if (p == NULL) {
+        // read the page first, as the rest of it is kept
+        p = _load_page(number);
+        if (p == NULL) {
+            return false;
+        }
+    }
+
+    struct mission_item item;
+    item.id      = loc.id;
+    item.options = loc.options;
+    item.p1      = loc.p1;
+    item.alt     = loc.alt;
+    item.lat     = loc.lat;
+    item.lng     = loc.lng;
+    memcpy(&p->data[(index % AP_MISSIONSTORE_PAGE_ITEMS) * AP_MISSIONSTORE_ITEM_SIZE], &item, sizeof(item));
+    p->dirty = true;
+    p->last_used = ++_use_counter;
+    return true;
+}
+
+void AP_MissionStore::prefetch(uint16_t index, uint16_t count)
+{
+    if (count == 0 || index >= max_items()) {
+        return;
+    }
+    uint16_t last = min(index + count, max_items()) - 1;
+    _prefetch_page = index / AP_MISSIONSTORE_PAGE_ITEMS;
+    _prefetch_end = last / AP_MISSIONSTORE_PAGE_ITEMS + 1;
+}
+
+void AP_MissionStore::update(void)
+{
+    if (!_healthy) {
+        return;
+    }
+    while (_prefetch_page < _prefetch_end) {
+        uint16_t number = _prefetch_page++;
+        struct page *p = _find_page(number);
+        if (p == NULL) {
+            _load_page(number);
+            return;
+        }
+        // keep it from being evicted by the rest of the prefetch
+        p->last_used = ++_use_counter;
+    }
+    for (uint8_t i=0; i<AP_MISSIONSTORE_CACHE_PAGES; i++) {
+        if (_pages[i].number != PAGE_NONE && _pages[i].dirty) {
+            _write_page(_pages[i]);
+            return;
+        }
+    }
+}
+
+void AP_MissionStore::flush(void)
+{
+    for (uint8_t i=0; i<AP_MISSIONSTORE_CACHE_PAGES; i++) {
+        if (_pages[i].number != PAGE_NONE && _pages[i].dirty) {
+            _write_page(_pages[i]);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __AP_MISSIONSTORE_H__
+#define __AP_MISSIONSTORE_H__
+
+/*
+  storage of mission items, with a small page cache in front of the
+  storage backend
+
+  Items are kept in the same packed 15 byte form as the original
+  EEPROM layout, so missions saved by older firmware are read back
+  unchanged from the EEPROM backend. Items are read and written in
+  pages of AP_MISSIONSTORE_PAGE_ITEMS. Writes are held in the cache
+  and written back when the page is evicted, from update(), or by
+  flush().
+
+  prefetch() queues the items the mission will need next. update(),
+  called from a scheduler task, loads them one page at a time, so the
+  reads by the navigation code are normally served from the cache
+ */
+
+#include <stdint.h>
+#include <AP_HAL.h>
+#include <AP_Common.h>
+
+// size of one item in the storage
+#define AP_MISSIONSTORE_ITEM_SIZE 15
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2
+ # define AP_MISSIONSTORE_PAGE_ITEMS  4
+ # define AP_MISSIONSTORE_CACHE_PAGES 2
+#else
+ # define AP_MISSIONSTORE_PAGE_ITEMS  8
+ # define AP_MISSIONSTORE_CACHE_PAGES 4
+#endif
+
+/*
+  a byte addressed storage area for the items
+ */
+class AP_MissionStore_Backend
+{
+public:
+    // prepare the storage. Returns false if it can't be used
+    virtual bool init(void) = 0;
+
+    // size of the storage in bytes
+    virtual uint32_t size(void) const = 0;
+
+    // read or write n bytes at offset ofs. Storage which has never
+    // been written reads as zero. Returns false on failure
+    virtual bool read(uint32_t ofs, void *buf, uint16_t n) = 0;
+    virtual bool write(uint32_t ofs, const void *buf, uint16_t n) = 0;
+};
+
+class AP_MissionStore
+{
+public:
+    AP_MissionStore(AP_MissionStore_Backend &backend);
+
+    // initialise the backend and empty the cache
+    void init(void);
+
+    // true if the backend initialised
+    bool healthy(void) const { return _healthy; }
+
+    // the number of items which fit in the storage
+    uint16_t max_items(void) const;
+
+    // read or write the item at index. Returns false if the index is
+    // out of range or the storage failed
+    bool read(uint16_t index, struct Location &loc);
+    bool write(uint16_t index, const struct Location &loc);
+
+    // ask for count items from index to be loaded by update()
+    void prefetch(uint16_t index, uint16_t count);
+
+    // load one page of a pending prefetch or, if there is none,
+    // write back one modified page. Call regularly from the main loop
+    void update(void);
+
+    // write back all modified pages
+    void flush(void);
+
+    // cache statistics
+    uint32_t hits;
+    uint32_t misses;
+
+private:
+    AP_MissionStore_Backend &_backend;
+    bool _healthy;
+
+    struct page {
+        uint16_t number;        // page number, PAGE_NONE when empty
+        bool dirty;
+        uint32_t last_used;
+        uint8_t data[AP_MISSIONSTORE_PAGE_ITEMS * AP_MISSIONSTORE_ITEM_SIZE];
+    } _pages[AP_MISSIONSTORE_CACHE_PAGES];
+
+    uint32_t _use_counter;
+
+    // pending prefetch, as a range of pages
+    uint16_t _prefetch_page;
+    uint16_t _prefetch_end;
+
+    struct page *_find_page(uint16_t number);
+    struct page *_load_page(uint16_t number);
+    bool _write_page(struct page &p);
+    uint16_t _page_bytes(uint16_t number) const;
+};
+
+#include "AP_MissionStore_EEPROM.h"
+#include "AP_MissionStore_File.h"
+
+#endif // __AP_MISSIONSTORE_H__
@@ -0,0 +1,24 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <AP_HAL.h>
+#include "AP_MissionStore.h"
+
+extern const AP_HAL::HAL& hal;
+
+bool AP_MissionStore_EEPROM::read(uint32_t ofs, void *buf, uint16_t n)
+{
+    if (ofs + n > _size) {
+        return false;
+    }
+    hal.storage->read_block(buf, _start + ofs, n);
+    return true;
+}
+
+bool AP_MissionStore_EEPROM::write(uint32_t ofs, const void *buf, uint16_t n)
+{
+    if (ofs + n > _size) {
+        return false;
+    }
+    hal.storage->write_block(_start + ofs, buf, n);
+    return true;
+}
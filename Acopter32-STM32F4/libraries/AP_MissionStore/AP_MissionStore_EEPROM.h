@@ -0,0 +1,27 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __AP_MISSIONSTORE_EEPROM_H__
+#define __AP_MISSIONSTORE_EEPROM_H__
+
+/*
+  mission items in an area of the HAL storage (EEPROM)
+ */
+class AP_MissionStore_EEPROM : public AP_MissionStore_Backend
+{
+public:
+    AP_MissionStore_EEPROM(uint16_t start, uint16_t size) :
+        _start(start),
+        _size(size)
+    {}
+
+    bool init(void) { return true; }
+    uint32_t size(void) const { return _size; }
+    bool read(uint32_t ofs, void *buf, uint16_t n);
+    bool write(uint32_t ofs, const void *buf, uint16_t n);
+
+private:
+    uint16_t _start;
+    uint16_t _size;
+};
+
+#endif // __AP_MISSIONSTORE_EEPROM_H__
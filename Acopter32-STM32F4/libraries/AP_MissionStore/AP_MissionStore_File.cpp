@@ -0,0 +1,55 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include "AP_MissionStore.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+extern const AP_HAL::HAL& hal;
+
+bool AP_MissionStore_File::init(void)
+{
+    if (_fd != -1) {
+        return true;
+    }
+    _fd = ::open(_filename, O_RDWR|O_CREAT, 0644);
+    if (_fd == -1) {
+        hal.console->printf("Failed to open mission file %s\n", _filename);
+        return false;
+    }
+    return true;
+}
+
+bool AP_MissionStore_File::read(uint32_t ofs, void *buf, uint16_t n)
+{
+    if (_fd == -1 || ofs + n > _size) {
+        return false;
+    }
+    if (::lseek(_fd, ofs, SEEK_SET) != (off_t)ofs) {
+        return false;
+    }
+    ssize_t ret = ::read(_fd, buf, n);
+    if (ret < 0) {
+        return false;
+    }
+    // the part beyond the end of the file has never been written
+    memset((uint8_t *)buf + ret, 0, n - ret);
+    return true;
+}
+
+bool AP_MissionStore_File::write(uint32_t ofs, const void *buf, uint16_t n)
+{
+    if (_fd == -1 || ofs + n > _size) {
+        return false;
+    }
+    if (::lseek(_fd, ofs, SEEK_SET) != (off_t)ofs) {
+        return false;
+    }
+    return ::write(_fd, buf, n) == (ssize_t)n;
+}
+#endif
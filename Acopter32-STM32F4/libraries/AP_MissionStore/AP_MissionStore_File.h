@@ -0,0 +1,34 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __AP_MISSIONSTORE_FILE_H__
+#define __AP_MISSIONSTORE_FILE_H__
+
+/*
+  mission items in a file, for boards with a filesystem. This allows
+  much larger missions than the EEPROM
+ */
+#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+class AP_MissionStore_File : public AP_MissionStore_Backend
+{
+public:
+    // the file is created if need be. max_items sets the size of
+    // the store
+    AP_MissionStore_File(const char *filename, uint16_t max_items) :
+        _filename(filename),
+        _size((uint32_t)max_items * AP_MISSIONSTORE_ITEM_SIZE),
+        _fd(-1)
+    {}
+
+    bool init(void);
+    uint32_t size(void) const { return _size; }
+    bool read(uint32_t ofs, void *buf, uint16_t n);
+    bool write(uint32_t ofs, const void *buf, uint16_t n);
+
+private:
+    const char *_filename;
+    uint32_t _size;
+    int _fd;
+};
+#endif
+
+#endif // __AP_MISSIONSTORE_FILE_H__
@@ -0,0 +1,119 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Test of the AP_MissionStore page cache on the EEPROM backend.
+//
+// A mission is written through the cache, flushed and read back after
+// the cache is emptied. It is then walked in order as update_commands()
+// does, with and without prefetch, and the cache hits and read times
+// are printed. This overwrites the mission area of the EEPROM.
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Empty.h>
+#include <AP_MissionStore.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+// the ArduCopter mission area
+#define STORE_START 0x600
+#define STORE_SIZE  2400
+
+AP_MissionStore_EEPROM backend(STORE_START, STORE_SIZE);
+AP_MissionStore store(backend);
+
+static struct Location test_item(uint16_t i)
+{
+    struct Location loc;
+    loc.id = 16 + (i % 3);
+    loc.options = i & 1;
+    loc.p1 = i;
+    loc.alt = 1000 + i;
+    loc.lat = -353632620 + i * 100L;
+    loc.lng = 1491652300 - i * 100L;
+    return loc;
+}
+
+static bool same(const struct Location &a, const struct Location &b)
+{
+    return a.id == b.id && a.options == b.options && a.p1 == b.p1 &&
+           a.alt == b.alt && a.lat == b.lat && a.lng == b.lng;
+}
+
+/*
+  read all items in order, as the mission does, and return the
+  average time of a read in microseconds
+ */
+static float walk_mission(uint16_t count, uint8_t prefetch)
+{
+    uint32_t total_us = 0;
+    struct Location loc;
+    store.init();
+    store.hits = store.misses = 0;
+    for (uint16_t i=0; i<count; i++) {
+        uint32_t t0 = hal.scheduler->micros();
+        store.read(i, loc);
+        total_us += hal.scheduler->micros() - t0;
+        store.prefetch(i+1, prefetch);
+        // the scheduler task runs between reads
+        store.update();
+    }
+    return total_us / (float)count;
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("AP_MissionStore test"));
+
+    store.init();
+    uint16_t count = store.max_items();
+    hal.console->printf_P(PSTR("%u items, %u per page, %u pages cached\n"),
+                          (unsigned)count,
+                          (unsigned)AP_MISSIONSTORE_PAGE_ITEMS,
+                          (unsigned)AP_MISSIONSTORE_CACHE_PAGES);
+
+    // write and read back
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<count; i++) {
+        store.write(i, test_item(i));
+    }
+    store.flush();
+    hal.console->printf_P(PSTR("write %lu us\n"), (unsigned long)(hal.scheduler->micros() - t0));
+
+    store.init();
+    uint16_t errors = 0;
+    struct Location loc;
+    for (uint16_t i=0; i<count; i++) {
+        if (!store.read(i, loc) || !same(loc, test_item(i))) {
+            errors++;
+        }
+    }
+    if (store.read(count, loc)) {
+        errors++;
+    }
+    hal.console->printf_P(PSTR("read back: %u errors\n"), (unsigned)errors);
+
+    float us = walk_mission(count, 0);
+    hal.console->printf_P(PSTR("no prefetch: %lu hits %lu misses, %.2f us per read\n"),
+                          (unsigned long)store.hits, (unsigned long)store.misses, us);
+    us = walk_mission(count, AP_MISSIONSTORE_PAGE_ITEMS);
+    hal.console->printf_P(PSTR("prefetch:    %lu hits %lu misses, %.2f us per read\n"),
+                          (unsigned long)store.hits, (unsigned long)store.misses, us);
+
+    hal.console->println_P(errors == 0 ? PSTR("PASSED") : PSTR("FAILED"));
+}
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
@@ -110,19 +110,26 @@ void AP_MotorsMatrix::output_min()
 // includes new scaling stability patch
 void AP_MotorsMatrix::output_armed()
 {
-    int8_t i;
+    output_armed_mix<AP_MOTORS_MAX_NUM_MOTORS, false>();
+}
+
+// output_armed_mix - output_armed for the first NUM_MOTORS motor slots
+// with ALL_ENABLED true the motors must be MOT_1 to MOT_<NUM_MOTORS>, so the loops have a
+// fixed length with no checks of motor_enabled[], and the compiler can unroll them
+template <uint8_t NUM_MOTORS, bool ALL_ENABLED>
+void AP_MotorsMatrix::output_armed_mix()
+{
+    uint8_t i;
     int16_t out_min_pwm = _rc_throttle->radio_min + _min_throttle;      // minimum pwm value we can send to the motors
     int16_t out_max_pwm = _rc_throttle->radio_max;                      // maximum pwm value we can send to the motors
-    int16_t out_mid_pwm = (out_min_pwm+out_max_pwm)/2;                  // mid pwm value we can send to the motors
-    int16_t out_best_thr_pwm;  // the is the best throttle we can come up which provides good control without climbing
-    float rpy_scale = 1.0; // this is used to scale the roll, pitch and yaw to fit within the motor limits
+    int16_t thr_out;        // the throttle that is actually provided
+    float rpy_scale = 1.0; // this is used to scale the roll, pitch and minimum yaw to fit within the motor limits
 
-    int16_t rpy_out[AP_MOTORS_MAX_NUM_MOTORS]; // buffer so we don't have to multiply coefficients multiple times.
+    int16_t rpy_out[NUM_MOTORS]; // buffer so we don't have to multiply coefficients multiple times.
 
     int16_t rpy_low = 0;    // lowest motor value
     int16_t rpy_high = 0;   // highest motor value
-    int16_t yaw_allowed;    // amount of yaw we can fit in
-    int16_t thr_adj;        // the difference between the pilot's desired throttle and out_best_thr_pwm (the throttle that is actually provided)
+    int16_t yaw_allowed;    // amount of yaw above the minimum yaw we can fit in
 
     // initialize limits flag
     limit.roll_pitch = false;
@@ -156,10 +163,11 @@ void AP_MotorsMatrix::output_armed()
         if (_spin_when_armed > _min_throttle) {
             _spin_when_armed = _min_throttle;
         }
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        for (i=0; i<NUM_MOTORS; i++) {
             // spin motors at minimum
-            if (motor_enabled[i]) {
+            if (ALL_ENABLED || motor_enabled[i]) {
                 motor_out[i] = _rc_throttle->radio_min + _spin_when_armed;
+                hal.rcout->write(_motor_to_channel_map[i], motor_out[i]);
             }
         }
 
@@ -175,153 +183,125 @@ void AP_MotorsMatrix::output_armed()
             limit.throttle_lower = true;
         }
 
-        // calculate roll and pitch for each motor
-        // set rpy_low and rpy_high to the lowest and highest values of the motors
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                rpy_out[i] = _rc_roll->pwm_out * _roll_factor[i] +
-                             _rc_pitch->pwm_out * _pitch_factor[i];
-
-                // record lowest roll pitch command
-                if (rpy_out[i] < rpy_low) {
-                    rpy_low = rpy_out[i];
-                }
-                // record highest roll pich command
-                if (rpy_out[i] > rpy_high) {
-                    rpy_high = rpy_out[i];
-                }
+        // the motors are desaturated in order of priority: roll and pitch (with a minimum of yaw) first,
+        // then the rest of the yaw, then throttle. Each is given as much of what it requested as fits
+        // once the ones before it have been placed, and roll and pitch are only ever scaled together so
+        // the direction of the tilt is kept.
+        //
+        // The throttle may be raised above the pilot's throttle to make room for the others, but no further
+        // than the higher of the pilot's throttle and the mid point between it and hover-throttle, so the
+        // copter does not climb when the pilot has asked for low throttle.
+        int16_t thr_max_pwm = max(_rc_throttle->radio_out, (_rc_throttle->radio_out+_hover_out)/2);
+        float out_range = out_max_pwm - out_min_pwm;                    // room for the differences between the motors
+        float out_below = max(thr_max_pwm - out_min_pwm, 0);            // room for motors to go below the throttle
+
+        // the yaw mixed with roll and pitch, which is kept if at all possible, and the rest of the requested yaw
+        int16_t yaw_min = constrain_int16(_rc_yaw->pwm_out, -AP_MOTORS_MATRIX_YAW_LOWER_LIMIT_PWM, AP_MOTORS_MATRIX_YAW_LOWER_LIMIT_PWM);
+        int16_t yaw_extra = _rc_yaw->pwm_out - yaw_min;
+
+        // calculate roll, pitch and the minimum yaw for each motor
+        // set rpy_low and rpy_high to the lowest and highest values of the motors, and
+        // all_low and all_high to what they would be with all the requested yaw
+        int16_t all_low = 0;
+        int16_t all_high = 0;
+        for (i=0; i<NUM_MOTORS; i++) {
+            if (ALL_ENABLED || motor_enabled[i]) {
+                rpy_out[i] = mul_add(yaw_min, _yaw_factor[i],
+                                     mul_add(_rc_pitch->pwm_out, _pitch_factor[i],
+                                             _rc_roll->pwm_out * _roll_factor[i]));
+                int16_t all_out = rpy_out[i] + yaw_extra * _yaw_factor[i];
+                rpy_low = min(rpy_low, rpy_out[i]);
+                rpy_high = max(rpy_high, rpy_out[i]);
+                all_low = min(all_low, all_out);
+                all_high = max(all_high, all_out);
             }
         }
 
-        // calculate throttle that gives most possible room for yaw (range 1000 ~ 2000) which is the lower of:
-        //      1. mid throttle - average of highest and lowest motor (this would give the maximum possible room margin above the highest motor and below the lowest)
-        //      2. the higher of:
-        //            a) the pilot's throttle input
-        //            b) the mid point between the pilot's input throttle and hover-throttle
-        //      Situation #2 ensure we never increase the throttle above hover throttle unless the pilot has commanded this.
-        //      Situation #2b allows us to raise the throttle above what the pilot commanded but not so far that it would actually cause the copter to rise.
-        //      We will choose #1 (the best throttle for yaw control) if that means reducing throttle to the motors (i.e. we favour reducing throttle *because* it provides better yaw control)
-        //      We will choose #2 (a mix of pilot and hover throttle) only when the throttle is quite low.  We favour reducing throttle instead of better yaw control because the pilot has commanded it
-        int16_t motor_mid = (rpy_low+rpy_high)/2;
-        out_best_thr_pwm = min(out_mid_pwm - motor_mid, max(_rc_throttle->radio_out, (_rc_throttle->radio_out+_hover_out)/2));
-
-        // calculate amount of yaw we can fit into the throttle range
-        // this is always equal to or less than the requested yaw from the pilot or rate controller
-        yaw_allowed = min(out_max_pwm - out_best_thr_pwm, out_best_thr_pwm - out_min_pwm) - (rpy_high-rpy_low)/2;
-        yaw_allowed = max(yaw_allowed, AP_MOTORS_MATRIX_YAW_LOWER_LIMIT_PWM);
-
-        if (_rc_yaw->pwm_out >= 0) {
-            // if yawing right
-            if (yaw_allowed > _rc_yaw->pwm_out) {
-                yaw_allowed = _rc_yaw->pwm_out; // to-do: this is bad form for yaw_allows to change meaning to become the amount that we are going to output
-            }else{
-                limit.yaw = true;
-            }
-        }else{
-            // if yawing left
-            yaw_allowed = -yaw_allowed;
-            if( yaw_allowed < _rc_yaw->pwm_out ) {
-                yaw_allowed = _rc_yaw->pwm_out; // to-do: this is bad form for yaw_allows to change meaning to become the amount that we are going to output
-            }else{
-                limit.yaw = true;
-            }
+        // 1. scale roll, pitch and the minimum yaw down together if they do not fit
+        if (rpy_high - rpy_low > out_range) {
+            rpy_scale = out_range / (rpy_high - rpy_low);
+        }
+        if (rpy_low < -out_below) {
+            rpy_scale = min(rpy_scale, out_below / -rpy_low);
+        }
+        if (rpy_scale < 1.0f) {
+            // we haven't even been able to apply full roll, pitch and minimal yaw
+            limit.roll_pitch = true;
+            limit.yaw = true;
+            yaw_extra = 0;
         }
 
-        // add yaw to intermediate numbers for each motor
-        rpy_low = 0;
-        rpy_high = 0;
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                rpy_out[i] =    rpy_out[i] +
-                                yaw_allowed * _yaw_factor[i];
-
-                // record lowest roll+pitch+yaw command
-                if( rpy_out[i] < rpy_low ) {
-                    rpy_low = rpy_out[i];
-                }
-                // record highest roll+pitch+yaw command
-                if( rpy_out[i] > rpy_high) {
-                    rpy_high = rpy_out[i];
+        // 2. add as much of the rest of the yaw as fits. Each pair of motors has to stay within out_range of
+        // each other, and each motor no more than out_below below the throttle. These are linear in the
+        // amount of yaw, so each gives an upper limit on yaw_scale
+        float yaw_scale = 1.0f;
+        if (yaw_extra != 0 && (all_high - all_low > out_range || all_low < -out_below)) {
+            for (i=0; i<NUM_MOTORS; i++) {
+                if (ALL_ENABLED || motor_enabled[i]) {
+                    float yaw_i = yaw_extra * _yaw_factor[i];
+                    if (rpy_out[i] + yaw_i < -out_below) {
+                        yaw_scale = min(yaw_scale, (out_below + rpy_out[i]) / -yaw_i);
+                    }
+                    for (uint8_t j=i+1; j<NUM_MOTORS; j++) {
+                        if (ALL_ENABLED || motor_enabled[j]) {
+                            float diff = rpy_out[i] - rpy_out[j];
+                            float yaw_diff = yaw_i - yaw_extra * _yaw_factor[j];
+                            if (fabsf(diff + yaw_diff) > out_range) {
+                                yaw_scale = min(yaw_scale, (out_range - (yaw_diff > 0 ? diff : -diff)) / fabsf(yaw_diff));
+                            }
+                        }
+                    }
                 }
             }
+            limit.yaw = true;
         }
+        yaw_allowed = yaw_extra * yaw_scale;
 
-        // check everything fits
-        thr_adj = _rc_throttle->radio_out - out_best_thr_pwm;
-
-        // calc upper and lower limits of thr_adj
-        int16_t thr_adj_max = out_max_pwm-(out_best_thr_pwm+rpy_high);
-
-        // if we are increasing the throttle (situation #2 above)..
-        if (thr_adj > 0) {
-            // increase throttle as close as possible to requested throttle
-            // without going over out_max_pwm
-            if (thr_adj > thr_adj_max){
-                thr_adj = thr_adj_max;
-                // we haven't even been able to apply full throttle command
-                limit.throttle_upper = true;
-            }
-        }else if(thr_adj < 0){
-            // decrease throttle as close as possible to requested throttle
-            // without going under out_min_pwm or over out_max_pwm
-            // earlier code ensures we can't break both boundaries
-            int16_t thr_adj_min = min(out_min_pwm-(out_best_thr_pwm+rpy_low),0);
-            if (thr_adj > thr_adj_max) {
-                thr_adj = thr_adj_max;
-                limit.throttle_upper = true;
-            }
-            if (thr_adj < thr_adj_min) {
-                thr_adj = thr_adj_min;
-                limit.throttle_lower = true;
+        // add the scaled roll, pitch and yaw for each motor
+        rpy_low = 0;
+        rpy_high = 0;
+        for (i=0; i<NUM_MOTORS; i++) {
+            if (ALL_ENABLED || motor_enabled[i]) {
+                rpy_out[i] = rpy_scale * rpy_out[i] + yaw_allowed * _yaw_factor[i];
+                rpy_low = min(rpy_low, rpy_out[i]);
+                rpy_high = max(rpy_high, rpy_out[i]);
             }
         }
 
-        // do we need to reduce roll, pitch, yaw command
-        // earlier code does not allow both limit's to be passed simultainiously with abs(_yaw_factor)<1
-        if ((rpy_low+out_best_thr_pwm)+thr_adj < out_min_pwm){
-            rpy_scale = (float)(out_min_pwm-thr_adj-out_best_thr_pwm)/rpy_low;
-            // we haven't even been able to apply full roll, pitch and minimal yaw without scaling
-            limit.roll_pitch = true;
-            limit.yaw = true;
-        }else if((rpy_high+out_best_thr_pwm)+thr_adj > out_max_pwm){
-            rpy_scale = (float)(out_max_pwm-thr_adj-out_best_thr_pwm)/rpy_high;
-            // we haven't even been able to apply full roll, pitch and minimal yaw without scaling
-            limit.roll_pitch = true;
-            limit.yaw = true;
+        // 3. use the throttle closest to the pilot's throttle that keeps the motors in range
+        thr_out = _rc_throttle->radio_out;
+        if (thr_out + rpy_high > out_max_pwm) {
+            thr_out = out_max_pwm - rpy_high;
+            // we haven't been able to apply full throttle command
+            limit.throttle_upper = true;
         }
-
-        // add scaled roll, pitch, constrained yaw and throttle for each motor
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                motor_out[i] = out_best_thr_pwm+thr_adj +
-                               rpy_scale*rpy_out[i];
-            }
+        if (thr_out + rpy_low < out_min_pwm) {
+            thr_out = out_min_pwm - rpy_low;
+            // we have had to raise the throttle
+            limit.throttle_lower = true;
         }
 
-        // adjust for throttle curve
-        if (_throttle_curve_enabled) {
-            for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-                if (motor_enabled[i]) {
-                    motor_out[i] = _throttle_curve.get_y(motor_out[i]);
+        // add throttle for each motor, adjust for the throttle curve, clip the motor
+        // output if required (only by rounding) and send it
+        for (i=0; i<NUM_MOTORS; i++) {
+            if (ALL_ENABLED || motor_enabled[i]) {
+                int16_t out = thr_out + rpy_out[i];
+                if (_throttle_curve_enabled) {
+                    out = _throttle_curve.get_y(out);
                 }
-            }
-        }
-        // clip motor output if required (shouldn't be)
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                motor_out[i] = constrain_int16(motor_out[i], out_min_pwm, out_max_pwm);
+                motor_out[i] = constrain_int16(out, out_min_pwm, out_max_pwm);
+                hal.rcout->write(_motor_to_channel_map[i], motor_out[i]);
             }
         }
     }
-
-    // send output to each motor
-    for( i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++ ) {
-        if( motor_enabled[i] ) {
-            hal.rcout->write(_motor_to_channel_map[i], motor_out[i]);
-        }
-    }
 }
 
+// the mixers used by output_armed and the frame classes
+template void AP_MotorsMatrix::output_armed_mix<4, true>();
+template void AP_MotorsMatrix::output_armed_mix<6, true>();
+template void AP_MotorsMatrix::output_armed_mix<8, true>();
+template void AP_MotorsMatrix::output_armed_mix<AP_MOTORS_MAX_NUM_MOTORS, false>();
+
 // output_disarmed - sends commands to the motors
 void AP_MotorsMatrix::output_disarmed()
 {
@@ -387,6 +367,8 @@ void AP_MotorsMatrix::add_motor_raw(int8_t motor_num, float roll_fac, float pitc
 
         // set order that motor appears in test
         _test_order[motor_num] = testing_order;
+
+        update_num_motors_contiguous();
     }
 }
 
@@ -418,6 +400,8 @@ void AP_MotorsMatrix::remove_motor(int8_t motor_num)
         _roll_factor[motor_num] = 0;
         _pitch_factor[motor_num] = 0;
         _yaw_factor[motor_num] = 0;
+
+        update_num_motors_contiguous();
     }
 }
 
@@ -428,4 +412,22 @@ void AP_MotorsMatrix::remove_all_motors()
         remove_motor(i);
     }
     _num_motors = 0;
+    _num_motors_contiguous = 0;
+}
+
+// update_num_motors_contiguous - record if the enabled motors are MOT_1 to MOT_n
+void AP_MotorsMatrix::update_num_motors_contiguous()
+{
+    uint8_t n = 0;
+    while (n < AP_MOTORS_MAX_NUM_MOTORS && motor_enabled[n]) {
+        n++;
+    }
+    for (uint8_t i=n; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (motor_enabled[i]) {
+            // a gap before this motor
+            _num_motors_contiguous = 0;
+            return;
+        }
+    }
+    _num_motors_contiguous = n;
 }
@@ -23,7 +23,8 @@ public:
     /// Constructor
     AP_MotorsMatrix( RC_Channel* rc_roll, RC_Channel* rc_pitch, RC_Channel* rc_throttle, RC_Channel* rc_yaw, uint16_t speed_hz = AP_MOTORS_SPEED_DEFAULT) :
         AP_Motors(rc_roll, rc_pitch, rc_throttle, rc_yaw, speed_hz),
-        _num_motors(0) {
+        _num_motors(0),
+        _num_motors_contiguous(0) {
     };
 
     // init
@@ -67,11 +68,29 @@ protected:
     // add_motor using raw roll, pitch, throttle and yaw factors
     void                add_motor_raw(int8_t motor_num, float roll_fac, float pitch_fac, float yaw_fac, uint8_t testing_order);
 
+    // output_armed_mix - mixer of output_armed for the first NUM_MOTORS motor slots
+    //   ALL_ENABLED should only be true if the motors are MOT_1 to MOT_<NUM_MOTORS>
+    template <uint8_t NUM_MOTORS, bool ALL_ENABLED> void output_armed_mix();
+
+    // output_armed_frame - output_armed for frame classes which always have NUM_MOTORS motors
+    //   uses the mixer specialised for NUM_MOTORS unless the motors have been changed from MOT_1 to MOT_<NUM_MOTORS>
+    template <uint8_t NUM_MOTORS> void output_armed_frame() {
+        if (_num_motors_contiguous == NUM_MOTORS) {
+            output_armed_mix<NUM_MOTORS, true>();
+        }else{
+            output_armed_mix<AP_MOTORS_MAX_NUM_MOTORS, false>();
+        }
+    }
+
+    // update_num_motors_contiguous - record if the enabled motors are MOT_1 to MOT_n
+    void                update_num_motors_contiguous();
+
     int8_t              _num_motors; // not a very useful variable as you really need to check the motor_enabled array to see which motors are enabled
     float               _roll_factor[AP_MOTORS_MAX_NUM_MOTORS]; // each motors contribution to roll
     float               _pitch_factor[AP_MOTORS_MAX_NUM_MOTORS]; // each motors contribution to pitch
     float               _yaw_factor[AP_MOTORS_MAX_NUM_MOTORS];  // each motors contribution to yaw (normally 1 or -1)
     uint8_t             _test_order[AP_MOTORS_MAX_NUM_MOTORS];  // order of the motors in the test sequence
+    uint8_t             _num_motors_contiguous; // number of motors if they are MOT_1 to MOT_n with none missing, zero otherwise
 };
 
 #endif  // AP_MOTORSMATRIX
@@ -23,6 +23,8 @@ public:
     virtual void        setup_motors();
 
 protected:
+    // output_armed - sends commands to the eight motors
+    virtual void        output_armed() { output_armed_frame<8>(); }
 
 };
 
@@ -0,0 +1,145 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Benchmark of the matrix motor mixer. For each multicopter frame
+// class the mixer specialised for its number of motors is compared with
+// the general mixer of AP_MotorsMatrix over the same random roll, pitch,
+// yaw and throttle inputs. The motor outputs must be identical, and the
+// mean time of an output_armed() call, including setting the inputs,
+// is printed.
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_HAL.h>
+#include <AP_Param.h>
+#include <AP_Math.h>
+#include <RC_Channel.h>
+#include <AP_Motors.h>
+#include <AP_Curve.h>
+#include <AP_Notify.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define BENCH_ITERATIONS 10000
+
+RC_Channel rc1(0), rc2(1), rc3(2), rc4(3);
+
+// gives access to both mixers of a frame class
+template <class FRAME>
+class BenchMotors : public FRAME
+{
+public:
+    BenchMotors() : FRAME(&rc1, &rc2, &rc3, &rc4) {}
+    void output_frame(void) { FRAME::output_armed(); }
+    void output_general(void) { AP_MotorsMatrix::output_armed(); }
+};
+
+BenchMotors<AP_MotorsQuad>      quad;
+BenchMotors<AP_MotorsHexa>      hexa;
+BenchMotors<AP_MotorsY6>        y6;
+BenchMotors<AP_MotorsOcta>      octa;
+BenchMotors<AP_MotorsOctaQuad>  octaquad;
+
+static uint32_t seed = 1;
+
+// a repeatable pseudo-random number in the range low to high
+static int16_t random_input(int16_t low, int16_t high)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return low + (int16_t)((seed >> 16) % (uint32_t)(high - low + 1));
+}
+
+static void set_inputs(uint16_t i)
+{
+    seed = i + 1;
+    rc1.servo_out = random_input(-4500, 4500);
+    rc2.servo_out = random_input(-4500, 4500);
+    rc3.servo_out = random_input(-50, 1000);
+    rc4.servo_out = random_input(-4500, 4500);
+}
+
+template <class FRAME>
+static void bench_frame(BenchMotors<FRAME> &motors, const char *name)
+{
+    int16_t general_out[AP_MOTORS_MAX_NUM_MOTORS];
+    uint32_t general_us = 0, frame_us = 0;
+    uint16_t mismatches = 0;
+
+    motors.set_frame_orientation(AP_MOTORS_X_FRAME);
+    motors.set_min_throttle(130);
+    motors.set_mid_throttle(500);
+    motors.Init();
+    motors.armed(true);
+
+    // check the outputs match
+    for (uint16_t i=0; i<BENCH_ITERATIONS; i++) {
+        set_inputs(i);
+        motors.output_general();
+        memcpy(general_out, motors.motor_out, sizeof(general_out));
+        set_inputs(i);
+        motors.output_frame();
+        if (memcmp(general_out, motors.motor_out, sizeof(general_out)) != 0) {
+            mismatches++;
+        }
+    }
+
+    // time each mixer over all the inputs. The inputs are set in
+    // both loops, so the difference is the time of the mixers
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<BENCH_ITERATIONS; i++) {
+        set_inputs(i);
+        motors.output_general();
+    }
+    general_us = hal.scheduler->micros() - t0;
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<BENCH_ITERATIONS; i++) {
+        set_inputs(i);
+        motors.output_frame();
+    }
+    frame_us = hal.scheduler->micros() - t0;
+
+    hal.console->printf_P(PSTR("%-9s general %.2f us  specialised %.2f us  mismatches %u\n"),
+                          name,
+                          general_us / (float)BENCH_ITERATIONS,
+                          frame_us / (float)BENCH_ITERATIONS,
+                          (unsigned)mismatches);
+}
+
+void setup()
+{
+    hal.console->println("AP_Motors mixer benchmark");
+
+    rc1.set_type(RC_CHANNEL_TYPE_ANGLE_RAW);
+    rc2.set_type(RC_CHANNEL_TYPE_ANGLE_RAW);
+    rc4.set_type(RC_CHANNEL_TYPE_ANGLE_RAW);
+    rc3.set_range(130, 1000);
+    rc3.set_range_out(0, 1000);
+
+    // cope with AP_Param not being loaded
+    RC_Channel *channels[] = { &rc1, &rc2, &rc3, &rc4 };
+    for (uint8_t i=0; i<4; i++) {
+        channels[i]->radio_min = 1000;
+        channels[i]->radio_trim = 1500;
+        channels[i]->radio_max = 2000;
+    }
+    rc3.radio_trim = 1000;
+
+    bench_frame(quad, "quad");
+    bench_frame(hexa, "hexa");
+    bench_frame(y6, "y6");
+    bench_frame(octa, "octa");
+    bench_frame(octaquad, "octaquad");
+}
+
+void loop()
+{
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
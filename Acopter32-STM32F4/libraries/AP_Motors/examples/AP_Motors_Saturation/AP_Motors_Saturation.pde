@@ -0,0 +1,251 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+//
+// Test of the matrix motor mixer when the motors saturate.
+//
+// For each multicopter frame class two things are measured:
+//
+//  - the roll, pitch, yaw and throttle given by the motor outputs for
+//    random demands over the full range of the inputs, compared with
+//    the demands. The roll/pitch direction error should stay near zero,
+//    as roll and pitch are only ever scaled together
+//
+//  - the attitude error of a simple rigid body model flown through
+//    aggressive steps of roll, pitch, yaw and throttle by a cascaded
+//    angle and rate controller. The motors saturate for much of the
+//    time, so this shows how well the mixer keeps attitude control
+//
+// The throttle curve is disabled so the outputs are linear in the
+// demands.
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_HAL.h>
+#include <AP_Param.h>
+#include <AP_Math.h>
+#include <RC_Channel.h>
+#include <AP_Motors.h>
+#include <AP_Curve.h>
+#include <AP_Notify.h>
+
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define SWEEP_ITERATIONS    10000
+
+// model of the vehicle: angular acceleration in rad/s/s per pwm of
+// roll/pitch and yaw output, and the rate damping in 1/s
+#define SIM_DT              0.01f
+#define SIM_STEPS           6000
+#define SIM_STEP_PERIOD     100
+#define SIM_RP_ACCEL        0.03f
+#define SIM_YAW_ACCEL       0.01f
+#define SIM_DAMPING         2.0f
+
+RC_Channel rc1(0), rc2(1), rc3(2), rc4(3);
+
+// gives the roll, pitch, yaw and throttle of the motor outputs
+template <class FRAME>
+class TestMotors : public FRAME
+{
+public:
+    TestMotors() : FRAME(&rc1, &rc2, &rc3, &rc4) {}
+
+    void init(void) {
+        this->set_frame_orientation(AP_MOTORS_X_FRAME);
+        this->set_min_throttle(130);
+        this->set_mid_throttle(500);
+        this->Init();
+        this->_throttle_curve_enabled.set(0);
+        this->armed(true);
+    }
+
+    // the roll, pitch and yaw which give the motor outputs, in the
+    // units of pwm_out, and the mean motor output
+    void achieved(Vector3f &rpy, float &throttle) {
+        float sum_r = 0, sum_p = 0, sum_y = 0;
+        float sum_rr = 0, sum_pp = 0, sum_yy = 0;
+        uint8_t n = 0;
+        throttle = 0;
+        for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (this->motor_enabled[i]) {
+                throttle += this->motor_out[i];
+                n++;
+            }
+        }
+        throttle /= n;
+        for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (this->motor_enabled[i]) {
+                float out = this->motor_out[i] - throttle;
+                sum_r += this->_roll_factor[i] * out;
+                sum_p += this->_pitch_factor[i] * out;
+                sum_y += this->_yaw_factor[i] * out;
+                sum_rr += sq(this->_roll_factor[i]);
+                sum_pp += sq(this->_pitch_factor[i]);
+                sum_yy += sq(this->_yaw_factor[i]);
+            }
+        }
+        rpy.x = sum_r / sum_rr;
+        rpy.y = sum_p / sum_pp;
+        rpy.z = sum_y / sum_yy;
+    }
+};
+
+TestMotors<AP_MotorsQuad>       quad;
+TestMotors<AP_MotorsHexa>       hexa;
+TestMotors<AP_MotorsOcta>       octa;
+TestMotors<AP_MotorsOctaQuad>   octaquad;
+
+static uint32_t seed = 1;
+
+// a repeatable pseudo-random number in the range low to high
+static int16_t random_input(int16_t low, int16_t high)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return low + (int16_t)((seed >> 16) % (uint32_t)(high - low + 1));
+}
+
+/*
+  compare the outputs with random demands
+ */
+template <class FRAME>
+static void test_sweep(TestMotors<FRAME> &motors)
+{
+    float max_dir_err = 0, sum_rp = 0, sum_yaw = 0, sum_sq_thr = 0;
+    uint16_t n_rp = 0, n_yaw = 0;
+
+    seed = 1;
+    for (uint16_t i=0; i<SWEEP_ITERATIONS; i++) {
+        rc1.servo_out = random_input(-4500, 4500);
+        rc2.servo_out = random_input(-4500, 4500);
+        rc3.servo_out = random_input(50, 1000);
+        rc4.servo_out = random_input(-4500, 4500);
+        motors.output();
+
+        Vector3f rpy;
+        float throttle;
+        motors.achieved(rpy, throttle);
+
+        Vector2f demand(rc1.pwm_out, rc2.pwm_out);
+        Vector2f rp(rpy.x, rpy.y);
+        if (demand.length() > 50) {
+            if (rp.length() > 1) {
+                float err = fabsf(wrap_PI(atan2f(rp.y, rp.x) - atan2f(demand.y, demand.x)));
+                max_dir_err = max(max_dir_err, err);
+            }
+            sum_rp += rp.length() / demand.length();
+            n_rp++;
+        }
+        if (abs(rc4.pwm_out) > 50) {
+            sum_yaw += rpy.z / rc4.pwm_out;
+            n_yaw++;
+        }
+        sum_sq_thr += sq(throttle - rc3.radio_out);
+    }
+
+    hal.console->printf_P(PSTR("  sweep: roll/pitch %.1f%% max direction error %.2f deg, yaw %.1f%%, throttle rms error %.1f\n"),
+                          100 * sum_rp / n_rp, ToDeg(max_dir_err),
+                          100 * sum_yaw / n_yaw, sqrtf(sum_sq_thr / SWEEP_ITERATIONS));
+}
+
+/*
+  fly the model through steps of attitude and throttle
+ */
+template <class FRAME>
+static void test_flight(TestMotors<FRAME> &motors)
+{
+    Vector3f att, rate, target;
+    Vector3f sum_sq_err;
+    float sum_sq_thr = 0;
+
+    seed = 1;
+    for (uint16_t step=0; step<SIM_STEPS; step++) {
+        if (step % SIM_STEP_PERIOD == 0) {
+            target.x = radians(random_input(-45, 45));
+            target.y = radians(random_input(-45, 45));
+            target.z = radians(random_input(-90, 90));
+            rc3.servo_out = random_input(200, 1000);
+        }
+
+        // angle and rate controllers, in centi-degrees
+        Vector3f err = target - att;
+        err.z = wrap_PI(err.z);
+        Vector3f rate_target(constrain_float(4.5f * err.x, -radians(360), radians(360)),
+                             constrain_float(4.5f * err.y, -radians(360), radians(360)),
+                             constrain_float(4.5f * err.z, -radians(180), radians(180)));
+        Vector3f out = (rate_target - rate) * (100 * RAD_TO_DEG);
+        rc1.servo_out = constrain_int16(0.25f * out.x, -4500, 4500);
+        rc2.servo_out = constrain_int16(0.25f * out.y, -4500, 4500);
+        rc4.servo_out = constrain_int16(0.4f * out.z, -4500, 4500);
+        motors.output();
+
+        Vector3f rpy;
+        float throttle;
+        motors.achieved(rpy, throttle);
+
+        // the axes are treated as independent, which is close enough
+        // for the small angles of this test
+        Vector3f accel(SIM_RP_ACCEL * rpy.x, SIM_RP_ACCEL * rpy.y, SIM_YAW_ACCEL * rpy.z);
+        rate += (accel - rate * SIM_DAMPING) * SIM_DT;
+        att += rate * SIM_DT;
+        att.z = wrap_PI(att.z);
+
+        err = target - att;
+        err.z = wrap_PI(err.z);
+        sum_sq_err.x += sq(err.x);
+        sum_sq_err.y += sq(err.y);
+        sum_sq_err.z += sq(err.z);
+        sum_sq_thr += sq(throttle - rc3.radio_out);
+    }
+
+    hal.console->printf_P(PSTR("  flight: rms attitude error roll %.2f pitch %.2f yaw %.2f deg, throttle rms error %.1f\n"),
+                          ToDeg(sqrtf(sum_sq_err.x / SIM_STEPS)),
+                          ToDeg(sqrtf(sum_sq_err.y / SIM_STEPS)),
+                          ToDeg(sqrtf(sum_sq_err.z / SIM_STEPS)),
+                          sqrtf(sum_sq_thr / SIM_STEPS));
+}
+
+template <class FRAME>
+static void test_frame(TestMotors<FRAME> &motors, const char *name)
+{
+    hal.console->printf_P(PSTR("%s\n"), name);
+    motors.init();
+    test_sweep(motors);
+    test_flight(motors);
+}
+
+void setup()
+{
+    hal.console->println("AP_Motors saturation test");
+
+    rc1.set_type(RC_CHANNEL_TYPE_ANGLE_RAW);
+    rc2.set_type(RC_CHANNEL_TYPE_ANGLE_RAW);
+    rc4.set_type(RC_CHANNEL_TYPE_ANGLE_RAW);
+    rc3.set_range(130, 1000);
+    rc3.set_range_out(0, 1000);
+
+    // cope with AP_Param not being loaded
+    RC_Channel *channels[] = { &rc1, &rc2, &rc3, &rc4 };
+    for (uint8_t i=0; i<4; i++) {
+        channels[i]->radio_min = 1000;
+        channels[i]->radio_trim = 1500;
+        channels[i]->radio_max = 2000;
+    }
+    rc3.radio_trim = 1000;
+
+    test_frame(quad, "quad");
+    test_frame(hexa, "hexa");
+    test_frame(octa, "octa");
+    test_frame(octaquad, "octaquad");
+}
+
+void loop()
+{
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
@@ -60,6 +60,12 @@
  # define HAL_GPIO_C_LED_PIN        -1
  # define HAL_GPIO_LED_ON           LOW
  # define HAL_GPIO_LED_OFF          HIGH
+#elif CONFIG_HAL_BOARD == HAL_BOARD_EMPTY
+ # define HAL_GPIO_A_LED_PIN        -1
+ # define HAL_GPIO_B_LED_PIN        -1
+ # define HAL_GPIO_C_LED_PIN        -1
+ # define HAL_GPIO_LED_ON           LOW
+ # define HAL_GPIO_LED_OFF          HIGH
 #elif CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
  # define HAL_GPIO_A_LED_PIN        19
  # define HAL_GPIO_B_LED_PIN        20
@@ -0,0 +1,115 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/// @file	AP_PIDCore.h
+/// @brief	The state and arithmetic of a PID controller, shared by AC_PID,
+///         APM_PI and PID
+
+#ifndef __AP_PIDCORE_H__
+#define __AP_PIDCORE_H__
+
+#include <stdint.h>
+#include <math.h>
+
+/// @name	features of a controller, or'ed together as the template
+///         argument of AP_PIDCore
+//@{
+#define AP_PID_I            0x01    // integrator, clamped to +/- imax
+#define AP_PID_D            0x02    // derivative of the input
+#define AP_PID_D_FILTER     0x04    // low pass filter on the derivative
+//@}
+
+/// @class	AP_PIDCore
+/// @brief	Integrator and derivative state of one controller
+///
+/// The gains are left to the caller, which keeps them as parameters,
+/// and so is the order in which the terms are worked out and scaled,
+/// so that each controller gives the same results as it always has.
+/// The features a controller does not have are compiled out.
+///
+/// T is the type of the derivative input. Its difference is taken
+/// in T, so an integer input gives the same derivative as the
+/// integer arithmetic of AC_PID.
+template <uint8_t FEATURES, typename T = float>
+class AP_PIDCore {
+public:
+    AP_PIDCore() :
+        integrator(0),
+        last_input(0),
+        last_derivative(NAN) {
+    }
+
+    /// zero the integrator, and suppress the next derivative
+    void reset_I() {
+        integrator = 0;
+        last_derivative = NAN;
+    }
+
+    /// Add rate * dt to the integrator and clamp it to +/- imax
+    ///
+    /// @returns	the new integrator
+    ///
+    float integrate(float rate, float dt, float imax) {
+        if (!(FEATURES & AP_PID_I)) {
+            return 0;
+        }
+        integrator += rate * dt;
+        if (integrator < -imax) {
+            integrator = -imax;
+        } else if (integrator > imax) {
+            integrator = imax;
+        }
+        return integrator;
+    }
+
+    /// Anti-windup: true when the integrator is to be held because the
+    /// output is at a limit, unless the error would reduce it. The
+    /// integrator is tested as a whole number, as the multicopter rate
+    /// controllers have always done
+    ///
+    /// @param error	the error the integrator would be given
+    /// @param limit	the limit flag of the motors for this axis
+    ///
+    bool hold_I(float error, bool limit) const {
+        return limit && !((integrator >= 1 && error < 0) || (integrator <= -1 && error > 0));
+    }
+
+    /// The gain of the derivative filter for a time constant and time step
+    static float filter_gain(float filter_rc, float dt) {
+        return dt / (filter_rc + dt);
+    }
+
+    /// Derivative of the input since the last call, through the low pass
+    /// filter when the controller has one. The first one after a reset
+    /// is zero, so a step in the input does not kick the output
+    ///
+    /// @param gain		filter_gain() for this dt
+    ///
+    float derivative(T input, float dt, float gain) {
+        if (!(FEATURES & AP_PID_D)) {
+            return 0;
+        }
+        float derivative;
+        if (isnan(last_derivative)) {
+            derivative = 0;
+            last_derivative = 0;
+        } else {
+            derivative = (input - last_input) / dt;
+        }
+
+        if (FEATURES & AP_PID_D_FILTER) {
+            // discrete low pass filter, cuts out the
+            // high frequency noise that can drive the controller crazy
+            derivative = last_derivative + gain * (derivative - last_derivative);
+        }
+
+        last_input = input;
+        last_derivative = derivative;
+        return derivative;
+    }
+
+    float           integrator;             ///< integrator value
+    T               last_input;             ///< last input for derivative
+    float           last_derivative;        ///< last derivative for low-pass filter
+};
+
+#endif // __AP_PIDCORE_H__
@@ -0,0 +1,450 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Checks that AC_PID, APM_PI and PID give the same results on top of
+// AP_PIDCore as the code they had before, bit for bit, and that
+// AC_PIDBank gives the same terms as the multicopter rate controllers
+// of the main loop did with get_p(), get_i() and get_d(). Then it
+// times one update of the roll, pitch and yaw rate controllers each
+// way.
+//
+// Costs are in CPU cycles from the DWT cycle counter on the
+// Cortex-M4 boards, in time stamp counter cycles on x86 and in
+// nanoseconds from micros() elsewhere. Each is timed over BENCH_REPEAT
+// updates and the fastest of BENCH_ROUNDS batches is kept.
+//
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_Math.h>
+#include <AP_PIDCore.h>
+#include <AC_PID.h>
+#include <APM_PI.h>
+#include <PID.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define BENCH_REPEAT  200
+#define BENCH_ROUNDS  10
+#define NUM_STEPS     20000
+#define NUM_PID_STEPS 200
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define CYCLE_UNITS "TSC cycles"
+static void cycles_init(void) {}
+static uint32_t cycles(void) { return (uint32_t)__rdtsc(); }
+#elif defined(__ARM_ARCH_7EM__)
+// the DWT cycle counter of the Cortex-M4
+#define DEMCR      (*(volatile uint32_t *)0xE000EDFC)
+#define DWT_CTRL   (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#define CYCLE_UNITS "cycles"
+static void cycles_init(void)
+{
+    DEMCR |= (1UL<<24);
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1;
+}
+static uint32_t cycles(void) { return DWT_CYCCNT; }
+#else
+#define CYCLE_UNITS "ns"
+static void cycles_init(void) {}
+static uint32_t cycles(void) { return hal.scheduler->micros() * 1000UL; }
+#endif
+
+/*
+  time BENCH_REPEAT runs of code, keeping the fastest batch, and give
+  the cost of one run in cost
+ */
+#define BENCH(cost, code) do {                              \
+        uint32_t best = 0xFFFFFFFF;                         \
+        for (uint8_t round=0; round<BENCH_ROUNDS; round++) { \
+            uint32_t start = cycles();                      \
+            for (uint16_t rep=0; rep<BENCH_REPEAT; rep++) { \
+                code;                                       \
+            }                                               \
+            best = min(best, cycles() - start);             \
+        }                                                   \
+        cost = best / (float)BENCH_REPEAT;                  \
+    } while (0)
+
+/*
+  the controllers as they were before AP_PIDCore
+ */
+class Old_AC_PID {
+public:
+    Old_AC_PID(float p, float i, float d, int16_t imax) :
+        _kp(p), _ki(i), _kd(d), _imax(imax),
+        _integrator(0), _last_input(0), _last_derivative(NAN) {}
+
+    int32_t get_p(int32_t error) {
+        return (float)error * _kp;
+    }
+    int32_t get_i(int32_t error, float dt) {
+        if((_ki != 0) && (dt != 0)) {
+            _integrator += ((float)error * _ki) * dt;
+            if (_integrator < -_imax) {
+                _integrator = -_imax;
+            } else if (_integrator > _imax) {
+                _integrator = _imax;
+            }
+            return _integrator;
+        }
+        return 0;
+    }
+    int32_t get_leaky_i(int32_t error, float dt, float leak_rate) {
+        if((_ki != 0) && (dt != 0)){
+            _integrator -= (float)_integrator * leak_rate;
+            _integrator += ((float)error * _ki) * dt;
+            if (_integrator < -_imax) {
+                _integrator = -_imax;
+            } else if (_integrator > _imax) {
+                _integrator = _imax;
+            }
+            return _integrator;
+        }
+        return 0;
+    }
+    int32_t get_d(int32_t input, float dt) {
+        if ((_kd != 0) && (dt != 0)) {
+            float derivative;
+            if (isnan(_last_derivative)) {
+                derivative = 0;
+                _last_derivative = 0;
+            } else {
+                derivative = (input - _last_input) / dt;
+            }
+            derivative = _last_derivative +
+                (dt / ( _filter + dt)) * (derivative - _last_derivative);
+            _last_input = input;
+            _last_derivative = derivative;
+            return _kd * derivative;
+        }
+        return 0;
+    }
+    float get_integrator() const { return _integrator; }
+    void reset_I() { _integrator = 0; _last_derivative = NAN; }
+
+private:
+    float _kp, _ki, _kd;
+    int16_t _imax;
+    float _integrator;
+    int32_t _last_input;
+    float _last_derivative;
+    static const float _filter;
+};
+const float Old_AC_PID::_filter = 7.9577e-3;
+
+class Old_APM_PI {
+public:
+    Old_APM_PI(float p, float i, int16_t imax) :
+        _kp(p), _ki(i), _imax(imax), _integrator(0) {}
+
+    int32_t get_pi(int32_t error, float dt) {
+        int32_t p = (float)error * _kp;
+        if(dt != 0) {
+            _integrator += ((float)error * _ki) * dt;
+            if (_integrator < -_imax) {
+                _integrator = -_imax;
+            } else if (_integrator > _imax) {
+                _integrator = _imax;
+            }
+        }
+        return p + (int32_t)_integrator;
+    }
+    void reset_I() { _integrator = 0; }
+
+private:
+    float _kp, _ki;
+    int16_t _imax;
+    float _integrator;
+};
+
+// PID::get_pid() with the time it read from millis() given to it
+class Old_PID {
+public:
+    Old_PID(float p, float i, float d, int16_t imax) :
+        _kp(p), _ki(i), _kd(d), _imax(imax),
+        _integrator(0), _last_error(0), _last_derivative(NAN), _last_t(0) {}
+
+    float get_pid(float error, float scaler, uint32_t tnow) {
+        uint32_t dt = tnow - _last_t;
+        float output = 0;
+        if (_last_t == 0 || dt > 1000) {
+            dt = 0;
+            reset_I();
+        }
+        _last_t = tnow;
+        float delta_time = (float)dt / 1000.0f;
+        output += error * _kp;
+        if ((fabsf(_kd) > 0) && (dt > 0)) {
+            float derivative;
+            if (isnan(_last_derivative)) {
+                derivative = 0;
+                _last_derivative = 0;
+            } else {
+                derivative = (error - _last_error) / delta_time;
+            }
+            float RC = 1/(2*PI*_fCut);
+            derivative = _last_derivative +
+                ((delta_time / (RC + delta_time)) *
+                 (derivative - _last_derivative));
+            _last_error = error;
+            _last_derivative = derivative;
+            output += _kd * derivative;
+        }
+        output *= scaler;
+        if ((fabsf(_ki) > 0) && (dt > 0)) {
+            _integrator += (error * _ki) * scaler * delta_time;
+            if (_integrator < -_imax) {
+                _integrator = -_imax;
+            } else if (_integrator > _imax) {
+                _integrator = _imax;
+            }
+            output += _integrator;
+        }
+        return output;
+    }
+    void reset_I() { _integrator = 0; _last_derivative = NAN; }
+
+private:
+    float _kp, _ki, _kd;
+    int16_t _imax;
+    float _integrator;
+    float _last_error;
+    float _last_derivative;
+    uint32_t _last_t;
+    static const uint8_t _fCut = 20;
+};
+
+// repeatable pseudo random numbers
+static uint32_t seed = 1;
+static int32_t rand_range(int32_t low, int32_t high)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return low + (int32_t)((seed >> 8) % (uint32_t)(high - low + 1));
+}
+
+// the rate controllers of each kind, with the gains of a quad
+#define ROLL_GAINS  0.15f, 0.1f, 0.004f, 500
+#define PITCH_GAINS 0.15f, 0.1f, 0.004f, 500
+#define YAW_GAINS   0.2f, 0.02f, 0, 800
+
+static Old_AC_PID old_pid[3] = {
+    Old_AC_PID(ROLL_GAINS), Old_AC_PID(PITCH_GAINS), Old_AC_PID(YAW_GAINS)
+};
+AC_PID call_roll(ROLL_GAINS), call_pitch(PITCH_GAINS), call_yaw(YAW_GAINS);
+static AC_PID *call_pid[3] = { &call_roll, &call_pitch, &call_yaw };
+AC_PID bank_roll(ROLL_GAINS), bank_pitch(PITCH_GAINS), bank_yaw(YAW_GAINS);
+static AC_PIDBank bank(bank_roll, bank_pitch, bank_yaw);
+
+struct rate_terms {
+    int32_t p, i, d;
+};
+
+// one axis as the main loop rate controllers did it
+#define RATE_PID(pid, error, dt, limit, t) do {                         \
+        (t).p = (pid).get_p(error);                                     \
+        (t).i = (pid).get_integrator();                                 \
+        if (!(limit) || (((t).i>0&&(error)<0)||((t).i<0&&(error)>0))) { \
+            (t).i = (pid).get_i(error, dt);                             \
+        }                                                               \
+        (t).d = (pid).get_d(error, dt);                                 \
+    } while (0)
+
+static void update_old(const int32_t error[3], float dt, bool limit_rp, bool limit_yaw, struct rate_terms t[3])
+{
+    for (uint8_t axis=0; axis<3; axis++) {
+        RATE_PID(old_pid[axis], error[axis], dt, axis == 2 ? limit_yaw : limit_rp, t[axis]);
+    }
+}
+
+static void update_calls(const int32_t error[3], float dt, bool limit_rp, bool limit_yaw, struct rate_terms t[3])
+{
+    for (uint8_t axis=0; axis<3; axis++) {
+        RATE_PID(*call_pid[axis], error[axis], dt, axis == 2 ? limit_yaw : limit_rp, t[axis]);
+    }
+}
+
+static void random_step(int32_t error[3], float &dt, bool &limit_rp, bool &limit_yaw)
+{
+    static const float dts[] = { 0.0025f, 0.005f, 0.01f, 0.0101f, 0 };
+    for (uint8_t axis=0; axis<3; axis++) {
+        error[axis] = rand_range(-6000, 6000);
+    }
+    // mostly small errors, as in flight
+    if (rand_range(0, 3) != 0) {
+        for (uint8_t axis=0; axis<3; axis++) {
+            error[axis] /= 40;
+        }
+    }
+    dt = dts[rand_range(0, 20) == 0 ? 4 : rand_range(0, 3)];
+    limit_rp = rand_range(0, 4) == 0;
+    limit_yaw = rand_range(0, 4) == 0;
+}
+
+static void reset_rate_controllers(void)
+{
+    for (uint8_t axis=0; axis<3; axis++) {
+        old_pid[axis].reset_I();
+        call_pid[axis]->reset_I();
+    }
+    bank_roll.reset_I();
+    bank_pitch.reset_I();
+    bank_yaw.reset_I();
+}
+
+static uint32_t check_rate_controllers(void)
+{
+    uint32_t errors = 0;
+
+    // the benchmark leaves the controllers in different states
+    reset_rate_controllers();
+
+    for (uint32_t step=0; step<NUM_STEPS; step++) {
+        int32_t error[3];
+        float dt;
+        bool limit_rp, limit_yaw;
+        random_step(error, dt, limit_rp, limit_yaw);
+
+        if (rand_range(0, 500) == 0) {
+            reset_rate_controllers();
+        }
+
+        struct rate_terms t_old[3], t_calls[3];
+        update_old(error, dt, limit_rp, limit_yaw, t_old);
+        update_calls(error, dt, limit_rp, limit_yaw, t_calls);
+        bank.update(error, dt, limit_rp, limit_yaw);
+
+        for (uint8_t axis=0; axis<3; axis++) {
+            const AC_PIDBank::terms &t_bank = bank.get_terms(axis);
+            if (t_calls[axis].p != t_old[axis].p || t_calls[axis].i != t_old[axis].i ||
+                t_calls[axis].d != t_old[axis].d ||
+                t_bank.p != t_old[axis].p || t_bank.i != t_old[axis].i || t_bank.d != t_old[axis].d) {
+                if (errors == 0) {
+                    hal.console->printf_P(PSTR("step %lu axis %u: old %ld/%ld/%ld calls %ld/%ld/%ld bank %ld/%ld/%ld\n"),
+                                          (unsigned long)step, (unsigned)axis,
+                                          (long)t_old[axis].p, (long)t_old[axis].i, (long)t_old[axis].d,
+                                          (long)t_calls[axis].p, (long)t_calls[axis].i, (long)t_calls[axis].d,
+                                          (long)t_bank.p, (long)t_bank.i, (long)t_bank.d);
+                }
+                errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+// the leaky integrator of the heli rate controllers, and APM_PI
+static uint32_t check_leaky_i_and_pi(void)
+{
+    Old_AC_PID old_leaky(ROLL_GAINS);
+    AC_PID leaky(ROLL_GAINS);
+    Old_APM_PI old_pi(1.0f, 0.5f, 300);
+    APM_PI pi(1.0f, 0.5f, 300);
+    uint32_t errors = 0;
+
+    for (uint32_t step=0; step<NUM_STEPS; step++) {
+        int32_t error[3];
+        float dt;
+        bool limit_rp, limit_yaw;
+        random_step(error, dt, limit_rp, limit_yaw);
+        if (rand_range(0, 500) == 0) {
+            old_leaky.reset_I();
+            leaky.reset_I();
+            old_pi.reset_I();
+            pi.reset_I();
+        }
+        if (leaky.get_leaky_i(error[0], dt, 0.02f) != old_leaky.get_leaky_i(error[0], dt, 0.02f) ||
+            leaky.get_integrator() != old_leaky.get_integrator()) {
+            errors++;
+        }
+        if (pi.get_pi(error[1], dt) != old_pi.get_pi(error[1], dt)) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/*
+  PID reads the time itself, so each step waits for the start of a
+  millisecond and gives the old code the same time
+ */
+static uint32_t check_pid(void)
+{
+    Old_PID old_pid_plane(0.8f, 0.2f, 0.05f, 3000);
+    PID pid_plane(0.8f, 0.2f, 0.05f, 3000);
+    uint32_t errors = 0;
+
+    for (uint16_t step=0; step<NUM_PID_STEPS; step++) {
+        uint32_t wait = rand_range(1, 8);
+        uint32_t start = hal.scheduler->millis();
+        uint32_t tnow;
+        do {
+            tnow = hal.scheduler->millis();
+        } while (tnow - start < wait);
+
+        float error = rand_range(-20000, 20000) * 0.05f;
+        float scaler = rand_range(50, 200) * 0.01f;
+        float out = pid_plane.get_pid(error, scaler);
+        if (hal.scheduler->millis() != tnow) {
+            // a millisecond went by in the call, so the old code
+            // cannot be given the same time. Start again
+            return errors + check_pid();
+        }
+        float out_old = old_pid_plane.get_pid(error, scaler, tnow);
+        if (memcmp(&out, &out_old, sizeof(out)) != 0) {
+            if (errors == 0) {
+                hal.console->printf_P(PSTR("PID step %u: %f should be %f\n"),
+                                      (unsigned)step, out, out_old);
+            }
+            errors++;
+        }
+    }
+    return errors;
+}
+
+static void bench_rate_controllers(void)
+{
+    float cost_calls, cost_bank;
+    int32_t error[3] = { 150, -80, 40 };
+    struct rate_terms t[3];
+    const float dt = 0.01f;
+
+    BENCH(cost_calls, update_calls(error, dt, false, false, t));
+    BENCH(cost_bank, bank.update(error, dt, false, false));
+
+    hal.console->printf("%-34s %9.1f\n", "get_p, get_i and get_d", cost_calls);
+    hal.console->printf("%-34s %9.1f %6.2fx\n", "AC_PIDBank", cost_bank,
+                        cost_calls / cost_bank);
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("PID benchmark"));
+    cycles_init();
+}
+
+void loop(void)
+{
+    uint32_t rate_errors = check_rate_controllers();
+    uint32_t other_errors = check_leaky_i_and_pi();
+    uint32_t pid_errors = check_pid();
+    hal.console->printf_P(PSTR("%lu rate controller, %lu leaky I and PI, %lu PID mismatches\n"),
+                          (unsigned long)rate_errors,
+                          (unsigned long)other_errors,
+                          (unsigned long)pid_errors);
+
+    hal.console->printf("%-34s %9s %7s   (%s per update of 3 axes)\n",
+                        "", "cost", "speedup", CYCLE_UNITS);
+    bench_rate_controllers();
+    hal.console->println();
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
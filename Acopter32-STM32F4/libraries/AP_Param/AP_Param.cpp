@@ -78,6 +78,15 @@ uint8_t AP_Param::_num_vars;
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
+#if AP_PARAM_NAME_INDEX
+// sorted name hash index, built by setup()
+AP_Param::NameIndexEntry *AP_Param::_name_index;
+uint16_t AP_Param::_name_index_count;
+
+// _var_info[] indexes sorted by name, built by setup()
+uint8_t *AP_Param::_object_index;
+#endif
+
 // write to EEPROM
 void AP_Param::eeprom_write_check(const void *ptr, uint16_t ofs, uint8_t size)
 {
@@ -229,6 +238,13 @@ bool AP_Param::setup(void)
         erase_all();
     }
 
+#if AP_PARAM_NAME_INDEX
+    if (_var_info != NULL) {
+        build_name_index();
+        build_object_index();
+    }
+#endif
+
     return true;
 }
 
@@ -584,6 +600,20 @@ AP_Param::find_group(const char *name, uint8_t vindex, const struct GroupInfo *g
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype)
+{
+#if AP_PARAM_NAME_INDEX
+    // names longer than AP_MAX_NAME_SIZE are not in the index
+    if (_name_index != NULL && strnlen(name, AP_MAX_NAME_SIZE+1) <= AP_MAX_NAME_SIZE) {
+        return find_indexed(name, ptype);
+    }
+#endif
+    return find_linear(name, ptype);
+}
+
+// Find a variable by name, scanning the var_info tables
+//
+AP_Param *
+AP_Param::find_linear(const char *name, enum ap_var_type *ptype)
 {
     for (uint8_t i=0; i<_num_vars; i++) {
         uint8_t type = PGM_UINT8(&_var_info[i].type);
@@ -638,6 +668,19 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
 //
 AP_Param *
 AP_Param::find_object(const char *name)
+{
+#if AP_PARAM_NAME_INDEX
+    if (_object_index != NULL) {
+        return find_object_indexed(name);
+    }
+#endif
+    return find_object_linear(name);
+}
+
+// Find a object by name, scanning the top level var_info table
+//
+AP_Param *
+AP_Param::find_object_linear(const char *name)
 {
     for (uint8_t i=0; i<_num_vars; i++) {
         if (strcasecmp_P(name, _var_info[i].name) == 0) {
@@ -647,6 +690,154 @@ AP_Param::find_object(const char *name)
     return NULL;
 }
 
+#if AP_PARAM_NAME_INDEX
+// case insensitive 16 bit FNV-1a hash of a parameter name
+uint16_t AP_Param::name_hash(const char *name)
+{
+    uint32_t h = 2166136261UL;
+    char c;
+    while ((c = *name++) != 0) {
+        if (c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        h ^= (uint8_t)c;
+        h *= 16777619UL;
+    }
+    return (uint16_t)(h ^ (h >> 16));
+}
+
+// build the sorted name hash index used by find(). This walks all
+// variables twice, once to count them and once to fill in the index,
+// so it is only done once at startup
+void AP_Param::build_name_index(void)
+{
+    if (_name_index != NULL) {
+        return;
+    }
+
+    ParamToken token;
+    AP_Param *ap;
+    enum ap_var_type type;
+    uint16_t count = 0;
+
+    for (ap=first(&token, &type); ap; ap=next(&token, &type)) {
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+    _name_index = new NameIndexEntry[count];
+    if (_name_index == NULL) {
+        serialDebug("no memory for name index");
+        return;
+    }
+
+    char name[AP_MAX_NAME_SIZE+1];
+    uint16_t n = 0;
+    for (ap=first(&token, &type); ap && n < count; ap=next(&token, &type)) {
+        // a non-zero idx is an element of a Vector3f, which needs
+        // the _X, _Y or _Z suffix
+        ap->copy_name_token(token, name, sizeof(name), token.idx != 0);
+        name[AP_MAX_NAME_SIZE] = 0;
+
+        NameIndexEntry e;
+        e.ap = ap;
+        e.token = token;
+        e.hash = name_hash(name);
+        e.type = type;
+
+        // insertion sort keeps entries with equal hashes in var_info
+        // order, so find() gives the same answer as a linear scan
+        uint16_t i = n;
+        while (i > 0 && _name_index[i-1].hash > e.hash) {
+            _name_index[i] = _name_index[i-1];
+            i--;
+        }
+        _name_index[i] = e;
+        n++;
+    }
+    _name_index_count = n;
+    serialDebug("name index %u entries", (unsigned)n);
+}
+
+// build the sorted _var_info[] index used by find_object()
+void AP_Param::build_object_index(void)
+{
+    if (_object_index != NULL || _num_vars == 0) {
+        return;
+    }
+    _object_index = new uint8_t[_num_vars];
+    if (_object_index == NULL) {
+        serialDebug("no memory for object index");
+        return;
+    }
+
+    char name[AP_MAX_NAME_SIZE+1];
+    for (uint8_t n=0; n<_num_vars; n++) {
+        strncpy_P(name, _var_info[n].name, sizeof(name));
+        name[AP_MAX_NAME_SIZE] = 0;
+        uint8_t i = n;
+        while (i > 0 && strcasecmp_P(name, _var_info[_object_index[i-1]].name) < 0) {
+            _object_index[i] = _object_index[i-1];
+            i--;
+        }
+        _object_index[i] = n;
+    }
+}
+
+// Find a variable by name using the name index
+//
+AP_Param *
+AP_Param::find_indexed(const char *name, enum ap_var_type *ptype)
+{
+    uint16_t hash = name_hash(name);
+
+    // find the first entry with this hash
+    uint16_t lo = 0, hi = _name_index_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (_name_index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // check the name of each candidate, as the hash can collide
+    char name2[AP_MAX_NAME_SIZE+1];
+    for (; lo < _name_index_count && _name_index[lo].hash == hash; lo++) {
+        const NameIndexEntry &e = _name_index[lo];
+        e.ap->copy_name_token(e.token, name2, sizeof(name2), e.token.idx != 0);
+        name2[AP_MAX_NAME_SIZE] = 0;
+        if (strcasecmp(name, name2) == 0) {
+            *ptype = (enum ap_var_type)e.type;
+            return e.ap;
+        }
+    }
+    return NULL;
+}
+
+// Find a object by name using the object index
+//
+AP_Param *
+AP_Param::find_object_indexed(const char *name)
+{
+    // find the first entry not less than name
+    uint8_t lo = 0, hi = _num_vars;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (strcasecmp_P(name, _var_info[_object_index[mid]].name) > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < _num_vars && strcasecmp_P(name, _var_info[_object_index[lo]].name) == 0) {
+        return (AP_Param *)PGM_POINTER(&_var_info[_object_index[lo]].ptr);
+    }
+    return NULL;
+}
+#endif // AP_PARAM_NAME_INDEX
 
 // Save the variable to EEPROM, if supported
 //
@@ -31,6 +31,17 @@
 #define AP_MAX_NAME_SIZE 16
 #define AP_NESTED_GROUPS_ENABLED
 
+// the name index makes find() and find_object() a binary search
+// instead of a walk of every var_info table. It costs about 12 bytes
+// of RAM per parameter, so is disabled on the AVR boards
+#ifndef AP_PARAM_NAME_INDEX
+ #if CONFIG_HAL_BOARD == HAL_BOARD_APM1 || CONFIG_HAL_BOARD == HAL_BOARD_APM2
+  #define AP_PARAM_NAME_INDEX 0
+ #else
+  #define AP_PARAM_NAME_INDEX 1
+ #endif
+#endif
+
 // a variant of offsetof() to work around C++ restrictions.
 // this can only be used when the offset of a variable in a object
 // is constant and known at compile time
@@ -101,7 +112,7 @@ public:
 
     // called once at startup to setup the _var_info[] table. This
     // will also check the EEPROM header and re-initialise it if the
-    // wrong version is found
+    // wrong version is found, and builds the name index if enabled
     static bool setup();
 
     // constructor with var_info
@@ -154,6 +165,14 @@ public:
     static AP_Param * find(const char *name, enum ap_var_type *ptype);
     static AP_Param * find_P(const prog_char_t *name, enum ap_var_type *ptype);
 
+    /// Find a variable by name with a linear scan of the var_info
+    /// tables, bypassing the name index.
+    ///
+    /// This is what find() does when the index is not available. It
+    /// is public so the two can be compared in benchmarks.
+    ///
+    static AP_Param * find_linear(const char *name, enum ap_var_type *ptype);
+
     /// Find a variable by index.
     ///
     ///
@@ -321,6 +340,22 @@ private:
                                     const struct GroupInfo *group_info,
                                     enum ap_var_type *ptype);
     static void                 write_sentinal(uint16_t ofs);
+    static AP_Param *           find_object_linear(const char *name);
+#if AP_PARAM_NAME_INDEX
+    // one entry per named variable, sorted by hash. Vector3f
+    // variables get an entry for the vector and one for each element
+    struct NameIndexEntry {
+        AP_Param *ap;
+        ParamToken token;
+        uint16_t hash;
+        uint8_t type;
+    };
+    static uint16_t             name_hash(const char *name);
+    static void                 build_name_index(void);
+    static void                 build_object_index(void);
+    static AP_Param *           find_indexed(const char *name, enum ap_var_type *ptype);
+    static AP_Param *           find_object_indexed(const char *name);
+#endif
     static bool                 scan(
                                     const struct Param_header *phdr,
                                     uint16_t *pofs);
@@ -341,6 +376,11 @@ private:
     static uint16_t             _eeprom_size;
     static uint8_t              _num_vars;
     static const struct Info *  _var_info;
+#if AP_PARAM_NAME_INDEX
+    static NameIndexEntry *     _name_index;
+    static uint16_t             _name_index_count;
+    static uint8_t *            _object_index;
+#endif
 
     // values filled into the EEPROM header
     static const uint8_t        k_EEPROM_magic0      = 0x50;
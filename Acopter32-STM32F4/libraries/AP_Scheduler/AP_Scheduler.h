@@ -31,6 +31,11 @@
   Sketches should call scheduler.init() on startup, then call
   scheduler.tick() at regular intervals (typically every 10ms). 
 
+  Task intervals are in ticks. A sketch which can run its main loop
+  at more than one rate should work them out from the period of the
+  task and the loop rate, so that the tasks keep the same real time
+  rates at any loop rate
+
   To run tasks use scheduler.run(), passing the amount of time that
   the scheduler is allowed to use before it must return
  */
@@ -0,0 +1,171 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Benchmark of the main loop at 100, 200 and 400Hz, as set by
+// MAIN_LOOP_RATE in ArduCopter.
+//
+// Each rate runs for BENCH_SECONDS with a fast loop doing the attitude
+// work of a copter every tick, and a task table like the ArduCopter
+// one with its periods in milliseconds. The tasks keep their sizes in
+// microseconds whatever the rate, so the report shows the CPU load
+// from the scheduler, the cost of the fast loop, and that each task
+// ran at the same rate in Hz at every loop rate. As in ArduCopter,
+// 300us of each tick is kept free of tasks and counts towards the
+// load, which is most of the difference between the rates on SITL.
+//
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_Math.h>
+#include <AP_Scheduler.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define BENCH_SECONDS 5
+
+// number of ticks of a loop at rate Hz in ms milliseconds
+#define TICKS(rate, ms) ((uint32_t)(ms) * (rate) / 1000)
+
+// how many times each task ran in the current benchmark
+static uint16_t task_runs[5];
+
+// stand in for the work of a task, by using its time in microseconds
+static void burn(uint16_t usec)
+{
+    uint32_t start = hal.scheduler->micros();
+    while (hal.scheduler->micros() - start < usec) ;
+}
+
+static void task_50hz_nav(void)   { task_runs[0]++; burn(300); }
+static void task_50hz_gcs(void)   { task_runs[1]++; burn(400); }
+static void task_10hz(void)       { task_runs[2]++; burn(600); }
+static void task_3hz(void)        { task_runs[3]++; burn(80); }
+static void task_1hz(void)        { task_runs[4]++; burn(300); }
+
+#define TASK_TABLE(rate) {                                  \
+        { task_50hz_nav,  TICKS(rate, 20),    450 },        \
+        { task_50hz_gcs,  TICKS(rate, 20),    550 },        \
+        { task_10hz,      TICKS(rate, 100),   800 },        \
+        { task_3hz,       TICKS(rate, 330),    90 },        \
+        { task_1hz,       TICKS(rate, 1000),  420 },        \
+    }
+
+static const AP_Scheduler::Task tasks_100hz[] PROGMEM = TASK_TABLE(100);
+static const AP_Scheduler::Task tasks_200hz[] PROGMEM = TASK_TABLE(200);
+static const AP_Scheduler::Task tasks_400hz[] PROGMEM = TASK_TABLE(400);
+
+static const struct {
+    uint16_t rate;
+    const AP_Scheduler::Task *tasks;
+} benchmarks[] = {
+    { 100, tasks_100hz },
+    { 200, tasks_200hz },
+    { 400, tasks_400hz },
+};
+
+static AP_Scheduler schedulers[3];
+
+// the attitude state of the fast loop
+static Matrix3f dcm;
+static Vector3f rate_integrator;
+static Vector3f last_rate_error;
+static volatile float motor_out;
+
+/*
+  the per tick work of the copter fast loop: a DCM update, three rate
+  PIDs and a four motor mix
+ */
+static void fast_loop(float dt)
+{
+    Vector3f gyro(0.02f, -0.01f, 0.005f);
+    dcm.rotate(gyro * dt);
+
+    float error = dcm.a * dcm.b;
+    Vector3f t0 = dcm.a - (dcm.b * (0.5f * error));
+    Vector3f t1 = dcm.b - (dcm.a * (0.5f * error));
+    dcm.a = t0 * (1.0f / t0.length());
+    dcm.b = t1 * (1.0f / t1.length());
+    dcm.c = dcm.a % dcm.b;
+
+    Vector3f rate_error = Vector3f(0.1f, 0.0f, -0.05f) - gyro;
+    rate_integrator += rate_error * dt;
+    Vector3f d = (rate_error - last_rate_error) / dt;
+    last_rate_error = rate_error;
+    Vector3f out = rate_error * 0.15f + rate_integrator * 0.1f + d * 0.004f;
+
+    motor_out = out.x + out.y + out.z;
+    motor_out = -out.x - out.y + out.z;
+    motor_out = out.x - out.y - out.z;
+    motor_out = -out.x + out.y - out.z;
+}
+
+static void run_benchmark(uint8_t b)
+{
+    uint16_t rate = benchmarks[b].rate;
+    uint32_t period = 1000000UL / rate;
+    AP_Scheduler &scheduler = schedulers[b];
+
+    memset(task_runs, 0, sizeof(task_runs));
+    dcm.identity();
+    rate_integrator.zero();
+    last_rate_error.zero();
+
+    uint32_t ticks = (uint32_t)rate * BENCH_SECONDS;
+    uint32_t fast_loop_time = 0;
+    uint32_t long_loops = 0;
+    uint32_t next_tick = hal.scheduler->micros() + period;
+
+    for (uint32_t i=0; i<ticks; i++) {
+        // wait for the tick, as the main loop waits for the IMU
+        while ((int32_t)(hal.scheduler->micros() - next_tick) < 0) ;
+        uint32_t timer = hal.scheduler->micros();
+        if (timer - next_tick > period / 20) {
+            long_loops++;
+        }
+        next_tick += period;
+
+        fast_loop(period * 1.0e-6f);
+        fast_loop_time += hal.scheduler->micros() - timer;
+
+        scheduler.tick();
+        uint32_t time_used = hal.scheduler->micros() - timer;
+        if (time_used + 300 < period) {
+            scheduler.run(period - time_used - 300);
+        } else {
+            scheduler.run(0);
+        }
+    }
+
+    hal.console->printf_P(PSTR("%3uHz  load %5.1f%%  fast loop %6.1fus  late %4lu  task Hz:"),
+                          (unsigned)rate,
+                          scheduler.load_average(period) * 100.0f,
+                          fast_loop_time / (float)ticks,
+                          (unsigned long)long_loops);
+    for (uint8_t t=0; t<5; t++) {
+        hal.console->printf_P(PSTR(" %5.1f"), task_runs[t] / (float)BENCH_SECONDS);
+    }
+    hal.console->println();
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("Main loop rate benchmark"));
+    hal.console->println_P(PSTR("tasks: 50Hz nav, 50Hz gcs, 10Hz, 3Hz, 1Hz"));
+    for (uint8_t b=0; b<3; b++) {
+        schedulers[b].init(benchmarks[b].tasks, 5);
+    }
+}
+
+void loop(void)
+{
+    for (uint8_t b=0; b<3; b++) {
+        run_benchmark(b);
+    }
+    hal.console->println();
+}
+
+AP_HAL_MAIN();
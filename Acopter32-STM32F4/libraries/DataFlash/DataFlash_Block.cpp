@@ -4,11 +4,11 @@
  */
 
 #include <AP_HAL.h>
-#include "wirish.h"
-#include <stm32f4xx.h>
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
 
+#include "wirish.h"
+#include <stm32f4xx.h>
 #include "DataFlash.h"
 
 extern AP_HAL::HAL& hal;
@@ -231,7 +231,7 @@ bool DataFlash_Block::NeedErase(void)
 
 /* END REVOMINI DATA FLASH */
 
-#elif CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#else // the page buffered flash of the other boards
 
 #include "DataFlash.h"
 
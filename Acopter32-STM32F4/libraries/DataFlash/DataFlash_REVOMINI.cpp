@@ -14,6 +14,9 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 #include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
+
 #include "DataFlash_REVOMINI.h"
 #include <wirish.h>
 
@@ -273,3 +276,4 @@ void DataFlash_REVOMINI::Flash_Jedec_EraseSector(uint32_t chip_offset)
 
 // *** END OF INTERNAL FUNCTIONS ***
 
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_REVOMINI
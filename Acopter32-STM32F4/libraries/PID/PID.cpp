@@ -44,28 +44,8 @@ float PID::get_pid(float error, float scaler)
 
     // Compute derivative component if time has elapsed
     if ((fabsf(_kd) > 0) && (dt > 0)) {
-        float derivative;
-
-		if (isnan(_last_derivative)) {
-			// we've just done a reset, suppress the first derivative
-			// term as we don't want a sudden change in input to cause
-			// a large D output change			
-			derivative = 0;
-			_last_derivative = 0;
-		} else {
-			derivative = (error - _last_error) / delta_time;
-		}
-
-        // discrete low pass filter, cuts out the
-        // high frequency noise that can drive the controller crazy
         float RC = 1/(2*PI*_fCut);
-        derivative = _last_derivative +
-                     ((delta_time / (RC + delta_time)) *
-                      (derivative - _last_derivative));
-
-        // update state
-        _last_error             = error;
-        _last_derivative    = derivative;
+        float derivative = _core.derivative(error, delta_time, _core.filter_gain(RC, delta_time));
 
         // add in derivative component
         output                          += _kd * derivative;
@@ -76,13 +56,7 @@ float PID::get_pid(float error, float scaler)
 
     // Compute integral component if time has elapsed
     if ((fabsf(_ki) > 0) && (dt > 0)) {
-        _integrator             += (error * _ki) * scaler * delta_time;
-        if (_integrator < -_imax) {
-            _integrator = -_imax;
-        } else if (_integrator > _imax) {
-            _integrator = _imax;
-        }
-        output                          += _integrator;
+        output                          += _core.integrate((error * _ki) * scaler, delta_time, _imax);
     }
 
     return output;
@@ -97,10 +71,7 @@ int16_t PID::get_pid_4500(float error, float scaler)
 void
 PID::reset_I()
 {
-    _integrator = 0;
-	// we use NAN (Not A Number) to indicate that the last 
-	// derivative value is not valid
-    _last_derivative = NAN;
+    _core.reset_I();
 }
 
 void
@@ -8,6 +8,7 @@
 
 #include <AP_Common.h>
 #include <AP_Param.h>
+#include <AP_PIDCore.h>
 #include <stdlib.h>
 #include <math.h>               // for fabs()
 
@@ -26,9 +27,6 @@ public:
         _ki = initial_i;
         _kd = initial_d;
         _imax = initial_imax;
-
-		// set _last_derivative as invalid when we startup
-		_last_derivative = NAN;
     }
 
     /// Iterate the PID, return the new control value
@@ -95,7 +93,7 @@ public:
     }
 
     float        get_integrator() const {
-        return _integrator;
+        return _core.integrator;
     }
 
     static const struct AP_Param::GroupInfo        var_info[];
@@ -106,9 +104,8 @@ private:
     AP_Float        _kd;
     AP_Int16        _imax;
 
-    float           _integrator;///< integrator value
-    float           _last_error;///< last error for derivative
-    float           _last_derivative;///< last derivative for low-pass filter
+    /// integrator and filtered derivative of the error
+    AP_PIDCore<AP_PID_I | AP_PID_D | AP_PID_D_FILTER> _core;
     uint32_t        _last_t;///< last time get_pid() was called in millis
 
     float           _get_pid(float error, uint16_t dt, float scaler);
@@ -8,6 +8,7 @@
 #include <AP_Progmem.h>
 #include <AP_Param.h>
 #include <AP_Math.h>
+#include <AP_PIDCore.h> // PID state shared by the PID libraries
 #include <PID.h> // ArduPilot Mega RC Library
 
 #include <AP_HAL_AVR.h>
@@ -174,6 +174,17 @@ RC_Channel::set_pwm_no_deadzone(int16_t pwm)
     }
 }
 
+void
+RC_Channel::set_pwm_all(uint16_t *periods, uint8_t first_ch)
+{
+    hal.rcin->read(periods, RC_INPUT_CHANNELS);
+    for (uint8_t i=first_ch; i<RC_INPUT_CHANNELS; i++) {
+        if (rc_ch[i] != NULL) {
+            rc_ch[i]->set_pwm(periods[i]);
+        }
+    }
+}
+
 int16_t
 RC_Channel::control_mix(float value)
 {
@@ -368,6 +379,17 @@ RC_Channel::input()
     radio_in = hal.rcin->read(_ch_out);
 }
 
+// input() from the inputs read by one call to the RC input driver
+void
+RC_Channel::input(const uint16_t *periods)
+{
+    if (_ch_out < RC_INPUT_CHANNELS) {
+        radio_in = periods[_ch_out];
+    } else {
+        input();
+    }
+}
+
 uint16_t
 RC_Channel::read() const
 {
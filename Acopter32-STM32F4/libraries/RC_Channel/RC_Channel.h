@@ -19,6 +19,10 @@
 
 #define RC_MAX_CHANNELS 14
 
+// the inputs read with one call to the RC input driver, which all the
+// drivers give
+#define RC_INPUT_CHANNELS 8
+
 /// @class	RC_Channel
 /// @brief	Object managing one RC channel
 class RC_Channel {
@@ -59,6 +63,12 @@ public:
     void        set_pwm(int16_t pwm);
     void        set_pwm_no_deadzone(int16_t pwm);
 
+    // read all the inputs with one call to the RC input driver into
+    // periods, which holds RC_INPUT_CHANNELS, and set each channel from
+    // first_ch up from its own input. The channels below first_ch are
+    // left to the caller, e.g. when their inputs are remapped
+    static void set_pwm_all(uint16_t *periods, uint8_t first_ch = 0);
+
     // pwm is stored here
     int16_t        radio_in;
 
@@ -103,6 +113,7 @@ public:
     void                                            output_trim() const;
     uint16_t                                        read() const;
     void                                            input();
+    void                                            input(const uint16_t *periods);
     void                                            enable_out();
 
     static const struct AP_Param::GroupInfo         var_info[];
@@ -183,10 +183,17 @@ RC_Channel_aux::set_radio_to_trim(RC_Channel_aux::Aux_servo_function_t function)
 void
 RC_Channel_aux::copy_radio_in_out(RC_Channel_aux::Aux_servo_function_t function, bool do_input_output)
 {
+    // the inputs are read once, for all the channels with the function
+    uint16_t periods[RC_INPUT_CHANNELS];
+    bool have_periods = false;
     for (uint8_t i = 0; i < 8; i++) {
         if (_aux_channels[i] && _aux_channels[i]->function.get() == function) {
 			if (do_input_output) {
-				_aux_channels[i]->input();
+				if (!have_periods) {
+					hal.rcin->read(periods, RC_INPUT_CHANNELS);
+					have_periods = true;
+				}
+				_aux_channels[i]->input(periods);
 			}
 			_aux_channels[i]->radio_out = _aux_channels[i]->radio_in;
 			if (do_input_output) {
@@ -0,0 +1,147 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Cost of the RC input processing of a copter's eight channels, read
+// one channel at a time with hal.rcin->read(ch) and converted with
+// set_pwm(), against RC_Channel::set_pwm_all() which reads them all
+// with one hal.rcin->read(periods, len) call. The conversions are the
+// same divides either way, so only the reads differ.
+//
+// Costs are in CPU cycles from the DWT cycle counter on the
+// Cortex-M4 boards, in time stamp counter cycles on x86 and in
+// nanoseconds from micros() elsewhere. Each is timed over BENCH_REPEAT
+// calls and the fastest of BENCH_ROUNDS batches is kept.
+//
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_Math.h>
+#include <RC_Channel.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define BENCH_REPEAT  200
+#define BENCH_ROUNDS  10
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define CYCLE_UNITS "TSC cycles"
+static void cycles_init(void) {}
+static uint32_t cycles(void) { return (uint32_t)__rdtsc(); }
+#elif defined(__ARM_ARCH_7EM__)
+// the DWT cycle counter of the Cortex-M4
+#define DEMCR      (*(volatile uint32_t *)0xE000EDFC)
+#define DWT_CTRL   (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#define CYCLE_UNITS "cycles"
+static void cycles_init(void)
+{
+    DEMCR |= (1UL<<24);
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1;
+}
+static uint32_t cycles(void) { return DWT_CYCCNT; }
+#else
+#define CYCLE_UNITS "ns"
+static void cycles_init(void) {}
+static uint32_t cycles(void) { return hal.scheduler->micros() * 1000UL; }
+#endif
+
+/*
+  time BENCH_REPEAT runs of code, keeping the fastest batch, and give
+  the cost of one run in cost
+ */
+#define BENCH(cost, code) do {                              \
+        uint32_t best = 0xFFFFFFFF;                         \
+        for (uint8_t round=0; round<BENCH_ROUNDS; round++) { \
+            uint32_t start = cycles();                      \
+            for (uint16_t rep=0; rep<BENCH_REPEAT; rep++) { \
+                code;                                       \
+            }                                               \
+            best = min(best, cycles() - start);             \
+        }                                                   \
+        cost = best / (float)BENCH_REPEAT;                  \
+    } while (0)
+
+// the channels of a copter: roll, pitch, throttle, yaw and four aux
+RC_Channel rc_1(0), rc_2(1), rc_3(2), rc_4(3);
+RC_Channel rc_5(4), rc_6(5), rc_7(6), rc_8(7);
+static RC_Channel *rc[RC_INPUT_CHANNELS] = { &rc_1, &rc_2, &rc_3, &rc_4, &rc_5, &rc_6, &rc_7, &rc_8 };
+
+// the input processing as the channels did it one at a time
+static void read_by_channel(void)
+{
+    for (uint8_t i=0; i<RC_INPUT_CHANNELS; i++) {
+        rc[i]->set_pwm(hal.rcin->read(i));
+    }
+}
+
+static void read_all(void)
+{
+    uint16_t periods[RC_INPUT_CHANNELS];
+    RC_Channel::set_pwm_all(periods);
+}
+
+static void report(const char *name, float old_cost, float new_cost)
+{
+    hal.console->printf("%-28s %10.1f %10.1f %6.2fx\n",
+                        name, old_cost, new_cost,
+                        new_cost > 0 ? old_cost / new_cost : 0.0f);
+}
+
+static void bench_all(void)
+{
+    float old_cost, new_cost;
+
+    BENCH(old_cost, read_by_channel());
+    BENCH(new_cost, read_all());
+    report("read and convert 8 channels", old_cost, new_cost);
+
+    // both ways should leave the same control_in
+    int16_t control[RC_INPUT_CHANNELS];
+    read_by_channel();
+    for (uint8_t i=0; i<RC_INPUT_CHANNELS; i++) {
+        control[i] = rc[i]->control_in;
+    }
+    read_all();
+    for (uint8_t i=0; i<RC_INPUT_CHANNELS; i++) {
+        if (rc[i]->control_in != control[i]) {
+            hal.console->printf_P(PSTR("ch%u: %d should be %d\n"),
+                                  (unsigned)i+1, (int)rc[i]->control_in, (int)control[i]);
+        }
+    }
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("RC_Channel input benchmark"));
+    cycles_init();
+
+    rc_1.set_angle(4500);
+    rc_1.set_default_dead_zone(30);
+    rc_2.set_angle(4500);
+    rc_2.set_default_dead_zone(30);
+    rc_2.set_reverse(true);
+    rc_3.set_range(130, 1000);
+    rc_4.set_angle(4500);
+    rc_4.set_default_dead_zone(40);
+    rc_5.set_range(0, 1000);
+    rc_6.set_range(0, 1000);
+    rc_7.set_range(0, 1000);
+    rc_8.set_range(0, 1000);
+}
+
+void loop(void)
+{
+    hal.console->printf("%-28s %10s %10s %7s   (%s)\n",
+                        "", "by channel", "all", "speedup", CYCLE_UNITS);
+    bench_all();
+    hal.console->println();
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
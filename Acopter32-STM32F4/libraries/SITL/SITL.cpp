@@ -46,6 +46,15 @@ const AP_Param::GroupInfo SITL::var_info[] PROGMEM = {
     AP_GROUPINFO("GPS_HZ",        18, SITL,  gps_hertz,  5),
     AP_GROUPINFO("BATT_VOLTAGE",  19, SITL,  batt_voltage,  12.6),
     AP_GROUPINFO("ASPD_RND",      20, SITL,  aspd_noise,  0.5),
+    AP_GROUPINFO("IMU_RATE",      21, SITL,  imu_rate,  1000),
+    AP_GROUPINFO("IMU_DELAY",     22, SITL,  imu_delay,  0),
+    AP_GROUPINFO("IMU_FILTER",    23, SITL,  imu_filter,  0),
+    AP_GROUPINFO("VIB_FREQ",      24, SITL,  vib_freq,  180),
+    AP_GROUPINFO("GYR_VIB",       25, SITL,  gyro_vib,  0),
+    AP_GROUPINFO("ACC_VIB",       26, SITL,  accel_vib,  0),
+    AP_GROUPINFO("VIB_HARM",      27, SITL,  vib_harmonics,  2),
+    AP_GROUPINFO("SEED",          28, SITL,  seed,  0),
+    AP_GROUPINFO("REPEATABLE",    29, SITL,  repeatable,  0),
     AP_GROUPEND
 };
 
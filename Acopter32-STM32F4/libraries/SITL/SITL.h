@@ -8,6 +8,10 @@
 #include <AP_Math.h>
 #include <GCS_MAVLink.h>
 
+// the largest SIM_SEED. Parameters are logged as floats, which hold
+// every integer up to 2^24, so the logged seed can repeat the run
+#define SITL_SEED_MAX 16777215UL
+
 struct PACKED sitl_fdm {
 	// this is the packet sent by the simulator
 	// to the APM executable to update the simulator state
@@ -66,6 +70,19 @@ public:
     AP_Int8  gps_hertz;   // GPS update rate in Hz
     AP_Float batt_voltage; // battery voltage base
 
+    // IMU sensor model
+    AP_Int16 imu_rate;    // sample rate in Hz, 0 for one sample per frame
+    AP_Int8  imu_delay;   // sensor delay in milliseconds
+    AP_Float imu_filter;  // sensor low pass filter in Hz, 0 for none
+    AP_Float vib_freq;    // motor vibration frequency in Hz
+    AP_Float gyro_vib;    // gyro vibration in degrees/second
+    AP_Float accel_vib;   // accel vibration in m/s/s
+    AP_Int8  vib_harmonics; // number of harmonics of vib_freq
+
+    // random numbers
+    AP_Int32 seed;        // seed of the sensor noise, 0 for one from the clock
+    AP_Int8  repeatable;  // sensor noise and timing from the simulated time
+
     // wind control
     AP_Float wind_speed;
     AP_Float wind_direction;
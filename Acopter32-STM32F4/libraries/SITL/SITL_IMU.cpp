@@ -0,0 +1,200 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+	SITL_IMU.cpp - model of an IMU as its driver samples it
+
+*/
+
+#include "SITL_IMU.h"
+
+// a simulator pause longer than this restarts the sampling rather
+// than filling the gap with samples
+#define SITL_IMU_MAX_GAP_USEC 100000
+
+SITL_IMU::SITL_IMU() :
+    _period_usec(1000),
+    _delay_samples(0),
+    _filter_hz(0),
+    _gyro_noise(0),
+    _accel_noise(0),
+    _seed(0),
+    _stream(0),
+    _sim_time(false),
+    _vib_freq(0),
+    _vib_gyro(0),
+    _vib_accel(0),
+    _vib_harmonics(1)
+{
+    reset();
+}
+
+void SITL_IMU::reset(void)
+{
+    _have_state = false;
+    _last_usec = 0;
+    _next_sample_usec = 0;
+    _vib_phase = 0;
+    _delay_head = 0;
+    _delay_count = 0;
+}
+
+void SITL_IMU::set_sensor(uint16_t rate_hz, uint8_t delay_ms, float filter_hz)
+{
+    // a rate of zero gives one sample per simulator frame
+    _period_usec = rate_hz ? 1000000UL / rate_hz : 0;
+    uint32_t delay = (uint32_t)delay_ms * rate_hz / 1000;
+    _delay_samples = min(delay, (uint32_t)SITL_IMU_MAX_DELAY - 1);
+    _filter_hz = filter_hz;
+}
+
+void SITL_IMU::set_noise(float gyro_noise, float accel_noise)
+{
+    _gyro_noise = gyro_noise;
+    _accel_noise = accel_noise;
+}
+
+void SITL_IMU::set_seed(uint32_t seed, uint8_t stream, bool sim_time)
+{
+    _seed = seed;
+    _stream = stream;
+    _sim_time = sim_time;
+    _random.set_seed(seed, stream);
+}
+
+void SITL_IMU::set_vibration(float freq_hz, float gyro_amp, float accel_amp, uint8_t harmonics)
+{
+    _vib_freq = freq_hz;
+    _vib_gyro = gyro_amp;
+    _vib_accel = accel_amp;
+    _vib_harmonics = constrain_int16(harmonics, 1, SITL_IMU_MAX_HARMONICS);
+}
+
+/*
+  the vibration at the current motor phase, after the sensor low pass
+  filter. The sensor filters before it is sampled, so the vibration
+  takes the gain and phase lag of the filter at its own frequency
+  rather than being aliased first. Each axis sees the harmonics a
+  third of a turn apart, so the axes are not in step
+ */
+void SITL_IMU::_vibration(Vector3f &gyro, Vector3f &accel) const
+{
+    float v[3] = { 0, 0, 0 };
+    for (uint8_t n=1; n<=_vib_harmonics; n++) {
+        float phase = _vib_phase * n;
+        float amp = 1.0f / n;
+        if (_filter_hz > 0) {
+            float ratio = _vib_freq * n / _filter_hz;
+            amp /= sqrtf(1 + ratio * ratio);
+            phase -= atanf(ratio);
+        }
+        v[0] += amp * sinf(phase);
+        v[1] += amp * sinf(phase + 2.0943951f);
+        v[2] += amp * sinf(phase + 4.1887902f);
+    }
+    gyro = Vector3f(v[0], v[1], v[2]) * _vib_gyro;
+    accel = Vector3f(v[1], v[2], v[0]) * _vib_accel;
+}
+
+uint16_t SITL_IMU::update(uint32_t time_usec, const Vector3f &gyro, const Vector3f &accel,
+                          sample_fn_t fn)
+{
+    if (!_have_state || time_usec - _last_usec > SITL_IMU_MAX_GAP_USEC) {
+        // start sampling from this state
+        _have_state = true;
+        _last_usec = time_usec;
+        _last_gyro = gyro;
+        _last_accel = accel;
+        _next_sample_usec = time_usec;
+        _filtered.gyro = gyro;
+        _filtered.accel = accel;
+    }
+
+    uint32_t frame_usec = time_usec - _last_usec;
+    uint32_t period_usec = _period_usec;
+    if (period_usec == 0) {
+        // one sample per simulator frame
+        period_usec = frame_usec ? frame_usec : 1;
+        _next_sample_usec = time_usec;
+    }
+    float dt = period_usec * 1.0e-6f;
+
+    // the sensor low pass filter on the slowly changing part of the
+    // signal, as a first order filter at the sample rate
+    float alpha = 1.0f;
+    if (_filter_hz > 0) {
+        float rc = 1.0f / (2.0f * PI * _filter_hz);
+        alpha = dt / (dt + rc);
+    }
+    float vib_step = 2.0f * PI * _vib_freq * dt;
+
+    uint16_t count = 0;
+    while ((int32_t)(time_usec - _next_sample_usec) >= 0) {
+        // the true state at the sample time, interpolated between
+        // simulator frames
+        float frac = 1.0f;
+        if (frame_usec != 0) {
+            frac = (float)(_next_sample_usec - _last_usec) / frame_usec;
+        }
+        Vector3f g = _last_gyro + (gyro - _last_gyro) * frac;
+        Vector3f a = _last_accel + (accel - _last_accel) * frac;
+        if (_sim_time) {
+            _random.set_time(_seed, _stream, _next_sample_usec);
+        }
+        g += _rand_vec3f(_gyro_noise);
+        a += _rand_vec3f(_accel_noise);
+
+        _filtered.gyro += (g - _filtered.gyro) * alpha;
+        _filtered.accel += (a - _filtered.accel) * alpha;
+
+        struct sample s = _filtered;
+        if (_vib_freq > 0) {
+            Vector3f vib_gyro, vib_accel;
+            _vibration(vib_gyro, vib_accel);
+            s.gyro += vib_gyro;
+            s.accel += vib_accel;
+            _vib_phase = wrap_PI(_vib_phase + vib_step);
+        }
+
+        // the sample waits behind the delay before the driver sees it
+        uint8_t tail = (_delay_head + _delay_count) % SITL_IMU_MAX_DELAY;
+        _delay[tail] = s;
+        _delay_count++;
+        while (_delay_count > _delay_samples) {
+            const struct sample &out = _delay[_delay_head];
+            fn(out.gyro, out.accel, dt);
+            _delay_head = (_delay_head + 1) % SITL_IMU_MAX_DELAY;
+            _delay_count--;
+            count++;
+        }
+
+        _next_sample_usec += period_usec;
+    }
+
+    _last_usec = time_usec;
+    _last_gyro = gyro;
+    _last_accel = accel;
+    return count;
+}
+
+// a Vector3f of random values between -amplitude and amplitude
+Vector3f SITL_IMU::_rand_vec3f(float amplitude)
+{
+    if (amplitude == 0) {
+        return Vector3f();
+    }
+    return Vector3f(_random.rand_float(), _random.rand_float(), _random.rand_float()) * amplitude;
+}
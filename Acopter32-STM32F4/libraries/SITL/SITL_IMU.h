@@ -0,0 +1,107 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __SITL_IMU_H__
+#define __SITL_IMU_H__
+
+#include <AP_Common.h>
+#include <AP_Math.h>
+#include "SITL_Random.h"
+
+// the most samples the sensor delay can hold, 100ms at 1kHz
+#define SITL_IMU_MAX_DELAY 100
+
+// the most vibration harmonics of the motor frequency
+#define SITL_IMU_MAX_HARMONICS 4
+
+/*
+  a model of an IMU sampled by its driver. The flight simulator gives
+  the true body rates and accelerations at its own frame rate, and
+  the model turns them into raw samples at the sensor rate, as the
+  MPU6000 driver reads them: interpolated between simulator frames,
+  with motor vibration, noise, the sensor low pass filter and the
+  sensor delay. The samples are handed on one at a time, to be
+  averaged by the inertial sensor driver, so vibration above half the
+  main loop rate aliases as it does on a real board
+ */
+class SITL_IMU
+{
+public:
+    SITL_IMU();
+
+    // called with each raw sample, gyro in rad/s and accel in m/s/s,
+    // with the sample period in seconds
+    typedef void (*sample_fn_t)(const Vector3f &gyro, const Vector3f &accel, float dt);
+
+    // the sensor sample rate in Hz, the delay from a sample to the
+    // driver reading it in milliseconds and the cut off frequency of
+    // the sensor low pass filter in Hz, 0 for none
+    void set_sensor(uint16_t rate_hz, uint8_t delay_ms, float filter_hz);
+
+    // white noise at each sample, gyro in rad/s and accel in m/s/s
+    void set_noise(float gyro_noise, float accel_noise);
+
+    // seed the noise. With sim_time set the noise of each sample
+    // depends only on the seed, the stream and the sample time
+    void set_seed(uint32_t seed, uint8_t stream, bool sim_time);
+
+    // vibration at the motor frequency and its harmonics, each
+    // harmonic at 1/n of the amplitude. gyro amplitude in rad/s and
+    // accel amplitude in m/s/s
+    void set_vibration(float freq_hz, float gyro_amp, float accel_amp, uint8_t harmonics);
+
+    // give the true state at time_usec, and pass fn the samples the
+    // sensor takes since the last call. Returns the number of samples
+    uint16_t update(uint32_t time_usec, const Vector3f &gyro, const Vector3f &accel,
+                    sample_fn_t fn);
+
+    // forget the history, for a restart of the simulator
+    void reset(void);
+
+private:
+    struct sample {
+        Vector3f gyro;
+        Vector3f accel;
+    };
+
+    // the sensor setup
+    uint32_t _period_usec;
+    uint8_t _delay_samples;
+    float _filter_hz;
+    float _gyro_noise;
+    float _accel_noise;
+    SITL_Random _random;
+    uint32_t _seed;
+    uint8_t _stream;
+    bool _sim_time;
+    float _vib_freq;
+    float _vib_gyro;
+    float _vib_accel;
+    uint8_t _vib_harmonics;
+
+    // the true state at the last update
+    uint32_t _last_usec;
+    Vector3f _last_gyro;
+    Vector3f _last_accel;
+    bool _have_state;
+
+    // when the next sample is due
+    uint32_t _next_sample_usec;
+
+    // phase of the motor rotation in radians, from -PI to PI
+    float _vib_phase;
+
+    // the output of the sensor low pass filter, before vibration
+    struct sample _filtered;
+
+    // samples taken but not yet seen by the driver
+    struct sample _delay[SITL_IMU_MAX_DELAY];
+    uint8_t _delay_head;
+    uint8_t _delay_count;
+
+    // the vibration at the current phase, per axis
+    void _vibration(Vector3f &gyro, Vector3f &accel) const;
+
+    Vector3f _rand_vec3f(float amplitude);
+};
+
+#endif // __SITL_IMU_H__
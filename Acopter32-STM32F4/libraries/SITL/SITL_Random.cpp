@@ -0,0 +1,69 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+	SITL_Random.cpp - seeded random numbers for the simulated sensors
+
+	This is the SplitMix64 generator: a counter stepped by a fixed
+	odd constant, with the output mixed by the MurmurHash3
+	finaliser. Any state is a good starting point, so a seed, a
+	stream and a time can be hashed straight into it.
+*/
+
+#include "SITL_Random.h"
+
+#define SITL_RANDOM_STEP 0x9E3779B97F4A7C15ULL
+
+uint64_t SITL_Random::_mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+void SITL_Random::set_seed(uint32_t seed, uint8_t stream)
+{
+    _state = _mix(((uint64_t)stream << 32) | seed);
+}
+
+void SITL_Random::set_time(uint32_t seed, uint8_t stream, uint64_t time_usec)
+{
+    _state = _mix(_mix(((uint64_t)stream << 32) | seed) + time_usec);
+}
+
+uint32_t SITL_Random::next(void)
+{
+    _state += SITL_RANDOM_STEP;
+    return _mix(_state) >> 32;
+}
+
+// generate a random float between -1 and 1
+float SITL_Random::rand_float(void)
+{
+    return ((next() % 2000000) - 1.0e6) / 1.0e6;
+}
+
+// generate a random Vector3f of size 1
+Vector3f SITL_Random::rand_vec3f(void)
+{
+    Vector3f v = Vector3f(rand_float(),
+                          rand_float(),
+                          rand_float());
+    if (v.length() != 0.0) {
+        v.normalize();
+    }
+    return v;
+}
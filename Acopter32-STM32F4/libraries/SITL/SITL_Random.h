@@ -0,0 +1,45 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __SITL_RANDOM_H__
+#define __SITL_RANDOM_H__
+
+#include <AP_Common.h>
+#include <AP_Math.h>
+
+/*
+  a random number generator for the simulated sensors. Each sensor
+  has its own generator, started from the SIM_SEED seed and a stream
+  number, so the values one sensor draws do not depend on how many
+  another has drawn.
+
+  With set_time() the sequence restarts from the seed, the stream and
+  a time, so the values drawn after it depend only on those and on
+  nothing that happened before
+ */
+class SITL_Random
+{
+public:
+    SITL_Random() : _state(0) {}
+
+    // start the sequence of a stream
+    void set_seed(uint32_t seed, uint8_t stream);
+
+    // restart the sequence of a stream at a time in microseconds
+    void set_time(uint32_t seed, uint8_t stream, uint64_t time_usec);
+
+    // the next 32 bit value
+    uint32_t next(void);
+
+    // a float between -1 and 1
+    float rand_float(void);
+
+    // a Vector3f of size 1
+    Vector3f rand_vec3f(void);
+
+private:
+    uint64_t _state;
+
+    static uint64_t _mix(uint64_t x);
+};
+
+#endif // __SITL_RANDOM_H__
@@ -0,0 +1,259 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Checks of the SITL IMU model: the number of samples at the sensor
+// rate, interpolation between simulator frames and the sensor delay.
+// With a repeatable seed the noise of each sample must depend only on
+// the seed and the sample time, not on how the simulator frames
+// arrive.
+//
+// Then it shows what is left of the motor vibration in the gyro after
+// the inertial sensor driver has averaged the samples for the main
+// loop, with and without the sensor low pass filter. Without the
+// filter, vibration close to a multiple of the sample rate aliases to
+// a low frequency, which the averaging does not remove.
+//
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_Math.h>
+#include <AP_ADC.h>
+#include <AP_InertialSensor.h>
+#include <GCS_MAVLink.h>
+#include <SITL.h>
+#include <SITL_IMU.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+static SITL_IMU imu;
+static AP_InertialSensor_HIL ins;
+
+// the samples the model gave since the last check
+#define MAX_SAMPLES 400
+static Vector3f samples[MAX_SAMPLES];
+static uint16_t num_samples;
+static float sample_dt;
+
+static void record_sample(const Vector3f &gyro, const Vector3f &accel, float dt)
+{
+    if (num_samples < MAX_SAMPLES) {
+        samples[num_samples] = gyro;
+    }
+    num_samples++;
+    sample_dt = dt;
+}
+
+static void ins_sample(const Vector3f &gyro, const Vector3f &accel, float dt)
+{
+    ins.accumulate(gyro, accel, dt);
+}
+
+static uint8_t failures;
+
+static void check(bool ok, const prog_char_t *msg)
+{
+    if (!ok) {
+        hal.console->printf_P(PSTR("Failed: "));
+        hal.console->println_P(msg);
+        failures++;
+    }
+}
+
+static void setup_model(uint16_t rate_hz, uint8_t delay_ms, float filter_hz)
+{
+    imu.reset();
+    imu.set_sensor(rate_hz, delay_ms, filter_hz);
+    imu.set_noise(0, 0);
+    imu.set_vibration(0, 0, 0, 1);
+    num_samples = 0;
+}
+
+// 200 frames of a 200Hz simulator give 1000 samples at 1kHz
+static void check_rate(void)
+{
+    setup_model(1000, 0, 0);
+    uint32_t t = 10000;
+    imu.update(t, Vector3f(), Vector3f(), record_sample);
+    num_samples = 0;
+    for (uint16_t i=0; i<200; i++) {
+        t += 5000;
+        imu.update(t, Vector3f(), Vector3f(), record_sample);
+    }
+    check(num_samples == 1000, PSTR("1kHz samples from 200Hz frames"));
+    check(fabsf(sample_dt - 0.001f) < 1.0e-6f, PSTR("1kHz sample period"));
+
+    // one sample per frame with a rate of zero
+    setup_model(0, 0, 0);
+    for (uint16_t i=0; i<50; i++) {
+        t += 20000;
+        imu.update(t, Vector3f(), Vector3f(), record_sample);
+    }
+    check(num_samples == 50, PSTR("one sample per frame"));
+}
+
+// samples between frames follow a ramp in the true rates
+static void check_interpolation(void)
+{
+    setup_model(1000, 0, 0);
+    uint32_t t = 10000;
+    imu.update(t, Vector3f(), Vector3f(), record_sample);
+    num_samples = 0;
+    t += 20000;
+    imu.update(t, Vector3f(2, -1, 0.5f), Vector3f(), record_sample);
+    float max_error = 0;
+    for (uint16_t i=0; i<num_samples; i++) {
+        float frac = (i + 1) / 20.0f;
+        Vector3f expected = Vector3f(2, -1, 0.5f) * frac;
+        max_error = max(max_error, (samples[i] - expected).length());
+    }
+    check(num_samples == 20, PSTR("samples in a 50Hz frame"));
+    check(max_error < 1.0e-5f, PSTR("interpolation between frames"));
+}
+
+// a step in the rates reaches the driver IMU_DELAY later
+static void check_delay(void)
+{
+    setup_model(1000, 5, 0);
+    uint32_t t = 10000;
+    Vector3f step(1, 1, 1);
+    imu.update(t, Vector3f(), Vector3f(), record_sample);
+    for (uint8_t i=0; i<20; i++) {
+        t += 1000;
+        imu.update(t, Vector3f(), Vector3f(), record_sample);
+    }
+    num_samples = 0;
+    for (uint8_t i=0; i<20; i++) {
+        t += 1000;
+        imu.update(t, step, Vector3f(), record_sample);
+    }
+    uint16_t first = 0;
+    while (first < num_samples && samples[first].x < 0.5f) {
+        first++;
+    }
+    check(first == 5, PSTR("5ms delay at 1kHz"));
+}
+
+/*
+  noisy samples at 1kHz from start_usec, with simulator frames every
+  frame_usec
+ */
+static void noisy_samples(uint32_t seed, bool sim_time, uint32_t start_usec,
+                          uint32_t frame_usec, Vector3f *out)
+{
+    setup_model(1000, 0, 0);
+    imu.set_noise(1.0f, 1.0f);
+    imu.set_seed(seed, 1, sim_time);
+    uint32_t t = start_usec;
+    imu.update(t, Vector3f(), Vector3f(), record_sample);
+    num_samples = 0;
+    while (num_samples < MAX_SAMPLES) {
+        t += frame_usec;
+        imu.update(t, Vector3f(), Vector3f(), record_sample);
+    }
+    memcpy(out, samples, sizeof(samples));
+}
+
+static void check_repeatable(void)
+{
+    static Vector3f run1[MAX_SAMPLES], run2[MAX_SAMPLES];
+    // the second run starts 5 samples earlier
+    const size_t overlap = sizeof(Vector3f) * (MAX_SAMPLES - 5);
+
+    // the same seed with frames at 200Hz and at 1kHz gives the same
+    // noise at the same sample times
+    noisy_samples(1234, true, 10000, 5000, run1);
+    noisy_samples(1234, true, 5000, 1000, run2);
+    check(memcmp(run1, &run2[5], overlap) == 0, PSTR("same noise at the same time"));
+
+    // a different seed
+    noisy_samples(4321, true, 10000, 5000, run2);
+    check(memcmp(run1, run2, sizeof(run1)) != 0, PSTR("other noise from another seed"));
+
+    // without the simulated time the seed gives a sequence, which
+    // repeats only if the samples are taken the same way
+    noisy_samples(1234, false, 10000, 5000, run1);
+    noisy_samples(1234, false, 10000, 5000, run2);
+    check(memcmp(run1, run2, sizeof(run1)) == 0, PSTR("same sequence from the same seed"));
+    noisy_samples(1234, false, 5000, 1000, run2);
+    check(memcmp(run1, &run2[5], overlap) != 0, PSTR("sequence follows the samples"));
+}
+
+/*
+  the RMS of the gyro the main loop sees, with a simulator at 2kHz
+  and a main loop at loop_hz
+ */
+static float vibration_rms(float vib_hz, float filter_hz, uint16_t loop_hz)
+{
+    setup_model(1000, 0, filter_hz);
+    imu.set_vibration(vib_hz, 1.0f, 0, 1);
+
+    uint32_t t = 10000;
+    uint32_t loop_period = 1000000UL / loop_hz;
+    uint32_t next_loop = t + loop_period;
+    float sum_sq = 0;
+    uint16_t count = 0;
+    ins.update();
+    while (count < 2000) {
+        t += 500;
+        imu.update(t, Vector3f(), Vector3f(), ins_sample);
+        if ((int32_t)(t - next_loop) >= 0) {
+            next_loop += loop_period;
+            ins.update();
+            // skip the filter settling
+            if (t > 200000) {
+                sum_sq += ins.get_gyro().x * ins.get_gyro().x;
+                count++;
+            }
+        }
+    }
+    return sqrtf(sum_sq / count);
+}
+
+static void show_aliasing(void)
+{
+    static const float freqs[] = { 30, 180, 360, 990 };
+    static const uint16_t loops[] = { 100, 400 };
+
+    hal.console->printf_P(PSTR("gyro RMS at the main loop for vibration of RMS 0.707\n"));
+    hal.console->printf_P(PSTR("%8s %7s %10s %10s\n"), "vib Hz", "loop Hz", "no filter", "42Hz LPF");
+    for (uint8_t f=0; f<sizeof(freqs)/sizeof(freqs[0]); f++) {
+        for (uint8_t l=0; l<sizeof(loops)/sizeof(loops[0]); l++) {
+            float rms = vibration_rms(freqs[f], 0, loops[l]);
+            float rms_filtered = vibration_rms(freqs[f], 42, loops[l]);
+            hal.console->printf_P(PSTR("%8.0f %7u %10.3f %10.3f\n"),
+                                  freqs[f], (unsigned)loops[l], rms, rms_filtered);
+            if (freqs[f] == 990) {
+                // 990Hz at 1kHz aliases to 10Hz, which passes the
+                // averaging but not the sensor filter
+                check(rms > 0.6f, PSTR("990Hz vibration aliases to 10Hz"));
+                check(rms_filtered < 0.05f, PSTR("990Hz vibration filtered"));
+            }
+            if (freqs[f] == 180 && loops[l] == 100) {
+                check(rms < 0.2f, PSTR("180Hz vibration averaged at 100Hz"));
+            }
+        }
+    }
+}
+
+void setup(void)
+{
+    hal.console->println_P(PSTR("SITL IMU model test"));
+}
+
+void loop(void)
+{
+    failures = 0;
+    check_rate();
+    check_interpolation();
+    check_delay();
+    check_repeatable();
+    show_aliasing();
+    hal.console->printf_P(PSTR("%u failures\n\n"), (unsigned)failures);
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
@@ -12,6 +12,8 @@ cSRCS_$(d) :=
 
 cppSRCS_$(d) := 
 cppSRCS_$(d) += SITL.cpp
+cppSRCS_$(d) += SITL_IMU.cpp
+cppSRCS_$(d) += SITL_Random.cpp
 
 
 cFILES_$(d) := $(cSRCS_$(d):%=$(d)/%)
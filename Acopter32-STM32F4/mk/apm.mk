@@ -54,6 +54,10 @@ ifeq ($(HAL_BOARD),HAL_BOARD_REVOMINI)
 include $(MK_DIR)/board_REVOMINI.mk
 endif
 
+ifeq ($(HAL_BOARD),HAL_BOARD_EMPTY)
+include $(MK_DIR)/board_empty.mk
+endif
+
 endif
 
 endif
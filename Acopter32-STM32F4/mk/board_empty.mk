@@ -0,0 +1,11 @@
+TOOLCHAIN = NATIVE
+
+include $(MK_DIR)/find_tools.mk
+
+# The empty HAL is built natively, to run library code and its tests
+# on the host without any hardware. HAL_EMPTY_HOST gives it a clock,
+# a console on stdout and storage in memory. It is optimised so that
+# timings of the library code mean something
+OPTFLAGS = -O2 -g
+EXTRAFLAGS += -DHAL_EMPTY_HOST
+include $(MK_DIR)/board_avr_sitl.mk
@@ -115,6 +115,10 @@ ifneq ($(findstring linux, $(MAKECMDGOALS)),)
 HAL_BOARD = HAL_BOARD_LINUX
 endif
 
+ifneq ($(findstring host, $(MAKECMDGOALS)),)
+HAL_BOARD = HAL_BOARD_EMPTY
+endif
+
 ifneq ($(findstring vrbrain, $(MAKECMDGOALS)),)
 HAL_BOARD = HAL_BOARD_VRBRAIN
 endif
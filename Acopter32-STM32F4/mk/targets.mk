@@ -37,6 +37,10 @@ empty: HAL_BOARD = HAL_BOARD_EMPTY
 empty: TOOLCHAIN = AVR
 empty: all
 
+host: HAL_BOARD = HAL_BOARD_EMPTY
+host: TOOLCHAIN = NATIVE
+host: all
+
 
 nologging: EXTRAFLAGS += "-DLOGGING_ENABLED=DISABLED "
 nologging: all